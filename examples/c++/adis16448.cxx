@@ -59,7 +59,23 @@ main(int argc, char **argv)
         std::cout << "YACCL_OUT:" << imu->accelScale(imu->regRead(YACCL_OUT)) << std::endl;
         std::cout << "ZACCL_OUT:" << imu->accelScale(imu->regRead(ZACCL_OUT)) << std::endl;
         std::cout << " " << std::endl;
+
+        //Read all outputs with a single burst, and display them
+        imu->enableCRC(true);
+        if (imu->update())
+        {
+            float x, y, z;
+            imu->getGyroscope(&x, &y, &z);
+            std::cout << "Burst gyro: " << x << " " << y << " " << z << std::endl;
+            imu->getAccelerometer(&x, &y, &z);
+            std::cout << "Burst accel: " << x << " " << y << " " << z << std::endl;
+            std::cout << "Burst temp: " << imu->getTemperature() << std::endl;
+        }
+        else
+            std::cout << "Burst read failed, CRC errors: " << imu->getCRCErrors() << std::endl;
+        std::cout << " " << std::endl;
     //! [Interesting]
+        delete imu;
         sleep(1);
     }
     return (0);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <iostream>
+#include <signal.h>
+#include "lsm9ds0.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+//! [Interesting]
+
+  // Instantiate an LSM9DS0 using default parameters (bus 1, gyro addr
+  // 6b, xm addr 1d)
+  upm::LSM9DS0 *sensor = new upm::LSM9DS0();
+
+  sensor->init();
+
+  // run the orientation filter from update()
+  sensor->enableFusion(true);
+
+  int count = 0;
+
+  while (shouldRun)
+    {
+      // update at roughly 100Hz, close to the default gyroscope and
+      // accelerometer rates
+      sensor->update();
+
+      // but only print twice a second
+      if (++count >= 50)
+        {
+          float w, x, y, z;
+
+          sensor->getQuaternion(&w, &x, &y, &z);
+          cout << "Quaternion: W: " << w << " X: " << x << " Y: " << y
+               << " Z: " << z << endl;
+
+          sensor->getEulerAngles(&x, &y, &z);
+          cout << "Roll: " << x << " Pitch: " << y << " Yaw: " << z << endl;
+
+          sensor->getGyroBias(&x, &y, &z);
+          cout << "Gyro bias:  X: " << x << " Y: " << y << " Z: " << z
+               << endl;
+          cout << endl;
+
+          count = 0;
+        }
+
+      usleep(10000);
+    }
+
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  delete sensor;
+
+  return 0;
+}
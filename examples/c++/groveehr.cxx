@@ -65,6 +65,11 @@ int main()
       cout << "Millis: " << millis << " Beats: " << beats;
       cout << " Heart Rate: " << hr << endl;
 
+      // the rate from the last beat interval, and over the last 10
+      // seconds, are available as soon as two beats were counted
+      cout << "Instant Rate: " << heart->instantHeartRate();
+      cout << " 10s Rate: " << heart->windowHeartRate(10000) << endl;
+
       sleep(1);
     }
 
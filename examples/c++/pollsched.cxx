@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <iostream>
+#include <signal.h>
+#include "pollsched.h"
+#include "mpu9150.h"
+#include "bmpx8x.h"
+
+using namespace std;
+
+int shouldRun = true;
+
+void sig_handler(int signo)
+{
+  if (signo == SIGINT)
+    shouldRun = false;
+}
+
+// BMPX8X has no update() method, so poll it with our own function
+int32_t pressure = 0;
+
+void pollPressure(void *ctx)
+{
+  pressure = ((upm::BMPX8X *)ctx)->getPressure();
+}
+
+int main(int argc, char **argv)
+{
+  signal(SIGINT, sig_handler);
+//! [Interesting]
+
+  // Instantiate an MPU9150 and a BMPX8X, both on I2C bus 0
+  upm::MPU9150 *imu = new upm::MPU9150();
+  imu->init();
+
+  upm::BMPX8X *baro = new upm::BMPX8X(0);
+
+  // poll the IMU at 100Hz and the barometer at 5Hz.  Since they share
+  // a bus, they will never be polled at the same time.
+  upm::PollScheduler *sched = new upm::PollScheduler();
+
+  int imuId = sched->addDevice(&upm::PollScheduler::updateDevice<upm::MPU9150>,
+                               imu, 100.0, upm::PollScheduler::BUS_I2C, 0);
+  int baroId = sched->addDevice(pollPressure, baro, 5.0,
+                                upm::PollScheduler::BUS_I2C, 0);
+
+  sched->start();
+
+  while (shouldRun)
+    {
+      float x, y, z;
+      int32_t p;
+      uint32_t seq;
+
+      // read a consistent sample without blocking the scheduler
+      do {
+        seq = sched->readBegin(imuId);
+        imu->getAccelerometer(&x, &y, &z);
+      } while (sched->readRetry(imuId, seq));
+
+      cout << "Accelerometer: ";
+      cout << "AX: " << x << " AY: " << y << " AZ: " << z << endl;
+
+      do {
+        seq = sched->readBegin(baroId);
+        p = pressure;
+      } while (sched->readRetry(baroId, seq));
+
+      cout << "Pressure:      " << p << endl;
+
+      cout << "IMU polls: " << sched->getSampleCount(imuId)
+           << " misses: " << sched->getDeadlineMisses(imuId)
+           << " jitter: " << sched->getJitter(imuId) << "us"
+           << " poll time: " << sched->getPollTime(imuId) << "us" << endl;
+      cout << endl;
+
+      usleep(500000);
+    }
+
+//! [Interesting]
+
+  cout << "Exiting..." << endl;
+
+  sched->stop();
+
+  delete sched;
+  delete baro;
+  delete imu;
+
+  return 0;
+}
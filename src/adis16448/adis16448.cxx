@@ -73,6 +73,25 @@ ADIS16448::ADIS16448(int bus, int rst)
             return;
           }
         configSPI();
+
+        _dr = 0;
+        _crcEnabled = false;
+        _crcErrors = 0;
+        _overruns = 0;
+        memset(_sample, 0, sizeof(_sample));
+
+        _queue = 0;
+        _queueSize = 0;
+        _queueHead = 0;
+        _queueCount = 0;
+
+        if (pthread_mutex_init(&_spiLock, NULL) ||
+            pthread_mutex_init(&_queueLock, NULL))
+          {
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": pthread_mutex_init() failed");
+            return;
+          }
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -81,6 +100,10 @@ ADIS16448::ADIS16448(int bus, int rst)
 ////////////////////////////////////////////////////////////////////////////
 ADIS16448::~ADIS16448()
 {
+// Stop the data ready ISR before tearing down the bus
+	uninstallDataReadyISR();
+	pthread_mutex_destroy(&_spiLock);
+	pthread_mutex_destroy(&_queueLock);
 // Close SPI bus
 	mraa_result_t error;
 	error = mraa_spi_stop(_spi);
@@ -139,20 +162,23 @@ void ADIS16448::configSPI() {
 int16_t ADIS16448::regRead(uint8_t regAddr)
 {
 	configSPI(); //Set up SPI (useful when multiple SPI devices present on bus)
+	lockSPI(); //Keep the data ready ISR off the bus for the whole exchange
 // Write register address to be read
 	uint8_t buf[2]; //Allocate write buffer
+	uint8_t x[2]; //Allocate read buffer
 	memset(buf, 0, sizeof(uint8_t)*2); //Initialize buffer and write 0s
 	buf[1] = regAddr; //Write the user-requested register address to the buffer
-	mraa_spi_write_buf(_spi, buf, 2); //Write the buffer onto the SPI port
+	mraa_spi_transfer_buf(_spi, buf, x, 2); //Write the buffer onto the SPI port
 
 	usleep(20); //Delay to not violate read rate (210us)
 
 // Read data from register requested
 	buf[1] = 0; //Clear contents of write buffer
-	uint8_t* x = mraa_spi_write_buf(_spi, buf, 2); //Write 0x0000 to SPI and read data requested above
+	mraa_spi_transfer_buf(_spi, buf, x, 2); //Write 0x0000 to SPI and read data requested above
 	int16_t _dataOut = (x[1] << 8) | (x[0] & 0xFF);; //Concatenate upper and lower bytes
 
 	usleep(20); //delay to not violate read rate (210us)
+	unlockSPI();
 	return(_dataOut);
 }
 ////////////////////////////////////////////////////////////////////////////
@@ -164,6 +190,7 @@ int16_t ADIS16448::regRead(uint8_t regAddr)
 void ADIS16448::regWrite(uint8_t regAddr,uint16_t regData)
 {
 	configSPI();
+	lockSPI();
 // Separate the 16 bit command word into two bytes
 	uint16_t addr = (((regAddr & 0x7F) | 0x80) << 8); //Check that the address is 7 bits, flip the sign bit
 	uint16_t lowWord = (addr | (regData & 0xFF));
@@ -185,7 +212,7 @@ void ADIS16448::regWrite(uint8_t regAddr,uint16_t regData)
 	mraa_spi_write_buf(_spi, hbuf, 2); //Write the buffer to the SPI port
 
 	usleep(20);
-
+	unlockSPI();
 }
 /////////////////////////////////////////////////////////////////////////////////////////
 // Converts accelerometer data output from the sensorRead() function and returns
@@ -245,3 +272,295 @@ float ADIS16448::magnetometerScale(int16_t sensorData)
 	float finalData = (sensorData * 0.0001429); //multiply by sensor resolution (142.9uGa LSB/dps)
 	return finalData;
 }
+
+////////////////////////////////////////////////////////////////////////////
+// Enables/disables the CRC-16 word appended to the burst output
+////////////////////////////////////////////////////////////////////////////
+// enable - true to append and check the CRC
+////////////////////////////////////////////////////////////////////////////
+void ADIS16448::enableCRC(bool enable)
+{
+	uint16_t msc = (uint16_t)regRead(MSC_CTRL);
+	if (enable)
+		msc |= MSC_CTRL_CRC_EN;
+	else
+		msc &= ~MSC_CTRL_CRC_EN;
+	regWrite(MSC_CTRL, msc);
+	_crcEnabled = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Computes the burst CRC-16 (poly 0x1021, init 0xFFFF, LSB first) over
+// XGYRO_OUT through TEMP_OUT, low byte then high byte of each word
+////////////////////////////////////////////////////////////////////////////
+// words - burst output, DIAG_STAT first
+// return - CRC as transmitted by the device
+////////////////////////////////////////////////////////////////////////////
+uint16_t ADIS16448::burstCRC(const int16_t *words)
+{
+	uint16_t crc = 0xFFFF;
+	for (int i = 1; i < BURST_WORDS - 1; i++)
+	{
+		uint8_t bytes[2];
+		bytes[0] = words[i] & 0xFF;
+		bytes[1] = (words[i] >> 8) & 0xFF;
+		for (int b = 0; b < 2; b++)
+		{
+			uint8_t data = bytes[b];
+			for (int bit = 0; bit < 8; bit++, data >>= 1)
+			{
+				if ((crc & 0x0001) ^ (data & 0x0001))
+					crc = (crc >> 1) ^ 0x1021;
+				else
+					crc >>= 1;
+			}
+		}
+	}
+	crc = ~crc;
+	return (uint16_t)((crc << 8) | (crc >> 8)); //Final byte swap
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reads all outputs with one burst command. No stall time is required
+// between the words of a burst, so this is a single SPI transfer.
+////////////////////////////////////////////////////////////////////////////
+// words - BURST_WORDS entries, DIAG_STAT first
+// return - false on SPI failure or CRC mismatch
+////////////////////////////////////////////////////////////////////////////
+bool ADIS16448::burstRead(int16_t *words)
+{
+	// Command word, followed by the outputs (and CRC if enabled)
+	int nwords = (_crcEnabled ? BURST_WORDS : BURST_WORDS - 1) + 1;
+	uint8_t tx[(BURST_WORDS + 1) * 2];
+	uint8_t rx[(BURST_WORDS + 1) * 2];
+	memset(tx, 0, sizeof(tx));
+	tx[1] = BURST_CMD;
+
+	configSPI();
+	lockSPI();
+	mraa_result_t rv = mraa_spi_transfer_buf(_spi, tx, rx, nwords * 2);
+	unlockSPI();
+
+	if (rv != MRAA_SUCCESS)
+		return false;
+
+	for (int i = 0; i < nwords - 1; i++)
+		words[i] = (rx[(i + 1) * 2 + 1] << 8) | rx[(i + 1) * 2];
+
+	if (!_crcEnabled)
+	{
+		words[BURST_WORDS - 1] = 0;
+		return true;
+	}
+
+	if (burstCRC(words) != (uint16_t)words[BURST_WORDS - 1])
+	{
+		_crcErrors++;
+		return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Burst reads a new current sample
+////////////////////////////////////////////////////////////////////////////
+bool ADIS16448::update()
+{
+	int16_t words[BURST_WORDS];
+	if (!burstRead(words))
+		return false;
+
+	memcpy(_sample, words, sizeof(_sample));
+	return true;
+}
+
+void ADIS16448::getAccelerometer(float *x, float *y, float *z)
+{
+	if (x)
+		*x = accelScale(_sample[4]);
+	if (y)
+		*y = accelScale(_sample[5]);
+	if (z)
+		*z = accelScale(_sample[6]);
+}
+
+void ADIS16448::getGyroscope(float *x, float *y, float *z)
+{
+	if (x)
+		*x = gyroScale(_sample[1]);
+	if (y)
+		*y = gyroScale(_sample[2]);
+	if (z)
+		*z = gyroScale(_sample[3]);
+}
+
+void ADIS16448::getMagnetometer(float *x, float *y, float *z)
+{
+	if (x)
+		*x = magnetometerScale(_sample[7]);
+	if (y)
+		*y = magnetometerScale(_sample[8]);
+	if (z)
+		*z = magnetometerScale(_sample[9]);
+}
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+float *ADIS16448::getAccelerometer()
+{
+	float *v = new float[3];
+	getAccelerometer(&v[0], &v[1], &v[2]);
+	return v;
+}
+
+float *ADIS16448::getGyroscope()
+{
+	float *v = new float[3];
+	getGyroscope(&v[0], &v[1], &v[2]);
+	return v;
+}
+
+float *ADIS16448::getMagnetometer()
+{
+	float *v = new float[3];
+	getMagnetometer(&v[0], &v[1], &v[2]);
+	return v;
+}
+#endif
+
+float ADIS16448::getTemperature()
+{
+	return tempScale(_sample[11]);
+}
+
+float ADIS16448::getPressure()
+{
+	// BARO_OUT is unsigned
+	return (uint16_t)_sample[10] * 0.02;
+}
+
+uint16_t ADIS16448::getDiagStat()
+{
+	return (uint16_t)_sample[0];
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Data ready ISR - burst reads one sample and appends it to the queue,
+// overwriting the oldest sample if the queue is full
+////////////////////////////////////////////////////////////////////////////
+void ADIS16448::dataReadyISR(void *ctx)
+{
+	ADIS16448 *This = (ADIS16448 *)ctx;
+	int16_t words[BURST_WORDS];
+
+	if (!This->burstRead(words))
+		return;
+
+	pthread_mutex_lock(&This->_queueLock);
+	if (This->_queue)
+	{
+		int tail = (This->_queueHead + This->_queueCount) % This->_queueSize;
+		if (This->_queueCount == This->_queueSize)
+		{
+			This->_queueHead = (This->_queueHead + 1) % This->_queueSize;
+			This->_overruns++;
+		}
+		else
+			This->_queueCount++;
+
+		memcpy(&This->_queue[tail * BURST_WORDS], words, sizeof(words));
+	}
+	pthread_mutex_unlock(&This->_queueLock);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Enables data ready on DIO1 (active high) and queues a burst sample on
+// every rising edge of drPin
+////////////////////////////////////////////////////////////////////////////
+// drPin - GPIO wired to DIO1
+// queueSize - number of samples retained
+////////////////////////////////////////////////////////////////////////////
+void ADIS16448::installDataReadyISR(int drPin, int queueSize)
+{
+	if (queueSize < 1)
+	{
+		throw std::invalid_argument(std::string(__FUNCTION__) +
+		                            ": queueSize must be at least 1");
+		return;
+	}
+
+	uninstallDataReadyISR();
+
+	pthread_mutex_lock(&_queueLock);
+	_queue = new int16_t[queueSize * BURST_WORDS];
+	_queueSize = queueSize;
+	_queueHead = 0;
+	_queueCount = 0;
+	pthread_mutex_unlock(&_queueLock);
+
+	if ( !(_dr = mraa_gpio_init(drPin)) )
+	{
+		throw std::invalid_argument(std::string(__FUNCTION__) +
+		                            ": mraa_gpio_init() failed, invalid pin?");
+		return;
+	}
+	mraa_gpio_dir(_dr, MRAA_GPIO_IN);
+
+	uint16_t msc = (uint16_t)regRead(MSC_CTRL);
+	msc &= ~MSC_CTRL_DR_LINE_DIO2;
+	msc |= (MSC_CTRL_DR_EN | MSC_CTRL_DR_POL_HIGH);
+	regWrite(MSC_CTRL, msc);
+
+	if (mraa_gpio_isr(_dr, MRAA_GPIO_EDGE_RISING, &dataReadyISR, this)
+	    != MRAA_SUCCESS)
+	{
+		throw std::runtime_error(std::string(__FUNCTION__) +
+		                         ": mraa_gpio_isr() failed");
+		return;
+	}
+}
+
+void ADIS16448::uninstallDataReadyISR()
+{
+	if (_dr)
+	{
+		mraa_gpio_isr_exit(_dr);
+		mraa_gpio_close(_dr);
+		_dr = 0;
+
+		uint16_t msc = (uint16_t)regRead(MSC_CTRL);
+		regWrite(MSC_CTRL, msc & ~MSC_CTRL_DR_EN);
+	}
+
+	pthread_mutex_lock(&_queueLock);
+	delete [] _queue;
+	_queue = 0;
+	_queueSize = 0;
+	_queueHead = 0;
+	_queueCount = 0;
+	pthread_mutex_unlock(&_queueLock);
+}
+
+int ADIS16448::samplesQueued()
+{
+	pthread_mutex_lock(&_queueLock);
+	int count = _queueCount;
+	pthread_mutex_unlock(&_queueLock);
+	return count;
+}
+
+bool ADIS16448::dequeueSample()
+{
+	bool rv = false;
+
+	pthread_mutex_lock(&_queueLock);
+	if (_queueCount > 0)
+	{
+		memcpy(_sample, &_queue[_queueHead * BURST_WORDS], sizeof(_sample));
+		_queueHead = (_queueHead + 1) % _queueSize;
+		_queueCount--;
+		rv = true;
+	}
+	pthread_mutex_unlock(&_queueLock);
+
+	return rv;
+}
@@ -37,6 +37,7 @@
 //
 //////////////////////////////////////////////////////////////////////////////////////
 #include <string>
+#include <pthread.h>
 #include <mraa/spi.h>
 #include <mraa/gpio.h>
 
@@ -82,6 +83,20 @@
 #define PROD_ID 0x56 //Product identifier
 #define SERIAL_NUM 0x58 //Lot-specific serial number
 
+// MSC_CTRL bits used by the burst/data ready support
+#define MSC_CTRL_DR_LINE_DIO2 0x01 //Data ready on DIO2 (DIO1 if clear)
+#define MSC_CTRL_DR_POL_HIGH 0x02 //Data ready active high
+#define MSC_CTRL_DR_EN 0x04 //Data ready enable
+#define MSC_CTRL_CRC_EN 0x10 //Append CRC-16 to burst output
+
+// Burst read command, and number of 16-bit words returned by it
+// (DIAG_STAT, 10 outputs, TEMP_OUT and the CRC-16)
+#define BURST_CMD 0x3E
+#define BURST_WORDS 13
+
+// Default depth of the data ready sample queue (~80ms at 819.2 SPS)
+#define ADIS16448_DEFAULT_QUEUE 64
+
 namespace upm {
  /**
   * @brief ADIS16448 Accelerometer library
@@ -102,6 +117,11 @@ namespace upm {
   *
   * This is an industrial-grade accelerometer by Analog Devices.
   *
+  * In addition to single register access, update() reads every output
+  * register with one burst command (and verifies the optional CRC-16),
+  * and installDataReadyISR() queues a burst sample on every data ready
+  * pulse so the device can be run at its full 819.2 SPS.
+  *
   * @snippet adis16448.cxx Interesting
   */
     class ADIS16448{
@@ -163,10 +183,176 @@ namespace upm {
          */
         float magnetometerScale(int16_t sensorData);
 
+        /**
+         * Enables or disables the CRC-16 appended to burst reads.  When
+         * enabled, update() and the data ready queue drop samples
+         * whose CRC does not match.
+         *
+         * @param enable true to enable CRC checking, false otherwise
+         */
+        void enableCRC(bool enable);
+
+        /**
+         * Reads DIAG_STAT and all sensor outputs with a single burst
+         * command, and stores them for the get*() methods below.
+         *
+         * @return true if the sample was read (and its CRC matched,
+         * if enabled), false otherwise
+         */
+        bool update();
+
+        /**
+         * Returns the scaled accelerometer values (in g's) of the
+         * current sample.
+         *
+         * @param x the returned x value, if arg is non-NULL
+         * @param y the returned y value, if arg is non-NULL
+         * @param z the returned z value, if arg is non-NULL
+         */
+        void getAccelerometer(float *x, float *y, float *z);
+
+        /**
+         * Returns the scaled gyroscope values (in degrees/sec) of the
+         * current sample.
+         *
+         * @param x the returned x value, if arg is non-NULL
+         * @param y the returned y value, if arg is non-NULL
+         * @param z the returned z value, if arg is non-NULL
+         */
+        void getGyroscope(float *x, float *y, float *z);
+
+        /**
+         * Returns the scaled magnetometer values (in Gauss) of the
+         * current sample.
+         *
+         * @param x the returned x value, if arg is non-NULL
+         * @param y the returned y value, if arg is non-NULL
+         * @param z the returned z value, if arg is non-NULL
+         */
+        void getMagnetometer(float *x, float *y, float *z);
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+        /**
+         * Returns the scaled accelerometer values of the current sample.
+         *
+         * @return Array containing X, Y, Z accelerometer values
+         */
+        float *getAccelerometer();
+
+        /**
+         * Returns the scaled gyroscope values of the current sample.
+         *
+         * @return Array containing X, Y, Z gyroscope values
+         */
+        float *getGyroscope();
+
+        /**
+         * Returns the scaled magnetometer values of the current sample.
+         *
+         * @return Array containing X, Y, Z magnetometer values
+         */
+        float *getMagnetometer();
+#endif
+
+        /**
+         * Returns the temperature of the current sample
+         *
+         * @return temperature in degrees Celcius
+         */
+        float getTemperature();
+
+        /**
+         * Returns the barometric pressure of the current sample
+         *
+         * @return pressure in mbar
+         */
+        float getPressure();
+
+        /**
+         * Returns the DIAG_STAT register of the current sample
+         *
+         * @return DIAG_STAT contents
+         */
+        uint16_t getDiagStat();
+
+        /**
+         * Enables the data ready output on DIO1 and installs an ISR on
+         * the given GPIO.  Every data ready pulse triggers a burst
+         * read whose result is appended to a sample queue of the given
+         * depth; when the queue is full the oldest sample is dropped.
+         *
+         * @param drPin GPIO connected to the ADIS16448 DIO1 pin
+         * @param queueSize depth of the sample queue
+         */
+        void installDataReadyISR(int drPin,
+                                 int queueSize=ADIS16448_DEFAULT_QUEUE);
+
+        /**
+         * Disables the data ready output, removes the ISR and discards
+         * any queued samples.
+         */
+        void uninstallDataReadyISR();
+
+        /**
+         * Returns the number of samples waiting in the data ready queue
+         *
+         * @return number of queued samples
+         */
+        int samplesQueued();
+
+        /**
+         * Removes the oldest sample from the data ready queue and makes
+         * it the current sample for the get*() methods.
+         *
+         * @return true if a sample was dequeued, false if the queue
+         * was empty
+         */
+        bool dequeueSample();
+
+        /**
+         * Returns the number of burst samples dropped due to a CRC
+         * mismatch since construction
+         *
+         * @return CRC error count
+         */
+        unsigned int getCRCErrors() { return _crcErrors; };
+
+        /**
+         * Returns the number of queued samples overwritten because the
+         * data ready queue was full
+         *
+         * @return overrun count
+         */
+        unsigned int getOverruns() { return _overruns; };
+
         private:
 
+        bool burstRead(int16_t *words);
+        static uint16_t burstCRC(const int16_t *words);
+        static void dataReadyISR(void *ctx);
+
+        void lockSPI() { pthread_mutex_lock(&_spiLock); };
+        void unlockSPI() { pthread_mutex_unlock(&_spiLock); };
+
         mraa_spi_context _spi;
         mraa_gpio_context _rst;
+        mraa_gpio_context _dr;
+
+        bool _crcEnabled;
+        unsigned int _crcErrors;
+        unsigned int _overruns;
+
+        // current sample, in burst order
+        int16_t _sample[BURST_WORDS];
+
+        // data ready sample ring, _queueSize entries of BURST_WORDS each
+        int16_t *_queue;
+        int _queueSize;
+        int _queueHead;
+        int _queueCount;
+
+        pthread_mutex_t _spiLock;
+        pthread_mutex_t _queueLock;
 
     };
 }
@@ -1,10 +1,29 @@
 %module javaupm_adis16448
 %include "../upm.i"
+%include "stdint.i"
 
 %{
     #include "adis16448.h"
 %}
 
+%typemap(jni) float * "jfloatArray"
+%typemap(jstype) float * "float[]"
+%typemap(jtype) float * "float[]"
+
+%typemap(javaout) float * {
+    return $jnicall;
+}
+
+%typemap(out) float * {
+    $result = JCALL1(NewFloatArray, jenv, 3);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 3, $1);
+    delete [] $1;
+}
+
+%ignore getAccelerometer(float *, float *, float *);
+%ignore getGyroscope(float *, float *, float *);
+%ignore getMagnetometer(float *, float *, float *);
+
 %include "adis16448.h"
 
 %pragma(java) jniclasscode=%{
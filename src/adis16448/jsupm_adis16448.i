@@ -1,5 +1,10 @@
 %module jsupm_adis16448
 %include "../upm.i"
+%include "cpointer.i"
+
+%include "stdint.i"
+
+%pointer_functions(float, floatp);
 
 %{
     #include "adis16448.h"
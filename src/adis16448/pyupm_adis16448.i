@@ -2,6 +2,11 @@
 %include "pyupm_doxy2swig.i"
 %module pyupm_adis16448
 %include "../upm.i"
+%include "cpointer.i"
+
+%include "stdint.i"
+
+%pointer_functions(float, floatp);
 
 %{
     #include "adis16448.h"
@@ -30,8 +30,11 @@ using namespace std;
 using namespace upm;
 
 ADXRS610::ADXRS610(int dPin, int tPin, float aref) :
-  m_aioData(dPin), m_aioTemp(tPin)
+  m_aioData(dPin), m_aioTemp(tPin),
+  m_gyroCal(1, GYROCAL_DEFAULT_THRESHOLD * m_degreeCoeff)
 {
+  m_backgroundCal = false;
+
   // ADC resolution of data and temp should be the same...
   m_aRes = (1 << m_aioData.getBit());
   m_aref = aref;
@@ -72,6 +75,21 @@ float ADXRS610::calibrateZeroPoint(unsigned int samples)
   return sum / samples;
 }
 
+bool ADXRS610::saveCalibration(std::string filename)
+{
+  return m_gyroCal.save(filename);
+}
+
+bool ADXRS610::loadCalibration(std::string filename)
+{
+  if (!m_gyroCal.load(filename))
+    return false;
+
+  m_zeroPoint = m_gyroCal.getBias();
+
+  return true;
+}
+
 float ADXRS610::getTemperature()
 {
   float tempV = getTemperatureVolts();
@@ -87,6 +105,9 @@ float ADXRS610::getAngularVelocity()
 {
   float dataV = getDataVolts();
 
+  if (m_backgroundCal && m_gyroCal.addSample(dataV))
+    m_zeroPoint = m_gyroCal.getBias();
+
   // check the deadband
   if (dataV < (m_zeroPoint + m_deadband) &&
       dataV > (m_zeroPoint - m_deadband))
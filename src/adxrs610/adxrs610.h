@@ -25,8 +25,11 @@
 
 #include <iostream>
 #include <string>
+#include <string>
 #include <mraa/aio.hpp>
 
+#include "gyrocal.h"
+
 // volts per degree / second (typ)
 #define m_degreeCoeff 0.006
 
@@ -117,7 +120,11 @@ namespace upm {
      *
      * @param zeroPoint The averaged zero point of the sensor at rest
      */
-    void setZeroPoint(float zeroPoint) { m_zeroPoint = zeroPoint; };
+    void setZeroPoint(float zeroPoint)
+    {
+      m_zeroPoint = zeroPoint;
+      m_gyroCal.setBias(&zeroPoint);
+    };
 
     /**
      * This method samples the data pin samples times to produce an
@@ -137,6 +144,35 @@ namespace upm {
      */
     float getZeroPoint() { return m_zeroPoint; };
 
+    /**
+     * Enable or disable background calibration.  When enabled, each
+     * getAngularVelocity() call also looks for periods where the
+     * sensor is at rest, and uses them to refine the zero point, so
+     * it follows drift (with temperature for example) without
+     * stopping to call calibrateZeroPoint().
+     * @param enable true to enable, false to disable
+     */
+    void enableBackgroundCalibration(bool enable)
+    {
+      m_backgroundCal = enable;
+    };
+
+    /**
+     * Save the zero point, to be reloaded with loadCalibration() at
+     * the next start.
+     * @param filename the file to write
+     * @return true if successful, false otherwise
+     */
+    bool saveCalibration(std::string filename);
+
+    /**
+     * Load a zero point written by saveCalibration(), replacing the
+     * one measured at construction time.
+     * @param filename the file to read
+     * @return true if successful, false otherwise
+     */
+    bool loadCalibration(std::string filename);
+
     /**
      * Return the measured temperature in Celcius.  Note, the
      * datasheet says that this value is very repeatable, but is not
@@ -169,6 +205,10 @@ namespace upm {
 
     // aref / 2
     float m_centerVolts;
+
+    // zero point estimation, in volts
+    GyroCal m_gyroCal;
+    bool m_backgroundCal;
   };
 }
 
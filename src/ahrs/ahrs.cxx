@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "ahrs.h"
+
+using namespace upm;
+using namespace std;
+
+static const float DEG2RAD = M_PI / 180.0;
+static const float RAD2DEG = 180.0 / M_PI;
+
+AHRS::AHRS(float kp, float ki)
+{
+  setGains(kp, ki);
+  reset();
+}
+
+AHRS::~AHRS()
+{
+}
+
+void AHRS::reset()
+{
+  m_q0 = 1.0;
+  m_q1 = m_q2 = m_q3 = 0.0;
+
+  m_ix = m_iy = m_iz = 0.0;
+
+  m_samples = 0;
+  m_timed = false;
+}
+
+void AHRS::setGains(float kp, float ki)
+{
+  if (kp < 0.0 || ki < 0.0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": gains must not be negative");
+      return;
+    }
+
+  m_twoKp = 2.0 * kp;
+  m_twoKi = 2.0 * ki;
+}
+
+void AHRS::update(float gx, float gy, float gz,
+                  float ax, float ay, float az,
+                  float mx, float my, float mz, float dt)
+{
+  if (dt <= 0.0)
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+
+      if (!m_timed)
+        {
+          // nothing to integrate over yet
+          m_lastUpdate = now;
+          m_timed = true;
+          return;
+        }
+
+      dt = float(now.tv_sec - m_lastUpdate.tv_sec) +
+        float(now.tv_nsec - m_lastUpdate.tv_nsec) / 1000000000.0;
+      m_lastUpdate = now;
+
+      if (dt <= 0.0)
+        return;
+    }
+
+  float s[AHRS_SAMPLE_SIZE] = { gx, gy, gz, ax, ay, az, mx, my, mz };
+
+  step(s, 0.5 * dt);
+}
+
+void AHRS::updateBatch(const float *samples, int numSamples, float dt)
+{
+  if (!samples || numSamples <= 0)
+    return;
+
+  if (dt <= 0.0)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": dt must be greater than 0");
+      return;
+    }
+
+  const float halfDt = 0.5 * dt;
+
+  for (int i=0; i<numSamples; i++)
+    step(&samples[i * AHRS_SAMPLE_SIZE], halfDt);
+}
+
+void AHRS::step(const float *s, float halfDt)
+{
+  float q0 = m_q0, q1 = m_q1, q2 = m_q2, q3 = m_q3;
+
+  float gx = s[0] * DEG2RAD;
+  float gy = s[1] * DEG2RAD;
+  float gz = s[2] * DEG2RAD;
+  float ax = s[3], ay = s[4], az = s[5];
+  float mx = s[6], my = s[7], mz = s[8];
+
+  float an = ax * ax + ay * ay + az * az;
+
+  // without a gravity reference (free fall, or no data yet) there is
+  // nothing to correct against, so just integrate the gyroscope
+  if (an > 0.0)
+    {
+      float recip = 1.0 / sqrtf(an);
+      ax *= recip;
+      ay *= recip;
+      az *= recip;
+
+      // estimated direction of gravity (halved)
+      float vx = q1 * q3 - q0 * q2;
+      float vy = q0 * q1 + q2 * q3;
+      float vz = q0 * q0 - 0.5 + q3 * q3;
+
+      // error is the cross product of the measured and estimated
+      // directions
+      float ex = ay * vz - az * vy;
+      float ey = az * vx - ax * vz;
+      float ez = ax * vy - ay * vx;
+
+      float mn = mx * mx + my * my + mz * mz;
+
+      if (mn > 0.0)
+        {
+          recip = 1.0 / sqrtf(mn);
+          mx *= recip;
+          my *= recip;
+          mz *= recip;
+
+          float q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+          float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+          float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+          // rotate the measured field into the earth frame, and
+          // flatten it onto the X (north) and Z axes
+          float hx = 2.0 * (mx * (0.5 - q2q2 - q3q3) + my * (q1q2 - q0q3) +
+                            mz * (q1q3 + q0q2));
+          float hy = 2.0 * (mx * (q1q2 + q0q3) + my * (0.5 - q1q1 - q3q3) +
+                            mz * (q2q3 - q0q1));
+          float bx = sqrtf(hx * hx + hy * hy);
+          float bz = 2.0 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) +
+                            mz * (0.5 - q1q1 - q2q2));
+
+          // estimated direction of the field (halved)
+          float wx = bx * (0.5 - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+          float wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+          float wz = bx * (q0q2 + q1q3) + bz * (0.5 - q1q1 - q2q2);
+
+          ex += my * wz - mz * wy;
+          ey += mz * wx - mx * wz;
+          ez += mx * wy - my * wx;
+        }
+
+      // the integral term accumulates the gyroscope bias
+      if (m_twoKi > 0.0)
+        {
+          float k = m_twoKi * 2.0 * halfDt;
+          m_ix += k * ex;
+          m_iy += k * ey;
+          m_iz += k * ez;
+        }
+
+      gx += m_twoKp * ex;
+      gy += m_twoKp * ey;
+      gz += m_twoKp * ez;
+    }
+
+  gx += m_ix;
+  gy += m_iy;
+  gz += m_iz;
+
+  // integrate the rate of change of the quaternion
+  gx *= halfDt;
+  gy *= halfDt;
+  gz *= halfDt;
+
+  float qa = q0, qb = q1, qc = q2;
+  q0 += -qb * gx - qc * gy - q3 * gz;
+  q1 += qa * gx + qc * gz - q3 * gy;
+  q2 += qa * gy - qb * gz + q3 * gx;
+  q3 += qa * gz + qb * gy - qc * gx;
+
+  float recip = 1.0 / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  m_q0 = q0 * recip;
+  m_q1 = q1 * recip;
+  m_q2 = q2 * recip;
+  m_q3 = q3 * recip;
+
+  m_samples++;
+}
+
+void AHRS::getQuaternion(float *w, float *x, float *y, float *z)
+{
+  if (w)
+    *w = m_q0;
+  if (x)
+    *x = m_q1;
+  if (y)
+    *y = m_q2;
+  if (z)
+    *z = m_q3;
+}
+
+void AHRS::getEulerAngles(float *roll, float *pitch, float *yaw)
+{
+  float q0 = m_q0, q1 = m_q1, q2 = m_q2, q3 = m_q3;
+
+  if (roll)
+    *roll = atan2f(2.0 * (q0 * q1 + q2 * q3),
+                   1.0 - 2.0 * (q1 * q1 + q2 * q2)) * RAD2DEG;
+
+  if (pitch)
+    {
+      float sp = 2.0 * (q0 * q2 - q3 * q1);
+
+      // clamp, rounding can push this just past +/-1 near the poles
+      if (sp > 1.0)
+        sp = 1.0;
+      else if (sp < -1.0)
+        sp = -1.0;
+
+      *pitch = asinf(sp) * RAD2DEG;
+    }
+
+  if (yaw)
+    *yaw = atan2f(2.0 * (q0 * q3 + q1 * q2),
+                  1.0 - 2.0 * (q2 * q2 + q3 * q3)) * RAD2DEG;
+}
+
+void AHRS::getGyroBias(float *x, float *y, float *z)
+{
+  if (x)
+    *x = -m_ix * RAD2DEG;
+  if (y)
+    *y = -m_iy * RAD2DEG;
+  if (z)
+    *z = -m_iz * RAD2DEG;
+}
+
+void AHRS::setGyroBias(float x, float y, float z)
+{
+  m_ix = -x * DEG2RAD;
+  m_iy = -y * DEG2RAD;
+  m_iz = -z * DEG2RAD;
+}
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+float *AHRS::getQuaternion()
+{
+  float *v = new float[4];
+  getQuaternion(&v[0], &v[1], &v[2], &v[3]);
+  return v;
+}
+
+float *AHRS::getEulerAngles()
+{
+  float *v = new float[3];
+  getEulerAngles(&v[0], &v[1], &v[2]);
+  return v;
+}
+
+float *AHRS::getGyroBias()
+{
+  float *v = new float[3];
+  getGyroBias(&v[0], &v[1], &v[2]);
+  return v;
+}
+#endif
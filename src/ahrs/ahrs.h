@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <time.h>
+
+// Default proportional and integral feedback gains
+#define AHRS_DEFAULT_KP 1.0
+#define AHRS_DEFAULT_KI 0.05
+
+// Number of floats per sample passed to updateBatch(): gyroscope X,
+// Y, Z, accelerometer X, Y, Z and magnetometer X, Y, Z
+#define AHRS_SAMPLE_SIZE 9
+
+namespace upm {
+
+  /**
+   * @library ahrs
+   * @brief Attitude and heading reference system (sensor fusion)
+   *
+   * AHRS fuses gyroscope, accelerometer and (optionally)
+   * magnetometer samples into an orientation quaternion, using a
+   * Mahony style complementary filter.  The gyroscope rates are
+   * integrated, while the error between the measured and estimated
+   * directions of gravity and of the earth's magnetic field is fed
+   * back through a proportional (Kp) and an integral (Ki) term.  The
+   * integral term converges to the gyroscope zero rate offset, so the
+   * filter also provides an online estimate of the gyroscope bias,
+   * see getGyroBias().
+   *
+   * Gyroscope rates are in degrees per second.  Accelerometer and
+   * magnetometer values only need to be consistent in scale between
+   * calls (g or m/s^2, gauss or uT), since only their direction is
+   * used.  All three vectors must be in the same (right handed) axis
+   * frame.  If the magnetometer vector is zero, only roll and pitch
+   * are corrected, and the yaw is purely integrated.
+   *
+   * The LSM9DS0 and MPU9150 drivers can run a filter directly from
+   * their update() method; see their enableFusion() methods.  When
+   * samples are read from a FIFO, updateBatch() processes them all in
+   * a single call.
+   */
+  class AHRS {
+  public:
+
+    /**
+     * AHRS constructor
+     *
+     * @param kp proportional gain.  Higher values trust the
+     * accelerometer and magnetometer more, and the gyroscope less.
+     * @param ki integral gain, controlling how fast the gyroscope bias
+     * estimate converges.  0 disables bias estimation.
+     */
+    AHRS(float kp=AHRS_DEFAULT_KP, float ki=AHRS_DEFAULT_KI);
+
+    /**
+     * AHRS destructor
+     */
+    ~AHRS();
+
+    /**
+     * reset the orientation to the identity quaternion, and clear the
+     * gyroscope bias estimate
+     */
+    void reset();
+
+    /**
+     * set the feedback gains
+     *
+     * @param kp proportional gain
+     * @param ki integral gain, 0 to disable bias estimation
+     */
+    void setGains(float kp, float ki);
+
+    /**
+     * process one sample.  Gyroscope values are in degrees per
+     * second.
+     *
+     * @param gx gyroscope X axis
+     * @param gy gyroscope Y axis
+     * @param gz gyroscope Z axis
+     * @param ax accelerometer X axis
+     * @param ay accelerometer Y axis
+     * @param az accelerometer Z axis
+     * @param mx magnetometer X axis
+     * @param my magnetometer Y axis
+     * @param mz magnetometer Z axis
+     * @param dt time since the previous sample, in seconds.  If 0,
+     * the time elapsed since the previous call is measured on the
+     * monotonic clock (the first such call only initializes the
+     * timer).
+     */
+    void update(float gx, float gy, float gz,
+                float ax, float ay, float az,
+                float mx, float my, float mz, float dt=0.0);
+
+    /**
+     * process a batch of samples taken at a fixed rate, such as the
+     * contents of a sensor FIFO.  Each sample consists of
+     * AHRS_SAMPLE_SIZE floats, in the same order as the arguments to
+     * update().
+     *
+     * @param samples pointer to numSamples * AHRS_SAMPLE_SIZE floats
+     * @param numSamples number of samples
+     * @param dt sample period, in seconds
+     */
+    void updateBatch(const float *samples, int numSamples, float dt);
+
+    /**
+     * return the current orientation quaternion
+     *
+     * @param w pointer to returned W (scalar) component
+     * @param x pointer to returned X component
+     * @param y pointer to returned Y component
+     * @param z pointer to returned Z component
+     */
+    void getQuaternion(float *w, float *x, float *y, float *z);
+
+    /**
+     * return the current orientation as roll (about X), pitch (about
+     * Y) and yaw (about Z), in degrees
+     *
+     * @param roll pointer to returned roll
+     * @param pitch pointer to returned pitch
+     * @param yaw pointer to returned yaw
+     */
+    void getEulerAngles(float *roll, float *pitch, float *yaw);
+
+    /**
+     * return the current gyroscope bias estimate, in degrees per
+     * second.  This value is subtracted from the gyroscope rates.
+     *
+     * @param x pointer to returned X axis bias
+     * @param y pointer to returned Y axis bias
+     * @param z pointer to returned Z axis bias
+     */
+    void getGyroBias(float *x, float *y, float *z);
+
+    /**
+     * seed the gyroscope bias estimate, such as with the result of a
+     * previous run or a calibration
+     *
+     * @param x X axis bias in degrees per second
+     * @param y Y axis bias in degrees per second
+     * @param z Z axis bias in degrees per second
+     */
+    void setGyroBias(float x, float y, float z);
+
+    /**
+     * return the number of samples processed since construction or
+     * the last reset()
+     *
+     * @return number of samples
+     */
+    unsigned int getSampleCount() { return m_samples; };
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+    /**
+     * return the current orientation quaternion
+     *
+     * @return array containing W, X, Y and Z
+     */
+    float *getQuaternion();
+
+    /**
+     * return the current orientation as roll, pitch and yaw, in
+     * degrees
+     *
+     * @return array containing roll, pitch and yaw
+     */
+    float *getEulerAngles();
+
+    /**
+     * return the current gyroscope bias estimate, in degrees per
+     * second
+     *
+     * @return array containing X, Y and Z
+     */
+    float *getGyroBias();
+#endif
+
+  protected:
+    void step(const float *s, float halfDt);
+
+  private:
+    // orientation quaternion
+    float m_q0, m_q1, m_q2, m_q3;
+
+    // integral feedback, in rad/s (the negated bias)
+    float m_ix, m_iy, m_iz;
+
+    float m_twoKp;
+    float m_twoKi;
+
+    unsigned int m_samples;
+
+    bool m_timed;
+    struct timespec m_lastUpdate;
+  };
+}
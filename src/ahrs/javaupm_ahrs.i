@@ -0,0 +1,66 @@
+%module javaupm_ahrs
+%include "../upm.i"
+%include "typemaps.i"
+
+%typemap(jni) float* "jfloatArray"
+%typemap(jstype) float* "float[]"
+%typemap(jtype) float* "float[]"
+
+%typemap(javaout) float* {
+    return $jnicall;
+}
+
+%typemap(out) float *getQuaternion {
+    $result = JCALL1(NewFloatArray, jenv, 4);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 4, $1);
+    delete [] $1;
+}
+
+%typemap(out) float *getEulerAngles {
+    $result = JCALL1(NewFloatArray, jenv, 3);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 3, $1);
+    delete [] $1;
+}
+
+%typemap(out) float *getGyroBias {
+    $result = JCALL1(NewFloatArray, jenv, 3);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 3, $1);
+    delete [] $1;
+}
+
+// samples are passed as a float[] of numSamples * AHRS_SAMPLE_SIZE
+%typemap(jni) (const float *samples, int numSamples) "jfloatArray";
+%typemap(jtype) (const float *samples, int numSamples) "float[]";
+%typemap(jstype) (const float *samples, int numSamples) "float[]";
+
+%typemap(javain) (const float *samples, int numSamples) "$javainput";
+
+%typemap(in) (const float *samples, int numSamples) {
+        $1 = (float *) JCALL2(GetFloatArrayElements, jenv, $input, NULL);
+        $2 = JCALL1(GetArrayLength, jenv, $input) / AHRS_SAMPLE_SIZE;
+}
+
+%typemap(freearg) (const float *samples, int numSamples) {
+        JCALL3(ReleaseFloatArrayElements, jenv, $input, (jfloat *)$1, JNI_ABORT);
+}
+
+%ignore getQuaternion(float *, float *, float *, float *);
+%ignore getEulerAngles(float *, float *, float *);
+%ignore getGyroBias(float *, float *, float *);
+
+%{
+    #include "ahrs.h"
+%}
+
+%include "ahrs.h"
+
+%pragma(java) jniclasscode=%{
+    static {
+        try {
+            System.loadLibrary("javaupm_ahrs");
+        } catch (UnsatisfiedLinkError e) {
+            System.err.println("Native code library failed to load. \n" + e);
+            System.exit(1);
+        }
+    }
+%}
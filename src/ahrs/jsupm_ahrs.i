@@ -0,0 +1,11 @@
+%module jsupm_ahrs
+%include "../upm.i"
+%include "cpointer.i"
+%include "../carrays_float.i"
+
+%pointer_functions(float, floatp);
+
+%include "ahrs.h"
+%{
+    #include "ahrs.h"
+%}
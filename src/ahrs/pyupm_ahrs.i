@@ -0,0 +1,15 @@
+// Include doxygen-generated documentation
+%include "pyupm_doxy2swig.i"
+%module pyupm_ahrs
+%include "../upm.i"
+%include "cpointer.i"
+%include "../carrays_float.i"
+
+%feature("autodoc", "3");
+
+%pointer_functions(float, floatp);
+
+%include "ahrs.h"
+%{
+    #include "ahrs.h"
+%}
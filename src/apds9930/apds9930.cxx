@@ -25,11 +25,44 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
 
 #include "apds9930.h"
 
+// recent mraa/iio.h carry a copy of the kernel's IIO types and event
+// ioctl, which the kernel header would redefine
+#ifndef IIO_GET_EVENT_FD_IOCTL
+#include <linux/iio/types.h>
+#define IIO_GET_EVENT_FD_IOCTL _IOR('i', 0x90, int)
+#endif
+
 using namespace upm;
 
+static int openAttr(int device, const char* attr)
+{
+    char path[64];
+
+    snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d/%s",
+             device, attr);
+
+    return open(path, O_RDONLY);
+}
+
+static bool hasAttr(int device, const char* attr)
+{
+    char path[96];
+
+    snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d/%s",
+             device, attr);
+
+    return (access(path, F_OK) == 0);
+}
+
 APDS9930::APDS9930(int device)
 {
     if (!(m_iio = mraa_iio_init(device))) {
@@ -37,25 +70,283 @@ APDS9930::APDS9930(int device)
                                     ": mraa_iio_init() failed, invalid device?");
         return;
     }
+
+    m_iio_device_num = device;
+
+    // if these fail, readings go through mraa_iio_read_int() instead
+    m_ambientFd = openAttr(device, "in_illuminance_input");
+    m_proximityFd = openAttr(device, "in_proximity_raw");
+
+    // Drivers raising the ALS threshold events on IIO_INTENSITY name
+    // their attributes after that channel, others use in_illuminance
+    if (hasAttr(device, "events/in_intensity0_thresh_rising_value"))
+        m_ambientEvents = "in_intensity0";
+    else
+        m_ambientEvents = "in_illuminance";
+
+    m_eventFd = -1;
+    m_eventRun = false;
+    m_eventRunning = false;
+
+    m_eventHead = 0;
+    m_eventCount = 0;
+    m_event.chan = CHAN_PROXIMITY;
+    m_event.dir = DIR_EITHER;
+
+    m_callback = 0;
+    m_callbackArg = 0;
+
+    pthread_mutex_init(&m_lock, NULL);
 }
 
 APDS9930::~APDS9930()
 {
+    enableEvents(false);
+
+    if (m_ambientFd >= 0)
+        close(m_ambientFd);
+    if (m_proximityFd >= 0)
+        close(m_proximityFd);
+
+    pthread_mutex_destroy(&m_lock);
     // mraa_iio_stop(m_iio);
 }
 
 int
-APDS9930::getAmbient()
+APDS9930::readAttr(int fd, const char* attr)
 {
     int iio_value = 0;
-    mraa_iio_read_int(m_iio, "in_illuminance_input", &iio_value);
-    return iio_value;
+
+    if (fd < 0) {
+        mraa_iio_read_int(m_iio, attr, &iio_value);
+        return iio_value;
+    }
+
+    // sysfs regenerates the value on every read from offset 0
+    char buf[16];
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+
+    if (len <= 0) {
+        mraa_iio_read_int(m_iio, attr, &iio_value);
+        return iio_value;
+    }
+
+    buf[len] = 0;
+    return (int) strtol(buf, NULL, 10);
+}
+
+int
+APDS9930::getAmbient()
+{
+    return readAttr(m_ambientFd, "in_illuminance_input");
 }
 
 int
 APDS9930::getProximity()
 {
-    int iio_value = 0;
-    mraa_iio_read_int(m_iio, "in_proximity_raw", &iio_value);
-    return iio_value;
+    return readAttr(m_proximityFd, "in_proximity_raw");
+}
+
+bool
+APDS9930::writeThresholds(const char* chan, int low, int high)
+{
+    std::string prefix = std::string("events/") + chan + "_thresh_";
+
+    if (mraa_iio_write_int(m_iio, (prefix + "falling_value").c_str(), low)
+        != MRAA_SUCCESS)
+        return false;
+    if (mraa_iio_write_int(m_iio, (prefix + "rising_value").c_str(), high)
+        != MRAA_SUCCESS)
+        return false;
+
+    // drivers expose either a combined enable, or one per direction
+    if (mraa_iio_write_int(m_iio, (prefix + "either_en").c_str(), 1)
+        == MRAA_SUCCESS)
+        return true;
+
+    return (mraa_iio_write_int(m_iio, (prefix + "rising_en").c_str(), 1)
+            == MRAA_SUCCESS &&
+            mraa_iio_write_int(m_iio, (prefix + "falling_en").c_str(), 1)
+            == MRAA_SUCCESS);
+}
+
+bool
+APDS9930::setProximityThresholds(int low, int high)
+{
+    return writeThresholds("in_proximity", low, high);
+}
+
+bool
+APDS9930::setAmbientThresholds(int low, int high)
+{
+    return writeThresholds(m_ambientEvents.c_str(), low, high);
+}
+
+bool
+APDS9930::disableThresholds(CHANNEL_T chan)
+{
+    std::string prefix = std::string("events/") +
+        ((chan == CHAN_PROXIMITY) ? std::string("in_proximity")
+                                  : m_ambientEvents) +
+        "_thresh_";
+
+    if (mraa_iio_write_int(m_iio, (prefix + "either_en").c_str(), 0)
+        == MRAA_SUCCESS)
+        return true;
+
+    return (mraa_iio_write_int(m_iio, (prefix + "rising_en").c_str(), 0)
+            == MRAA_SUCCESS &&
+            mraa_iio_write_int(m_iio, (prefix + "falling_en").c_str(), 0)
+            == MRAA_SUCCESS);
+}
+
+void
+APDS9930::enableEvents(bool enable)
+{
+    if (!enable) {
+        if (!m_eventRunning)
+            return;
+
+        m_eventRun = false;
+        pthread_join(m_eventThread, NULL);
+
+        close(m_eventFd);
+        m_eventFd = -1;
+        m_eventRunning = false;
+        return;
+    }
+
+    if (m_eventRunning)
+        return;
+
+    char path[32];
+    snprintf(path, sizeof(path), "/dev/iio:device%d", m_iio_device_num);
+
+    int devFd = open(path, O_RDONLY);
+    if (devFd < 0) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": unable to open " + path);
+        return;
+    }
+
+    int rv = ioctl(devFd, IIO_GET_EVENT_FD_IOCTL, &m_eventFd);
+    // the event fd stays valid without the device fd
+    close(devFd);
+
+    if (rv < 0 || m_eventFd < 0) {
+        m_eventFd = -1;
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": unable to get the IIO event fd");
+        return;
+    }
+
+    m_eventRun = true;
+    if (pthread_create(&m_eventThread, NULL, eventThread, this)) {
+        m_eventRun = false;
+        close(m_eventFd);
+        m_eventFd = -1;
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": pthread_create() failed");
+        return;
+    }
+
+    m_eventRunning = true;
+}
+
+void
+APDS9930::handleEvent(struct iio_event_data* data)
+{
+    int chan_type, modifier, type, direction, channel, channel2, different;
+
+    if (mraa_iio_event_extract_event(data, &chan_type, &modifier, &type,
+                                     &direction, &channel, &channel2,
+                                     &different) != MRAA_SUCCESS)
+        return;
+
+    EVENT_T ev;
+
+    if (chan_type == IIO_PROXIMITY)
+        ev.chan = CHAN_PROXIMITY;
+    else if (chan_type == IIO_LIGHT ||
+             chan_type == IIO_INTENSITY)
+        ev.chan = CHAN_AMBIENT;
+    else
+        return;
+
+    if (direction == IIO_EV_DIR_RISING)
+        ev.dir = DIR_RISING;
+    else if (direction == IIO_EV_DIR_FALLING)
+        ev.dir = DIR_FALLING;
+    else
+        ev.dir = DIR_EITHER;
+
+    pthread_mutex_lock(&m_lock);
+
+    int idx = (m_eventHead + m_eventCount) % APDS9930_MAX_EVENTS;
+    m_events[idx] = ev;
+    if (m_eventCount < APDS9930_MAX_EVENTS)
+        m_eventCount++;
+    else
+        // overwrote the oldest event
+        m_eventHead = (m_eventHead + 1) % APDS9930_MAX_EVENTS;
+
+    EVENT_CALLBACK_T func = m_callback;
+    void* arg = m_callbackArg;
+
+    pthread_mutex_unlock(&m_lock);
+
+    if (func)
+        func(ev.chan, ev.dir, data->timestamp, arg);
+}
+
+void*
+APDS9930::eventThread(void* ctx)
+{
+    upm::APDS9930* This = (upm::APDS9930*) ctx;
+    struct pollfd pfd;
+
+    pfd.fd = This->m_eventFd;
+    pfd.events = POLLIN;
+
+    while (This->m_eventRun) {
+        // wake up periodically to notice a stop request
+        if (poll(&pfd, 1, APDS9930_EVENT_POLL_MS) <= 0)
+            continue;
+
+        struct iio_event_data data;
+        if (read(This->m_eventFd, &data, sizeof(data)) == sizeof(data))
+            This->handleEvent(&data);
+    }
+
+    return 0;
+}
+
+bool
+APDS9930::getNextEvent()
+{
+    pthread_mutex_lock(&m_lock);
+
+    if (!m_eventCount) {
+        pthread_mutex_unlock(&m_lock);
+        return false;
+    }
+
+    m_event = m_events[m_eventHead];
+    m_eventHead = (m_eventHead + 1) % APDS9930_MAX_EVENTS;
+    m_eventCount--;
+
+    pthread_mutex_unlock(&m_lock);
+
+    return true;
+}
+
+void
+APDS9930::setEventCallback(EVENT_CALLBACK_T func, void* arg)
+{
+    pthread_mutex_lock(&m_lock);
+
+    m_callback = func;
+    m_callbackArg = arg;
+
+    pthread_mutex_unlock(&m_lock);
 }
@@ -24,8 +24,17 @@
 #pragma once
 
 #include <string>
+#include <stdint.h>
+#include <pthread.h>
 #include <mraa/iio.h>
 
+// Maximum number of threshold events queued for getNextEvent()
+#define APDS9930_MAX_EVENTS 16
+
+// Interval at which the event thread checks for a stop request, in
+// milliseconds
+#define APDS9930_EVENT_POLL_MS 100
+
 namespace upm
 {
 /**
@@ -47,12 +56,47 @@ namespace upm
  * This sensor provides digital ambient light sensing (ALS),
  * IR LED and a complete proximity detection system.
  *
+ * The sysfs attributes of both channels are opened once, and each
+ * reading is a single pread() of the open file, rather than an
+ * open, read and close of the attribute every time.
+ *
+ * Instead of polling getProximity(), the driver can program the
+ * sensor's interrupt thresholds and wait for the threshold events
+ * on the IIO event file descriptor.  The events are read by a
+ * thread that sleeps in poll() while nothing happens, and are
+ * delivered to a callback, or queued for getNextEvent().
+ *
  * @snippet apds9930.cxx Interesting
  */
 
 class APDS9930
 {
   public:
+    /**
+     * Event channels
+     */
+    typedef enum {
+        CHAN_AMBIENT   = 0,
+        CHAN_PROXIMITY = 1
+    } CHANNEL_T;
+
+    /**
+     * Event directions.  DIR_EITHER is reported by kernel drivers
+     * that do not tell which threshold was crossed.
+     */
+    typedef enum {
+        DIR_EITHER  = 0,
+        DIR_RISING  = 1,
+        DIR_FALLING = 2
+    } DIRECTION_T;
+
+    /**
+     * Event callback.  timestamp is the kernel's timestamp of the
+     * event in nanoseconds.
+     */
+    typedef void (*EVENT_CALLBACK_T)(CHANNEL_T chan, DIRECTION_T dir,
+                                     int64_t timestamp, void* arg);
+
     /**
      * APDS-9930 digital proximity and ambient light sensor constructor
      *
@@ -75,8 +119,102 @@ class APDS9930
      * @return Proximity value
      */
     int getProximity();
+    /**
+     * Programs the proximity interrupt thresholds and enables the
+     * proximity threshold events.  An event is reported when the
+     * proximity value rises above high or falls below low.
+     *
+     * @param low Falling threshold
+     * @param high Rising threshold
+     * @return true if successful
+     */
+    bool setProximityThresholds(int low, int high);
+    /**
+     * Programs the ambient light interrupt thresholds and enables the
+     * ambient light threshold events
+     *
+     * @param low Falling threshold
+     * @param high Rising threshold
+     * @return true if successful
+     */
+    bool setAmbientThresholds(int low, int high);
+    /**
+     * Disables the threshold events of a channel
+     *
+     * @param chan One of the CHANNEL_T values
+     * @return true if successful
+     */
+    bool disableThresholds(CHANNEL_T chan);
+    /**
+     * Starts or stops the thread reading the IIO event file
+     * descriptor.  Events are only delivered while it runs.
+     *
+     * @param enable true to start, false to stop
+     */
+    void enableEvents(bool enable);
+    /**
+     * Makes the oldest queued event the current one, and removes it
+     * from the queue.  When the queue overflows, the oldest events
+     * are dropped.
+     *
+     * @return true if an event was available, false otherwise
+     */
+    bool getNextEvent();
+    /**
+     * Gets the channel of the current event
+     *
+     * @return One of the CHANNEL_T values
+     */
+    CHANNEL_T getEventChannel() { return m_event.chan; };
+    /**
+     * Gets the direction of the current event
+     *
+     * @return One of the DIRECTION_T values
+     */
+    DIRECTION_T getEventDirection() { return m_event.dir; };
+    /**
+     * Installs a function to be called for each threshold event, from
+     * the event thread.  It should return quickly.
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setEventCallback(EVENT_CALLBACK_T func, void* arg);
 
   private:
+    typedef struct {
+        CHANNEL_T chan;
+        DIRECTION_T dir;
+    } EVENT_T;
+
+    int readAttr(int fd, const char* attr);
+    bool writeThresholds(const char* chan, int low, int high);
+    void handleEvent(struct iio_event_data* data);
+    static void* eventThread(void* ctx);
+
     mraa_iio_context m_iio;
+    int m_iio_device_num;
+
+    // open sysfs attributes, -1 if they could not be opened
+    int m_ambientFd;
+    int m_proximityFd;
+
+    // attribute prefix of the ambient light threshold events
+    std::string m_ambientEvents;
+
+    int m_eventFd;
+    volatile bool m_eventRun;
+    bool m_eventRunning;
+    pthread_t m_eventThread;
+
+    EVENT_T m_events[APDS9930_MAX_EVENTS];
+    int m_eventHead;
+    int m_eventCount;
+    EVENT_T m_event;
+
+    EVENT_CALLBACK_T m_callback;
+    void* m_callbackArg;
+
+    pthread_mutex_t m_lock;
 };
 }
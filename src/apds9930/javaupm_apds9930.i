@@ -1,6 +1,9 @@
 %module javaupm_apds9930
 %include "../upm.i"
 
+// Java users should poll getNextEvent() instead
+%ignore setEventCallback;
+
 %{
     #include "apds9930.h"
 %}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <time.h>
+#include <iostream>
+
+#include "edgerate.h"
+
+using namespace upm;
+using namespace std;
+
+EdgeRate::EdgeRate()
+{
+  pthread_mutex_init(&m_lock, NULL);
+
+  m_callback = 0;
+  m_callbackArg = 0;
+
+  reset();
+}
+
+EdgeRate::~EdgeRate()
+{
+  pthread_mutex_destroy(&m_lock);
+}
+
+uint64_t EdgeRate::now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t(ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+uint32_t EdgeRate::elapsedMillis(uint64_t start)
+{
+  uint32_t elapse = uint32_t((now() - start) / 1000);
+
+  // never return 0
+  if (elapse == 0)
+    elapse = 1;
+
+  return elapse;
+}
+
+void EdgeRate::edge()
+{
+  uint64_t ts = now();
+
+  pthread_mutex_lock(&m_lock);
+
+  m_edges[m_head] = ts;
+  m_head = (m_head + 1) % EDGERATE_MAX_EDGES;
+  m_count++;
+
+  EDGE_CALLBACK_T func = m_callback;
+  void *arg = m_callbackArg;
+
+  pthread_mutex_unlock(&m_lock);
+
+  if (func)
+    func(ts, arg);
+}
+
+void EdgeRate::reset()
+{
+  pthread_mutex_lock(&m_lock);
+
+  m_head = 0;
+  m_count = 0;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+uint32_t EdgeRate::edgeCount()
+{
+  pthread_mutex_lock(&m_lock);
+  uint32_t count = m_count;
+  pthread_mutex_unlock(&m_lock);
+
+  return count;
+}
+
+float EdgeRate::instantRate()
+{
+  uint64_t last, prev;
+
+  pthread_mutex_lock(&m_lock);
+
+  if (m_count < 2)
+    {
+      pthread_mutex_unlock(&m_lock);
+      return 0.0;
+    }
+
+  last = m_edges[(m_head + EDGERATE_MAX_EDGES - 1) % EDGERATE_MAX_EDGES];
+  prev = m_edges[(m_head + EDGERATE_MAX_EDGES - 2) % EDGERATE_MAX_EDGES];
+
+  pthread_mutex_unlock(&m_lock);
+
+  uint64_t interval = last - prev;
+  uint64_t since = now() - last;
+
+  // no edge for longer than the last period, so the rate has
+  // dropped at least this far
+  if (since > interval)
+    interval = since;
+
+  if (interval == 0)
+    return 0.0;
+
+  return 1000000.0 / float(interval);
+}
+
+float EdgeRate::windowRate(uint32_t windowMs)
+{
+  uint64_t start = now() - (uint64_t(windowMs) * 1000);
+
+  pthread_mutex_lock(&m_lock);
+
+  int stored = (m_count < uint32_t(EDGERATE_MAX_EDGES)) ?
+    int(m_count) : EDGERATE_MAX_EDGES;
+  int newest = (m_head + EDGERATE_MAX_EDGES - 1) % EDGERATE_MAX_EDGES;
+
+  // walk back from the newest edge to the oldest one in the window
+  int n = 0;
+  int oldest = newest;
+  while (n < stored)
+    {
+      int idx = (newest + EDGERATE_MAX_EDGES - n) % EDGERATE_MAX_EDGES;
+
+      if (m_edges[idx] < start)
+        break;
+
+      oldest = idx;
+      n++;
+    }
+
+  uint64_t span = m_edges[newest] - m_edges[oldest];
+
+  pthread_mutex_unlock(&m_lock);
+
+  if (n < 2 || span == 0)
+    return 0.0;
+
+  return (float(n - 1) * 1000000.0) / float(span);
+}
+
+void EdgeRate::setCallback(EDGE_CALLBACK_T func, void *arg)
+{
+  pthread_mutex_lock(&m_lock);
+
+  m_callback = func;
+  m_callbackArg = arg;
+
+  pthread_mutex_unlock(&m_lock);
+}
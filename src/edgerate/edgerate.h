@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+
+// Number of edge timestamps kept for windowed rates
+#define EDGERATE_MAX_EDGES 512
+
+namespace upm {
+
+  /**
+   * @library edgerate
+   * @brief Edge timestamping and rate estimation for counting drivers
+   *
+   * EdgeRate is used by drivers that count pulses on a GPIO
+   * interrupt (heart beats, wheel ticks, flow meter pulses).  Each
+   * call to edge(), normally made from the driver's ISR, records a
+   * timestamp taken on the monotonic clock in a ring buffer of the
+   * last EDGERATE_MAX_EDGES edges.
+   *
+   * From these timestamps, instantRate() returns the rate given by
+   * the most recent interval between two edges, so it reacts within
+   * one period.  windowRate() averages the intervals that fall in a
+   * sliding window of a given length, limited by the stored history.
+   * Both return edges per second.
+   *
+   * An optional callback is run for every edge, from the ISR thread.
+   *
+   * The static now() and elapsedMillis() methods provide the
+   * monotonic clock used by the drivers' millisecond counters.
+   */
+  class EdgeRate {
+  public:
+
+    /**
+     * Edge callback.  timestamp is the time of the edge in
+     * microseconds on the monotonic clock (see now()).
+     */
+    typedef void (*EDGE_CALLBACK_T)(uint64_t timestamp, void *arg);
+
+    /**
+     * EdgeRate constructor
+     */
+    EdgeRate();
+
+    /**
+     * EdgeRate destructor
+     */
+    ~EdgeRate();
+
+    /**
+     * record an edge.  This is meant to be called from an ISR.
+     */
+    void edge();
+
+    /**
+     * discard all recorded edges
+     */
+    void reset();
+
+    /**
+     * return the number of edges recorded since construction or the
+     * last reset()
+     *
+     * @return number of edges
+     */
+    uint32_t edgeCount();
+
+    /**
+     * return the rate from the interval between the last two edges.
+     * When the time since the last edge already exceeds that
+     * interval, the rate is computed from the time since the last
+     * edge instead, so the rate decays toward 0 once edges stop
+     * arriving.
+     *
+     * @return edges per second, 0 if fewer than 2 edges were recorded
+     */
+    float instantRate();
+
+    /**
+     * return the average rate over the edges of the last windowMs
+     * milliseconds.  If more edges arrived in that time than are
+     * kept, the average is taken over the stored ones.
+     *
+     * @param windowMs length of the window in milliseconds
+     * @return edges per second, 0 if fewer than 2 edges fall into the
+     * window
+     */
+    float windowRate(uint32_t windowMs);
+
+    /**
+     * install a function to be called on every edge, from the ISR
+     * thread.  It should return quickly.
+     *
+     * @param func the function to call, or NULL to remove it
+     * @param arg argument passed to func
+     */
+    void setCallback(EDGE_CALLBACK_T func, void *arg);
+
+    /**
+     * return the current time on the monotonic clock
+     *
+     * @return microseconds
+     */
+    static uint64_t now();
+
+    /**
+     * return the milliseconds elapsed since a timestamp returned by
+     * now(), never 0
+     *
+     * @param start the starting timestamp
+     * @return elapsed milliseconds
+     */
+    static uint32_t elapsedMillis(uint64_t start);
+
+  private:
+    uint64_t m_edges[EDGERATE_MAX_EDGES];
+    // index of the next slot to fill
+    int m_head;
+    uint32_t m_count;
+
+    EDGE_CALLBACK_T m_callback;
+    void *m_callbackArg;
+
+    pthread_mutex_t m_lock;
+  };
+}
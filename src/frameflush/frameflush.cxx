@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <string>
+
+#include "frameflush.h"
+
+using namespace upm;
+using namespace std;
+
+FrameFlush::FrameFlush(int frameBytes, FLUSH_FUNC_T func, void *ctx)
+{
+  m_frameBytes = frameBytes;
+  m_func = func;
+  m_ctx = ctx;
+
+  m_buffers[0] = 0;
+  m_buffers[1] = 0;
+  m_back = 0;
+  m_pending = false;
+
+  m_running = false;
+  m_run = false;
+
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_work, NULL);
+  pthread_cond_init(&m_done, NULL);
+
+  m_period = 0;
+  m_lastFlush = 0;
+  m_lastSwap = 0;
+
+  m_frameTime = 0;
+  m_flushTime = 0;
+  m_waitTime = 0;
+  m_frames = 0;
+  m_errors = 0;
+}
+
+FrameFlush::~FrameFlush()
+{
+  stop();
+
+  pthread_cond_destroy(&m_done);
+  pthread_cond_destroy(&m_work);
+  pthread_mutex_destroy(&m_lock);
+}
+
+uint64_t FrameFlush::now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t(ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+uint8_t *FrameFlush::start(const uint8_t *initial)
+{
+  if (m_running)
+    return m_buffers[m_back];
+
+  for (int i = 0; i < 2; i++)
+    {
+      if (!(m_buffers[i] = (uint8_t *)malloc(m_frameBytes)))
+        {
+          free(m_buffers[0]);
+          m_buffers[0] = 0;
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": frame buffer allocation failed");
+          return 0;
+        }
+    }
+
+  if (initial)
+    memcpy(m_buffers[0], initial, m_frameBytes);
+  else
+    memset(m_buffers[0], 0, m_frameBytes);
+
+  m_back = 0;
+  m_pending = false;
+  m_run = true;
+
+  if (pthread_create(&m_thread, NULL, flushThread, this))
+    {
+      m_run = false;
+      free(m_buffers[0]);
+      free(m_buffers[1]);
+      m_buffers[0] = m_buffers[1] = 0;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+      return 0;
+    }
+
+  m_running = true;
+  return m_buffers[m_back];
+}
+
+void FrameFlush::stop(uint8_t *final)
+{
+  if (!m_running)
+    return;
+
+  waitIdle();
+
+  pthread_mutex_lock(&m_lock);
+  m_run = false;
+  pthread_cond_signal(&m_work);
+  pthread_mutex_unlock(&m_lock);
+
+  pthread_join(m_thread, NULL);
+
+  if (final)
+    memcpy(final, m_buffers[m_back], m_frameBytes);
+
+  free(m_buffers[0]);
+  free(m_buffers[1]);
+  m_buffers[0] = m_buffers[1] = 0;
+
+  m_running = false;
+}
+
+void FrameFlush::flush(const uint8_t *frame)
+{
+  uint64_t start = now();
+  bool failed = false;
+
+  try
+    {
+      m_func(frame, m_ctx);
+    }
+  catch (...)
+    {
+      failed = true;
+    }
+
+  uint64_t end = now();
+
+  pthread_mutex_lock(&m_lock);
+  if (failed)
+    m_errors++;
+  m_flushTime = end - start;
+  m_lastFlush = start;
+  m_frames++;
+  pthread_mutex_unlock(&m_lock);
+}
+
+uint8_t *FrameFlush::swapBuffers(bool preserve)
+{
+  if (!m_running)
+    {
+      throw std::logic_error(std::string(__FUNCTION__) +
+                             ": not started");
+      return 0;
+    }
+
+  uint64_t start = now();
+
+  pthread_mutex_lock(&m_lock);
+
+  // the other buffer is still owned by the flush thread
+  while (m_pending)
+    pthread_cond_wait(&m_done, &m_lock);
+
+  uint64_t ready = now();
+
+  int front = m_back;
+  m_back ^= 1;
+  m_pending = true;
+
+  if (m_lastSwap)
+    m_frameTime = start - m_lastSwap;
+  m_lastSwap = start;
+  m_waitTime = ready - start;
+
+  pthread_cond_signal(&m_work);
+  pthread_mutex_unlock(&m_lock);
+
+  // the flush thread only reads the front buffer, so copying from it
+  // while it is being sent is safe
+  if (preserve)
+    memcpy(m_buffers[m_back], m_buffers[front], m_frameBytes);
+
+  return m_buffers[m_back];
+}
+
+void FrameFlush::waitIdle()
+{
+  pthread_mutex_lock(&m_lock);
+
+  while (m_pending)
+    pthread_cond_wait(&m_done, &m_lock);
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void *FrameFlush::flushThread(void *ctx)
+{
+  upm::FrameFlush *This = (upm::FrameFlush *)ctx;
+
+  pthread_mutex_lock(&This->m_lock);
+
+  while (true)
+    {
+      while (This->m_run && !This->m_pending)
+        pthread_cond_wait(&This->m_work, &This->m_lock);
+
+      if (!This->m_pending)
+        break;
+
+      const uint8_t *frame = This->m_buffers[This->m_back ^ 1];
+      uint64_t next = This->m_lastFlush + This->m_period;
+
+      pthread_mutex_unlock(&This->m_lock);
+
+      // hold the frame back until the frame rate allows it
+      uint64_t current = now();
+      if (This->m_period && This->m_lastFlush && current < next)
+        usleep(next - current);
+
+      This->flush(frame);
+
+      pthread_mutex_lock(&This->m_lock);
+      This->m_pending = false;
+      pthread_cond_broadcast(&This->m_done);
+    }
+
+  pthread_mutex_unlock(&This->m_lock);
+
+  return 0;
+}
+
+void FrameFlush::setFrameRate(float fps)
+{
+  pthread_mutex_lock(&m_lock);
+  m_period = (fps > 0.0) ? uint64_t(1000000.0 / fps) : 0;
+  pthread_mutex_unlock(&m_lock);
+}
+
+float FrameFlush::getFrameTime()
+{
+  pthread_mutex_lock(&m_lock);
+  float ms = float(m_frameTime) / 1000.0;
+  pthread_mutex_unlock(&m_lock);
+
+  return ms;
+}
+
+float FrameFlush::getFlushTime()
+{
+  pthread_mutex_lock(&m_lock);
+  float ms = float(m_flushTime) / 1000.0;
+  pthread_mutex_unlock(&m_lock);
+
+  return ms;
+}
+
+float FrameFlush::getWaitTime()
+{
+  pthread_mutex_lock(&m_lock);
+  float ms = float(m_waitTime) / 1000.0;
+  pthread_mutex_unlock(&m_lock);
+
+  return ms;
+}
+
+uint32_t FrameFlush::getFrameCount()
+{
+  pthread_mutex_lock(&m_lock);
+  uint32_t frames = m_frames;
+  pthread_mutex_unlock(&m_lock);
+
+  return frames;
+}
+
+uint32_t FrameFlush::getErrors()
+{
+  pthread_mutex_lock(&m_lock);
+  uint32_t errors = m_errors;
+  pthread_mutex_unlock(&m_lock);
+
+  return errors;
+}
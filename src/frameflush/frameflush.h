@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+
+namespace upm {
+
+  /**
+   * @library frameflush
+   * @brief Double buffered background frame flushing for display drivers
+   *
+   * FrameFlush lets a display driver with a framebuffer draw the next
+   * frame while the previous one is being sent to the display.  It
+   * owns two frame buffers.  The application draws into the back
+   * buffer, and swapBuffers() hands it to a background thread, which
+   * sends it through the driver's flush function, while the
+   * application continues with the other buffer.  swapBuffers() only
+   * blocks when the previous frame has not been sent yet.
+   *
+   * The flush thread can be limited to a maximum frame rate, which
+   * also paces the application through swapBuffers().  The time
+   * between swaps, the time spent sending each frame, and the time
+   * swapBuffers() spent waiting for the flush thread are kept, so it
+   * is easy to see whether rendering or I/O limits the frame rate.
+   *
+   * Only swapBuffers() and the counters may be used from another
+   * thread while the flush thread is running; the driver must not use
+   * the display link for anything else until stop() or waitIdle().
+   */
+  class FrameFlush {
+  public:
+
+    /**
+     * Flush function, sending a complete frame to the display.  It
+     * runs on the flush thread.  Exceptions are caught and counted
+     * (see getErrors()).
+     */
+    typedef void (*FLUSH_FUNC_T)(const uint8_t *frame, void *ctx);
+
+    /**
+     * FrameFlush constructor.  No memory is allocated until start()
+     * is called.
+     *
+     * @param frameBytes size of one frame in bytes
+     * @param func the flush function
+     * @param ctx a pointer passed to the flush function, usually the
+     * driver instance
+     */
+    FrameFlush(int frameBytes, FLUSH_FUNC_T func, void *ctx);
+
+    /**
+     * FrameFlush destructor.  Sends any pending frame and stops the
+     * flush thread.
+     */
+    ~FrameFlush();
+
+    /**
+     * allocate the frame buffers and start the flush thread
+     *
+     * @param initial if not NULL, the back buffer is initialized with
+     * this frame
+     * @return the back buffer to draw into
+     */
+    uint8_t *start(const uint8_t *initial=0);
+
+    /**
+     * wait for the pending frame to be sent, stop the flush thread and
+     * free the frame buffers
+     *
+     * @param final if not NULL, the back buffer is copied here first
+     */
+    void stop(uint8_t *final=0);
+
+    /**
+     * return whether the flush thread is running
+     *
+     * @return true if running
+     */
+    bool isRunning() { return m_running; };
+
+    /**
+     * return the buffer the application draws into
+     *
+     * @return the back buffer, NULL if not started
+     */
+    uint8_t *backBuffer() { return m_running ? m_buffers[m_back] : 0; };
+
+    /**
+     * hand the back buffer to the flush thread, and return the buffer
+     * to draw the next frame into.  This blocks only while the
+     * previous frame is still waiting to be sent or being sent.
+     * Must only be called between start() and stop().
+     *
+     * @param preserve true to start the next frame as a copy of the
+     * one just submitted, for applications that only redraw what
+     * changed.  false leaves the frame from two swaps ago in the
+     * buffer, for applications that redraw everything.
+     * @return the new back buffer
+     */
+    uint8_t *swapBuffers(bool preserve=true);
+
+    /**
+     * wait until all submitted frames have been sent
+     */
+    void waitIdle();
+
+    /**
+     * limit the rate at which frames are sent
+     *
+     * @param fps maximum frames per second, 0 for no limit
+     */
+    void setFrameRate(float fps);
+
+    /**
+     * return the time between the last two calls to swapBuffers(),
+     * which is the application's frame time
+     *
+     * @return milliseconds
+     */
+    float getFrameTime();
+
+    /**
+     * return the time spent sending the last frame
+     *
+     * @return milliseconds
+     */
+    float getFlushTime();
+
+    /**
+     * return the time the last swapBuffers() blocked waiting for the
+     * previous frame to be sent.  A value close to the flush time
+     * means the display link, not rendering, limits the frame rate.
+     *
+     * @return milliseconds
+     */
+    float getWaitTime();
+
+    /**
+     * return the number of frames sent since construction
+     *
+     * @return frame count
+     */
+    uint32_t getFrameCount();
+
+    /**
+     * return the number of flushes that threw an exception
+     *
+     * @return error count
+     */
+    uint32_t getErrors();
+
+  private:
+    static void *flushThread(void *ctx);
+    static uint64_t now();
+
+    // send a frame and update the counters
+    void flush(const uint8_t *frame);
+
+    int m_frameBytes;
+    FLUSH_FUNC_T m_func;
+    void *m_ctx;
+
+    uint8_t *m_buffers[2];
+    // index of the buffer the application draws into
+    int m_back;
+    // a frame was submitted and is not completely sent yet
+    bool m_pending;
+
+    bool m_running;
+    bool m_run;
+    pthread_t m_thread;
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_work;
+    pthread_cond_t m_done;
+
+    // minimum time between the starts of two flushes, in microseconds
+    uint64_t m_period;
+    uint64_t m_lastFlush;
+    uint64_t m_lastSwap;
+
+    uint64_t m_frameTime;
+    uint64_t m_flushTime;
+    uint64_t m_waitTime;
+    uint32_t m_frames;
+    uint32_t m_errors;
+  };
+}
@@ -30,9 +30,53 @@
 
 #include "grove.h"
 #include "math.h"
+#include <limits.h>
 
 using namespace upm;
 
+// Builds the table of converted values for every code of an ADC
+// with the given resolution, so that readings need no libm calls.
+static int *buildTable(int bits, int (*func)(int code, int maxCode),
+                       int *maxCode)
+{
+    if (bits <= 0 || bits > 16)
+        bits = 10;
+
+    *maxCode = (1 << bits) - 1;
+
+    int *table = new int[*maxCode + 1];
+    for (int i=0; i<=*maxCode; i++)
+        table[i] = func(i, *maxCode);
+
+    return table;
+}
+
+// Rounds a converted value, clamping values that do not fit an int
+// (the ends of the ADC range may divide by 0)
+static int roundValue(float v)
+{
+    if (isnan(v))
+        return 0;
+    if (v >= (float) INT_MAX)
+        return INT_MAX;
+    if (v <= (float) INT_MIN)
+        return INT_MIN;
+    return (int) round(v);
+}
+
+// Converts raw values through a table, computing any value outside
+// of the ADC's range (such as read errors) directly
+static void convertTable(const int *table, int maxCode,
+                         int (*func)(int code, int maxCode),
+                         const int *raw, int *out, int count)
+{
+    for (int i=0; i<count; i++) {
+        unsigned int code = (unsigned int) raw[i];
+        out[i] = (code <= (unsigned int) maxCode) ? table[code]
+            : func(raw[i], maxCode);
+    }
+}
+
 //// GroveLed ////
 
 GroveLed::GroveLed(int pin)
@@ -109,6 +153,13 @@ bool GroveRelay::isOff()
 
 //// GroveTemp ////
 
+static int tempFromCode(int a, int maxCode)
+{
+    float r = (float)(maxCode-a)*10000.0/a;
+    float t = 1.0/(log(r/10000.0)/3975.0 + 1.0/298.15)-273.15;
+    return roundValue(t);
+}
+
 GroveTemp::GroveTemp(unsigned int pin)
 {
     if ( !(m_aio = mraa_aio_init(pin)) ) {
@@ -117,19 +168,25 @@ GroveTemp::GroveTemp(unsigned int pin)
         return;
     }
     m_name = "Temperature Sensor";
+    m_table = buildTable(mraa_aio_get_bit(m_aio), &tempFromCode, &m_maxCode);
 }
 
 GroveTemp::~GroveTemp()
 {
     mraa_aio_close(m_aio);
+    delete [] m_table;
 }
 
 int GroveTemp::value ()
 {
     int a = mraa_aio_read(m_aio);
-    float r = (float)(1023.0-a)*10000.0/a;
-    float t = 1.0/(log(r/10000.0)/3975.0 + 1.0/298.15)-273.15;
-    return (int) round(t);
+    convertTable(m_table, m_maxCode, &tempFromCode, &a, &a, 1);
+    return a;
+}
+
+void GroveTemp::convert(const int *raw, int *out, int count)
+{
+    convertTable(m_table, m_maxCode, &tempFromCode, raw, out, count);
 }
 
 float GroveTemp::raw_value()
@@ -139,6 +196,14 @@ float GroveTemp::raw_value()
 
 //// GroveLight ////
 
+static int lightFromCode(int code, int maxCode)
+{
+    // rough conversion to lux, using formula from Grove Starter Kit booklet
+    float a = (float) code;
+    a = 10000.0/pow(((maxCode-a)*10.0/a)*15.0,4.0/3.0);
+    return roundValue(a);
+}
+
 GroveLight::GroveLight(unsigned int pin)
 {
     if ( !(m_aio = mraa_aio_init(pin)) ) {
@@ -147,19 +212,25 @@ GroveLight::GroveLight(unsigned int pin)
         return;
     }
     m_name = "Light Sensor";
+    m_table = buildTable(mraa_aio_get_bit(m_aio), &lightFromCode, &m_maxCode);
 }
 
 GroveLight::~GroveLight()
 {
     mraa_aio_close(m_aio);
+    delete [] m_table;
 }
 
 int GroveLight::value()
 {
-    // rough conversion to lux, using formula from Grove Starter Kit booklet
-    float a = (float) mraa_aio_read(m_aio);
-    a = 10000.0/pow(((1023.0-a)*10.0/a)*15.0,4.0/3.0);
-    return (int) round(a);
+    int a = mraa_aio_read(m_aio);
+    convertTable(m_table, m_maxCode, &lightFromCode, &a, &a, 1);
+    return a;
+}
+
+void GroveLight::convert(const int *raw, int *out, int count)
+{
+    convertTable(m_table, m_maxCode, &lightFromCode, raw, out, count);
 }
 
 float GroveLight::raw_value()
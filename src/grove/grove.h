@@ -189,8 +189,22 @@ class GroveTemp: public Grove {
          * @return Normalized temperature in Celsius
          */
         int value();
+        /**
+         * Converts an array of raw ADC values, as returned by
+         * raw_value(), to temperatures in Celsius.  Values inside the
+         * ADC's range are looked up in a table built by the
+         * constructor.
+         *
+         * @param raw Array of raw values
+         * @param out Array receiving the converted values
+         * @param count Number of values to convert
+         */
+        void convert(const int *raw, int *out, int count);
     private:
         mraa_aio_context m_aio;
+        // converted value of every ADC code, and the largest code
+        int *m_table;
+        int m_maxCode;
 };
 
 /**
@@ -230,8 +244,22 @@ class GroveLight: public Grove {
          * @return Normalized light reading in lux
          */
         int value();
+        /**
+         * Converts an array of raw ADC values, as returned by
+         * raw_value(), to approximate light values in lux.  Values inside the
+         * ADC's range are looked up in a table built by the
+         * constructor.
+         *
+         * @param raw Array of raw values
+         * @param out Array receiving the converted values
+         * @param count Number of values to convert
+         */
+        void convert(const int *raw, int *out, int count);
     private:
         mraa_aio_context m_aio;
+        // converted value of every ADC code, and the largest code
+        int *m_table;
+        int m_maxCode;
 };
 
 /**
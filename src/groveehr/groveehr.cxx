@@ -53,40 +53,18 @@ GroveEHR::~GroveEHR()
 
 void GroveEHR::initClock()
 {
-  gettimeofday(&m_startTime, NULL);
+  m_startTime = EdgeRate::now();
 }
 
 uint32_t GroveEHR::getMillis()
 {
-  struct timeval elapsed, now;
-  uint32_t elapse;
-
-  // get current time
-  gettimeofday(&now, NULL);
-
-  // compute the delta since m_startTime
-  if( (elapsed.tv_usec = now.tv_usec - m_startTime.tv_usec) < 0 ) 
-    {
-      elapsed.tv_usec += 1000000;
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec - 1;
-    } 
-  else 
-    {
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec;
-    }
-
-  elapse = (uint32_t)((elapsed.tv_sec * 1000) + (elapsed.tv_usec / 1000));
-
-  // never return 0
-  if (elapse == 0)
-    elapse = 1;
-
-  return elapse;
+  return EdgeRate::elapsedMillis(m_startTime);
 }
 
 void GroveEHR::clearBeatCounter()
 {
   m_beatCounter = 0;
+  m_beats.reset();
 }
 
 void GroveEHR::startBeatCounter()
@@ -111,6 +89,7 @@ void GroveEHR::beatISR(void *ctx)
 {
   upm::GroveEHR *This = (upm::GroveEHR *)ctx;
   This->m_beatCounter++;
+  This->m_beats.edge();
 }
 
 int GroveEHR::heartRate()
@@ -128,3 +107,18 @@ int GroveEHR::heartRate()
 
   return int(heartRate);
 }
+
+float GroveEHR::instantHeartRate()
+{
+  return m_beats.instantRate() * 60.0;
+}
+
+float GroveEHR::windowHeartRate(uint32_t windowMs)
+{
+  return m_beats.windowRate(windowMs) * 60.0;
+}
+
+void GroveEHR::setBeatCallback(EdgeRate::EDGE_CALLBACK_T func, void *arg)
+{
+  m_beats.setCallback(func, arg);
+}
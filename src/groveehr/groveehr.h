@@ -25,9 +25,13 @@
 
 #include <string>
 #include <stdint.h>
-#include <sys/time.h>
 #include <mraa/gpio.h>
 
+#include "edgerate.h"
+
+// Default window for windowHeartRate(), in milliseconds
+#define GROVEEHR_DEFAULT_WINDOW 10000
+
 namespace upm {
   /**
    * @brief Grove Ear-clip Heart Rate Sensor library
@@ -110,6 +114,36 @@ namespace upm {
      */
     int heartRate();
 
+    /**
+     * Computes the heart rate from the interval between the last two
+     * beats, so it follows changes within one beat.  The beat counter
+     * must be running.
+     *
+     * @return Heart rate in beats per minute, 0 until two beats were
+     * counted
+     */
+    float instantHeartRate();
+
+    /**
+     * Computes the average heart rate over the beats of the last
+     * windowMs milliseconds
+     *
+     * @param windowMs Window length in milliseconds
+     * @return Heart rate in beats per minute, 0 until two beats were
+     * counted in the window
+     */
+    float windowHeartRate(uint32_t windowMs=GROVEEHR_DEFAULT_WINDOW);
+
+    /**
+     * Installs a function to be called on every beat, from the
+     * interrupt thread.  The timestamp passed to it is in
+     * microseconds on the monotonic clock.
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setBeatCallback(EdgeRate::EDGE_CALLBACK_T func, void *arg);
+
   private:
     /**
      * Beat interrupt service routine (ISR)
@@ -118,7 +152,8 @@ namespace upm {
     static void beatISR(void *ctx);
     
     volatile uint32_t m_beatCounter;
-    struct timeval m_startTime;
+    uint64_t m_startTime;
+    EdgeRate m_beats;
     mraa_gpio_context m_gpio;
   };
 }
@@ -1,6 +1,9 @@
 %module javaupm_groveehr
 %include "../upm.i"
 
+// Java users should poll the rate methods instead
+%ignore setBeatCallback;
+
 %ignore beatISR;
 
 %{
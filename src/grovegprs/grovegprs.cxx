@@ -23,6 +23,7 @@
  */
 
 #include <iostream>
+#include <time.h>
 
 #include "grovegprs.h"
 
@@ -31,9 +32,46 @@ using namespace std;
 
 static const int defaultDelay = 100;     // max wait time for read
 
+// final result codes ending a command successfully
+static const char *resultOK[] = {
+  "OK", "SEND OK", "CONNECT", "SHUT OK", "CLOSE OK", 0
+};
+
+// final result codes ending a command with an error.  These are
+// matched as prefixes, to catch "+CME ERROR: <n>".
+static const char *resultError[] = {
+  "ERROR", "+CME ERROR", "+CMS ERROR", "SEND FAIL", "NO CARRIER",
+  "BUSY", "NO ANSWER", "NO DIALTONE", 0
+};
+
+static uint64_t getMillis()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t(ts.tv_sec) * 1000) + (ts.tv_nsec / 1000000);
+}
+
 GroveGPRS::GroveGPRS(int uart) :
   m_uart(uart)
 {
+  m_busy = false;
+  m_sentTime = 0;
+  m_nextId = 1;
+  m_completed = 0;
+
+  m_waitId = 0;
+  m_waitResult = RESULT_PENDING;
+
+  m_rxLen = 0;
+  m_rawRemaining = 0;
+  m_skipLF = false;
+
+  m_commandCallback = 0;
+  m_commandCallbackArg = 0;
+  m_dataCallback = 0;
+  m_dataCallbackArg = 0;
 }
 
 GroveGPRS::~GroveGPRS()
@@ -72,3 +110,286 @@ mraa::Result GroveGPRS::setBaudRate(int baud)
   return m_uart.setBaudRate(baud);
 }
 
+
+int GroveGPRS::queueCommand(std::string cmd, unsigned int timeoutMs)
+{
+  return queueSend(cmd, 0, 0, timeoutMs);
+}
+
+int GroveGPRS::queueSend(std::string cmd, const uint8_t *data, int len,
+                         unsigned int timeoutMs)
+{
+  COMMAND_T command;
+
+  command.id = m_nextId++;
+  command.cmd = cmd;
+  command.timeoutMs = timeoutMs;
+  command.data = data;
+  command.len = len;
+
+  m_queue.push_back(command);
+
+  // get it on the wire right away if the modem is idle
+  startCommand();
+
+  return command.id;
+}
+
+GroveGPRS::RESULT_T GroveGPRS::sendCommand(std::string cmd,
+                                           unsigned int timeoutMs)
+{
+  m_waitId = queueCommand(cmd, timeoutMs);
+  m_waitResult = RESULT_PENDING;
+
+  // each queued command is expired by the engine, so this ends
+  while (m_waitResult == RESULT_PENDING)
+    process(defaultDelay);
+
+  m_waitId = 0;
+
+  return m_waitResult;
+}
+
+void GroveGPRS::startCommand()
+{
+  if (m_busy || m_queue.empty())
+    return;
+
+  std::string cmd = m_queue.front().cmd + "\r";
+
+  m_busy = true;
+  m_sentTime = getMillis();
+
+  // no flush here: waiting for the UART to drain would only delay
+  // the response
+  m_uart.write(cmd.data(), cmd.size());
+}
+
+void GroveGPRS::completeCommand(RESULT_T result)
+{
+  COMMAND_T command = m_queue.front();
+
+  m_queue.pop_front();
+  m_busy = false;
+  m_completed++;
+
+  if (command.id == m_waitId)
+    {
+      m_waitResult = result;
+      m_response = command.response;
+    }
+
+  if (m_commandCallback)
+    m_commandCallback(command.id, result, command.response.c_str(),
+                      m_commandCallbackArg);
+
+  // keep the modem busy
+  startCommand();
+}
+
+void GroveGPRS::handleLine(char *line)
+{
+  bool claimed = false;
+
+  for (size_t i=0; i<m_urcHandlers.size(); i++)
+    {
+      const std::string &prefix = m_urcHandlers[i].prefix;
+
+      if (strncmp(line, prefix.c_str(), prefix.size()) == 0)
+        {
+          int raw = m_urcHandlers[i].func(line, m_urcHandlers[i].arg);
+
+          if (raw > 0)
+            m_rawRemaining = raw;
+
+          claimed = true;
+          break;
+        }
+    }
+
+  if (!m_busy)
+    return;
+
+  COMMAND_T &command = m_queue.front();
+
+  // command echo
+  if (command.cmd == line)
+    return;
+
+  for (int i=0; resultOK[i]; i++)
+    if (strcmp(line, resultOK[i]) == 0)
+      {
+        completeCommand(RESULT_OK);
+        return;
+      }
+
+  for (int i=0; resultError[i]; i++)
+    if (strncmp(line, resultError[i], strlen(resultError[i])) == 0)
+      {
+        // keep the error, it may carry a code
+        if (!command.response.empty())
+          command.response += "\n";
+        command.response += line;
+
+        completeCommand(RESULT_ERROR);
+        return;
+      }
+
+  // a claimed line only belongs to the response if it names the
+  // command, as in "+CSQ: 20,0" for AT+CSQ
+  if (claimed)
+    {
+      std::string name(line, strcspn(line, ":"));
+
+      if (command.cmd.find(name) == std::string::npos)
+        return;
+    }
+
+  if (!command.response.empty())
+    command.response += "\n";
+  command.response += line;
+}
+
+int GroveGPRS::process(unsigned int millis)
+{
+  unsigned int completed = m_completed;
+
+  startCommand();
+
+  if (m_uart.dataAvailable(millis))
+    {
+      do
+        {
+          int rv = m_uart.read((char *)m_rxBuf + m_rxLen,
+                               sizeof(m_rxBuf) - m_rxLen);
+          if (rv <= 0)
+            break;
+
+          m_rxLen += rv;
+
+          // lines are NUL terminated and handled in place, and raw
+          // data is passed on from where it was read
+          int start = 0;
+
+          while (start < m_rxLen)
+            {
+              if (m_skipLF)
+                {
+                  m_skipLF = false;
+                  if (m_rxBuf[start] == '\n')
+                    {
+                      start++;
+                      continue;
+                    }
+                }
+
+              if (m_rawRemaining)
+                {
+                  int n = m_rxLen - start;
+                  if (n > m_rawRemaining)
+                    n = m_rawRemaining;
+
+                  if (m_dataCallback)
+                    m_dataCallback(m_rxBuf + start, n, m_dataCallbackArg);
+
+                  m_rawRemaining -= n;
+                  start += n;
+                  continue;
+                }
+
+              int end = start;
+              while (end < m_rxLen && m_rxBuf[end] != '\r' &&
+                     m_rxBuf[end] != '\n')
+                end++;
+
+              if (end == m_rxLen)
+                {
+                  // the data prompt is not followed by a line ending
+                  if (m_busy && m_queue.front().data &&
+                      m_rxBuf[start] == '>')
+                    {
+                      COMMAND_T &command = m_queue.front();
+
+                      m_uart.write((const char *)command.data, command.len);
+                      // only send it once
+                      command.data = 0;
+                      start = end;
+                    }
+                  break;
+                }
+
+              // raw data claimed by this line starts after its CR LF
+              bool cr = (m_rxBuf[end] == '\r');
+              m_rxBuf[end] = 0;
+
+              if (end > start)
+                {
+                  handleLine((char *)m_rxBuf + start);
+
+                  if (m_rawRemaining && cr)
+                    m_skipLF = true;
+                }
+
+              start = end + 1;
+            }
+
+          // keep the partial line for the next read.  If it fills the
+          // whole buffer, it is too long to handle, so drop it.
+          if (start == 0 && m_rxLen == int(sizeof(m_rxBuf)))
+            {
+              cerr << __FUNCTION__ << ": line too long, discarded" << endl;
+              start = m_rxLen;
+            }
+
+          m_rxLen -= start;
+          if (m_rxLen)
+            memmove(m_rxBuf, m_rxBuf + start, m_rxLen);
+        } while (m_uart.dataAvailable(0));
+    }
+
+  if (m_busy && (getMillis() - m_sentTime) >= m_queue.front().timeoutMs)
+    completeCommand(RESULT_TIMEOUT);
+
+  return m_completed - completed;
+}
+
+void GroveGPRS::setCommandCallback(COMMAND_CALLBACK_T func, void *arg)
+{
+  m_commandCallback = func;
+  m_commandCallbackArg = arg;
+}
+
+void GroveGPRS::setURCHandler(std::string prefix, URC_CALLBACK_T func,
+                              void *arg)
+{
+  for (size_t i=0; i<m_urcHandlers.size(); i++)
+    if (m_urcHandlers[i].prefix == prefix)
+      {
+        if (func)
+          {
+            m_urcHandlers[i].func = func;
+            m_urcHandlers[i].arg = arg;
+          }
+        else
+          m_urcHandlers.erase(m_urcHandlers.begin() + i);
+
+        return;
+      }
+
+  if (!func)
+    return;
+
+  URC_HANDLER_T handler;
+
+  handler.prefix = prefix;
+  handler.func = func;
+  handler.arg = arg;
+
+  m_urcHandlers.push_back(handler);
+}
+
+void GroveGPRS::setDataCallback(DATA_CALLBACK_T func, void *arg)
+{
+  m_dataCallback = func;
+  m_dataCallbackArg = arg;
+}
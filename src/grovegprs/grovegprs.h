@@ -28,7 +28,10 @@
 
 #include <string>
 #include <iostream>
+#include <deque>
+#include <vector>
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -38,6 +41,12 @@
 
 #define GROVEGPRS_DEFAULT_UART 0
 
+// Default time allowed for a command to complete, in milliseconds
+#define GROVEGPRS_DEFAULT_TIMEOUT 5000
+
+// Size of the receive buffer.  This is the longest line handled.
+#define GROVEGPRS_RX_BUFFER_SIZE 1024
+
 namespace upm {
     /**
      * @brief Grove GPRS Module library
@@ -65,6 +74,23 @@ namespace upm {
      *
      * It is connected via a UART at 19200 baud.
      *
+     * Besides raw reads and writes, the driver provides an AT command
+     * engine.  Commands are queued with queueCommand() or
+     * queueSend(), and are sent one after the other as soon as the
+     * previous one completes, each with its own timeout.  The input is
+     * split into lines in place in a receive buffer.  Lines up to the
+     * final result code (OK, ERROR, ...) form the command's response,
+     * while lines starting with a registered prefix are passed to a
+     * handler, so unsolicited result codes do not get mixed into
+     * responses.  A handler can claim a number of raw bytes following
+     * its line (socket or HTTP payloads), which are then passed to the
+     * data callback straight from the receive buffer.
+     *
+     * The engine runs from process(), which must be called regularly,
+     * and from sendCommand().  Callbacks are run from within these
+     * calls, and may queue commands, but must not call process() or
+     * sendCommand() themselves.
+     *
      * @image html grovegprs.jpg
      * @snippet grovegprs.cxx Interesting
      */
@@ -72,6 +98,39 @@ namespace upm {
   class GroveGPRS {
   public:
 
+    /**
+     * Command results
+     */
+    typedef enum {
+      RESULT_PENDING            = 0,
+      RESULT_OK                 = 1,
+      RESULT_ERROR              = 2,
+      RESULT_TIMEOUT            = 3
+    } RESULT_T;
+
+    /**
+     * Command completion callback.  response holds the lines received
+     * before the final result code, separated by newlines.
+     */
+    typedef void (*COMMAND_CALLBACK_T)(int id, RESULT_T result,
+                                       const char *response, void *arg);
+
+    /**
+     * Handler for lines starting with a registered prefix.  line is
+     * NUL terminated, without the line ending, and is only valid
+     * until the handler returns.  The handler returns the number of
+     * raw data bytes that follow the line, 0 if none.
+     */
+    typedef int (*URC_CALLBACK_T)(const char *line, void *arg);
+
+    /**
+     * Callback for raw data claimed by a URC handler.  The data may be
+     * passed in several pieces, and is only valid until the callback
+     * returns.
+     */
+    typedef void (*DATA_CALLBACK_T)(const uint8_t *data, int len,
+                                    void *arg);
+
     /**
      * GroveGPRS object constructor
      *
@@ -143,11 +202,154 @@ namespace upm {
      */
     mraa::Result setBaudRate(int baud=19200);
 
+    /**
+     * Queues an AT command.  The command is sent once all commands
+     * queued before it have completed.
+     *
+     * @param cmd The command, without the terminating carriage return
+     * @param timeoutMs Time allowed for the command to complete, in
+     * milliseconds, from the time it is sent
+     * @return The command ID, passed to the command callback
+     */
+    int queueCommand(std::string cmd,
+                     unsigned int timeoutMs=GROVEGPRS_DEFAULT_TIMEOUT);
+
+    /**
+     * Queues a command that prompts for data with "> ", such as
+     * AT+CIPSEND=<len>.  Once the prompt is received, the data is
+     * written to the device directly from the buffer, which must
+     * remain valid until the command completes.
+     *
+     * @param cmd The command, without the terminating carriage return
+     * @param data The data to send at the prompt
+     * @param len Length of data
+     * @param timeoutMs Time allowed for the command to complete, in
+     * milliseconds
+     * @return The command ID
+     */
+    int queueSend(std::string cmd, const uint8_t *data, int len,
+                  unsigned int timeoutMs=GROVEGPRS_DEFAULT_TIMEOUT);
+
+    /**
+     * Queues a command and waits for it to complete.  The response is
+     * available from getResponse().
+     *
+     * @param cmd The command, without the terminating carriage return
+     * @param timeoutMs Time allowed for the command to complete, in
+     * milliseconds
+     * @return One of the RESULT_T values
+     */
+    RESULT_T sendCommand(std::string cmd,
+                         unsigned int timeoutMs=GROVEGPRS_DEFAULT_TIMEOUT);
+
+    /**
+     * Returns the response of the last command run by sendCommand(),
+     * the lines received before the final result code, separated by
+     * newlines
+     *
+     * @return The response
+     */
+    std::string getResponse() { return m_response; };
+
+    /**
+     * Runs the command engine: sends queued commands, reads and
+     * parses any input, and expires timed out commands
+     *
+     * @param millis Number of milliseconds to wait for input; 0 means
+     * no waiting
+     * @return Number of commands completed
+     */
+    int process(unsigned int millis=0);
+
+    /**
+     * Returns the number of commands queued or in progress
+     *
+     * @return Number of commands
+     */
+    int pendingCommands() { return m_queue.size(); };
+
+    /**
+     * Installs a function to be called when a command completes
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setCommandCallback(COMMAND_CALLBACK_T func, void *arg);
+
+    /**
+     * Installs a handler for lines starting with a prefix, such as
+     * "+CMTI:" or "+RECEIVE".  The handler sees every such line,
+     * including ones sent in response to a command, which are then
+     * also added to that command's response.  A prefix that is
+     * already registered has its handler replaced.
+     *
+     * @param prefix The line prefix
+     * @param func Handler, or NULL to remove the prefix
+     * @param arg Argument passed to func
+     */
+    void setURCHandler(std::string prefix, URC_CALLBACK_T func, void *arg);
+
+    /**
+     * Installs a function to receive raw data claimed by URC
+     * handlers
+     *
+     * @param func Function to call, or NULL to discard the data
+     * @param arg Argument passed to func
+     */
+    void setDataCallback(DATA_CALLBACK_T func, void *arg);
+
 
   protected:
     mraa::Uart m_uart;
 
+    // write the command at the head of the queue, if idle
+    void startCommand();
+    // complete the command at the head of the queue
+    void completeCommand(RESULT_T result);
+    // handle a complete input line
+    void handleLine(char *line);
+
   private:
+    typedef struct {
+      int id;
+      std::string cmd;
+      unsigned int timeoutMs;
+      const uint8_t *data;
+      int len;
+      std::string response;
+    } COMMAND_T;
+
+    typedef struct {
+      std::string prefix;
+      URC_CALLBACK_T func;
+      void *arg;
+    } URC_HANDLER_T;
+
+    std::deque<COMMAND_T> m_queue;
+    // the head of the queue has been written
+    bool m_busy;
+    uint64_t m_sentTime;
+    int m_nextId;
+    unsigned int m_completed;
+
+    // sendCommand() state
+    int m_waitId;
+    RESULT_T m_waitResult;
+    std::string m_response;
+
+    uint8_t m_rxBuf[GROVEGPRS_RX_BUFFER_SIZE];
+    int m_rxLen;
+    // raw data bytes still expected by the data callback
+    int m_rawRemaining;
+    // skip the LF of a CR LF ending the line before raw data
+    bool m_skipLF;
+
+    std::vector<URC_HANDLER_T> m_urcHandlers;
+
+    COMMAND_CALLBACK_T m_commandCallback;
+    void *m_commandCallbackArg;
+    DATA_CALLBACK_T m_dataCallback;
+    void *m_dataCallbackArg;
   };
 }
 
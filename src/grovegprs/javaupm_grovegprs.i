@@ -3,6 +3,11 @@
 %include "carrays.i"
 %include "std_string.i"
 
+// Java users should use sendCommand() instead
+%ignore setCommandCallback;
+%ignore setURCHandler;
+%ignore setDataCallback;
+
 %{
     #include "grovegprs.h"
 %}
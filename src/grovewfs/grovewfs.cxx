@@ -57,35 +57,12 @@ GroveWFS::~GroveWFS()
 
 void GroveWFS::initClock()
 {
-  gettimeofday(&m_startTime, NULL);
+  m_startTime = EdgeRate::now();
 }
 
 uint32_t GroveWFS::getMillis()
 {
-  struct timeval elapsed, now;
-  uint32_t elapse;
-
-  // get current time
-  gettimeofday(&now, NULL);
-
-  // compute the delta since m_startTime
-  if( (elapsed.tv_usec = now.tv_usec - m_startTime.tv_usec) < 0 ) 
-    {
-      elapsed.tv_usec += 1000000;
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec - 1;
-    } 
-  else 
-    {
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec;
-    }
-
-  elapse = (uint32_t)((elapsed.tv_sec * 1000) + (elapsed.tv_usec / 1000));
-
-  // never return 0
-  if (elapse == 0)
-    elapse = 1;
-
-  return elapse;
+  return EdgeRate::elapsedMillis(m_startTime);
 }
 
 void GroveWFS::startFlowCounter()
@@ -110,6 +87,7 @@ void GroveWFS::flowISR(void *ctx)
 {
   upm::GroveWFS *This = (upm::GroveWFS *)ctx;
   This->m_flowCounter++;
+  This->m_pulses.edge();
 }
 
 float GroveWFS::flowRate()
@@ -122,3 +100,19 @@ float GroveWFS::flowRate()
 
   return flowRate;
 }
+
+float GroveWFS::instantFlowRate()
+{
+  // same conversion as flowRate(), from pulses per second
+  return (m_pulses.instantRate() * 7.5) / 60.0;
+}
+
+float GroveWFS::windowFlowRate(uint32_t windowMs)
+{
+  return (m_pulses.windowRate(windowMs) * 7.5) / 60.0;
+}
+
+void GroveWFS::setFlowCallback(EdgeRate::EDGE_CALLBACK_T func, void *arg)
+{
+  m_pulses.setCallback(func, arg);
+}
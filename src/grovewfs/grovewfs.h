@@ -25,9 +25,13 @@
 
 #include <string>
 #include <stdint.h>
-#include <sys/time.h>
 #include <mraa/gpio.h>
 
+#include "edgerate.h"
+
+// Default window for windowFlowRate(), in milliseconds
+#define GROVEWFS_DEFAULT_WINDOW 1000
+
 namespace upm {
 
   /**
@@ -95,7 +99,7 @@ namespace upm {
      * stopped via stopFlowCounter() prior to calling this function.
      *
      */
-    void clearFlowCounter() { m_flowCounter = 0; };
+    void clearFlowCounter() { m_flowCounter = 0; m_pulses.reset(); };
 
     /**
      * Starts the flow counter
@@ -123,6 +127,35 @@ namespace upm {
      */
     float flowRate();
 
+    /**
+     * Computes the flow rate in liters per minute (LPM) from the
+     * interval between the last two pulses, so it follows changes
+     * within one pulse.  The flow counter must be running.
+     *
+     * @return Computed flow rate, 0 until two pulses were counted
+     */
+    float instantFlowRate();
+
+    /**
+     * Computes the average flow rate in liters per minute (LPM) over
+     * the pulses of the last windowMs milliseconds
+     *
+     * @param windowMs Window length in milliseconds
+     * @return Computed flow rate, 0 until two pulses were counted in
+     * the window
+     */
+    float windowFlowRate(uint32_t windowMs=GROVEWFS_DEFAULT_WINDOW);
+
+    /**
+     * Installs a function to be called on every pulse, from the
+     * interrupt thread.  The timestamp passed to it is in
+     * microseconds on the monotonic clock.
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setFlowCallback(EdgeRate::EDGE_CALLBACK_T func, void *arg);
+
   private:
     /**
      * Flow interrupt service routine (ISR)
@@ -131,7 +164,8 @@ namespace upm {
     static void flowISR(void *ctx);
 
     volatile uint32_t m_flowCounter;
-    struct timeval m_startTime;
+    uint64_t m_startTime;
+    EdgeRate m_pulses;
     mraa_gpio_context m_gpio;
     bool m_isrInstalled;
   };
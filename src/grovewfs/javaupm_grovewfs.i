@@ -1,6 +1,9 @@
 %module javaupm_grovewfs
 %include "../upm.i"
 
+// Java users should poll the rate methods instead
+%ignore setFlowCallback;
+
 %ignore flowISR;
 
 %{
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "gyrocal.h"
+
+using namespace upm;
+using namespace std;
+
+// calibration file layout, in host byte order
+#define GYROCAL_MAGIC "UPMGYCAL"
+#define GYROCAL_VERSION 1
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t axes;
+  uint32_t updates;
+  float bias[GYROCAL_MAX_AXES];
+} GYROCAL_BLOB_T;
+
+GyroCal::GyroCal(int axes, float threshold, int window)
+{
+  if (axes < 1 || axes > GYROCAL_MAX_AXES)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": invalid number of axes");
+      return;
+    }
+
+  m_axes = axes;
+
+  reset();
+  setThreshold(threshold, window);
+}
+
+GyroCal::~GyroCal()
+{
+}
+
+void GyroCal::reset()
+{
+  for (int i=0; i<GYROCAL_MAX_AXES; i++)
+    m_bias[i] = 0.0;
+
+  m_calibrated = false;
+  m_updates = 0;
+  m_count = 0;
+}
+
+void GyroCal::setThreshold(float threshold, int window)
+{
+  if (threshold <= 0.0 || window < 2)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": threshold must be positive, and window"
+                                  " at least 2 samples");
+      return;
+    }
+
+  m_threshold = threshold;
+  m_window = window;
+  m_count = 0;
+}
+
+bool GyroCal::addSample(const float *values)
+{
+  if (m_count == 0)
+    {
+      for (int i=0; i<m_axes; i++)
+        m_mean[i] = m_m2[i] = 0.0;
+    }
+
+  m_count++;
+
+  for (int i=0; i<m_axes; i++)
+    {
+      double delta = values[i] - m_mean[i];
+      m_mean[i] += delta / m_count;
+      m_m2[i] += delta * (values[i] - m_mean[i]);
+    }
+
+  if (m_count < m_window)
+    return false;
+
+  // the window is complete, start a new one with the next sample
+  m_count = 0;
+
+  double limit = double(m_threshold) * m_threshold * (m_window - 1);
+  for (int i=0; i<m_axes; i++)
+    if (m_m2[i] > limit)
+      return false;
+
+  for (int i=0; i<m_axes; i++)
+    {
+      if (m_calibrated)
+        m_bias[i] += GYROCAL_DEFAULT_WEIGHT * (m_mean[i] - m_bias[i]);
+      else
+        m_bias[i] = m_mean[i];
+    }
+
+  m_calibrated = true;
+  m_updates++;
+
+  return true;
+}
+
+float GyroCal::getBias(int axis)
+{
+  if (axis < 0 || axis >= m_axes)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": axis out of range");
+      return 0.0;
+    }
+
+  return m_bias[axis];
+}
+
+void GyroCal::setBias(const float *bias)
+{
+  for (int i=0; i<m_axes; i++)
+    m_bias[i] = bias[i];
+
+  m_calibrated = true;
+}
+
+bool GyroCal::save(std::string filename)
+{
+  if (!m_calibrated)
+    return false;
+
+  GYROCAL_BLOB_T blob;
+
+  memset(&blob, 0, sizeof(blob));
+  memcpy(blob.magic, GYROCAL_MAGIC, sizeof(blob.magic));
+  blob.version = GYROCAL_VERSION;
+  blob.axes = m_axes;
+  blob.updates = m_updates;
+  for (int i=0; i<m_axes; i++)
+    blob.bias[i] = m_bias[i];
+
+  // write a temporary file, then rename it over the old one, so a
+  // reader never sees a partial file
+  std::string tmpname = filename + ".tmp";
+
+  FILE *fp = fopen(tmpname.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  bool ok = (fwrite(&blob, sizeof(blob), 1, fp) == 1);
+
+  if (fclose(fp) != 0)
+    ok = false;
+
+  if (!ok || rename(tmpname.c_str(), filename.c_str()) != 0)
+    {
+      remove(tmpname.c_str());
+      return false;
+    }
+
+  return true;
+}
+
+bool GyroCal::load(std::string filename)
+{
+  GYROCAL_BLOB_T blob;
+
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (!fp)
+    return false;
+
+  bool ok = (fread(&blob, sizeof(blob), 1, fp) == 1);
+  fclose(fp);
+
+  if (!ok || memcmp(blob.magic, GYROCAL_MAGIC, sizeof(blob.magic)) ||
+      blob.version != GYROCAL_VERSION || blob.axes != uint32_t(m_axes))
+    return false;
+
+  setBias(blob.bias);
+  m_updates = blob.updates;
+
+  return true;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <string>
+
+// Maximum number of axes handled by one calibrator
+#define GYROCAL_MAX_AXES 3
+
+// Default maximum standard deviation of a stationary window, suited
+// to samples in degrees per second
+#define GYROCAL_DEFAULT_THRESHOLD 1.0
+
+// Default number of samples examined for each stationary check
+#define GYROCAL_DEFAULT_WINDOW 64
+
+// Default weight given to a new stationary window once a bias is
+// known (the first window is always taken as is)
+#define GYROCAL_DEFAULT_WEIGHT 0.25
+
+namespace upm {
+
+  /**
+   * @library gyrocal
+   * @brief Background gyroscope bias calibration
+   *
+   * GyroCal estimates the zero rate offset (bias) of a gyroscope from
+   * the live sample stream, instead of requiring the device to be
+   * held still for a blocking calibration loop at startup.
+   *
+   * Samples are examined in windows of a fixed number of samples.  A
+   * window in which the standard deviation of every axis stays below
+   * the threshold is considered stationary, and its mean is blended
+   * into the bias estimate.  Windows with any motion are discarded.
+   *
+   * The threshold, and therefore the bias, is in whatever unit the
+   * driver feeds in (degrees per second, raw counts or volts).  The
+   * estimate can be saved to and reloaded from a small binary file,
+   * so a device can start with a good bias right away, and refine it
+   * in the background.
+   */
+  class GyroCal {
+  public:
+
+    /**
+     * GyroCal constructor
+     *
+     * @param axes number of axes, up to GYROCAL_MAX_AXES
+     * @param threshold maximum standard deviation of a stationary
+     * window, in the unit of the samples
+     * @param window number of samples per stationary check
+     */
+    GyroCal(int axes=GYROCAL_MAX_AXES,
+            float threshold=GYROCAL_DEFAULT_THRESHOLD,
+            int window=GYROCAL_DEFAULT_WINDOW);
+
+    /**
+     * GyroCal destructor
+     */
+    ~GyroCal();
+
+    /**
+     * discard the bias estimate and the current window
+     */
+    void reset();
+
+    /**
+     * set the stationary detection parameters.  This restarts the
+     * current window.
+     *
+     * @param threshold maximum standard deviation of a stationary
+     * window, in the unit of the samples
+     * @param window number of samples per stationary check
+     */
+    void setThreshold(float threshold, int window=GYROCAL_DEFAULT_WINDOW);
+
+    /**
+     * add an uncorrected sample
+     *
+     * @param values pointer to one value per axis
+     * @return true if this sample completed a stationary window, and
+     * the bias estimate was updated
+     */
+    bool addSample(const float *values);
+
+    /**
+     * single axis version of addSample()
+     *
+     * @param value the uncorrected value
+     * @return true if the bias estimate was updated
+     */
+    bool addSample(float value) { return addSample(&value); };
+
+    /**
+     * return true once a bias estimate is available, either from a
+     * stationary window, from setBias() or from load()
+     *
+     * @return true if calibrated
+     */
+    bool isCalibrated() { return m_calibrated; };
+
+    /**
+     * return the bias estimate of an axis, 0 if not yet calibrated
+     *
+     * @param axis axis index
+     * @return the bias
+     */
+    float getBias(int axis=0);
+
+    /**
+     * set the bias estimate of all axes
+     *
+     * @param bias pointer to one value per axis
+     */
+    void setBias(const float *bias);
+
+    /**
+     * return the number of stationary windows the estimate was built
+     * from
+     *
+     * @return the number of updates
+     */
+    unsigned int getUpdateCount() { return m_updates; };
+
+    /**
+     * save the bias estimate to a file.  The file is replaced
+     * atomically.
+     *
+     * @param filename the file to write
+     * @return true if successful, false if not calibrated or the file
+     * could not be written
+     */
+    bool save(std::string filename);
+
+    /**
+     * load a bias estimate written by save()
+     *
+     * @param filename the file to read
+     * @return true if successful, false if the file is missing or
+     * does not match this calibrator's number of axes
+     */
+    bool load(std::string filename);
+
+  private:
+    int m_axes;
+    float m_threshold;
+    int m_window;
+
+    // running mean and sum of squared differences (Welford)
+    int m_count;
+    double m_mean[GYROCAL_MAX_AXES];
+    double m_m2[GYROCAL_MAX_AXES];
+
+    float m_bias[GYROCAL_MAX_AXES];
+    bool m_calibrated;
+    unsigned int m_updates;
+  };
+}
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string.h>
 
 #include "h3lis331dl.h"
 
@@ -35,10 +36,18 @@ using namespace std;
 
 
 H3LIS331DL::H3LIS331DL(int bus, uint8_t address):
-  m_i2c(bus)
+  m_i2c(bus), m_regs(&m_i2c, address, REG_INT2_DUR + 1, 0x80)
 {
   m_addr = address;
 
+  // control, reference and interrupt configuration registers are only
+  // changed by us, so cache them
+  m_regs.setPolicy(REG_REG1, REG_REG5, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_REFERENCE, REG_REFERENCE, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_INT1_CFG, REG_INT1_CFG, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_INT1_THS, REG_INT2_CFG, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_INT2_THS, REG_INT2_DUR, RegMap::REG_CACHED);
+
   mraa::Result rv;
   if ( (rv = m_i2c.address(m_addr)) != mraa::SUCCESS)
     {
@@ -77,17 +86,17 @@ bool H3LIS331DL::init(DR_BITS_T odr, PM_BITS_T pm, FS_BITS_T fs)
 
 uint8_t H3LIS331DL::getChipID()
 {
-  return m_i2c.readReg(REG_WHOAMI);
+  return m_regs.readReg(REG_WHOAMI);
 }
 
 bool H3LIS331DL::setDataRate(DR_BITS_T odr)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
+  uint8_t reg1 = m_regs.readReg(REG_REG1);
 
   reg1 &= ~(REG1_DR0 | REG1_DR1);
   reg1 |= (odr << REG1_DR_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
+  if (m_regs.writeReg(REG_REG1, reg1))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -99,12 +108,12 @@ bool H3LIS331DL::setDataRate(DR_BITS_T odr)
 
 bool H3LIS331DL::setPowerMode(PM_BITS_T pm)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
+  uint8_t reg1 = m_regs.readReg(REG_REG1);
 
   reg1 &= ~(REG1_PM0 | REG1_PM1 | REG1_PM2);
   reg1 |= (pm << REG1_PM_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
+  if (m_regs.writeReg(REG_REG1, reg1))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -116,12 +125,12 @@ bool H3LIS331DL::setPowerMode(PM_BITS_T pm)
 
 bool H3LIS331DL::enableAxis(uint8_t axisEnable)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
+  uint8_t reg1 = m_regs.readReg(REG_REG1);
 
   reg1 &= ~(REG1_XEN | REG1_YEN | REG1_ZEN);
   reg1 |= (axisEnable & (REG1_XEN | REG1_YEN | REG1_ZEN));
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
+  if (m_regs.writeReg(REG_REG1, reg1))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -133,12 +142,12 @@ bool H3LIS331DL::enableAxis(uint8_t axisEnable)
 
 bool H3LIS331DL::setFullScale(FS_BITS_T fs)
 {
-  uint8_t reg4 = m_i2c.readReg(REG_REG4);
+  uint8_t reg4 = m_regs.readReg(REG_REG4);
 
   reg4 &= ~(REG4_FS0 | REG4_FS1);
   reg4 |= (fs << REG4_FS_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG4, reg4))
+  if (m_regs.writeReg(REG_REG4, reg4))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -150,12 +159,12 @@ bool H3LIS331DL::setFullScale(FS_BITS_T fs)
 
 bool H3LIS331DL::setHPCF(HPCF_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   reg &= ~(REG2_HPCF0 | REG2_HPCF1);
   reg |= (val << REG2_HPCF_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -167,12 +176,12 @@ bool H3LIS331DL::setHPCF(HPCF_BITS_T val)
 
 bool H3LIS331DL::setHPM(HPM_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   reg &= ~(REG2_HPM0 | REG2_HPM1);
   reg |= (val << REG2_HPM_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -184,36 +193,39 @@ bool H3LIS331DL::setHPM(HPM_BITS_T val)
 
 bool H3LIS331DL::boot()
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   reg |= REG2_BOOT;
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
       return false;
     }
 
-  // wait for the boot bit to clear
+  // wait for the boot bit to clear, bypassing the cache
   do {
-    reg = m_i2c.readReg(REG_REG2);
+    m_regs.readRegs(REG_REG2, &reg, 1);
     usleep(200000);
   } while (reg & REG2_BOOT);
 
+  // the cached copy still has BOOT set
+  m_regs.invalidate(REG_REG2);
+
   return true;
 }
 
 bool H3LIS331DL::enableHPF1(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   if (enable)
     reg |= REG2_HPEN1;
   else
     reg &= ~REG2_HPEN1;
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -225,14 +237,14 @@ bool H3LIS331DL::enableHPF1(bool enable)
 
 bool H3LIS331DL::enableHPF2(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   if (enable)
     reg |= REG2_HPEN2;
   else
     reg &= ~REG2_HPEN2;
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -244,14 +256,14 @@ bool H3LIS331DL::enableHPF2(bool enable)
 
 bool H3LIS331DL::enableFDS(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  uint8_t reg = m_regs.readReg(REG_REG2);
 
   if (enable)
     reg |= REG2_FDS;
   else
     reg &= ~REG2_FDS;
 
-  if (m_i2c.writeReg(REG_REG2, reg))
+  if (m_regs.writeReg(REG_REG2, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -263,14 +275,14 @@ bool H3LIS331DL::enableFDS(bool enable)
 
 bool H3LIS331DL::setInterruptActiveLow(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   if (enable)
     reg |= REG3_IHL;
   else
     reg &= ~REG3_IHL;
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -282,14 +294,14 @@ bool H3LIS331DL::setInterruptActiveLow(bool enable)
 
 bool H3LIS331DL::setInterruptOpenDrain(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   if (enable)
     reg |= REG3_PP_OD;
   else
     reg &= ~REG3_PP_OD;
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -301,14 +313,14 @@ bool H3LIS331DL::setInterruptOpenDrain(bool enable)
 
 bool H3LIS331DL::setInterrupt1Latch(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   if (enable)
     reg |= REG3_LIR1;
   else
     reg &= ~REG3_LIR1;
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -320,14 +332,14 @@ bool H3LIS331DL::setInterrupt1Latch(bool enable)
 
 bool H3LIS331DL::setInterrupt2Latch(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   if (enable)
     reg |= REG3_LIR2;
   else
     reg &= ~REG3_LIR2;
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -339,12 +351,12 @@ bool H3LIS331DL::setInterrupt2Latch(bool enable)
 
 bool H3LIS331DL::setInterrupt1PadConfig(I_CFG_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   reg &= ~(REG3_I1_CFG0 | REG3_I1_CFG1);
   reg |= (val << REG3_I1_CFG_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -356,12 +368,12 @@ bool H3LIS331DL::setInterrupt1PadConfig(I_CFG_BITS_T val)
 
 bool H3LIS331DL::setInterrupt2PadConfig(I_CFG_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  uint8_t reg = m_regs.readReg(REG_REG3);
 
   reg &= ~(REG3_I2_CFG0 | REG3_I2_CFG1);
   reg |= (val << REG3_I2_CFG_SHIFT);
 
-  if (m_i2c.writeReg(REG_REG3, reg))
+  if (m_regs.writeReg(REG_REG3, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -374,14 +386,14 @@ bool H3LIS331DL::setInterrupt2PadConfig(I_CFG_BITS_T val)
 
 bool H3LIS331DL::enableBDU(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG4);
+  uint8_t reg = m_regs.readReg(REG_REG4);
 
   if (enable)
     reg |= REG4_BDU;
   else
     reg &= ~REG4_BDU;
 
-  if (m_i2c.writeReg(REG_REG4, reg))
+  if (m_regs.writeReg(REG_REG4, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -393,14 +405,14 @@ bool H3LIS331DL::enableBDU(bool enable)
 
 bool H3LIS331DL::enableBLE(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG4);
+  uint8_t reg = m_regs.readReg(REG_REG4);
 
   if (enable)
     reg |= REG4_BLE;
   else
     reg &= ~REG4_BLE;
 
-  if (m_i2c.writeReg(REG_REG4, reg))
+  if (m_regs.writeReg(REG_REG4, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -412,14 +424,14 @@ bool H3LIS331DL::enableBLE(bool enable)
 
 bool H3LIS331DL::enableSleepToWake(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG5);
+  uint8_t reg = m_regs.readReg(REG_REG5);
 
   if (enable)
     reg |= (REG5_TURNON0 | REG5_TURNON1);
   else
     reg &= ~(REG5_TURNON0 | REG5_TURNON1);
 
-  if (m_i2c.writeReg(REG_REG5, reg))
+  if (m_regs.writeReg(REG_REG5, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -431,17 +443,17 @@ bool H3LIS331DL::enableSleepToWake(bool enable)
 
 uint8_t H3LIS331DL::getStatus()
 {
-  return m_i2c.readReg(REG_STATUS);
+  return m_regs.readReg(REG_STATUS);
 }
 
 bool H3LIS331DL::setInterrupt1Config(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT1_CFG);
+  uint8_t reg = m_regs.readReg(REG_INT1_CFG);
 
   // mask off reserved bit
   reg = (val & ~0x40);
 
-  if (m_i2c.writeReg(REG_INT1_CFG, reg))
+  if (m_regs.writeReg(REG_INT1_CFG, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -453,12 +465,12 @@ bool H3LIS331DL::setInterrupt1Config(uint8_t val)
 
 bool H3LIS331DL::setInterrupt1Source(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT1_SRC);
+  uint8_t reg = m_regs.readReg(REG_INT1_SRC);
 
   // mask off reserved bit
   reg = (val & ~0x80);
 
-  if (m_i2c.writeReg(REG_INT1_SRC, reg))
+  if (m_regs.writeReg(REG_INT1_SRC, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -470,7 +482,7 @@ bool H3LIS331DL::setInterrupt1Source(uint8_t val)
 
 bool H3LIS331DL::setInterrupt1Threshold(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT1_THS, val))
+  if (m_regs.writeReg(REG_INT1_THS, val))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -482,7 +494,7 @@ bool H3LIS331DL::setInterrupt1Threshold(uint8_t val)
 
 bool H3LIS331DL::setInterrupt1Duration(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT1_DUR, val))
+  if (m_regs.writeReg(REG_INT1_DUR, val))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -494,12 +506,12 @@ bool H3LIS331DL::setInterrupt1Duration(uint8_t val)
 
 bool H3LIS331DL::setInterrupt2Config(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT2_CFG);
+  uint8_t reg = m_regs.readReg(REG_INT2_CFG);
 
   // mask off reserved bit
   reg = (val & ~0x40);
 
-  if (m_i2c.writeReg(REG_INT2_CFG, reg))
+  if (m_regs.writeReg(REG_INT2_CFG, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -511,12 +523,12 @@ bool H3LIS331DL::setInterrupt2Config(uint8_t val)
 
 bool H3LIS331DL::setInterrupt2Source(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT2_SRC);
+  uint8_t reg = m_regs.readReg(REG_INT2_SRC);
 
   // mask off reserved bit
   reg = (val & ~0x80);
 
-  if (m_i2c.writeReg(REG_INT2_SRC, reg))
+  if (m_regs.writeReg(REG_INT2_SRC, reg))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -528,7 +540,7 @@ bool H3LIS331DL::setInterrupt2Source(uint8_t val)
 
 bool H3LIS331DL::setInterrupt2Threshold(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT2_THS, val))
+  if (m_regs.writeReg(REG_INT2_THS, val))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -540,7 +552,7 @@ bool H3LIS331DL::setInterrupt2Threshold(uint8_t val)
 
 bool H3LIS331DL::setInterrupt2Duration(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT2_DUR, val))
+  if (m_regs.writeReg(REG_INT2_DUR, val))
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -552,22 +564,30 @@ bool H3LIS331DL::setInterrupt2Duration(uint8_t val)
 
 void H3LIS331DL::update()
 {
-  uint8_t low, high;
+  uint8_t buf[6];
+
+  // all three axes, low byte first, in one auto-increment read
+  memset(buf, 0, 6);
+  m_regs.readRegs(REG_OUT_X_L, buf, 6);
+
+  m_rawX = ((buf[1] << 8) | buf[0]);
+  m_rawY = ((buf[3] << 8) | buf[2]);
+  m_rawZ = ((buf[5] << 8) | buf[4]);
+}
 
-  // X
-  low = m_i2c.readReg(REG_OUT_X_L);
-  high = m_i2c.readReg(REG_OUT_X_H);
-  m_rawX = ((high << 8) | low);
+bool H3LIS331DL::deferConfigWrites(bool enable)
+{
+  return (m_regs.setDeferred(enable) == mraa::SUCCESS);
+}
 
-  // Y
-  low = m_i2c.readReg(REG_OUT_Y_L);
-  high = m_i2c.readReg(REG_OUT_Y_H);
-  m_rawY = ((high << 8) | low);
+bool H3LIS331DL::syncConfig()
+{
+  return (m_regs.sync() == mraa::SUCCESS);
+}
 
-  // Z
-  low = m_i2c.readReg(REG_OUT_Z_L);
-  high = m_i2c.readReg(REG_OUT_Z_H);
-  m_rawZ = ((high << 8) | low);
+bool H3LIS331DL::restoreConfig()
+{
+  return (m_regs.restore() == mraa::SUCCESS);
 }
 
 void H3LIS331DL::setAdjustmentOffsets(int adjX, int adjY, int adjZ)
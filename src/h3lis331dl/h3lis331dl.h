@@ -27,6 +27,8 @@
 #include <mraa/common.hpp>
 #include <mraa/i2c.hpp>
 
+#include "regmap.h"
+
 #define H3LIS331DL_I2C_BUS 0
 #define H3LIS331DL_DEFAULT_I2C_ADDR 0x18
 
@@ -618,9 +620,39 @@ namespace upm {
 #endif
 
 
+    /**
+     * Defers writes to the control, reference and interrupt
+     * configuration registers.  These registers are cached, so the
+     * read-modify-write cycles of the set*() and enable*() methods
+     * only read the device once.  While deferred, their writes only
+     * update the cache, and are sent in as few bursts as possible by
+     * syncConfig().
+     *
+     * @param enable true to defer writes, false to sync and return to
+     * writing immediately
+     * @return true if successful, false otherwise
+     */
+    bool deferConfigWrites(bool enable);
+
+    /**
+     * Writes any deferred configuration register changes to the device
+     *
+     * @return true if successful, false otherwise
+     */
+    bool syncConfig();
+
+    /**
+     * Rewrites all cached configuration registers to the device, for
+     * example after a power cycle.
+     *
+     * @return true if successful, false otherwise
+     */
+    bool restoreConfig();
+
     /**
      * Provides public access to the MRAA I2C context of the class for
-     * direct user access
+     * direct user access.  Note that registers written directly
+     * through this context bypass the register cache.
      *
      * @return Reference to the class I2C context
      */
@@ -634,6 +666,7 @@ namespace upm {
 
   private:
     uint8_t m_addr;
+    I2cRegMap m_regs;
   };
 }
 
@@ -21,9 +21,13 @@
  */
 #include <iostream>
 #include <fstream>
+#include <iostream>
+#include <algorithm>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <stdexcept>
 #include "hx711.h"
 
@@ -57,12 +61,27 @@ HX711::HX711(uint8_t data, uint8_t sck, uint8_t gain) {
                                     ": Couldn't set direction for CLOCK pin.");
     }
 
+    pthread_mutex_init(&m_lock, NULL);
+    pthread_cond_init(&m_newSample, NULL);
+
+    m_running = false;
+    m_filter = FILTER_MEDIAN;
+    m_window = HX711_DEFAULT_WINDOW;
+    m_threshold = 0;
+    m_outliers = 0;
+    m_head = 0;
+    m_stored = 0;
+    m_count = 0;
+    m_rejected = 0;
+
     this->setGain(gain);
 }
 
 HX711::~HX711() {
     mraa_result_t error = MRAA_SUCCESS;
 
+    stop();
+
     error = mraa_gpio_close (this->m_dataPinCtx);
     if (error != MRAA_SUCCESS) {
         mraa_result_print(error);
@@ -72,14 +91,37 @@ HX711::~HX711() {
     if (error != MRAA_SUCCESS) {
         mraa_result_print(error);
     }
+
+    pthread_cond_destroy(&m_newSample);
+    pthread_mutex_destroy(&m_lock);
 }
 
 unsigned long HX711::read() {
-    unsigned long Count = 0;
+    if (m_running) {
+        pthread_mutex_lock(&m_lock);
+        waitSample();
+        unsigned long Count = filter(FILTER_NONE, 1);
+        pthread_mutex_unlock(&m_lock);
 
-    while (mraa_gpio_read(this->m_dataPinCtx));
+        return (Count);
+    }
+
+    // DOUT goes low when a conversion is ready
+    for (int waited = 0; mraa_gpio_read(this->m_dataPinCtx); waited++) {
+        if (waited >= HX711_READ_TIMEOUT) {
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": Timed out waiting for a conversion.");
+        }
+        usleep(1000);
+    }
+
+    return shiftIn();
+}
 
-    for (int i=0; i<GAIN; i++)
+unsigned long HX711::shiftIn() {
+    unsigned long Count = 0;
+
+    for (int i=0; i<24; i++)
     {
         mraa_gpio_write(this->m_sckPinCtx, 1);
         Count = Count << 1;
@@ -90,14 +132,226 @@ unsigned long HX711::read() {
         }
     }
 
-    mraa_gpio_write(this->m_sckPinCtx, 1);
-    Count = Count ^ 0x800000;
-    mraa_gpio_write(this->m_sckPinCtx, 0);
+    // the extra pulses select channel and gain of the next conversion
+    for (int i=24; i<=GAIN; i++)
+    {
+        mraa_gpio_write(this->m_sckPinCtx, 1);
+        mraa_gpio_write(this->m_sckPinCtx, 0);
+    }
+
+    return (Count ^ 0x800000);
+}
+
+void HX711::start() {
+    if (m_running)
+        return;
+
+    // we warn if these fail, since it may not be possible on all
+    // platforms.  The clock pulses are longer, but stay well below
+    // the 60us that power the chip down.
+    if (mraa_gpio_use_mmaped(this->m_sckPinCtx, 1) != MRAA_SUCCESS)
+        cerr << __FUNCTION__
+             << ": Warning: mmap of CLOCK pin failed, using sysfs."
+             << endl;
 
-    return (Count);
+    if (mraa_gpio_use_mmaped(this->m_dataPinCtx, 1) != MRAA_SUCCESS)
+        cerr << __FUNCTION__
+             << ": Warning: mmap of DATA pin failed, using sysfs."
+             << endl;
+
+    if (mraa_gpio_isr(this->m_dataPinCtx, MRAA_GPIO_EDGE_FALLING,
+                      &isrHandler, this) != MRAA_SUCCESS) {
+        mraa_gpio_use_mmaped(this->m_sckPinCtx, 0);
+        mraa_gpio_use_mmaped(this->m_dataPinCtx, 0);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mraa_gpio_isr() failed");
+        return;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    m_head = 0;
+    m_stored = 0;
+    m_count = 0;
+    m_rejected = 0;
+    m_outliers = 0;
+    m_running = true;
+    pthread_mutex_unlock(&m_lock);
+
+    // a conversion that was ready before the handler was installed
+    // produces no edge, and the chip waits until it is read
+    sample();
+}
+
+void HX711::stop() {
+    if (!m_running)
+        return;
+
+    mraa_gpio_isr_exit(this->m_dataPinCtx);
+
+    mraa_gpio_use_mmaped(this->m_sckPinCtx, 0);
+    mraa_gpio_use_mmaped(this->m_dataPinCtx, 0);
+
+    pthread_mutex_lock(&m_lock);
+    m_running = false;
+    pthread_cond_broadcast(&m_newSample);
+    pthread_mutex_unlock(&m_lock);
+}
+
+void HX711::sample() {
+    pthread_mutex_lock(&m_lock);
+
+    // DOUT also toggles while a conversion is clocked out, which
+    // queues spurious interrupts
+    if (!m_running || mraa_gpio_read(this->m_dataPinCtx)) {
+        pthread_mutex_unlock(&m_lock);
+        return;
+    }
+
+    unsigned long value = shiftIn();
+
+    if (m_threshold && m_stored) {
+        unsigned long median = filter(FILTER_MEDIAN, m_window);
+        unsigned long diff = (value > median) ? value - median : median - value;
+
+        if (diff > m_threshold) {
+            if (++m_outliers < HX711_MAX_OUTLIERS) {
+                m_rejected++;
+                pthread_mutex_unlock(&m_lock);
+                return;
+            }
+
+            // the load changed, forget the old samples
+            m_stored = 0;
+        }
+    }
+
+    m_outliers = 0;
+
+    m_samples[m_head] = value;
+    m_head = (m_head + 1) % HX711_BUFFER_SIZE;
+    if (m_stored < HX711_BUFFER_SIZE)
+        m_stored++;
+    m_count++;
+
+    pthread_cond_broadcast(&m_newSample);
+    pthread_mutex_unlock(&m_lock);
+}
+
+void HX711::isrHandler(void *ctx) {
+    upm::HX711 *This = (upm::HX711 *)ctx;
+
+    This->sample();
+}
+
+void HX711::waitSample() {
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += HX711_READ_TIMEOUT / 1000;
+    deadline.tv_nsec += (HX711_READ_TIMEOUT % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    uint32_t count = m_count;
+
+    while (m_running && m_count == count) {
+        if (pthread_cond_timedwait(&m_newSample, &m_lock, &deadline)
+            == ETIMEDOUT) {
+            pthread_mutex_unlock(&m_lock);
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": Timed out waiting for a conversion.");
+            return;
+        }
+    }
+
+    if (m_count == count) {
+        pthread_mutex_unlock(&m_lock);
+        throw std::logic_error(std::string(__FUNCTION__) +
+                               ": Background acquisition is not running.");
+        return;
+    }
+}
+
+unsigned long HX711::filter(FILTER_T type, int window) {
+    unsigned long values[HX711_BUFFER_SIZE];
+    int n = std::min(window, m_stored);
+
+    // the most recent sample first
+    for (int i = 0; i < n; i++)
+        values[i] = m_samples[(m_head + HX711_BUFFER_SIZE - 1 - i) %
+                              HX711_BUFFER_SIZE];
+
+    switch (type) {
+        case FILTER_MOVING_AVERAGE: {
+            unsigned long sum = 0;
+            for (int i = 0; i < n; i++)
+                sum += values[i];
+            return sum / n;
+        }
+
+        case FILTER_MEDIAN:
+            std::nth_element(values, values + n / 2, values + n);
+            return values[n / 2];
+
+        default:
+            return values[0];
+    }
+}
+
+void HX711::setFilter(FILTER_T filter, int window) {
+    if (window < 1 || window > HX711_BUFFER_SIZE) {
+        throw std::out_of_range(std::string(__FUNCTION__) +
+                                ": window must be between 1 and "
+                                "HX711_BUFFER_SIZE");
+        return;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    m_filter = filter;
+    m_window = window;
+    pthread_mutex_unlock(&m_lock);
+}
+
+void HX711::setOutlierThreshold(unsigned long threshold) {
+    pthread_mutex_lock(&m_lock);
+    m_threshold = threshold;
+    m_outliers = 0;
+    pthread_mutex_unlock(&m_lock);
+}
+
+unsigned long HX711::readFiltered() {
+    pthread_mutex_lock(&m_lock);
+
+    if (!m_stored)
+        waitSample();
+
+    unsigned long value = filter(m_filter, m_window);
+
+    pthread_mutex_unlock(&m_lock);
+
+    return value;
+}
+
+uint32_t HX711::getSampleCount() {
+    pthread_mutex_lock(&m_lock);
+    uint32_t count = m_count;
+    pthread_mutex_unlock(&m_lock);
+
+    return count;
+}
+
+uint32_t HX711::getRejectedCount() {
+    pthread_mutex_lock(&m_lock);
+    uint32_t count = m_rejected;
+    pthread_mutex_unlock(&m_lock);
+
+    return count;
 }
 
 void HX711::setGain(uint8_t gain){
+    pthread_mutex_lock(&m_lock);
     switch (gain) {
         case 128:       // channel A, gain factor 128
             GAIN = 24;
@@ -111,10 +365,31 @@ void HX711::setGain(uint8_t gain){
     }
 
     mraa_gpio_write(this->m_sckPinCtx, 0);
+    pthread_mutex_unlock(&m_lock);
+
     read();
+
+    // samples converted at the old gain
+    if (m_running) {
+        pthread_mutex_lock(&m_lock);
+        m_stored = 0;
+        pthread_mutex_unlock(&m_lock);
+    }
 }
 
 unsigned long HX711::readAverage(uint8_t times){
+    if (m_running) {
+        int n = std::max(1, std::min(int(times), HX711_BUFFER_SIZE));
+
+        pthread_mutex_lock(&m_lock);
+        while (m_stored < n)
+            waitSample();
+        unsigned long value = filter(FILTER_MOVING_AVERAGE, n);
+        pthread_mutex_unlock(&m_lock);
+
+        return value;
+    }
+
     unsigned long sum = 0;
     for (uint8_t i = 0; i < times; i++) {
         sum += read();
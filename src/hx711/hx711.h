@@ -25,8 +25,23 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 #include <mraa/gpio.h>
 
+// Number of samples kept by the background acquisition
+#define HX711_BUFFER_SIZE 64
+
+// Default number of samples the filters work on
+#define HX711_DEFAULT_WINDOW 10
+
+// Consecutive outliers after which a sample is accepted anyway, so a
+// real change of load is followed
+#define HX711_MAX_OUTLIERS 3
+
+// Time to wait for a conversion, in milliseconds.  The chip converts
+// at 10 or 80 samples per second.
+#define HX711_READ_TIMEOUT 1000
+
 namespace upm {
      /**
       * @brief HX711 24-bit ADC library
@@ -50,11 +65,36 @@ namespace upm {
       * interface directly with a bridge sensor. This module was tested on
       * the Intel(R) Galileo Gen 2 board.
       *
+      * Readings can be taken on demand with read(), or continuously in
+      * the background.  start() installs an interrupt handler on the
+      * falling edge of DOUT, which signals a finished conversion, so no
+      * thread spins waiting for the chip.  The handler clocks out the
+      * conversion, using memory mapped GPIO when the platform supports
+      * it, and stores it in a ring buffer of the last
+      * HX711_BUFFER_SIZE samples.  readFiltered() returns the median or
+      * moving average of the most recent samples, and isolated samples
+      * far from the median can be rejected before they are stored.
+      * While running, read(), readAverage() and tare() take their
+      * samples from the buffer.
+      *
+      * Each instance has its own interrupt thread, so several HX711s
+      * (for instance the load cells of one scale) are sampled
+      * concurrently.
+      *
       * @image html hx711.jpeg
       * @snippet hx711.cxx Interesting
       */
       class HX711 {
       public:
+            /**
+            * Filters applied by readFiltered()
+            */
+            typedef enum {
+                FILTER_NONE           = 0, // most recent sample
+                FILTER_MOVING_AVERAGE = 1,
+                FILTER_MEDIAN         = 2
+            } FILTER_T;
+
             /**
             * HX711 constructor
             *
@@ -71,12 +111,73 @@ namespace upm {
             ~HX711();
 
             /**
-            * Waits for the chip to be ready and returns a reading
+            * Waits for the chip to be ready and returns a reading.  In
+            * background mode, waits for the next sample instead.
+            * Throws std::runtime_error if no conversion finishes within
+            * HX711_READ_TIMEOUT milliseconds.
             *
             * @return Raw ADC reading
             */
             unsigned long read();
 
+            /**
+            * Starts background acquisition.  Samples are read as soon
+            * as the chip signals a finished conversion.
+            */
+            void start();
+
+            /**
+            * Stops background acquisition.  The buffered samples are
+            * kept.
+            */
+            void stop();
+
+            /**
+            * Returns whether background acquisition is running
+            * @return True if running
+            */
+            bool isRunning() { return m_running; };
+
+            /**
+            * Sets the filter used by readFiltered()
+            * @param filter One of the FILTER_T values
+            * @param window Number of recent samples to filter, up to
+            * HX711_BUFFER_SIZE
+            */
+            void setFilter(FILTER_T filter, int window = HX711_DEFAULT_WINDOW);
+
+            /**
+            * Enables outlier rejection in background mode.  A sample
+            * that differs from the median of the filter window by more
+            * than the threshold is dropped, unless it is the
+            * HX711_MAX_OUTLIERS-th in a row.  Such a run is taken as a
+            * change of load, and the buffer restarts from that sample.
+            * @param threshold Maximum difference in raw counts, 0 to
+            * disable
+            */
+            void setOutlierThreshold(unsigned long threshold);
+
+            /**
+            * Returns the filtered reading of the most recent samples.
+            * Only available in background mode; waits for the first
+            * sample if none was stored yet.
+            * @return Filtered raw ADC reading
+            */
+            unsigned long readFiltered();
+
+            /**
+            * Returns the number of samples stored since start()
+            * @return Sample count
+            */
+            uint32_t getSampleCount();
+
+            /**
+            * Returns the number of samples rejected as outliers since
+            * start()
+            * @return Rejected sample count
+            */
+            uint32_t getRejectedCount();
+
             /**
             * Sets the gain factor; takes effect only after a call to read()
             * channel A can be set for a 128 or 64 gain; channel B has a fixed 32-gain
@@ -86,7 +187,9 @@ namespace upm {
             void setGain(uint8_t gain = 128);
 
             /**
-            * Returns an average reading
+            * Returns an average reading.  In background mode, the most
+            * recent buffered samples are averaged, waiting only until
+            * that many samples have been stored.
             * @param times Defines how many reading to do
             * @return Average reading
             */
@@ -133,6 +236,35 @@ namespace upm {
             * @param scale Value obtained via calibration
             */
             void setOffset(long offset = 0);
+
+            // clock out a conversion, DOUT must be low
+            unsigned long shiftIn();
+            // wait for the next sample to be stored, m_lock held
+            void waitSample();
+            // filter the most recent samples, m_lock held
+            unsigned long filter(FILTER_T type, int window);
+
+            // read a conversion if one is ready and store it
+            void sample();
+            static void isrHandler(void *ctx);
+
+            bool m_running;
+
+            FILTER_T m_filter;
+            int m_window;
+            unsigned long m_threshold;
+            int m_outliers;
+
+            unsigned long m_samples[HX711_BUFFER_SIZE];
+            // index of the next slot to fill
+            int m_head;
+            // number of valid samples in the buffer
+            int m_stored;
+            uint32_t m_count;
+            uint32_t m_rejected;
+
+            pthread_mutex_t m_lock;
+            pthread_cond_t m_newSample;
      };
 
 }
@@ -40,6 +40,7 @@ GFX::GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {
     textbgcolor = 0xFFFF;
     wrap = true;
     _cp437 = false;
+    textfont = &classicFont;
 }
 
 void GFX::drawLine(int16_t x0, 
@@ -47,57 +48,21 @@ void GFX::drawLine(int16_t x0,
                    int16_t x1, 
                    int16_t y1, 
                    uint16_t color) {
-                   
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
-    if (steep) {
-        adagfxswap(x0, y0);
-        adagfxswap(x1, y1);
-    }
-
-    if (x0 > x1) {
-        adagfxswap(x0, x1);
-        adagfxswap(y0, y1);
-    }
-
-    int16_t dx, dy;
-    dx = x1 - x0;
-    dy = abs(y1 - y0);
-
-    int16_t err = dx / 2;
-    int16_t ystep;
-
-    if (y0 < y1) {
-        ystep = 1;
-    } else {
-        ystep = -1;
-    }
-
-    for (; x0<=x1; x0++) {
-        if (steep) {
-            drawPixel(y0, x0, color);
-        } else {
-            drawPixel(x0, y0, color);
-        }
-        err -= dy;
-        if (err < 0) {
-            y0 += ystep;
-          err += dx;
-        }
-    }
+    rasterLine(x0, y0, x1, y1, color);
 }
 
 void GFX::drawFastVLine(int16_t x, 
                         int16_t y, 
                         int16_t h, 
                         uint16_t color) {
-    drawLine(x, y, x, y+h-1, color);
+    rasterVLine(x, y, h, color);
 }
 
 void GFX::drawFastHLine(int16_t x, 
                         int16_t y, 
                         int16_t w, 
                         uint16_t color) {
-    drawLine(x, y, x+w-1, y, color);
+    rasterHLine(x, y, w, color);
 }
 
 void GFX::drawRect(int16_t x, 
@@ -105,10 +70,7 @@ void GFX::drawRect(int16_t x,
                    int16_t w, 
                    int16_t h, 
                    uint16_t color) {
-    drawFastHLine(x, y, w, color);
-    drawFastHLine(x, y+h-1, w, color);
-    drawFastVLine(x, y, h, color);
-    drawFastVLine(x+w-1, y, h, color);
+    rasterRect(x, y, w, h, color);
 }
 
 void GFX::fillRect(int16_t x, 
@@ -116,9 +78,7 @@ void GFX::fillRect(int16_t x,
                    int16_t w, 
                    int16_t h, 
                    uint16_t color) {
-    for (int16_t i=x; i<x+w; i++) {
-        drawFastVLine(i, y, h, color);
-    }
+    rasterBlock(x, y, w, h, color);
 }
 
 void GFX::fillScreen(uint16_t color) {
@@ -130,36 +90,7 @@ void GFX::invertDisplay(bool i) {
 }
 
 void GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-
-    drawPixel(x0  , y0+r, color);
-    drawPixel(x0  , y0-r, color);
-    drawPixel(x0+r, y0  , color);
-    drawPixel(x0-r, y0  , color);
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        drawPixel(x0 + x, y0 + y, color);
-        drawPixel(x0 - x, y0 + y, color);
-        drawPixel(x0 + x, y0 - y, color);
-        drawPixel(x0 - x, y0 - y, color);
-        drawPixel(x0 + y, y0 + x, color);
-        drawPixel(x0 - y, y0 + x, color);
-        drawPixel(x0 + y, y0 - x, color);
-        drawPixel(x0 - y, y0 - x, color);
-    }
+    rasterCircle(x0, y0, r, color);
 }
 
 void GFX::drawCircleHelper(int16_t x0, 
@@ -167,43 +98,11 @@ void GFX::drawCircleHelper(int16_t x0,
                            int16_t r, 
                            uint8_t cornername,
                            uint16_t color) {
-    int16_t f     = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x     = 0;
-    int16_t y     = r;
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f     += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f     += ddF_x;
-        if (cornername & 0x4) {
-            drawPixel(x0 + x, y0 + y, color);
-            drawPixel(x0 + y, y0 + x, color);
-        }
-        if (cornername & 0x2) {
-            drawPixel(x0 + x, y0 - y, color);
-            drawPixel(x0 + y, y0 - x, color);
-        }
-        if (cornername & 0x8) {
-            drawPixel(x0 - y, y0 + x, color);
-            drawPixel(x0 - x, y0 + y, color);
-        }
-        if (cornername & 0x1) {
-            drawPixel(x0 - y, y0 - x, color);
-            drawPixel(x0 - x, y0 - y, color);
-        }
-    }
+    rasterCircleCorners(x0, y0, r, cornername, color);
 }
 
 void GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    drawFastVLine(x0, y0-r, 2*r+1, color);
-    fillCircleHelper(x0, y0, r, 3, 0, color);
+    rasterFillCircle(x0, y0, r, color);
 }
 
 void GFX::fillCircleHelper(int16_t x0, 
@@ -212,31 +111,7 @@ void GFX::fillCircleHelper(int16_t x0,
                            uint8_t cornername,
                            int16_t delta,
                            uint16_t color) {
-    int16_t f     = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x     = 0;
-    int16_t y     = r;
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f     += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f     += ddF_x;
-
-        if (cornername & 0x1) {
-            drawFastVLine(x0+x, y0-y, 2*y+1+delta, color);
-            drawFastVLine(x0+y, y0-x, 2*x+1+delta, color);
-        }
-        if (cornername & 0x2) {
-            drawFastVLine(x0-x, y0-y, 2*y+1+delta, color);
-            drawFastVLine(x0-y, y0-x, 2*x+1+delta, color);
-        }
-    }
+    rasterFillCircleHalves(x0, y0, r, cornername, delta, color);
 }
 
 void GFX::drawTriangle(int16_t x0, 
@@ -246,9 +121,7 @@ void GFX::drawTriangle(int16_t x0,
                        int16_t x2, 
                        int16_t y2, 
                        uint16_t color) {
-  drawLine(x0, y0, x1, y1, color);
-  drawLine(x1, y1, x2, y2, color);
-  drawLine(x2, y2, x0, y0, color);
+    rasterTriangle(x0, y0, x1, y1, x2, y2, color);
 }
 
 void GFX::fillTriangle(int16_t x0, 
@@ -258,79 +131,7 @@ void GFX::fillTriangle(int16_t x0,
                        int16_t x2, 
                        int16_t y2, 
                        uint16_t color) {
-
-  int16_t a, b, y, last;
-
-  // Sort coordinates by Y order (y2 >= y1 >= y0)
-  if (y0 > y1) {
-    adagfxswap(y0, y1); adagfxswap(x0, x1);
-  }
-  if (y1 > y2) {
-    adagfxswap(y2, y1); adagfxswap(x2, x1);
-  }
-  if (y0 > y1) {
-    adagfxswap(y0, y1); adagfxswap(x0, x1);
-  }
-
-  if(y0 == y2) { // Handle awkward all-on-same-line case as its own thing
-    a = b = x0;
-    if(x1 < a)      a = x1;
-    else if(x1 > b) b = x1;
-    if(x2 < a)      a = x2;
-    else if(x2 > b) b = x2;
-    drawFastHLine(a, y0, b-a+1, color);
-    return;
-  }
-
-  int16_t
-    dx01 = x1 - x0,
-    dy01 = y1 - y0,
-    dx02 = x2 - x0,
-    dy02 = y2 - y0,
-    dx12 = x2 - x1,
-    dy12 = y2 - y1;
-  int32_t
-    sa   = 0,
-    sb   = 0;
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
-  if(y1 == y2) last = y1;   // Include y1 scanline
-  else         last = y1-1; // Skip it
-
-  for(y=y0; y<=last; y++) {
-    a   = x0 + sa / dy01;
-    b   = x0 + sb / dy02;
-    sa += dx01;
-    sb += dx02;
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) adagfxswap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
-  }
-
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = dx12 * (y - y1);
-  sb = dx02 * (y - y0);
-  for(; y<=y2; y++) {
-    a   = x1 + sa / dy12;
-    b   = x0 + sb / dy02;
-    sa += dx12;
-    sb += dx02;
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) adagfxswap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
-  }
+    rasterFillTriangle(x0, y0, x1, y1, x2, y2, color);
 }
 
 // Draw a rounded rectangle
@@ -340,17 +141,7 @@ void GFX::drawRoundRect(int16_t x,
                         int16_t h, 
                         int16_t r, 
                         uint16_t color) {
-                        
-  // smarter version
-  drawFastHLine(x+r  , y    , w-2*r, color); // Top
-  drawFastHLine(x+r  , y+h-1, w-2*r, color); // Bottom
-  drawFastVLine(x    , y+r  , h-2*r, color); // Left
-  drawFastVLine(x+w-1, y+r  , h-2*r, color); // Right
-  // draw four corners
-  drawCircleHelper(x+r    , y+r    , r, 1, color);
-  drawCircleHelper(x+w-r-1, y+r    , r, 2, color);
-  drawCircleHelper(x+w-r-1, y+h-r-1, r, 4, color);
-  drawCircleHelper(x+r    , y+h-r-1, r, 8, color);
+    rasterRoundRect(x, y, w, h, r, color);
 }
 
 void GFX::fillRoundRect(int16_t x, 
@@ -359,13 +150,28 @@ void GFX::fillRoundRect(int16_t x,
                         int16_t h, 
                         int16_t r, 
                         uint16_t color) {
-                        
-  // smarter version
-  fillRect(x+r, y, w-2*r, h, color);
+    rasterFillRoundRect(x, y, w, h, r, color);
+}
+
+void GFX::drawImage(int16_t x,
+                    int16_t y,
+                    const uint8_t *pixels,
+                    int16_t w,
+                    int16_t h,
+                    Raster::IMAGE_FORMAT_T format,
+                    uint8_t scale) {
+    rasterImage(x, y, pixels, w, h, w * imageBytesPerPixel(format), format,
+                scale);
+}
 
-  // draw four corners
-  fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
-  fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+void GFX::drawImage(int16_t x, int16_t y, RasterImage &image, uint8_t scale) {
+    rasterImage(x, y, image.pixels(), image.width(), image.height(),
+                image.stride(), image.format(), scale);
+}
+
+void GFX::drawImage(int16_t x, int16_t y, std::string filename, uint8_t scale) {
+    RasterImage image(filename);
+    drawImage(x, y, image, scale);
 }
 
 void GFX::drawChar(int16_t x, 
@@ -383,20 +189,7 @@ void GFX::drawChar(int16_t x,
 
     if(!_cp437 && (c >= 176)) c++; // Handle 'classic' charset behavior
 
-    for(int8_t i=0; i<6; i++ ) {
-        uint8_t line;
-        if(i < 5) line = font[(c * 5) + i];
-        else      line = 0x0;
-        for(int8_t j=0; j<8; j++, line >>= 1) {
-            if(line & 0x1) {
-                if(size == 1) drawPixel(x+i, y+j, color);
-                else          fillRect(x+(i*size), y+(j*size), size, size, color);
-            } else if(bg != color) {
-                if(size == 1) drawPixel(x+i, y+j, bg);
-                else          fillRect(x+i*size, y+j*size, size, size, bg);
-            }
-        }
-    }
+    rasterGlyph(x, y, &font[c * 5], color, bg, size, 6);
 }
 
 int16_t GFX::getCursorX(void) const {
@@ -455,30 +248,69 @@ void GFX::cp437(bool x) {
     _cp437 = x;
 }
 
+void GFX::setFont(const Raster::FONT_T *f) {
+    textfont = f ? f : &classicFont;
+}
+
+unsigned char GFX::glyphCode(unsigned char c) const {
+    if(textfont == &classicFont && !_cp437 && (c >= 176)) c++; // Handle 'classic' charset behavior
+    return c;
+}
+
 void GFX::write(uint8_t c) {
     
     if(c == '\n') {
-        cursor_y += textsize*8;
+        cursor_y += textsize * textfont->height;
         cursor_x  = 0;
     } else if(c == '\r') {
         // skip em
     } else {
+        unsigned char g = glyphCode(c);
+        int16_t advance = textsize * glyphAdvance(textfont, g);
     
         // Heading off edge?
-        if(wrap && ((cursor_x + textsize * 6) >= _width)) {
-            cursor_x  = 0;            // Reset x to zero
-            cursor_y += textsize * 8; // Advance y one line
+        if(wrap && ((cursor_x + advance) >= _width)) {
+            cursor_x  = 0;                            // Reset x to zero
+            cursor_y += textsize * textfont->height;  // Advance y one line
         }
-        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
-        cursor_x += textsize * 6;
+        rasterText(cursor_x, cursor_y, textfont, &g, 1, textcolor, textbgcolor, textsize);
+        cursor_x += advance;
     }
 }
 
 void GFX::print(std::string msg) {
+    // the characters of the current line, drawn as one run
+    std::string run;
+    int16_t runX = cursor_x;
+    int16_t runY = cursor_y;
     int len = msg.length();
+
     for (int idx = 0; idx < len; idx++) {
-        write(msg[idx]);
+        if(msg[idx] == '\r') continue;
+
+        unsigned char g = glyphCode(msg[idx]);
+        int16_t advance = textsize * glyphAdvance(textfont, g);
+
+        if((msg[idx] == '\n') || (wrap && ((cursor_x + advance) >= _width))) {
+            rasterText(runX, runY, textfont, (const unsigned char *)run.data(),
+                       run.size(), textcolor, textbgcolor, textsize);
+            run.clear();
+
+            cursor_x  = 0;
+            cursor_y += textsize * textfont->height;
+            if(msg[idx] == '\n') continue;
+        }
+
+        if(run.empty()) {
+            runX = cursor_x;
+            runY = cursor_y;
+        }
+        run += g;
+        cursor_x += advance;
     }
+
+    rasterText(runX, runY, textfont, (const unsigned char *)run.data(),
+               run.size(), textcolor, textbgcolor, textsize);
 }
 
 int16_t GFX::width(void) const {
@@ -746,4 +578,6 @@ const unsigned char GFX::font[] = {
     0x00, 0x19, 0x1D, 0x17, 0x12,
     0x00, 0x3C, 0x3C, 0x3C, 0x3C,
     0x00, 0x00, 0x00, 0x00, 0x00  // #255 NBSP
-};
\ No newline at end of file
+};
+
+const Raster::FONT_T GFX::classicFont = { GFX::font, 0, 0, 5, 8, 0, 256, 1 };
@@ -27,6 +27,7 @@
 #pragma once
 
 #include <mraa.hpp>
+#include "raster.h"
 
 #define adagfxswap(a, b) { int16_t t = a; a = b; b = t; }
 
@@ -34,8 +35,11 @@ namespace upm
 {
     /**
      * @brief GFX helper class
+     *
+     * The primitives are rasterized by upm::Raster into clipped solid
+     * blocks, which the display driver fills through fillBlock().
      */
-    class GFX {
+    class GFX : protected Raster {
         public:
         
             /**
@@ -265,6 +269,55 @@ namespace upm
                                int16_t radius, 
                                uint16_t color);
                                
+            /**
+             * Draw an image from memory, such as a decoded camera frame.
+             * Images in RGB565 (high byte first) are sent straight from
+             * the buffer; other formats are converted a few rows at a
+             * time.
+             *
+             * @param x X-axis coordinate of the top-left corner
+             * @param y Y-axis coordinate of the top-left corner
+             * @param pixels First pixel of the top row
+             * @param w Width of the image in pixels
+             * @param h Height of the image in pixels
+             * @param format Pixel format of the image
+             * @param scale Integer scale factor
+             */
+            void drawImage(int16_t x,
+                           int16_t y,
+                           const uint8_t *pixels,
+                           int16_t w,
+                           int16_t h,
+                           Raster::IMAGE_FORMAT_T format = Raster::IMAGE_RGB565,
+                           uint8_t scale = 1);
+
+            /**
+             * Draw a memory mapped image, see RasterImage.
+             *
+             * @param x X-axis coordinate of the top-left corner
+             * @param y Y-axis coordinate of the top-left corner
+             * @param image The image
+             * @param scale Integer scale factor
+             */
+            void drawImage(int16_t x,
+                           int16_t y,
+                           RasterImage &image,
+                           uint8_t scale = 1);
+
+            /**
+             * Draw a BMP file (uncompressed 16, 24 or 32 bit). The file
+             * is memory mapped, not read.
+             *
+             * @param x X-axis coordinate of the top-left corner
+             * @param y Y-axis coordinate of the top-left corner
+             * @param filename The BMP file
+             * @param scale Integer scale factor
+             */
+            void drawImage(int16_t x,
+                           int16_t y,
+                           std::string filename,
+                           uint8_t scale = 1);
+
             /**
              * Draw a character at the specified point.
              *
@@ -354,6 +407,15 @@ namespace upm
              * @param x True to enable CP437 charset. False to disable.
              */
             void cp437(bool x);
+
+            /**
+             * Set the font used by write() and print().  Fonts may be
+             * proportional, and taller than the built-in one; the line
+             * height follows the font.
+             *
+             * @param f Font, or NULL for the built-in 5x8 font
+             */
+            void setFont(const Raster::FONT_T *f);
             
             /**
              * Write a character at the current cursor position. Definition
@@ -364,7 +426,9 @@ namespace upm
             virtual void write(uint8_t c);
             
             /**
-             * Prints a string to the screen.
+             * Prints a string to the screen. The characters of each line
+             * are composed from cached glyphs and sent as one block, so
+             * write() is not called.
              *
              * @param s Message to print
              */
@@ -385,7 +449,10 @@ namespace upm
             int16_t height(void) const;
             
         protected:
-        
+
+            int16_t rasterWidth() { return _width; }
+            int16_t rasterHeight() { return _height; }
+
             const int16_t WIDTH;
             const int16_t HEIGHT;
             
@@ -401,6 +468,12 @@ namespace upm
             uint8_t textsize;
             bool wrap;
             bool _cp437;
+            const Raster::FONT_T *textfont;
             static const unsigned char font[];
+            static const Raster::FONT_T classicFont;
+
+        private:
+            // the glyph drawn for a character of the current font
+            unsigned char glyphCode(unsigned char c) const;
     };
 }     
\ No newline at end of file
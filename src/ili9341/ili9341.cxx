@@ -255,93 +255,61 @@ void ILI9341::drawPixel(int16_t x, int16_t y, uint16_t color) {
     writedata(color);
 }
 
-void ILI9341::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+void ILI9341::fillBlock(int16_t x,
+                        int16_t y,
+                        int16_t w,
+                        int16_t h,
+                        uint16_t color) {
 
-    // Rudimentary clipping
-    if((x >= _width) || (y >= _height)) {
-        return;
-    }
-    
-    if((y+h-1) >= _height) {
-        h = _height-y;
-    }
-
-    setAddrWindow(x, y, x, y+h-1);
-
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
-    
-    lcdCSOn();
-    dcHigh();
-
-    while (h--) {
-        m_spi.writeByte(hi);
-        m_spi.writeByte(lo);
-    }
-
-    lcdCSOff();
-}
-
-void ILI9341::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
-
-    // Rudimentary clipping
-    if((x >= _width) || (y >= _height)) {
-        return;
-    }
-
-    if((x+w-1) >= _width) {
-        w = _width - x;
-    }
-
-    setAddrWindow(x, y, x+w-1, y);
+    setAddrWindow(x, y, x+w-1, y+h-1);
 
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
+    int total = w * h;
+    int chunk = (total < ILI9341_SPAN_PIXELS) ? total : ILI9341_SPAN_PIXELS;
+    Raster::fill565(m_spanBuffer, color, chunk);
 
     lcdCSOn();
     dcHigh();
 
-    while (w--) {
-        m_spi.writeByte(hi);
-        m_spi.writeByte(lo);
+    while (total > 0) {
+        int n = (total < chunk) ? total : chunk;
+        m_spi.transfer(m_spanBuffer, NULL, n * 2);
+        total -= n;
     }
 
     lcdCSOff();
 }
 
-void ILI9341::fillRect(int16_t x, 
-                       int16_t y, 
-                       int16_t w, 
-                       int16_t h,
-                       uint16_t color) {
-                       
-    // rudimentary clipping (drawChar w/big text requires this)
-    if((x >= _width) || (y >= _height)) return;
-    if((x + w - 1) >= _width)  w = _width  - x;
-    if((y + h - 1) >= _height) h = _height - y;
+void ILI9341::blitBlock(int16_t x,
+                        int16_t y,
+                        int16_t w,
+                        int16_t h,
+                        const uint8_t *pixels,
+                        int stride) {
 
     setAddrWindow(x, y, x+w-1, y+h-1);
 
-    uint8_t hi = color >> 8;
-    uint8_t lo = color;
-  
     lcdCSOn();
     dcHigh();
 
-    for(y = h; y > 0; y--) {
-        for(x = w; x > 0; x--) {
-            m_spi.writeByte(hi);
-            m_spi.writeByte(lo);
+    if (stride == w * 2) {
+        // contiguous rows, send them as one stream
+        int total = w * h * 2;
+        while (total > 0) {
+            int n = (total < ILI9341_MAX_TRANSFER) ? total : ILI9341_MAX_TRANSFER;
+            m_spi.transfer(const_cast<uint8_t *>(pixels), NULL, n);
+            pixels += n;
+            total -= n;
+        }
+    } else {
+        for (int16_t row = 0; row < h; row++) {
+            m_spi.transfer(const_cast<uint8_t *>(pixels), NULL, w * 2);
+            pixels += stride;
         }
     }
 
     lcdCSOff();
 }
 
-void ILI9341::fillScreen(uint16_t color) {
-    fillRect(0, 0,  _width, _height, color);
-}
-
 void ILI9341::invertDisplay(bool i) {
     writecommand(i ? ILI9341_INVON : ILI9341_INVOFF);
 }
@@ -38,6 +38,13 @@
 #define ILI9341_TFTWIDTH    240
 #define ILI9341_TFTHEIGHT   320
 
+// Pixels of color sent per SPI transfer when filling a block
+#define ILI9341_SPAN_PIXELS 320
+
+// Largest SPI transfer used when streaming pixel data (the default
+// spidev buffer size)
+#define ILI9341_MAX_TRANSFER 4096
+
 #define SPI_FREQ            15000000
 
 #define ILI9341_NOP         0x00
@@ -202,48 +209,6 @@ namespace upm {
              */
             void drawPixel(int16_t x, int16_t y, uint16_t color);
 
-            /**
-             * Draws a vertical line using minimal SPI writes.
-             *
-             * @param x Axis on the horizontal scale to begin line
-             * @param y Axis on the vertical scale to begin line
-             * @param h Height of line in pixels
-             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
-             */
-            void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
-            
-            /**
-             * Draws a horizontal line using  minimal SPI writes.
-             *
-             * @param x Axis on the horizontal scale to begin line
-             * @param y Axis on the vertical scale to begin line
-             * @param w Width of line in pixels
-             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
-             */
-            void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
-            
-            /**
-             * Draw a filled rectangle.
-             *
-             * @param x Axis on the horizontal scale of upper-left corner
-             * @param y Axis on the vertical scale of upper-left corner
-             * @param w Width of rectangle in pixels
-             * @param h Height of rectangle in pixels
-             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
-             */
-            void fillRect(int16_t x, 
-                          int16_t y, 
-                          int16_t w, 
-                          int16_t h,
-                          uint16_t color);
-                          
-            /**
-             * Fill the screen with a single color.
-             *
-             * @param color RGB (16-bit) color (R[0-4], G[5-10], B[11-15]
-             */
-            void fillScreen(uint16_t color);
-            
             /**
              * Sets the screen to one of four 90 deg rotations.
              *
@@ -328,10 +293,27 @@ namespace upm {
              * Set reset line to LOW
              */
             mraa::Result rstLow();
-            
+
+        protected:
+            /**
+             * Fills a block by setting the address window once, and
+             * streaming the color from a prefilled buffer.
+             */
+            void fillBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                           uint16_t color);
+
+            /**
+             * Copies a block of pixels by setting the address window
+             * once, and streaming the rows in as few SPI transfers as
+             * possible.
+             */
+            void blitBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                           const uint8_t *pixels, int stride);
+
         private:
             mraa::Spi   m_spi;
             uint8_t     m_spiBuffer[32];
+            uint8_t     m_spanBuffer[ILI9341_SPAN_PIXELS * 2];
             
             mraa::Gpio  m_csLCDPinCtx;
             mraa::Gpio  m_csSDPinCtx;
@@ -62,16 +62,27 @@
 #define ITG3200_SLEEP 0x40
 #define ITG3200_WAKEUP 0x00
 
+//LSB per degree/second
+#define ITG3200_SENSITIVITY 14.375
+
 using namespace upm;
 
-Itg3200::Itg3200(int bus) : m_i2c(bus)
+Itg3200::Itg3200(int bus, bool blockingCalibration) :
+    m_gyroCal(3, GYROCAL_DEFAULT_THRESHOLD * ITG3200_SENSITIVITY), m_i2c(bus)
 {
     m_i2c.address(ITG3200_I2C_ADDR);
     m_buffer[0] = ITG3200_PWR_MGM;
     m_buffer[1] = ITG3200_RESET;
     m_i2c.write(m_buffer, 2);
 
-    Itg3200::calibrate();
+    for(int i = 0; i < 3; i++){
+        m_offsets[i] = 0;
+    }
+    m_backgroundCal = !blockingCalibration;
+
+    if (blockingCalibration){
+        Itg3200::calibrate();
+    }
     Itg3200::update();
 }
 
@@ -83,6 +94,10 @@ Itg3200::calibrate(void)
     int skip = 5; // initial samples to skip
     int temp[3] = {0};
 
+    for(int i = 0; i < 3; i++){
+        m_offsets[i] = 0;
+    }
+
     for(int i = 0; i < reads; i++){
 
         Itg3200::update();
@@ -94,9 +109,43 @@ Itg3200::calibrate(void)
         usleep(delay);
     }
 
+    float bias[3];
     for(int i = 0; i < 3; i++){
         m_offsets[i] = (-1) * temp[i] / (reads - skip);
+        bias[i] = -m_offsets[i];
+    }
+    m_gyroCal.setBias(bias);
+}
+
+void
+Itg3200::enableBackgroundCalibration(bool enable)
+{
+    m_backgroundCal = enable;
+}
+
+bool
+Itg3200::isCalibrated()
+{
+    return m_gyroCal.isCalibrated();
+}
+
+bool
+Itg3200::saveCalibration(std::string filename)
+{
+    return m_gyroCal.save(filename);
+}
+
+bool
+Itg3200::loadCalibration(std::string filename)
+{
+    if (!m_gyroCal.load(filename)){
+        return false;
     }
+
+    for(int i = 0; i < 3; i++){
+        m_offsets[i] = -lround(m_gyroCal.getBias(i));
+    }
+    return true;
 }
 
 float
@@ -109,7 +158,7 @@ float*
 Itg3200::getRotation()
 {
     for(int i = 0; i < 3; i++){
-        m_angle[i] = m_rotation[i]/14.375;
+        m_angle[i] = m_rotation[i]/ITG3200_SENSITIVITY;
     }
     return &m_angle[0];
 }
@@ -138,12 +187,28 @@ Itg3200::update(void)
     //temp
     //
     m_temperature = (m_buffer[0] << 8 ) | m_buffer[1];
+
+    int16_t raw[3];
     // x
-    m_rotation[0] = ((m_buffer[2] << 8 ) | m_buffer[3]) + m_offsets[0];
+    raw[0] = (m_buffer[2] << 8 ) | m_buffer[3];
     // y
-    m_rotation[1] = ((m_buffer[4] << 8 ) | m_buffer[5]) + m_offsets[1];
+    raw[1] = (m_buffer[4] << 8 ) | m_buffer[5];
     // z
-    m_rotation[2] = ((m_buffer[6] << 8 ) | m_buffer[7]) + m_offsets[2];
+    raw[2] = (m_buffer[6] << 8 ) | m_buffer[7];
+
+    if (m_backgroundCal){
+        float values[3] = { float(raw[0]), float(raw[1]), float(raw[2]) };
+
+        if (m_gyroCal.addSample(values)){
+            for(int i = 0; i < 3; i++){
+                m_offsets[i] = -lround(m_gyroCal.getBias(i));
+            }
+        }
+    }
+
+    for(int i = 0; i < 3; i++){
+        m_rotation[i] = raw[i] + m_offsets[i];
+    }
 
     return mraa::SUCCESS;
 }
@@ -23,8 +23,11 @@
  */
 #pragma once
 
+#include <string>
 #include <mraa/i2c.hpp>
 
+#include "gyrocal.h"
+
 #define READ_BUFFER_LENGTH 8
 
 namespace upm {
@@ -61,8 +64,12 @@ public:
      * Creates an Itg3200 object
      *
      * @param bus Number of the used I2C bus
+     * @param blockingCalibration If true (the default), calibrate() is
+     * called on object creation.  If false, background calibration is
+     * enabled instead, so the object is usable right away; a saved
+     * calibration can then be restored with loadCalibration().
      */
-    Itg3200(int bus);
+    Itg3200(int bus, bool blockingCalibration=true);
 
     /**
      * Calibrates the sensor to 0 on all axes. The sensor needs to be resting for accurate calibration.
@@ -71,6 +78,41 @@ public:
      */
     void calibrate();
 
+    /**
+     * Enables or disables background calibration.  When enabled,
+     * update() looks for periods where the sensor is at rest, and
+     * uses them to refine the zero offsets, without blocking.
+     *
+     * @param enable True to enable, false to disable.  Disabling keeps
+     * the current offsets.
+     */
+    void enableBackgroundCalibration(bool enable);
+
+    /**
+     * Returns true once the zero offsets are known, from calibrate(),
+     * background calibration or loadCalibration()
+     *
+     * @return bool True if calibrated
+     */
+    bool isCalibrated();
+
+    /**
+     * Saves the zero offsets, to be reloaded with loadCalibration() at
+     * the next start
+     *
+     * @param filename The file to write
+     * @return bool True if successful
+     */
+    bool saveCalibration(std::string filename);
+
+    /**
+     * Loads zero offsets written by saveCalibration()
+     *
+     * @param filename The file to read
+     * @return bool True if successful
+     */
+    bool loadCalibration(std::string filename);
+
     /**
      * Returns the temperature reading, in Celsius, from the integrated temperature sensor
      *
@@ -109,6 +151,8 @@ private:
     float m_angle[3];
     int16_t m_rotation[3];
     int16_t m_offsets[3];
+    GyroCal m_gyroCal;
+    bool m_backgroundCal;
     int16_t m_temperature;
     uint8_t m_buffer[READ_BUFFER_LENGTH];
     mraa::I2c m_i2c;
@@ -25,7 +25,9 @@
  * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include <unistd.h>
+#include <string.h>
 #include <iostream>
+#include <stdexcept>
 
 #include "eboled.h"
 
@@ -35,9 +37,12 @@ using namespace std;
 static uint16_t screenBuffer[BUFFER_SIZE];
 
 EBOLED::EBOLED(int spi, int CD, int reset) :
-  m_spi(spi), m_gpioCD(CD), m_gpioRST(reset)
+  m_spi(spi), m_gpioCD(CD), m_gpioRST(reset),
+  m_flush(sizeof(screenBuffer), &EBOLED::flushFrame, this)
 {
   m_name = "EBOLED";
+  m_buffer = screenBuffer;
+  m_shownValid = false;
   m_textColor = COLOR_WHITE;
   m_textWrap = 0;
   m_textSize = 1;
@@ -110,24 +115,155 @@ EBOLED::EBOLED(int spi, int CD, int reset) :
 
 EBOLED::~EBOLED()
 {
+  setDoubleBuffer(false);
   clear();
 }
 
 mraa::Result EBOLED::refresh()
 {
-  mraa::Result error = mraa::SUCCESS;;
+  if (m_flush.isRunning())
+  {
+    swapBuffers();
+    return mraa::SUCCESS;
+  }
 
-  m_gpioCD.write(1);            // data mode
-  for(int i=0; i<BUFFER_SIZE; i++)
+  return sendFrame(screenBuffer);
+}
+
+void EBOLED::invalidate()
+{
+  m_flush.waitIdle();
+  m_shownValid = false;
+}
+
+mraa::Result EBOLED::sendFrame(const uint16_t *frame)
+{
+  mraa::Result error = mraa::SUCCESS;
+  int page = 0;
+
+  while (page < OLED_PAGES)
   {
-    error = data(screenBuffer[i]);
-    if(error != mraa::SUCCESS)
+    if (!pageChanged(frame, page))
+    {
+      page++;
+      continue;
+    }
+
+    // merge consecutive changed pages into one window and burst
+    int last = page;
+    while (last + 1 < OLED_PAGES && pageChanged(frame, last + 1))
+      last++;
+
+    if ((error = sendPages(frame, page, last)) != mraa::SUCCESS)
+    {
+      // the display no longer matches m_shown
+      m_shownValid = false;
       return error;
+    }
+
+    page = last + 1;
+  }
+
+  m_shownValid = true;
+  return error;
+}
+
+bool EBOLED::pageChanged(const uint16_t *frame, int page)
+{
+  if (!m_shownValid)
+    return true;
+
+  return memcmp(&frame[page * VERT_COLUMNS], &m_shown[page * VERT_COLUMNS],
+                VERT_COLUMNS * sizeof(uint16_t)) != 0;
+}
+
+mraa::Result EBOLED::sendPages(const uint16_t *frame, int first, int last)
+{
+  command(CMD_SETPAGEADDRESS);
+  command(first);
+  command(last);
+
+  command(CMD_SETCOLUMNADDRESS);
+  command(0x20);
+  command(0x5f);
+
+  // each entry holds two columns, the even one in the low byte
+  int len = 0;
+  for (int i = first * VERT_COLUMNS; i < (last + 1) * VERT_COLUMNS; i++)
+  {
+    m_pageBuffer[len++] = frame[i] & 0xff;
+    m_pageBuffer[len++] = frame[i] >> 8;
   }
 
+  m_gpioCD.write(1);            // data mode
+  mraa::Result error = m_spi.transfer(m_pageBuffer, NULL, len);
+  if (error != mraa::SUCCESS)
+    return error;
+
+  memcpy(&m_shown[first * VERT_COLUMNS], &frame[first * VERT_COLUMNS],
+         (last + 1 - first) * VERT_COLUMNS * sizeof(uint16_t));
+
   return error;
 }
 
+void EBOLED::flushFrame(const uint8_t *frame, void *ctx)
+{
+  EBOLED *This = static_cast<EBOLED *>(ctx);
+
+  if (This->sendFrame((const uint16_t *)frame) != mraa::SUCCESS)
+  {
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": SPI transfer failed");
+    return;
+  }
+}
+
+void EBOLED::setDoubleBuffer(bool enable)
+{
+  // m_buffer is where drawing goes, screenBuffer the single buffer
+  if (enable)
+  {
+    if (!m_flush.isRunning())
+      m_buffer = (uint16_t *)m_flush.start((uint8_t *)screenBuffer);
+  }
+  else if (m_flush.isRunning())
+  {
+    m_flush.stop((uint8_t *)screenBuffer);
+    m_buffer = screenBuffer;
+  }
+}
+
+void EBOLED::swapBuffers(bool preserve)
+{
+  if (!m_flush.isRunning())
+  {
+    sendFrame(screenBuffer);
+    return;
+  }
+
+  m_buffer = (uint16_t *)m_flush.swapBuffers(preserve);
+}
+
+void EBOLED::setFrameRate(float fps)
+{
+  m_flush.setFrameRate(fps);
+}
+
+float EBOLED::getFrameTime()
+{
+  return m_flush.getFrameTime();
+}
+
+float EBOLED::getFlushTime()
+{
+  return m_flush.getFlushTime();
+}
+
+uint32_t EBOLED::getFrameCount()
+{
+  return m_flush.getFrameCount();
+}
+
 mraa::Result EBOLED::write (std::string msg)
 {
   int len = msg.length();
@@ -213,17 +349,13 @@ void EBOLED::drawChar (uint8_t x, uint8_t y, uint8_t data, uint8_t color, uint8_
 
 mraa::Result EBOLED::clear()
 {
-  mraa::Result error = mraa::SUCCESS;;
+  static const uint16_t blank[BUFFER_SIZE] = { 0 };
 
-  m_gpioCD.write(1);            // data mode
-  for(int i=0; i<BUFFER_SIZE; i++)
-  {
-    error = data(0x0000);
-    if(error != mraa::SUCCESS)
-      return error;
-  }
+  // the flush thread must be done with the display first
+  m_flush.waitIdle();
 
-  return mraa::SUCCESS;;
+  m_shownValid = false;
+  return sendPages(blank, 0, OLED_PAGES - 1);
 }
 
 mraa::Result EBOLED::home()
@@ -248,13 +380,13 @@ void EBOLED::drawPixel(int8_t x, int8_t y, uint8_t color)
   switch(color)
   {
     case COLOR_XOR:
-      screenBuffer[(x/2) + ((y/8) * VERT_COLUMNS)] ^= (1<<(y%8+(x%2 * 8)));
+      m_buffer[(x/2) + ((y/8) * VERT_COLUMNS)] ^= (1<<(y%8+(x%2 * 8)));
       return;
     case COLOR_WHITE:
-      screenBuffer[(x/2) + ((y/8) * VERT_COLUMNS)] |= (1<<(y%8+(x%2 * 8)));
+      m_buffer[(x/2) + ((y/8) * VERT_COLUMNS)] |= (1<<(y%8+(x%2 * 8)));
       return;
     case COLOR_BLACK:
-      screenBuffer[(x/2) + ((y/8) * VERT_COLUMNS)] &= ~(1<<(y%8+(x%2 * 8)));
+      m_buffer[(x/2) + ((y/8) * VERT_COLUMNS)] &= ~(1<<(y%8+(x%2 * 8)));
       return;
   }
 }
@@ -562,6 +694,5 @@ mraa::Result EBOLED::data(uint16_t data)
 
 void EBOLED::clearScreenBuffer()
 {
-  for(int i=0; i<BUFFER_SIZE;i++)
-    screenBuffer[i] = 0x0000;
+  memset(m_buffer, 0, BUFFER_SIZE * sizeof(uint16_t));
 }
@@ -36,6 +36,7 @@
 
 #include "lcd.h"
 #include "ssd.h"
+#include "frameflush.h"
 
 #define EBOLED_DEFAULT_SPI_BUS 0
 #define EBOLED_DEFAULT_CD      36
@@ -51,6 +52,7 @@ namespace upm
   const uint8_t OLED_WIDTH      = 0x40; // 64 pixels
   const uint8_t VERT_COLUMNS    = 0x20; // half width for hi/lo 16bit writes.
   const uint8_t OLED_HEIGHT     = 0x30; // 48 pixels
+  const uint8_t OLED_PAGES      = 0x06; // 8 pixel high pages
   const int     BUFFER_SIZE     = 192;
 
   /**
@@ -132,12 +134,68 @@ namespace upm
     ~EBOLED();
 
     /**
-     * Draw the buffer to screen.
+     * Draw the buffer to screen.  Only the pages (8 pixel high rows)
+     * that differ from what the display currently shows are sent,
+     * each run of changed pages in a single SPI transfer.  In double
+     * buffered mode, this is the same as swapBuffers().
      *
      * @return result of operation
      */
     mraa::Result refresh();
 
+    /**
+     * Make the next refresh() send every page, for instance after
+     * the display RAM was changed behind the driver's back.
+     */
+    void invalidate();
+
+    /**
+     * Enables or disables double buffering.  When enabled, drawing
+     * goes to a back buffer, and swapBuffers() hands it to a
+     * background thread that sends its changed pages to the display,
+     * so the next frame can be drawn while the current one is on the
+     * wire.  Apart from drawing and swapBuffers(), the display must
+     * not be accessed while double buffering is enabled.
+     *
+     * @param enable True to enable, false to wait for the last frame
+     * and return to the single buffer
+     */
+    void setDoubleBuffer(bool enable);
+
+    /**
+     * Sends the frame drawn so far and continues with the other
+     * buffer.  Blocks only while the previous frame is still being
+     * sent.  Without double buffering, this is the same as refresh().
+     *
+     * @param preserve True to start the next frame as a copy of this
+     * one, false if the whole frame is redrawn every time
+     */
+    void swapBuffers(bool preserve=true);
+
+    /**
+     * Limits the rate at which double buffered frames are sent
+     *
+     * @param fps Maximum frames per second, 0 for no limit
+     */
+    void setFrameRate(float fps);
+
+    /**
+     * Returns the time between the last two swapBuffers() calls, in
+     * milliseconds
+     */
+    float getFrameTime();
+
+    /**
+     * Returns the time spent sending the last double buffered frame,
+     * in milliseconds
+     */
+    float getFlushTime();
+
+    /**
+     * Returns the number of double buffered frames sent
+     */
+    uint32_t getFrameCount();
+
     /**
      * Write a string to LCD
      *
@@ -374,5 +432,24 @@ namespace upm
     uint8_t m_textSize;
     uint8_t m_textColor;
     uint8_t m_textWrap;
+
+    // where drawing goes, the single buffer or the double buffered
+    // back buffer
+    uint16_t *m_buffer;
+
+    // what the display RAM holds, valid once a full frame was sent
+    uint16_t m_shown[BUFFER_SIZE];
+    bool m_shownValid;
+
+    // one transfer of up to all pages, in column byte order
+    uint8_t m_pageBuffer[BUFFER_SIZE * 2];
+
+    FrameFlush m_flush;
+
+    // send the pages of a frame that differ from m_shown
+    mraa::Result sendFrame(const uint16_t *frame);
+    bool pageChanged(const uint16_t *frame, int page);
+    mraa::Result sendPages(const uint16_t *frame, int first, int last);
+    static void flushFrame(const uint8_t *frame, void *ctx);
   };
 }
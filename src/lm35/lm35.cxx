@@ -33,6 +33,9 @@ LM35::LM35(int pin, float aref) :
 {
   m_aRes = m_aio.getBit();
   m_aref = aref;
+
+  // mV per code, at 10mV/degree C
+  m_scale = ((m_aref / float(1 << m_aRes)) * 1000.0) / 10.0;
 }
 
 LM35::~LM35()
@@ -43,9 +46,11 @@ float LM35::getTemperature()
 {
   int val = m_aio.read();
 
-  // convert to mV
-  float temp = (float(val) * (m_aref / float(1 << m_aRes))) * 1000.0;
+  return float(val) * m_scale;
+}
 
-  // 10mV/degree C
-  return(temp / 10.0);
+void LM35::convert(const int *raw, float *out, int count)
+{
+  for (int i=0; i<count; i++)
+    out[i] = float(raw[i]) * m_scale;
 }
@@ -81,6 +81,17 @@ namespace upm {
      */
     float getTemperature();
 
+    /**
+     * Converts an array of raw ADC values to temperatures in degrees
+     * Celcius, for callers that sample the pin at a high rate and
+     * convert in batches
+     *
+     * @param raw Array of raw ADC values
+     * @param out Array receiving the temperatures
+     * @param count Number of values to convert
+     */
+    void convert(const int *raw, float *out, int count);
+
   protected:
     mraa::Aio m_aio;
 
@@ -88,6 +99,8 @@ namespace upm {
     float m_aref;
     // ADC resolution
     int m_aRes;
+    // degrees C per ADC code
+    float m_scale;
   };
 }
 
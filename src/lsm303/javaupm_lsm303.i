@@ -18,6 +18,8 @@
     JCALL4(SetShortArrayRegion, jenv, $result, 0, 3, (jshort*)$1);
 }
 
+%ignore readFIFO(int16_t *, uint64_t *, int);
+
 %include "lsm303.h"
 
 %pragma(java) jniclasscode=%{
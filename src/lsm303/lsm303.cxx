@@ -30,16 +30,31 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "lsm303.h"
 
 using namespace upm;
 
-LSM303::LSM303(int bus, int addrMag, int addrAcc, int accScale) : m_i2c(bus)
+// monotonic time in microseconds, used to stamp FIFO samples
+static uint64_t getMicroseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (now.tv_nsec / 1000);
+}
+
+LSM303::LSM303(int bus, int addrMag, int addrAcc, int accScale) :
+    m_i2c(bus), m_gpioIRQ(0)
 {
     m_addrMag = addrMag;
     m_addrAcc = addrAcc;
 
+    m_fifoLastTime = 0;
+    m_fifoPeriod = 0;
+    m_fifoOverruns = 0;
+
     // 0x27 is the 'normal' mode with X/Y/Z enable
     setRegisterSafe(m_addrAcc, CTRL_REG1_A, 0x27);
 
@@ -64,6 +79,11 @@ LSM303::LSM303(int bus, int addrMag, int addrAcc, int accScale) : m_i2c(bus)
     setRegisterSafe(m_addrMag, MR_REG_M, 0x00);
 }
 
+LSM303::~LSM303()
+{
+    uninstallISR();
+}
+
 float
 LSM303::getHeading()
 {
@@ -114,13 +134,10 @@ LSM303::getCoordinates()
 {
     mraa::Result ret = mraa::SUCCESS;
 
+    // the magnetometer auto-increments on its own
     memset(&buf[0], 0, sizeof(uint8_t)*6);
-    ret = m_i2c.address(m_addrMag);
-    ret = m_i2c.writeByte(OUT_X_H_M);
-    ret = m_i2c.address(m_addrMag);
-    int num = m_i2c.read(buf, 6);
-    if (num != 6) {
-        return ret;
+    if (readRegs(m_addrMag, OUT_X_H_M, buf, 6) != 6) {
+        return mraa::ERROR_UNSPECIFIED;
     }
     // convert to coordinates
     for (int i=0; i<3; i++) {
@@ -151,31 +168,196 @@ LSM303::getCoorZ() {
   return coor[Z];
 }
 
-// helper function that writes a value to the acc and then reads
-// FIX: shouldn't this be write-then-read?
+// helper function that reads len consecutive registers starting at
+// reg with a single write-then-read transaction
 int
-LSM303::readThenWrite(uint8_t reg)
+LSM303::readRegs(uint8_t slave, uint8_t reg, uint8_t *buffer, int len)
 {
-    m_i2c.address(m_addrAcc);
-    m_i2c.writeByte(reg);
-    m_i2c.address(m_addrAcc);
-    return (int) m_i2c.readByte();
+    if (m_i2c.address(slave) != mraa::SUCCESS) {
+        return -1;
+    }
+    return m_i2c.readBytesReg(reg, buffer, len);
 }
 
 mraa::Result
 LSM303::getAcceleration()
 {
-    mraa::Result ret = mraa::SUCCESS;
+    // all six output registers, low byte first, in one burst
+    memset(&buf[0], 0, sizeof(uint8_t)*6);
+    if (readRegs(m_addrAcc, OUT_X_L_A | AUTO_INCREMENT_A, buf, 6) != 6) {
+        return mraa::ERROR_UNSPECIFIED;
+    }
 
-    accel[X] = (int16_t(readThenWrite(OUT_X_H_A)) << 8)
-             |  int16_t(readThenWrite(OUT_X_L_A));
-    accel[Y] = (int16_t(readThenWrite(OUT_Y_H_A)) << 8)
-             |  int16_t(readThenWrite(OUT_Y_L_A));
-    accel[Z] = (int16_t(readThenWrite(OUT_Z_H_A)) << 8)
-             |  int16_t(readThenWrite(OUT_Z_L_A));
+    for (int i=0; i<3; i++) {
+        accel[i] = (int16_t(buf[(2*i)+1]) << 8)
+                 |  int16_t(buf[2*i]);
+    }
     //printf("X=%x, Y=%x, Z=%x\n", accel[X], accel[Y], accel[Z]);
 
-    return ret;
+    return mraa::SUCCESS;
+}
+
+mraa::Result
+LSM303::setFIFOMode(bool enable, uint8_t watermark)
+{
+    mraa::Result ret;
+
+    if (!enable) {
+        if ((ret = updateRegister(m_addrAcc, CTRL_REG3_A, I1_WTM_A, 0))
+            != mraa::SUCCESS)
+            return ret;
+        // returning to bypass mode also empties the FIFO
+        if ((ret = setRegisterSafe(m_addrAcc, FIFO_CTRL_REG_A, 0x00))
+            != mraa::SUCCESS)
+            return ret;
+        return updateRegister(m_addrAcc, CTRL_REG5_A, FIFO_EN_A, 0);
+    }
+
+    if ((ret = updateRegister(m_addrAcc, CTRL_REG5_A, FIFO_EN_A, FIFO_EN_A))
+        != mraa::SUCCESS)
+        return ret;
+    if ((ret = setRegisterSafe(m_addrAcc, FIFO_CTRL_REG_A,
+                               FIFO_MODE_STREAM_A |
+                               (watermark & FIFO_FTH_MASK_A)))
+        != mraa::SUCCESS)
+        return ret;
+
+    m_fifoLastTime = 0;
+    m_fifoPeriod = 0;
+
+    return updateRegister(m_addrAcc, CTRL_REG3_A, I1_WTM_A, I1_WTM_A);
+}
+
+mraa::Result
+LSM303::enableDataReadyInterrupt(bool enable)
+{
+    return updateRegister(m_addrAcc, CTRL_REG3_A, I1_DRDY1_A,
+                          (enable) ? I1_DRDY1_A : 0);
+}
+
+int
+LSM303::getFIFOLevel()
+{
+    uint8_t src;
+
+    if (readRegs(m_addrAcc, FIFO_SRC_REG_A, &src, 1) != 1)
+        return -1;
+
+    if (src & FIFO_EMPTY_A)
+        return 0;
+
+    // FSS holds the number of unread samples minus one when the FIFO
+    // is full, so report a full FIFO as such
+    if (src & FIFO_OVRN_A)
+        return LSM303_FIFO_SIZE;
+
+    return src & FIFO_FSS_MASK_A;
+}
+
+int
+LSM303::readFIFO(int16_t *data, uint64_t *timestamps, int maxSamples)
+{
+    uint8_t src;
+    uint8_t fifo[LSM303_FIFO_SIZE * 6];
+
+    if (readRegs(m_addrAcc, FIFO_SRC_REG_A, &src, 1) != 1)
+        return -1;
+
+    uint64_t now = getMicroseconds();
+
+    if (src & FIFO_EMPTY_A)
+        return 0;
+
+    int count = src & FIFO_FSS_MASK_A;
+    if (src & FIFO_OVRN_A) {
+        m_fifoOverruns++;
+        count = LSM303_FIFO_SIZE;
+    }
+
+    if (count > maxSamples)
+        count = maxSamples;
+    if (count <= 0)
+        return 0;
+
+    // with the FIFO enabled, the auto-incrementing address wraps from
+    // OUT_Z_H_A back to OUT_X_L_A, so one burst drains count samples
+    int len = count * 6;
+    if (readRegs(m_addrAcc, OUT_X_L_A | AUTO_INCREMENT_A, fifo, len) != len)
+        return -1;
+
+    for (int i=0; i<count * 3; i++) {
+        data[i] = (int16_t(fifo[(2*i)+1]) << 8)
+                |  int16_t(fifo[2*i]);
+    }
+
+    // the last sample is also the current acceleration
+    for (int i=0; i<3; i++)
+        accel[i] = data[((count - 1) * 3) + i];
+
+    // estimate the sample period from the time elapsed since the last
+    // batch, and spread this batch's timestamps back from now
+    if (m_fifoLastTime && !(src & FIFO_OVRN_A))
+        m_fifoPeriod = (now - m_fifoLastTime) / count;
+    m_fifoLastTime = now;
+
+    if (timestamps) {
+        for (int i=0; i<count; i++)
+            timestamps[i] = now - ((count - 1 - i) * m_fifoPeriod);
+    }
+
+    return count;
+}
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+void
+LSM303::installISR(int gpio, mraa::Edge level, jobject runnable)
+{
+    // delete any existing ISR and GPIO context
+    uninstallISR();
+
+    m_gpioIRQ = new mraa::Gpio(gpio);
+
+    m_gpioIRQ->dir(mraa::DIR_IN);
+    m_gpioIRQ->isr(level, runnable);
+}
+#else
+void
+LSM303::installISR(int gpio, mraa::Edge level,
+                   void (*isr)(void *), void *arg)
+{
+    // delete any existing ISR and GPIO context
+    uninstallISR();
+
+    m_gpioIRQ = new mraa::Gpio(gpio);
+
+    m_gpioIRQ->dir(mraa::DIR_IN);
+    m_gpioIRQ->isr(level, isr, arg);
+}
+#endif
+
+void
+LSM303::uninstallISR()
+{
+    if (m_gpioIRQ) {
+        m_gpioIRQ->isrExit();
+        delete m_gpioIRQ;
+
+        m_gpioIRQ = 0;
+    }
+}
+
+// helper function that changes the masked bits of a register
+mraa::Result
+LSM303::updateRegister(uint8_t slave, uint8_t sregister, uint8_t mask,
+                       uint8_t bits)
+{
+    uint8_t val;
+
+    if (readRegs(slave, sregister, &val, 1) != 1) {
+        return mraa::ERROR_UNSPECIFIED;
+    }
+
+    return setRegisterSafe(slave, sregister, (val & ~mask) | (bits & mask));
 }
 
 // helper function that sets a register and then checks the set was succesful
@@ -28,6 +28,7 @@
 
 #include <string.h>
 #include <mraa/i2c.hpp>
+#include <mraa/gpio.hpp>
 #include <math.h>
 
 namespace upm {
@@ -56,6 +57,27 @@ namespace upm {
 #define OUT_Z_L_A 0x2C
 #define OUT_Z_H_A 0x2D
 
+#define FIFO_CTRL_REG_A 0x2E
+#define FIFO_SRC_REG_A 0x2F
+
+/* Set in the accelerometer sub-address to auto-increment on reads */
+#define AUTO_INCREMENT_A 0x80
+
+/* CTRL_REG3_A (INT1) and CTRL_REG5_A bits */
+#define I1_DRDY1_A 0x10
+#define I1_WTM_A 0x04
+#define FIFO_EN_A 0x40
+
+/* FIFO_CTRL_REG_A stream mode, FIFO_SRC_REG_A fields */
+#define FIFO_MODE_STREAM_A 0x80
+#define FIFO_FTH_MASK_A 0x1F
+#define FIFO_FSS_MASK_A 0x1F
+#define FIFO_OVRN_A 0x40
+#define FIFO_EMPTY_A 0x20
+
+/* Depth of the accelerometer FIFO, in samples */
+#define LSM303_FIFO_SIZE 32
+
 #define X 0
 #define Y 1
 #define Z 2
@@ -83,6 +105,11 @@ namespace upm {
  * module used over I2C. The magnometer and acceleromter are accessed
  * at two seperate I2C addresses.
  *
+ * All three axes are read with a single auto-incrementing burst.  On
+ * devices with an accelerometer FIFO (such as the LSM303DLHC), the
+ * FIFO can be run in stream mode with the INT1 watermark interrupt,
+ * and drained in batches of timestamped samples with readFIFO().
+ *
  * @image html lsm303.jpeg
  * @snippet lsm303.cxx Interesting
  */
@@ -101,11 +128,11 @@ class LSM303 {
                 int accScale=8);
 
         /**
-         * LSM303 object destructor
-         * where is no more need for this here - I2c connection will be stopped
-         * automatically when m_i2c variable will go out of scope
-         * ~LSM303 ();
+         * LSM303 object destructor, removes any installed ISR.  The
+         * I2c connection will be stopped automatically when m_i2c
+         * variable will go out of scope
          **/
+        ~LSM303 ();
 
         /**
          * Gets the current heading; headings <0 indicate an error has occurred
@@ -165,8 +192,82 @@ class LSM303 {
          */
         int16_t getAccelZ();
 
+        /**
+         * Enables or disables the accelerometer FIFO in stream mode.
+         * While enabled, INT1 is asserted once the FIFO holds more
+         * than watermark samples, so the FIFO can be drained with
+         * readFIFO() from an ISR (see installISR()) or a slow loop.
+         *
+         * @param enable true to enable the FIFO, false to bypass it
+         * @param watermark FIFO level (0-31) that asserts INT1
+         * @return mraa::SUCCESS if successful
+         */
+        mraa::Result setFIFOMode(bool enable, uint8_t watermark=16);
+
+        /**
+         * Enables or disables the accelerometer data ready interrupt
+         * on INT1, for sampling without the FIFO.
+         *
+         * @param enable true to enable the interrupt
+         * @return mraa::SUCCESS if successful
+         */
+        mraa::Result enableDataReadyInterrupt(bool enable);
+
+        /**
+         * Gets the number of unread samples in the accelerometer FIFO
+         *
+         * @return number of samples, or -1 on error
+         */
+        int getFIFOLevel();
+
+        /**
+         * Reads up to maxSamples accelerometer samples from the FIFO
+         * with a single burst.  Samples are returned oldest first as
+         * X, Y, Z triplets in the same raw format as getRawAccelData().
+         * The newest sample is stamped with the time of the read, and
+         * earlier ones are spaced by the sample period measured across
+         * successive calls.
+         *
+         * @param data buffer for 3 * maxSamples values
+         * @param timestamps buffer for maxSamples monotonic timestamps
+         * in microseconds, or NULL
+         * @param maxSamples maximum number of samples to read
+         * @return number of samples read, or -1 on error
+         */
+        int readFIFO(int16_t *data, uint64_t *timestamps, int maxSamples);
+
+        /**
+         * Returns the number of times the FIFO was found to have
+         * overrun (and lost samples) by readFIFO()
+         *
+         * @return overrun count
+         */
+        unsigned int getFIFOOverruns() { return m_fifoOverruns; };
+
+        /**
+         * install an interrupt handler on the GPIO connected to INT1.
+         *
+         * @param gpio gpio pin to use as interrupt pin
+         * @param level the interrupt trigger level (one of mraa::Edge
+         * values)
+         * @param isr the interrupt handler, accepting a void * argument
+         * @param arg the argument to pass the the interrupt handler
+         */
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+        void installISR(int gpio, mraa::Edge level, jobject runnable);
+#else
+        void installISR(int gpio, mraa::Edge level, void (*isr)(void *), void *arg);
+#endif
+
+        /**
+         * uninstall a previously installed interrupt handler
+         */
+        void uninstallISR();
+
     private:
-        int readThenWrite(uint8_t reg);
+        int readRegs(uint8_t slave, uint8_t reg, uint8_t *buffer, int len);
+        mraa::Result updateRegister(uint8_t slave, uint8_t sregister,
+                                    uint8_t mask, uint8_t bits);
         mraa::Result setRegisterSafe(uint8_t slave, uint8_t sregister, uint8_t data);
 
         mraa::I2c m_i2c;
@@ -175,6 +276,11 @@ class LSM303 {
         uint8_t buf[6];
         int16_t coor[3];
         int16_t accel[3];
+
+        mraa::Gpio *m_gpioIRQ;
+        uint64_t m_fifoLastTime;
+        uint64_t m_fifoPeriod;
+        unsigned int m_fifoOverruns;
 };
 
 }
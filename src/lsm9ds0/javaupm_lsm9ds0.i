@@ -34,9 +34,30 @@
     delete [] $1;
 }
 
+%typemap(out) float *getQuaternion {
+    $result = JCALL1(NewFloatArray, jenv, 4);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 4, $1);
+    delete [] $1;
+}
+
+%typemap(out) float *getEulerAngles {
+    $result = JCALL1(NewFloatArray, jenv, 3);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 3, $1);
+    delete [] $1;
+}
+
+%typemap(out) float *getGyroBias {
+    $result = JCALL1(NewFloatArray, jenv, 3);
+    JCALL4(SetFloatArrayRegion, jenv, $result, 0, 3, $1);
+    delete [] $1;
+}
+
 %ignore getAccelerometer(float *, float *, float *);
 %ignore getGyroscope(float *, float *, float *);
 %ignore getMagnetometer(float *, float *, float *);
+%ignore getQuaternion(float *, float *, float *, float *);
+%ignore getEulerAngles(float *, float *, float *);
+%ignore getGyroBias(float *, float *, float *);
 
 %{
     #include "lsm9ds0.h"
@@ -58,6 +58,9 @@ LSM9DS0::LSM9DS0(int bus, uint8_t gAddress, uint8_t xmAddress) :
   m_gyroScale = 0.0;
   m_magScale = 0.0;
 
+  m_ahrs = 0;
+  m_backgroundCal = false;
+
   mraa::Result rv;
   if ( (rv = m_i2cG.address(m_gAddr)) != mraa::SUCCESS)
     {
@@ -80,6 +83,9 @@ LSM9DS0::~LSM9DS0()
   uninstallISR(INTERRUPT_G_DRDY);
   uninstallISR(INTERRUPT_XM_GEN1);
   uninstallISR(INTERRUPT_XM_GEN2);
+
+  if (m_ahrs)
+    delete m_ahrs;
 }
 
 bool LSM9DS0::init()
@@ -208,6 +214,18 @@ void LSM9DS0::update()
   updateAccelerometer();
   updateMagnetometer();
   updateTemperature();
+
+  if (m_ahrs)
+    {
+      float g[3], a[3], m[3];
+
+      getGyroscope(&g[0], &g[1], &g[2]);
+      getAccelerometer(&a[0], &a[1], &a[2]);
+      getMagnetometer(&m[0], &m[1], &m[2]);
+
+      // all three sensors share the same axis orientation
+      m_ahrs->update(g[0], g[1], g[2], a[0], a[1], a[2], m[0], m[1], m[2]);
+    }
 }
 
 void LSM9DS0::updateGyroscope()
@@ -226,6 +244,15 @@ void LSM9DS0::updateGyroscope()
   m_gyroX = float(x);
   m_gyroY = float(y);
   m_gyroZ = float(z);
+
+  if (m_backgroundCal)
+    {
+      float rates[3] = { (m_gyroX * m_gyroScale) / 1000.0f,
+                         (m_gyroY * m_gyroScale) / 1000.0f,
+                         (m_gyroZ * m_gyroScale) / 1000.0f };
+
+      m_gyroCal.addSample(rates);
+    }
 }
 
 void LSM9DS0::updateAccelerometer()
@@ -600,13 +627,13 @@ void LSM9DS0::getAccelerometer(float *x, float *y, float *z)
 void LSM9DS0::getGyroscope(float *x, float *y, float *z)
 {
   if (x)
-    *x = (m_gyroX * m_gyroScale) / 1000.0;
+    *x = (m_gyroX * m_gyroScale) / 1000.0f - m_gyroCal.getBias(0);
 
   if (y)
-    *y = (m_gyroY * m_gyroScale) / 1000.0;
+    *y = (m_gyroY * m_gyroScale) / 1000.0f - m_gyroCal.getBias(1);
 
   if (z)
-    *z = (m_gyroZ * m_gyroScale) / 1000.0;
+    *z = (m_gyroZ * m_gyroScale) / 1000.0f - m_gyroCal.getBias(2);
 }
 
 void LSM9DS0::getMagnetometer(float *x, float *y, float *z)
@@ -644,6 +671,115 @@ float *LSM9DS0::getMagnetometer()
 }
 #endif
 
+void LSM9DS0::enableBackgroundCalibration(bool enable)
+{
+  m_backgroundCal = enable;
+}
+
+bool LSM9DS0::isCalibrated()
+{
+  return m_gyroCal.isCalibrated();
+}
+
+bool LSM9DS0::saveCalibration(std::string filename)
+{
+  return m_gyroCal.save(filename);
+}
+
+bool LSM9DS0::loadCalibration(std::string filename)
+{
+  return m_gyroCal.load(filename);
+}
+
+void LSM9DS0::enableFusion(bool enable, float kp, float ki)
+{
+  if (!enable)
+    {
+      if (m_ahrs)
+        delete m_ahrs;
+      m_ahrs = 0;
+      return;
+    }
+
+  if (m_ahrs)
+    m_ahrs->setGains(kp, ki);
+  else
+    m_ahrs = new AHRS(kp, ki);
+}
+
+void LSM9DS0::getQuaternion(float *w, float *x, float *y, float *z)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getQuaternion(w, x, y, z);
+      return;
+    }
+
+  if (w)
+    *w = 1.0;
+  if (x)
+    *x = 0.0;
+  if (y)
+    *y = 0.0;
+  if (z)
+    *z = 0.0;
+}
+
+void LSM9DS0::getEulerAngles(float *roll, float *pitch, float *yaw)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getEulerAngles(roll, pitch, yaw);
+      return;
+    }
+
+  if (roll)
+    *roll = 0.0;
+  if (pitch)
+    *pitch = 0.0;
+  if (yaw)
+    *yaw = 0.0;
+}
+
+void LSM9DS0::getGyroBias(float *x, float *y, float *z)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getGyroBias(x, y, z);
+      return;
+    }
+
+  if (x)
+    *x = 0.0;
+  if (y)
+    *y = 0.0;
+  if (z)
+    *z = 0.0;
+}
+
+#ifdef JAVACALLBACK
+float *LSM9DS0::getQuaternion()
+{
+  float *v = new float[4];
+  getQuaternion(&v[0], &v[1], &v[2], &v[3]);
+  return v;
+}
+
+float *LSM9DS0::getEulerAngles()
+{
+  float *v = new float[3];
+  getEulerAngles(&v[0], &v[1], &v[2]);
+  return v;
+}
+
+float *LSM9DS0::getGyroBias()
+{
+  float *v = new float[3];
+  getGyroBias(&v[0], &v[1], &v[2]);
+  return v;
+}
+#endif
+
 float LSM9DS0::getTemperature()
 {
   // This might be wrong... The datasheet does not provide enough info
@@ -29,6 +29,9 @@
 
 #include <mraa/gpio.hpp>
 
+#include "ahrs.h"
+#include "gyrocal.h"
+
 #define LSM9DS0_I2C_BUS 1
 #define LSM9DS0_DEFAULT_XM_ADDR 0x1d
 #define LSM9DS0_DEFAULT_GYRO_ADDR 0x6b
@@ -1285,6 +1288,112 @@ namespace upm {
     float *getMagnetometer();
 #endif
 
+    /**
+     * enable or disable background gyroscope calibration.  When
+     * enabled, update() looks for periods where the device is at
+     * rest, and uses them to estimate the gyroscope bias, which is
+     * then subtracted by getGyroscope().  This replaces holding the
+     * device still for a calibration at startup.
+     *
+     * @param enable true to enable, false to disable.  Disabling keeps
+     * the current bias estimate.
+     */
+    void enableBackgroundCalibration(bool enable);
+
+    /**
+     * return true once a gyroscope bias estimate is available, either
+     * from background calibration or loadCalibration()
+     *
+     * @return true if the gyroscope is calibrated
+     */
+    bool isCalibrated();
+
+    /**
+     * save the gyroscope bias estimate, to be reloaded with
+     * loadCalibration() at the next start
+     *
+     * @param filename the file to write
+     * @return true if successful, false otherwise
+     */
+    bool saveCalibration(std::string filename);
+
+    /**
+     * load a gyroscope bias estimate written by saveCalibration()
+     *
+     * @param filename the file to read
+     * @return true if successful, false otherwise
+     */
+    bool loadCalibration(std::string filename);
+
+    /**
+     * enable or disable orientation fusion.  When enabled, every call
+     * to update() feeds the new gyroscope, accelerometer and
+     * magnetometer values into an AHRS filter, using the time elapsed
+     * since the previous update().  For best results call update() at
+     * (or close to) the configured output data rates.
+     *
+     * @param enable true to enable fusion, false to disable it
+     * @param kp the filter's proportional gain
+     * @param ki the filter's integral gain, which controls the online
+     * gyroscope bias estimation.  0 disables bias estimation.
+     */
+    void enableFusion(bool enable, float kp=AHRS_DEFAULT_KP,
+                      float ki=AHRS_DEFAULT_KI);
+
+    /**
+     * get the fused orientation as a quaternion.  If fusion is not
+     * enabled, the identity quaternion is returned.
+     *
+     * @param w the returned w (scalar) value, if arg is non-NULL
+     * @param x the returned x value, if arg is non-NULL
+     * @param y the returned y value, if arg is non-NULL
+     * @param z the returned z value, if arg is non-NULL
+     */
+    void getQuaternion(float *w, float *x, float *y, float *z);
+
+    /**
+     * get the fused orientation as roll, pitch and yaw angles in
+     * degrees
+     *
+     * @param roll the returned roll, if arg is non-NULL
+     * @param pitch the returned pitch, if arg is non-NULL
+     * @param yaw the returned yaw, if arg is non-NULL
+     */
+    void getEulerAngles(float *roll, float *pitch, float *yaw);
+
+    /**
+     * get the gyroscope bias estimated by the fusion filter, in
+     * degrees per second
+     *
+     * @param x the returned x value, if arg is non-NULL
+     * @param y the returned y value, if arg is non-NULL
+     * @param z the returned z value, if arg is non-NULL
+     */
+    void getGyroBias(float *x, float *y, float *z);
+
+#if defined(SWIGJAVA) || defined(JAVACALLBACK)
+    /**
+     * get the fused orientation as a quaternion
+     *
+     * @return Array containing W, X, Y, Z quaternion values
+     */
+    float *getQuaternion();
+
+    /**
+     * get the fused orientation as roll, pitch and yaw in degrees
+     *
+     * @return Array containing roll, pitch, yaw values
+     */
+    float *getEulerAngles();
+
+    /**
+     * get the estimated gyroscope bias in degrees per second
+     *
+     * @return Array containing X, Y, Z bias values
+     */
+    float *getGyroBias();
+#endif
+
     /**
      * get the temperature value.  Unfortunately the datasheet does
      * not provide a mechanism to convert the temperature value into
@@ -1462,6 +1571,13 @@ namespace upm {
     float m_gyroScale;
     float m_magScale;
 
+    // orientation filter, if fusion is enabled
+    AHRS *m_ahrs;
+
+    // gyroscope bias estimation, in degrees per second
+    GyroCal m_gyroCal;
+    bool m_backgroundCal;
+
   private:
     // OR'd with a register, this enables register autoincrement mode,
     // which we need.
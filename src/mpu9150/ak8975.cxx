@@ -227,6 +227,27 @@ float AK8975::adjustValue(float value, float adj)
   return ( value * ((((adj - 128.0) * 0.5) / 128.0) + 1.0) );
 } 
 
+bool AK8975::processData(const uint8_t *data)
+{
+  // data[0] is ST1, data[1-6] are the axis values, data[7] is ST2
+  if (!(data[0] & ST1_DRDY))
+    return false;
+
+  if (data[7] & (ST2_DERR | ST2_HOFL))
+    return false;
+
+  int16_t x, y, z;
+  x = ( (data[2] << 8) | data[1] );
+  y = ( (data[4] << 8) | data[3] );
+  z = ( (data[6] << 8) | data[5] );
+
+  m_xData = float(x);
+  m_yData = float(y);
+  m_zData = float(z);
+
+  return true;
+}
+
 void AK8975::getMagnetometer(float *x, float *y, float *z)
 {
   if (x)
@@ -201,6 +201,19 @@ namespace upm {
      */
     void getMagnetometer(float *x, float *y, float *z);
 
+    /**
+     * store a measurement that was read from the device by some other
+     * means, such as the auxillary I2C master of an MPU60X0, instead
+     * of via update().  The data must consist of the 8 registers
+     * starting at REG_ST1 (ST1, HXL through HZH, and ST2).  The
+     * measurement is ignored if ST1_DRDY is clear, or if ST2 reports
+     * a data error or overflow.
+     *
+     * @param data the 8 bytes read starting at REG_ST1
+     * @return true if a new measurement was stored, false otherwise
+     */
+    bool processData(const uint8_t *data);
+
 
   protected:
     /**
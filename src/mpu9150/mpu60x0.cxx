@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <iostream>
 #include <string.h>
+#include <stdexcept>
 
 #include "mpu60x0.h"
 
@@ -33,10 +34,24 @@ using namespace std;
 
 
 MPU60X0::MPU60X0(int bus, uint8_t address) :
-  m_i2c(bus), m_gpioIRQ(0)
+  m_i2c(bus), m_regs(&m_i2c, address, REG_WHO_AM_I + 1), m_gpioIRQ(0)
 {
   m_addr = address;
 
+  // registers only changed by us are cached, everything else (self
+  // test, status, data, FIFO and USER_CTRL with its self clearing
+  // reset bits) is always read from the device.  PWR_MGMT_1 is cached
+  // without its DEVICE_RESET bit, so restoreConfig() does not replay
+  // a reset.
+  m_regs.setPolicy(REG_SMPLRT_DIV, REG_I2C_SLV4_CTRL, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_INT_PIN_CFG, REG_INT_ENABLE, RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_I2C_SLV0_DO, REG_I2C_MST_DELAY_CTRL,
+                   RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_MOT_DETECT_CTRL, REG_MOT_DETECT_CTRL,
+                   RegMap::REG_CACHED);
+  m_regs.setPolicy(REG_PWR_MGMT_1, REG_PWR_MGMT_2, RegMap::REG_CACHED);
+  m_regs.setSelfClearing(REG_PWR_MGMT_1, DEVICE_RESET);
+
   m_accelX = 0.0;
   m_accelY = 0.0;
   m_accelZ = 0.0;
@@ -50,6 +65,8 @@ MPU60X0::MPU60X0(int bus, uint8_t address) :
   m_accelScale = 1.0;
   m_gyroScale = 1.0;
 
+  m_backgroundCal = false;
+
   mraa::Result rv;
   if ( (rv = m_i2c.address(m_addr)) != mraa::SUCCESS)
     {
@@ -110,6 +127,11 @@ void MPU60X0::update()
   memset(buffer, 0, 14);
   readRegs(REG_ACCEL_XOUT_H, buffer, 14);
 
+  decodeData(buffer);
+}
+
+void MPU60X0::decodeData(const uint8_t *buffer)
+{
   int16_t ax, ay, az;
   int16_t temp;
   int16_t gx, gy, gz;
@@ -134,22 +156,31 @@ void MPU60X0::update()
   m_gyroX = float(gx);
   m_gyroY = float(gy);
   m_gyroZ = float(gz);
+
+  if (m_backgroundCal)
+    {
+      float rates[3] = { m_gyroX / m_gyroScale,
+                         m_gyroY / m_gyroScale,
+                         m_gyroZ / m_gyroScale };
+
+      m_gyroCal.addSample(rates);
+    }
 }
 
 uint8_t MPU60X0::readReg(uint8_t reg)
 {
-  return m_i2c.readReg(reg);
+  return m_regs.readReg(reg);
 }
 
 void MPU60X0::readRegs(uint8_t reg, uint8_t *buffer, int len)
 {
-  m_i2c.readBytesReg(reg, buffer, len);
+  m_regs.readRegs(reg, buffer, len);
 }
 
 bool MPU60X0::writeReg(uint8_t reg, uint8_t val)
 {
   mraa::Result rv;
-  if ((rv = m_i2c.writeReg(reg, val)) != mraa::SUCCESS)
+  if ((rv = m_regs.writeReg(reg, val)) != mraa::SUCCESS)
     {
       throw std::runtime_error(std::string(__FUNCTION__) +
                                ": I2c.writeReg() failed");
@@ -159,6 +190,21 @@ bool MPU60X0::writeReg(uint8_t reg, uint8_t val)
   return true;
 }
 
+bool MPU60X0::deferConfigWrites(bool enable)
+{
+  return (m_regs.setDeferred(enable) == mraa::SUCCESS);
+}
+
+bool MPU60X0::syncConfig()
+{
+  return (m_regs.sync() == mraa::SUCCESS);
+}
+
+bool MPU60X0::restoreConfig()
+{
+  return (m_regs.restore() == mraa::SUCCESS);
+}
+
 bool MPU60X0::setSleep(bool enable)
 {
   uint8_t reg = readReg(REG_PWR_MGMT_1);
@@ -304,13 +350,33 @@ void MPU60X0::getAccelerometer(float *x, float *y, float *z)
 void MPU60X0::getGyroscope(float *x, float *y, float *z)
 {
   if (x)
-    *x = m_gyroX / m_gyroScale;
+    *x = m_gyroX / m_gyroScale - m_gyroCal.getBias(0);
 
   if (y)
-    *y = m_gyroY / m_gyroScale;
+    *y = m_gyroY / m_gyroScale - m_gyroCal.getBias(1);
 
   if (z)
-    *z = m_gyroZ / m_gyroScale;
+    *z = m_gyroZ / m_gyroScale - m_gyroCal.getBias(2);
+}
+
+void MPU60X0::enableBackgroundCalibration(bool enable)
+{
+  m_backgroundCal = enable;
+}
+
+bool MPU60X0::isCalibrated()
+{
+  return m_gyroCal.isCalibrated();
+}
+
+bool MPU60X0::saveCalibration(std::string filename)
+{
+  return m_gyroCal.save(filename);
+}
+
+bool MPU60X0::loadCalibration(std::string filename)
+{
+  return m_gyroCal.load(filename);
 }
 
 float MPU60X0::getTemperature()
@@ -354,6 +420,108 @@ bool MPU60X0::enableI2CBypass(bool enable)
   return writeReg(REG_INT_PIN_CFG, reg);
 }
 
+bool MPU60X0::enableI2CMaster(bool enable)
+{
+  uint8_t reg = readReg(REG_USER_CTRL);
+
+  if (enable)
+    reg |= I2C_MST_EN;
+  else
+    reg &= ~I2C_MST_EN;
+
+  return writeReg(REG_USER_CTRL, reg);
+}
+
+bool MPU60X0::setI2CMasterClock(I2C_MST_CLK_T clk, bool waitForES)
+{
+  uint8_t reg = readReg(REG_I2C_MST_CTRL);
+
+  reg &= ~(_I2C_MST_CLK_MASK << _I2C_MST_CLK_SHIFT);
+  reg |= (clk << _I2C_MST_CLK_SHIFT);
+
+  if (waitForES)
+    reg |= WAIT_FOR_ES;
+  else
+    reg &= ~WAIT_FOR_ES;
+
+  return writeReg(REG_I2C_MST_CTRL, reg);
+}
+
+bool MPU60X0::setupI2CSlave(int slave, uint8_t addr, uint8_t reg, int len,
+                            bool read)
+{
+  if (slave < 0 || slave > 3)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": slave must be between 0 and 3");
+      return false;
+    }
+
+  if (len < 0 || len > _I2C_SLV_LEN_MASK)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": len must be between 0 and 15");
+      return false;
+    }
+
+  // the ADDR, REG and CTRL registers for each slave are consecutive
+  uint8_t base = REG_I2C_SLV0_ADDR + (slave * 3);
+
+  uint8_t slvAddr = (addr & _I2C_SLV_ADDR_MASK) << _I2C_SLV_ADDR_SHIFT;
+  if (read)
+    slvAddr |= I2C_SLV_RW;
+
+  uint8_t ctrl = 0;
+  if (len)
+    ctrl = I2C_SLV_EN | (len << _I2C_SLV_LEN_SHIFT);
+
+  // disable the slave while it is being reconfigured
+  if (!writeReg(base + 2, 0))
+    return false;
+
+  if (!writeReg(base, slvAddr) || !writeReg(base + 1, reg))
+    return false;
+
+  return writeReg(base + 2, ctrl);
+}
+
+bool MPU60X0::setI2CSlaveDataOut(int slave, uint8_t val)
+{
+  if (slave < 0 || slave > 3)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": slave must be between 0 and 3");
+      return false;
+    }
+
+  return writeReg(REG_I2C_SLV0_DO + slave, val);
+}
+
+bool MPU60X0::setI2CMasterDelay(uint8_t delay, uint8_t mask)
+{
+  uint8_t reg = readReg(REG_I2C_SLV4_CTRL);
+
+  reg &= ~(_I2C_MST_DLY_MASK << _I2C_MST_DLY_SHIFT);
+  reg |= ((delay & _I2C_MST_DLY_MASK) << _I2C_MST_DLY_SHIFT);
+
+  if (!writeReg(REG_I2C_SLV4_CTRL, reg))
+    return false;
+
+  return writeReg(REG_I2C_MST_DELAY_CTRL, mask);
+}
+
+bool MPU60X0::setFIFOSources(uint8_t mask, bool enable)
+{
+  uint8_t reg = readReg(REG_FIFO_EN);
+
+  if (enable)
+    reg |= mask;
+  else
+    reg &= ~mask;
+
+  return writeReg(REG_FIFO_EN, reg);
+}
+
 bool MPU60X0::setMotionDetectionThreshold(uint8_t thr)
 {
   return writeReg(REG_MOT_THR, thr);
@@ -29,6 +29,9 @@
 
 #include <mraa/gpio.hpp>
 
+#include "regmap.h"
+#include "gyrocal.h"
+
 #define MPU60X0_I2C_BUS 0
 #define MPU60X0_DEFAULT_I2C_ADDR 0x68
 
@@ -712,6 +715,35 @@ namespace upm {
      */
     bool writeReg(uint8_t reg, uint8_t val);
 
+    /**
+     * defer writes to the configuration registers.  The configuration
+     * registers (sample rate, filter, scale, I2C master, interrupt and
+     * power management) are cached, so the read-modify-write cycles
+     * of the set*() and enable*() methods only read the device once.
+     * While deferred, their writes only update the cache, and are
+     * sent in as few bursts as possible by syncConfig().
+     *
+     * @param enable true to defer writes, false to sync and return to
+     * writing immediately
+     * @return true if successful, false otherwise
+     */
+    bool deferConfigWrites(bool enable);
+
+    /**
+     * write any deferred configuration register changes to the device
+     *
+     * @return true if successful, false otherwise
+     */
+    bool syncConfig();
+
+    /**
+     * rewrite all cached configuration registers to the device, for
+     * example after a DEVICE_RESET or a power cycle.
+     *
+     * @return true if successful, false otherwise
+     */
+    bool restoreConfig();
+
     /**
      * enable or disable device sleep
      *
@@ -816,6 +848,43 @@ namespace upm {
     float *getGyroscope();
 #endif
 
+    /**
+     * enable or disable background gyroscope calibration.  When
+     * enabled, update() looks for periods where the device is at
+     * rest, and uses them to estimate the gyroscope bias, which is
+     * then subtracted by getGyroscope().  This replaces holding the
+     * device still for a calibration at startup.
+     *
+     * @param enable true to enable, false to disable.  Disabling keeps
+     * the current bias estimate.
+     */
+    void enableBackgroundCalibration(bool enable);
+
+    /**
+     * return true once a gyroscope bias estimate is available, either
+     * from background calibration or loadCalibration()
+     *
+     * @return true if the gyroscope is calibrated
+     */
+    bool isCalibrated();
+
+    /**
+     * save the gyroscope bias estimate, to be reloaded with
+     * loadCalibration() at the next start
+     *
+     * @param filename the file to write
+     * @return true if successful, false otherwise
+     */
+    bool saveCalibration(std::string filename);
+
+    /**
+     * load a gyroscope bias estimate written by saveCalibration()
+     *
+     * @param filename the file to read
+     * @return true if successful, false otherwise
+     */
+    bool loadCalibration(std::string filename);
+
 
     /**
      * get the temperature value
@@ -858,6 +927,78 @@ namespace upm {
      */
     bool enableI2CBypass(bool enable);
 
+    /**
+     * enable or disable the auxillary I2C master.  When enabled, the
+     * MPU60X0 accesses the slaves configured with setupI2CSlave() on
+     * its auxillary I2C bus once per sample (or less often, see
+     * setI2CMasterDelay()), and stores data read from them in the
+     * EXT_SENS_DATA registers.  I2C bypass must be disabled while
+     * the master is enabled.
+     *
+     * @param enable true to enable the I2C master
+     * @return true if successful, false otherwise
+     */
+    bool enableI2CMaster(bool enable);
+
+    /**
+     * set the auxillary I2C master clock, and whether the data ready
+     * interrupt should be delayed until external sensor data from
+     * the slaves has been loaded into the EXT_SENS_DATA registers.
+     *
+     * @param clk one of the I2C_MST_CLK_T values
+     * @param waitForES true to wait for external sensor data
+     * @return true if successful, false otherwise
+     */
+    bool setI2CMasterClock(I2C_MST_CLK_T clk, bool waitForES);
+
+    /**
+     * configure one of the auxillary I2C slaves (0-3).  Data read
+     * from the slaves is stored consecutively in the EXT_SENS_DATA
+     * registers, in slave order.
+     *
+     * @param slave the slave number, 0-3
+     * @param addr the 7-bit I2C address of the slave device
+     * @param reg the slave register to start reading or writing at
+     * @param len the number of bytes to transfer (0-15), 0 disables
+     * the slave
+     * @param read true to read from the slave, false to write the
+     * byte set with setI2CSlaveDataOut()
+     * @return true if successful, false otherwise
+     */
+    bool setupI2CSlave(int slave, uint8_t addr, uint8_t reg, int len,
+                       bool read);
+
+    /**
+     * set the byte written to a slave (0-3) that was configured for
+     * writing with setupI2CSlave().
+     *
+     * @param slave the slave number, 0-3
+     * @param val the value to write
+     * @return true if successful, false otherwise
+     */
+    bool setI2CSlaveDataOut(int slave, uint8_t val);
+
+    /**
+     * reduce the rate at which the auxillary I2C slaves are accessed.
+     * Slaves selected in slaveMask are accessed every (1 + delay)
+     * samples.
+     *
+     * @param delay the I2C_MST_DLY value, 0-31
+     * @param mask bitmask of MST_DELAY_CTRL_BITS_T values
+     * @return true if successful, false otherwise
+     */
+    bool setI2CMasterDelay(uint8_t delay, uint8_t mask);
+
+    /**
+     * enable or disable writing of the given sources into the FIFO.
+     * Bits not present in mask are left unchanged.
+     *
+     * @param mask bitmask of FIFO_EN_BITS_T values
+     * @param enable true to enable, false to disable
+     * @return true if successful, false otherwise
+     */
+    bool setFIFOSources(uint8_t mask, bool enable);
+
     /**
      * set the motion detection threshold for interrupt generation.
      * Motion is detected when the absolute value of any of the
@@ -930,6 +1071,15 @@ namespace upm {
     void uninstallISR();
 
   protected:
+    /**
+     * decode the accelerometer, temperature and gyroscope registers
+     * (REG_ACCEL_XOUT_H through REG_GYRO_ZOUT_L) into the
+     * uncompensated values below.
+     *
+     * @param buffer 14 bytes read starting at REG_ACCEL_XOUT_H
+     */
+    void decodeData(const uint8_t *buffer);
+
     // uncompensated accelerometer and gyroscope values
     float m_accelX;
     float m_accelY;
@@ -947,9 +1097,14 @@ namespace upm {
     float m_accelScale;
     float m_gyroScale;
 
+    // gyroscope bias estimation, in degrees per second
+    GyroCal m_gyroCal;
+    bool m_backgroundCal;
+
   private:
     mraa::I2c m_i2c;
     uint8_t m_addr;
+    I2cRegMap m_regs;
 
     mraa::Gpio *m_gpioIRQ;
   };
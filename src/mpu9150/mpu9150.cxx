@@ -25,6 +25,7 @@
 #include <iostream>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "mpu9150.h"
 
@@ -37,12 +38,16 @@ MPU9150::MPU9150 (int bus, int address, int magAddress, bool enableAk8975) :
   m_magAddress = magAddress;
   m_i2cBus = bus;
   m_enableAk8975 = enableAk8975;
+  m_auxMag = false;
+  m_ahrs = 0;
 }
 
 MPU9150::~MPU9150()
 {
   if (m_mag)
     delete m_mag;
+  if (m_ahrs)
+    delete m_ahrs;
 }
 
 bool MPU9150::init()
@@ -86,10 +91,109 @@ bool MPU9150::init()
 
 void MPU9150::update()
 {
-  MPU60X0::update();
+  if (!m_auxMag)
+    {
+      MPU60X0::update();
 
-  if (m_mag)
-    m_mag->update();
+      if (m_mag)
+        m_mag->update();
+    }
+  else
+    {
+      // accel, temp and gyro, followed by the AK8975 ST1-ST2
+      // registers the I2C master stored in EXT_SENS_DATA_00-07
+      uint8_t buffer[22];
+
+      memset(buffer, 0, 22);
+      readRegs(REG_ACCEL_XOUT_H, buffer, 22);
+
+      decodeData(buffer);
+
+      // if there is no new measurement, keep the last one
+      m_mag->processData(&buffer[14]);
+    }
+
+  if (m_ahrs)
+    {
+      float g[3], a[3], m[3];
+
+      getGyroscope(&g[0], &g[1], &g[2]);
+      getAccelerometer(&a[0], &a[1], &a[2]);
+      getMagnetometer(&m[0], &m[1], &m[2]);
+
+      // The AK8975's X and Y axes are swapped relative to the
+      // MPU60X0's, and its Z axis points the other way.
+      m_ahrs->update(g[0], g[1], g[2], a[0], a[1], a[2], m[1], m[0], -m[2]);
+    }
+}
+
+bool MPU9150::enableAuxMagnetometer(bool enable, uint8_t delay, bool fifo)
+{
+  if (!enable)
+    {
+      if (!m_auxMag)
+        return true;
+
+      // stop the master before handing the bus back to the host
+      if (!setFIFOSources(SLV0_FIFO_EN, false) ||
+          !setupI2CSlave(0, 0, 0, 0, false) ||
+          !setupI2CSlave(1, 0, 0, 0, false) ||
+          !enableI2CMaster(false))
+        return false;
+
+      // let any transaction in progress complete
+      usleep(10000);
+
+      m_auxMag = false;
+
+      return enableI2CBypass(true);
+    }
+
+  // we still need bypass mode once, to read the AK8975's fuse
+  // (compensation) coefficients
+  if (!m_mag)
+    {
+      if (!enableI2CBypass(true))
+        {
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": Unable to enable I2C bypass");
+          return false;
+        }
+
+      m_mag = new AK8975(m_i2cBus, m_magAddress);
+
+      if (!m_mag->init())
+        {
+          delete m_mag;
+          m_mag = 0;
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": Unable to init magnetometer");
+          return false;
+        }
+    }
+  else
+    m_mag->setMode(AK8975::CNTL_PWRDWN);
+
+  if (!enableI2CBypass(false))
+    return false;
+
+  // SLV0 reads ST1 through ST2, then SLV1 starts the next single
+  // measurement, so each read returns the previous cycle's result.
+  if (!setI2CMasterClock(MST_CLK_400, true) ||
+      !setupI2CSlave(0, m_magAddress, AK8975::REG_ST1, 8, true) ||
+      !setI2CSlaveDataOut(1, AK8975::CNTL_MEASURE) ||
+      !setupI2CSlave(1, m_magAddress, AK8975::REG_CNTL, 1, false) ||
+      !setI2CMasterDelay(delay, (I2C_SLV0_DLY_EN | I2C_SLV1_DLY_EN |
+                                 DELAY_ES_SHADOW)) ||
+      !setFIFOSources(SLV0_FIFO_EN, fifo))
+    return false;
+
+  if (!enableI2CMaster(true))
+    return false;
+
+  m_auxMag = true;
+
+  return true;
 }
 
 void MPU9150::getMagnetometer(float *x, float *y, float *z)
@@ -109,6 +213,72 @@ void MPU9150::getMagnetometer(float *x, float *y, float *z)
     *z = mz;
 }
 
+void MPU9150::enableFusion(bool enable, float kp, float ki)
+{
+  if (!enable)
+    {
+      if (m_ahrs)
+        delete m_ahrs;
+      m_ahrs = 0;
+      return;
+    }
+
+  if (m_ahrs)
+    m_ahrs->setGains(kp, ki);
+  else
+    m_ahrs = new AHRS(kp, ki);
+}
+
+void MPU9150::getQuaternion(float *w, float *x, float *y, float *z)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getQuaternion(w, x, y, z);
+      return;
+    }
+
+  if (w)
+    *w = 1.0;
+  if (x)
+    *x = 0.0;
+  if (y)
+    *y = 0.0;
+  if (z)
+    *z = 0.0;
+}
+
+void MPU9150::getEulerAngles(float *roll, float *pitch, float *yaw)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getEulerAngles(roll, pitch, yaw);
+      return;
+    }
+
+  if (roll)
+    *roll = 0.0;
+  if (pitch)
+    *pitch = 0.0;
+  if (yaw)
+    *yaw = 0.0;
+}
+
+void MPU9150::getGyroBias(float *x, float *y, float *z)
+{
+  if (m_ahrs)
+    {
+      m_ahrs->getGyroBias(x, y, z);
+      return;
+    }
+
+  if (x)
+    *x = 0.0;
+  if (y)
+    *y = 0.0;
+  if (z)
+    *z = 0.0;
+}
+
 #ifdef SWIGJAVA
 float *MPU9150::getMagnetometer()
 {
@@ -116,4 +286,25 @@ float *MPU9150::getMagnetometer()
     getMagnetometer(&v[0], &v[1], &v[2]);
     return v;
 }
+
+float *MPU9150::getQuaternion()
+{
+    float *v = new float[4];
+    getQuaternion(&v[0], &v[1], &v[2], &v[3]);
+    return v;
+}
+
+float *MPU9150::getEulerAngles()
+{
+    float *v = new float[3];
+    getEulerAngles(&v[0], &v[1], &v[2]);
+    return v;
+}
+
+float *MPU9150::getGyroBias()
+{
+    float *v = new float[3];
+    getGyroBias(&v[0], &v[1], &v[2]);
+    return v;
+}
 #endif
@@ -26,10 +26,16 @@
 
 #include "mpu60x0.h"
 #include "ak8975.h"
+#include "ahrs.h"
 
 #define MPU9150_I2C_BUS 0
 #define MPU9150_DEFAULT_I2C_ADDR  MPU60X0_DEFAULT_I2C_ADDR
 
+// Default I2C_MST_DLY used when reading the magnetometer with the
+// auxillary I2C master.  At a 1Khz sample rate this polls the AK8975
+// at 100Hz, its maximum single measurement rate.
+#define MPU9150_AUX_MAG_DELAY 9
+
 
 namespace upm {
 
@@ -98,6 +104,28 @@ namespace upm {
      */
     void update();
 
+    /**
+     * Read the magnetometer through the MPU60X0's auxillary I2C
+     * master instead of using I2C bypass.  Once enabled, the MPU60X0
+     * triggers an AK8975 measurement and reads its result into
+     * EXT_SENS_DATA_00-07 every (1 + delay) samples on its own, so
+     * update() gets accelerometer, temperature, gyroscope and
+     * magnetometer data with a single burst read and never waits on
+     * the magnetometer.  The delay should be chosen so that the
+     * magnetometer is polled at no more than 100Hz.  init() must have
+     * been called first.
+     *
+     * @param enable true to use the auxillary I2C master, false to
+     * return to I2C bypass mode
+     * @param delay the I2C_MST_DLY value, 0-31
+     * @param fifo true to also write the magnetometer data into the
+     * FIFO (via SLV0_FIFO_EN)
+     * @return true if successful, false otherwise
+     */
+    bool enableAuxMagnetometer(bool enable,
+                               uint8_t delay=MPU9150_AUX_MAG_DELAY,
+                               bool fifo=false);
+
     /**
      * Return the compensated values for the x, y, and z axes.  The
      * unit of measurement is in micro-teslas (uT).
@@ -108,6 +136,54 @@ namespace upm {
      */
     void getMagnetometer(float *x, float *y, float *z);
 
+    /**
+     * Enable or disable orientation fusion.  When enabled, every call
+     * to update() feeds the new gyroscope, accelerometer and
+     * magnetometer values into an AHRS filter, using the time elapsed
+     * since the previous update().  The magnetometer axes are
+     * remapped to the accelerometer and gyroscope axes.  Without a
+     * magnetometer only roll and pitch are corrected, and the yaw
+     * will drift.
+     *
+     * @param enable true to enable fusion, false to disable it
+     * @param kp the filter's proportional gain
+     * @param ki the filter's integral gain, which controls the online
+     * gyroscope bias estimation.  0 disables bias estimation.
+     */
+    void enableFusion(bool enable, float kp=AHRS_DEFAULT_KP,
+                      float ki=AHRS_DEFAULT_KI);
+
+    /**
+     * Return the fused orientation as a quaternion.  If fusion is
+     * not enabled, the identity quaternion is returned.
+     *
+     * @param w Pointer to returned W (scalar) value
+     * @param x Pointer to returned X value
+     * @param y Pointer to returned Y value
+     * @param z Pointer to returned Z value
+     */
+    void getQuaternion(float *w, float *x, float *y, float *z);
+
+    /**
+     * Return the fused orientation as roll, pitch and yaw angles in
+     * degrees.
+     *
+     * @param roll Pointer to returned roll
+     * @param pitch Pointer to returned pitch
+     * @param yaw Pointer to returned yaw
+     */
+    void getEulerAngles(float *roll, float *pitch, float *yaw);
+
+    /**
+     * Return the gyroscope bias estimated by the fusion filter, in
+     * degrees per second.
+     *
+     * @param x Pointer to returned X axis value
+     * @param y Pointer to returned Y axis value
+     * @param z Pointer to returned Z axis value
+     */
+    void getGyroBias(float *x, float *y, float *z);
+
 #ifdef SWIGJAVA
     /**
      * Return the compensated values for the x, y, and z axes.  The
@@ -116,6 +192,27 @@ namespace upm {
      * @return Array containing X, Y, Z magnetometer values
      */
     float *getMagnetometer();
+
+    /**
+     * Return the fused orientation as a quaternion.
+     *
+     * @return Array containing W, X, Y, Z quaternion values
+     */
+    float *getQuaternion();
+
+    /**
+     * Return the fused orientation as roll, pitch and yaw in degrees.
+     *
+     * @return Array containing roll, pitch, yaw values
+     */
+    float *getEulerAngles();
+
+    /**
+     * Return the estimated gyroscope bias in degrees per second.
+     *
+     * @return Array containing X, Y, Z bias values
+     */
+    float *getGyroBias();
 #endif
 
 
@@ -124,11 +221,15 @@ namespace upm {
     // magnetometer instance
     AK8975* m_mag;
 
+    // orientation filter, if fusion is enabled
+    AHRS* m_ahrs;
+
 
   private:
     int m_i2cBus;
     uint8_t m_magAddress;
     bool m_enableAk8975;
+    bool m_auxMag;
   };
 
 }
@@ -55,6 +55,10 @@ namespace upm {
    * This is a circular LED ring based on the MY9221 chip. It is often used
    * with a rotary encoder and has 24 controllable LEDs.
    *
+   * Animations can be played from a background thread: with auto
+   * refresh disabled, set up each frame and add it with
+   * queueFrame(), then call startAnimation().
+   *
    * @image html grovecircularled.jpg
    * @snippet grovecircularled.cxx Interesting
    */
@@ -59,6 +59,10 @@ namespace upm {
    * segment, and one red segment.  They can be daisy chained together
    * so that this module can control multiple LED bars.
    *
+   * Animations can be played from a background thread: with auto
+   * refresh disabled, set up each frame and add it with
+   * queueFrame(), then call startAnimation().
+   *
    * @image html my9221.jpg
    * @snippet groveledbar.cxx Interesting
    */
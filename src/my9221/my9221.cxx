@@ -38,6 +38,8 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "my9221.h"
 
@@ -78,7 +80,27 @@ MY9221::MY9221 (uint8_t dataPin, uint8_t clockPin, int instances)
   m_commandWord = 0x0000;       // all defaults
   m_instances = instances;
 
-  m_bitStates = new uint16_t[instances * LEDS_PER_INSTANCE];
+  int leds = instances * LEDS_PER_INSTANCE;
+
+  m_bitStates = new uint16_t[leds];
+
+  m_clkState = 0;
+  m_gpioClk.write(m_clkState);
+
+  m_sentStates = new uint16_t[leds];
+  m_sentCommand = m_commandWord;
+  m_sentValid = false;
+  // one command word for every LEDS_PER_INSTANCE states
+  m_stream = new uint8_t[(leds + instances) * 16];
+
+  m_frames = new uint16_t[MY9221_MAX_FRAMES * leds];
+  m_frameHead = 0;
+  m_frameCount = 0;
+  m_frameMs = 0;
+  m_loop = false;
+  m_animating = false;
+
+  pthread_mutex_init(&m_lock, NULL);
 
   setAutoRefresh(true);
   clearAll();
@@ -86,12 +108,19 @@ MY9221::MY9221 (uint8_t dataPin, uint8_t clockPin, int instances)
 
 MY9221::~MY9221()
 {
+  stopAnimation();
+
   clearAll();
 
   if (!m_autoRefresh)
     refresh();
 
-  delete m_bitStates;
+  pthread_mutex_destroy(&m_lock);
+
+  delete [] m_bitStates;
+  delete [] m_sentStates;
+  delete [] m_stream;
+  delete [] m_frames;
 }
 
 void MY9221::setLED(int led, bool on)
@@ -137,20 +166,182 @@ void MY9221::clearAll()
     refresh();
 }
 
-void MY9221::refresh()
+void MY9221::refresh(bool force)
 {
-  for (int i=0; i<(m_instances * LEDS_PER_INSTANCE); i++)
+  pthread_mutex_lock(&m_lock);
+  sendStates(m_bitStates, force);
+  pthread_mutex_unlock(&m_lock);
+}
+
+void MY9221::sendStates(const uint16_t *states, bool force)
+{
+  int leds = m_instances * LEDS_PER_INSTANCE;
+
+  bool cmdChanged = (!m_sentValid || m_commandWord != m_sentCommand);
+
+  if (!force && !cmdChanged &&
+      !memcmp(states, m_sentStates, leds * sizeof(uint16_t)))
+    return;
+
+  // update the bitstream for the words that changed.  Each instance
+  // takes its command word followed by its LED states.
+  for (int i=0; i<leds; i++)
+    {
+      int word = i + (i / LEDS_PER_INSTANCE) + 1;
+
+      if (i % LEDS_PER_INSTANCE == 0 && cmdChanged)
+        {
+          uint8_t *bits = m_stream + ((word - 1) * 16);
+          for (int b=0; b<16; b++)
+            bits[b] = (m_commandWord >> (15 - b)) & 1;
+        }
+
+      if (!m_sentValid || states[i] != m_sentStates[i])
+        {
+          uint8_t *bits = m_stream + (word * 16);
+          for (int b=0; b<16; b++)
+            bits[b] = (states[i] >> (15 - b)) & 1;
+        }
+    }
+
+  memcpy(m_sentStates, states, leds * sizeof(uint16_t));
+  m_sentCommand = m_commandWord;
+  m_sentValid = true;
+
+  // send it, writing the data pin only when its level changes, and
+  // toggling the clock from its known level
+  int bits = (leds + m_instances) * 16;
+  int data = -1;
+
+  for (int i=0; i<bits; i++)
     {
-      if (i % 12 == 0)
+      if (m_stream[i] != data)
         {
-          send16bitBlock(m_commandWord);
+          data = m_stream[i];
+          m_gpioData.write(data);
         }
-      send16bitBlock(m_bitStates[i]);
+
+      m_clkState = !m_clkState;
+      m_gpioClk.write(m_clkState);
     }
 
   lockData();
 }
 
+bool MY9221::queueFrame()
+{
+  int leds = m_instances * LEDS_PER_INSTANCE;
+
+  pthread_mutex_lock(&m_lock);
+
+  if (m_frameCount >= MY9221_MAX_FRAMES)
+    {
+      pthread_mutex_unlock(&m_lock);
+      return false;
+    }
+
+  int slot = (m_frameHead + m_frameCount) % MY9221_MAX_FRAMES;
+  memcpy(m_frames + (slot * leds), m_bitStates, leds * sizeof(uint16_t));
+  m_frameCount++;
+
+  pthread_mutex_unlock(&m_lock);
+
+  return true;
+}
+
+void MY9221::clearFrames()
+{
+  pthread_mutex_lock(&m_lock);
+
+  m_frameHead = 0;
+  m_frameCount = 0;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+int MY9221::framesQueued()
+{
+  pthread_mutex_lock(&m_lock);
+  int count = m_frameCount;
+  pthread_mutex_unlock(&m_lock);
+
+  return count;
+}
+
+void MY9221::startAnimation(unsigned int frameMs, bool loop)
+{
+  stopAnimation();
+
+  m_frameMs = frameMs;
+  m_loop = loop;
+  m_animating = true;
+
+  if (pthread_create(&m_animThread, NULL, animationThread, this))
+    {
+      m_animating = false;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+    }
+}
+
+void MY9221::stopAnimation()
+{
+  if (!m_animating)
+    return;
+
+  m_animating = false;
+  pthread_join(m_animThread, NULL);
+}
+
+void *MY9221::animationThread(void *ctx)
+{
+  upm::MY9221 *This = (upm::MY9221 *)ctx;
+  int leds = This->m_instances * LEDS_PER_INSTANCE;
+
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  while (This->m_animating)
+    {
+      pthread_mutex_lock(&This->m_lock);
+
+      if (This->m_frameCount)
+        {
+          uint16_t *frame = This->m_frames + (This->m_frameHead * leds);
+
+          This->sendStates(frame, false);
+
+          This->m_frameHead = (This->m_frameHead + 1) % MY9221_MAX_FRAMES;
+          This->m_frameCount--;
+
+          // requeue the frame at the tail
+          if (This->m_loop)
+            {
+              int tail = (This->m_frameHead + This->m_frameCount) %
+                MY9221_MAX_FRAMES;
+              uint16_t *slot = This->m_frames + (tail * leds);
+
+              // with a full queue, the tail is the frame's own slot
+              if (slot != frame)
+                memcpy(slot, frame, leds * sizeof(uint16_t));
+              This->m_frameCount++;
+            }
+        }
+
+      pthread_mutex_unlock(&This->m_lock);
+
+      // sleep until the next frame is due, on an absolute schedule so
+      // the send time does not add up
+      next.tv_nsec += (This->m_frameMs % 1000) * 1000000;
+      next.tv_sec += This->m_frameMs / 1000 + next.tv_nsec / 1000000000;
+      next.tv_nsec %= 1000000000;
+
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+  return 0;
+}
+
 void MY9221::lockData()
 {
   m_gpioData.write(0);
@@ -176,15 +367,10 @@ void MY9221::send16bitBlock(uint16_t data)
     {
       uint32_t state = (data & 0x8000) ? 1 : 0;
       m_gpioData.write(state);
-      state = m_gpioClk.read();
-
-      if (state)
-        state = 0;
-      else
-        state = 1;
-      
-      m_gpioClk.write(state);
-      
+
+      m_clkState = !m_clkState;
+      m_gpioClk.write(m_clkState);
+
       data <<= 1;
     }
   return;
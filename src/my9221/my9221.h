@@ -35,9 +35,13 @@
 #pragma once
 
 #include <string>
+#include <pthread.h>
 #include <mraa/common.hpp>
 #include <mraa/gpio.hpp>
 
+// Maximum number of frames queued for animation
+#define MY9221_MAX_FRAMES 64
+
 namespace upm {
 
   /**
@@ -120,14 +124,59 @@ namespace upm {
     /**
      * Set the LED states to match the internal stored states.  This
      * is useful when auto refresh (setAutoRefresh()) is false to
-     * update the display.
+     * update the display.  Nothing is sent if the states are the
+     * same as the ones last sent.
+     *
+     * @param force true to send the states even if they are unchanged
+     */
+    void refresh(bool force=false);
+
+    /**
+     * Adds a copy of the current LED states to the animation queue.
+     * Disable auto refresh, set up the LEDs for each frame, and call
+     * this once per frame.
+     *
+     * @return true if the frame was queued, false if the queue is full
      */
-    void refresh();
+    bool queueFrame();
+
+    /**
+     * Discards all queued frames
+     */
+    void clearFrames();
+
+    /**
+     * Returns the number of frames waiting in the animation queue
+     *
+     * @return number of frames
+     */
+    int framesQueued();
+
+    /**
+     * Starts a background thread showing one queued frame every
+     * frameMs milliseconds.  Frames can be queued while the animation
+     * runs.  Auto refresh should be disabled while animating.
+     *
+     * @param frameMs Time each frame is shown, in milliseconds
+     * @param loop true to requeue each frame after it is shown, so
+     * the animation repeats until stopped
+     */
+    void startAnimation(unsigned int frameMs, bool loop=false);
+
+    /**
+     * Stops the animation thread.  The frame being shown stays on the
+     * display, and the remaining frames stay queued.
+     */
+    void stopAnimation();
 
   protected:
     virtual void lockData();
     virtual void send16bitBlock(uint16_t data);
 
+    // send a set of LED states, if different from the ones on display
+    void sendStates(const uint16_t *states, bool force);
+    static void *animationThread(void *ctx);
+
     bool m_autoRefresh;
     // we're only doing 8-bit greyscale, so the high order bits are
     // always 0
@@ -147,6 +196,28 @@ namespace upm {
     mraa::Gpio m_gpioData;
 
   private:
+    // current level of the clock pin.  Data is latched on both edges,
+    // so the clock toggles once per bit.
+    int m_clkState;
+
+    // the states and command word on display, and the data level of
+    // every bit sent for them (16 per word, command word included)
+    uint16_t *m_sentStates;
+    uint16_t m_sentCommand;
+    bool m_sentValid;
+    uint8_t *m_stream;
+
+    // animation frames, a ring of MY9221_MAX_FRAMES sets of states
+    uint16_t *m_frames;
+    int m_frameHead;
+    int m_frameCount;
+    unsigned int m_frameMs;
+    bool m_loop;
+    volatile bool m_animating;
+    pthread_t m_animThread;
+
+    // serializes sends and the frame queue
+    pthread_mutex_t m_lock;
   };
 
 }
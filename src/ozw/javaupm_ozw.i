@@ -9,6 +9,11 @@
     #include "ozw.h"
 %}
 
+%apply int *OUTPUT { int *nodeId, int *index };
+
+// Java users should poll the value change queue instead
+%ignore setValueChangeHandler;
+
 %include "ozw.h"
 
 %pragma(java) jniclasscode=%{
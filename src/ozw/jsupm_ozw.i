@@ -4,6 +4,7 @@
 %include "stdint.i"
 
 %pointer_functions(float, floatp);
+%pointer_functions(int, intp);
 
 %include "ozw.h"
 %{
@@ -70,6 +70,24 @@ OZW::OZW()
                                ": pthread_cond_init() failed");
     }
 
+  if (pthread_rwlock_init(&m_cacheLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_rwlock_init(cacheLock) failed");
+    }
+
+  if (pthread_mutex_init(&m_changeLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(changeLock) failed");
+    }
+
+  m_cacheEnabled = true;
+  m_changeHandler = 0;
+  m_changeArg = 0;
+  m_changeQueueSize = OZW_DEFAULT_CHANGE_QUEUE;
+  m_changeOverruns = 0;
+
   setDebug(false);
 }
 
@@ -95,6 +113,8 @@ OZW::~OZW()
   pthread_mutex_destroy(&m_nodeLock);
   pthread_mutex_destroy(&m_initLock);
   pthread_cond_destroy(&m_initCond);
+  pthread_rwlock_destroy(&m_cacheLock);
+  pthread_mutex_destroy(&m_changeLock);
 
   // delete any nodes.  This should be safe after deleting the node
   // mutex since the handler is no longer registered.
@@ -193,6 +213,10 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
   const uint32_t homeId = notification->GetHomeId();
   const uint8_t nodeId = notification->GetNodeId();
 
+  // index of a changed value to dispatch once the node lock is
+  // released, or -1
+  int changedIndex = -1;
+
   switch (notification->GetType()) 
     {
 
@@ -216,6 +240,7 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
             delete This->m_zwNodeMap[nodeId];
             This->m_zwNodeMap.erase(nodeId);
           }
+        This->uncacheValues(nodeId, OZW_ALL_VALUES);
 
         break;
       }
@@ -224,7 +249,9 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
       {
         if (This->m_debugging)
           cerr << "### ### VALUE ADDED " << endl;
-        This->m_zwNodeMap[nodeId]->addValueID(notification->GetValueID());
+        int index = 
+          This->m_zwNodeMap[nodeId]->addValueID(notification->GetValueID());
+        This->cacheValue(nodeId, index, notification->GetValueID());
 
         break;
       }
@@ -233,14 +260,29 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
       {
         if (This->m_debugging)
           cerr << "### ### VALUE DELETED " << endl;
-        This->m_zwNodeMap[nodeId]->removeValueID(notification->GetValueID());
+        int index = 
+          This->m_zwNodeMap[nodeId]->removeValueID(notification->GetValueID());
+        if (index >= 0)
+          This->uncacheValues(nodeId, index);
 
         break;
       }
 
     case Notification::Type_ValueChanged:
+    case Notification::Type_ValueRefreshed:
       {
-        // might be able to do something with this someday...
+        if (This->m_zwNodeMap.count(nodeId) == 0)
+          break;
+
+        int index = 
+          This->m_zwNodeMap[nodeId]->valueIDToIndex(notification->GetValueID());
+        if (index >= 0)
+          {
+            This->cacheValue(nodeId, index, notification->GetValueID());
+            if (notification->GetType() == Notification::Type_ValueChanged)
+              changedIndex = index;
+          }
+
         break;
       }
 
@@ -257,6 +299,7 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
           }
         // empty the map
         This->m_zwNodeMap.clear();
+        This->uncacheValues(-1, OZW_ALL_VALUES);
 
         break;
       }
@@ -306,6 +349,10 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
     }
 
   This->unlockNodes();
+
+  // let subscribers know, now that the node lock has been released
+  if (changedIndex >= 0)
+    This->dispatchValueChange(nodeId, changedIndex);
 }
 
 void OZW::dumpNodes(bool all)
@@ -366,6 +413,10 @@ bool OZW::getValueID(int nodeId, int index, ValueID *vid)
 
 string OZW::getValueAsString(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    return val.str;
+
   // we have to play this game since there is no default ctor for ValueID
   ValueID vid(m_homeId, (uint64)0);
 
@@ -729,6 +780,27 @@ bool OZW::isValuePolled(int nodeId, int index)
 
 bool OZW::getValueAsBool(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    {
+      if (val.writeOnly)
+        {
+          cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
+               << " is WriteOnly" << endl;
+          return false;
+        }
+
+      if (val.type != ValueID::ValueType_Bool &&
+          val.type != ValueID::ValueType_Button)
+        {
+          cerr << __FUNCTION__ << ": Value is not a bool type, returning "
+               << false << endl;
+          return false;
+        }
+
+      return bool(val.ival);
+    }
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -756,6 +828,26 @@ bool OZW::getValueAsBool(int nodeId, int index)
 
 uint8_t OZW::getValueAsByte(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    {
+      if (val.writeOnly)
+        {
+          cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
+               << " is WriteOnly" << endl;
+          return 0;
+        }
+
+      if (val.type != ValueID::ValueType_Byte)
+        {
+          cerr << __FUNCTION__ << ": Value is not a byte type, returning "
+               << 0 << endl;
+          return 0;
+        }
+
+      return uint8_t(val.ival);
+    }
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -783,6 +875,26 @@ uint8_t OZW::getValueAsByte(int nodeId, int index)
 
 float OZW::getValueAsFloat(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    {
+      if (val.writeOnly)
+        {
+          cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
+               << " is WriteOnly" << endl;
+          return 0.0;
+        }
+
+      if (val.type != ValueID::ValueType_Decimal)
+        {
+          cerr << __FUNCTION__ << ": Value is not a float type, returning "
+               << 0.0 << endl;
+          return 0.0;
+        }
+
+      return val.fval;
+    }
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -810,6 +922,26 @@ float OZW::getValueAsFloat(int nodeId, int index)
 
 int OZW::getValueAsInt32(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    {
+      if (val.writeOnly)
+        {
+          cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
+               << " is WriteOnly" << endl;
+          return 0;
+        }
+
+      if (val.type != ValueID::ValueType_Int)
+        {
+          cerr << __FUNCTION__ << ": Value is not an int32 type, returning "
+               << 0 << endl;
+          return 0;
+        }
+
+      return int(val.ival);
+    }
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -837,6 +969,26 @@ int OZW::getValueAsInt32(int nodeId, int index)
 
 int OZW::getValueAsInt16(int nodeId, int index)
 {
+  zwValue_t val;
+  if (getCachedValue(nodeId, index, &val))
+    {
+      if (val.writeOnly)
+        {
+          cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
+               << " is WriteOnly" << endl;
+          return 0;
+        }
+
+      if (val.type != ValueID::ValueType_Short)
+        {
+          cerr << __FUNCTION__ << ": Value is not an int16 type, returning "
+               << 0 << endl;
+          return 0;
+        }
+
+      return int(val.ival);
+    }
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -907,3 +1059,223 @@ void OZW::setDebug(bool enable)
 
   //  Log::SetLoggingState(enable);
 }
+
+void OZW::enableValueCache(bool enable)
+{
+  pthread_rwlock_wrlock(&m_cacheLock);
+  m_cacheEnabled = enable;
+  pthread_rwlock_unlock(&m_cacheLock);
+}
+
+void OZW::cacheValue(int nodeId, int index, ValueID vid)
+{
+  // query OpenZWave outside of the cache lock so readers are not
+  // held up
+  zwValue_t val;
+
+  val.type = vid.GetType();
+  val.writeOnly = Manager::Get()->IsValueWriteOnly(vid);
+  val.fval = 0.0;
+  val.ival = 0;
+  Manager::Get()->GetValueAsString(vid, &val.str);
+
+  switch (val.type)
+    {
+    case ValueID::ValueType_Bool:
+    case ValueID::ValueType_Button:
+      {
+        bool b = false;
+        Manager::Get()->GetValueAsBool(vid, &b);
+        val.ival = b;
+        break;
+      }
+
+    case ValueID::ValueType_Byte:
+      {
+        uint8_t b = 0;
+        Manager::Get()->GetValueAsByte(vid, &b);
+        val.ival = b;
+        break;
+      }
+
+    case ValueID::ValueType_Decimal:
+      Manager::Get()->GetValueAsFloat(vid, &val.fval);
+      break;
+
+    case ValueID::ValueType_Int:
+      Manager::Get()->GetValueAsInt(vid, &val.ival);
+      break;
+
+    case ValueID::ValueType_Short:
+      {
+        int16_t sh = 0;
+        Manager::Get()->GetValueAsShort(vid, &sh);
+        val.ival = sh;
+        break;
+      }
+
+    default:
+      break;
+    }
+
+  pthread_rwlock_wrlock(&m_cacheLock);
+  m_valueCache[valueKey(nodeId, index)] = val;
+  pthread_rwlock_unlock(&m_cacheLock);
+}
+
+void OZW::uncacheValues(int nodeId, int index)
+{
+  pthread_rwlock_wrlock(&m_cacheLock);
+
+  if (nodeId < 0)
+    m_valueCache.clear();
+  else if (index != OZW_ALL_VALUES)
+    m_valueCache.erase(valueKey(nodeId, index));
+  else
+    {
+      // OZW_ALL_VALUES has the highest key of the node
+      uint64_t last = valueKey(nodeId, OZW_ALL_VALUES);
+
+      m_valueCache.erase(m_valueCache.lower_bound(valueKey(nodeId, 0)),
+                         m_valueCache.upper_bound(last));
+    }
+
+  pthread_rwlock_unlock(&m_cacheLock);
+}
+
+bool OZW::getCachedValue(int nodeId, int index, zwValue_t *val)
+{
+  bool rv = false;
+
+  pthread_rwlock_rdlock(&m_cacheLock);
+
+  if (m_cacheEnabled)
+    {
+      zwValueMap_t::iterator it = m_valueCache.find(valueKey(nodeId, index));
+
+      if (it != m_valueCache.end())
+        {
+          *val = (*it).second;
+          rv = true;
+        }
+    }
+
+  pthread_rwlock_unlock(&m_cacheLock);
+
+  return rv;
+}
+
+void OZW::subscribeValue(int nodeId, int index)
+{
+  pthread_mutex_lock(&m_changeLock);
+  m_subscriptions.insert(valueKey(nodeId, index));
+  pthread_mutex_unlock(&m_changeLock);
+}
+
+void OZW::unsubscribeValue(int nodeId, int index)
+{
+  pthread_mutex_lock(&m_changeLock);
+  m_subscriptions.erase(valueKey(nodeId, index));
+  pthread_mutex_unlock(&m_changeLock);
+}
+
+void OZW::setValueChangeHandler(void (*handler)(int nodeId, int index,
+                                                void *arg),
+                                void *arg)
+{
+  pthread_mutex_lock(&m_changeLock);
+  m_changeHandler = handler;
+  m_changeArg = arg;
+  pthread_mutex_unlock(&m_changeLock);
+}
+
+void OZW::setValueChangeQueueSize(int size)
+{
+  if (size < 0)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": size must be 0 or greater");
+      return;
+    }
+
+  pthread_mutex_lock(&m_changeLock);
+
+  m_changeQueueSize = size;
+  while (m_changeQueue.size() > m_changeQueueSize)
+    {
+      m_changeQueue.pop_front();
+      m_changeOverruns++;
+    }
+
+  pthread_mutex_unlock(&m_changeLock);
+}
+
+int OZW::valueChangesQueued()
+{
+  pthread_mutex_lock(&m_changeLock);
+  int rv = m_changeQueue.size();
+  pthread_mutex_unlock(&m_changeLock);
+
+  return rv;
+}
+
+bool OZW::dequeueValueChange(int *nodeId, int *index)
+{
+  bool rv = false;
+
+  pthread_mutex_lock(&m_changeLock);
+
+  if (!m_changeQueue.empty())
+    {
+      if (nodeId)
+        *nodeId = m_changeQueue.front().first;
+      if (index)
+        *index = m_changeQueue.front().second;
+      m_changeQueue.pop_front();
+      rv = true;
+    }
+
+  pthread_mutex_unlock(&m_changeLock);
+
+  return rv;
+}
+
+unsigned int OZW::getValueChangeOverruns()
+{
+  pthread_mutex_lock(&m_changeLock);
+  unsigned int rv = m_changeOverruns;
+  pthread_mutex_unlock(&m_changeLock);
+
+  return rv;
+}
+
+void OZW::dispatchValueChange(int nodeId, int index)
+{
+  pthread_mutex_lock(&m_changeLock);
+
+  if (!m_subscriptions.count(valueKey(nodeId, index)) &&
+      !m_subscriptions.count(valueKey(nodeId, OZW_ALL_VALUES)))
+    {
+      pthread_mutex_unlock(&m_changeLock);
+      return;
+    }
+
+  if (m_changeQueueSize)
+    {
+      if (m_changeQueue.size() >= m_changeQueueSize)
+        {
+          m_changeQueue.pop_front();
+          m_changeOverruns++;
+        }
+      m_changeQueue.push_back(std::pair<int, int>(nodeId, index));
+    }
+
+  void (*handler)(int, int, void *) = m_changeHandler;
+  void *arg = m_changeArg;
+
+  pthread_mutex_unlock(&m_changeLock);
+
+  // call the handler without any of our locks held
+  if (handler)
+    handler(nodeId, index, arg);
+}
@@ -25,6 +25,9 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <deque>
+#include <pthread.h>
 
 #include "Manager.h"
 #include "Notification.h"
@@ -99,6 +102,13 @@ namespace upm {
   // forward declaration of private zwNode data
   class zwNode;
 
+  // default number of value change events that can be queued before
+  // the oldest are discarded
+#define OZW_DEFAULT_CHANGE_QUEUE 256
+
+  // subscribe to all values of a node
+#define OZW_ALL_VALUES -1
+
   class OZW {
   public:
 
@@ -519,6 +529,99 @@ namespace upm {
      */
     bool isNodeAwake(int nodeId);
 
+    /**
+     * Enable or disable the value cache.  When enabled (the
+     * default), the content of each value is captured as OpenZWave
+     * reports it (ValueAdded, ValueChanged and ValueRefreshed
+     * notifications), and the getValueAs*() methods return the
+     * cached content without taking the node lock or calling into
+     * OpenZWave.  The cache is protected by a read/write lock, so
+     * many readers can query values concurrently, and only the
+     * notification thread ever takes it for writing.  Disable the
+     * cache to always query OpenZWave directly.
+     *
+     * @param enable true to enable the value cache, false otherwise
+     */
+    void enableValueCache(bool enable);
+
+    /**
+     * Subscribe to changes of a value.  Whenever OpenZWave reports a
+     * change to a subscribed value, the value change handler (if
+     * installed via setValueChangeHandler()) is called, and the
+     * nodeId and index are added to the value change queue (see
+     * dequeueValueChange()).
+     *
+     * @param nodeId The node ID
+     * @param index The value index (see dumpNodes()) of the value to
+     * subscribe to, or OZW_ALL_VALUES to subscribe to all of the values
+     * for the node.  The default is OZW_ALL_VALUES.
+     */
+    void subscribeValue(int nodeId, int index=OZW_ALL_VALUES);
+
+    /**
+     * Remove a subscription previously made with subscribeValue().
+     * Changes that have already been queued are not removed.
+     *
+     * @param nodeId The node ID
+     * @param index The value index (see dumpNodes()) or OZW_ALL_VALUES,
+     * as passed to subscribeValue().  The default is OZW_ALL_VALUES.
+     */
+    void unsubscribeValue(int nodeId, int index=OZW_ALL_VALUES);
+
+    /**
+     * Install a function to be called whenever a subscribed value
+     * changes.  The handler is called from the OpenZWave
+     * notification thread (without any internal locks held), so it
+     * should return quickly.  The value content can be read inside
+     * the handler with the getValueAs*() methods, which will be
+     * served from the value cache.  Pass NULL to remove the handler.
+     *
+     * @param handler The function to call.  It is passed the nodeId
+     * and index of the value that changed, and the arg pointer
+     * @param arg A pointer passed to the handler
+     */
+    void setValueChangeHandler(void (*handler)(int nodeId, int index,
+                                               void *arg),
+                               void *arg);
+
+    /**
+     * Set the maximum number of value changes that will be held in
+     * the value change queue.  When the queue is full, the oldest
+     * change is discarded and the overrun counter is incremented.
+     * The default is OZW_DEFAULT_CHANGE_QUEUE.  A size of 0 disables
+     * queueing.
+     *
+     * @param size The maximum number of queued changes
+     */
+    void setValueChangeQueueSize(int size);
+
+    /**
+     * Return the number of value changes currently queued.
+     *
+     * @return The number of queued value changes
+     */
+    int valueChangesQueued();
+
+    /**
+     * Remove the oldest value change from the value change queue.
+     *
+     * @param nodeId A pointer to an int that will contain the node ID
+     * of the value that changed
+     * @param index A pointer to an int that will contain the index of
+     * the value that changed
+     * @return true if a value change was returned, false if the queue
+     * was empty
+     */
+    bool dequeueValueChange(int *nodeId, int *index);
+
+    /**
+     * Return the number of value changes discarded because the value
+     * change queue was full.
+     *
+     * @return The number of discarded value changes
+     */
+    unsigned int getValueChangeOverruns();
+
   protected:
     /**
      * Based on a nodeId and a value index, lookup the corresponding
@@ -543,6 +646,70 @@ namespace upm {
      */
     void unlockNodes() { pthread_mutex_unlock(&m_nodeLock); };
 
+    // cached content of a value
+    typedef struct {
+      OpenZWave::ValueID::ValueType type;
+      bool writeOnly;
+      std::string str;
+      float fval;
+      int32_t ival;
+    } zwValue_t;
+
+    typedef std::map<uint64_t, zwValue_t> zwValueMap_t;
+
+    /**
+     * Build the key used for the value cache and subscriptions.
+     * The whole index is kept, so OZW_ALL_VALUES sorts after, and
+     * never matches, any real value index of the node.
+     *
+     * @param nodeId The node ID
+     * @param index The value index, or OZW_ALL_VALUES
+     * @return The key
+     */
+    static uint64_t valueKey(int nodeId, int index)
+    {
+      return (uint64_t(nodeId & 0xff) << 32) | uint32_t(index);
+    };
+
+    /**
+     * Query OpenZWave for the current content of a value and store it
+     * in the value cache.  Called from the notification handler only.
+     *
+     * @param nodeId The node ID
+     * @param index The value index
+     * @param vid The OpenZWave ValueID
+     */
+    void cacheValue(int nodeId, int index, OpenZWave::ValueID vid);
+
+    /**
+     * Remove values from the value cache.  Called from the
+     * notification handler only.
+     *
+     * @param nodeId The node ID, or -1 for all nodes
+     * @param index The value index, or OZW_ALL_VALUES for all values
+     * of the node
+     */
+    void uncacheValues(int nodeId, int index);
+
+    /**
+     * Copy a value out of the value cache.
+     *
+     * @param nodeId The node ID
+     * @param index The value index
+     * @param val A pointer to a zwValue_t to hold the cached content
+     * @return true if the value was cached, false otherwise
+     */
+    bool getCachedValue(int nodeId, int index, zwValue_t *val);
+
+    /**
+     * Call the value change handler and queue the change if the
+     * value is subscribed.
+     *
+     * @param nodeId The node ID
+     * @param index The value index
+     */
+    void dispatchValueChange(int nodeId, int index);
+
   private:
     uint32_t m_homeId;
     bool m_mgrCreated;
@@ -568,6 +735,20 @@ namespace upm {
     // has successfully queried essential data about the network).
     pthread_mutex_t m_initLock;
     pthread_cond_t m_initCond;
+
+    // the value cache, written only by the notification handler
+    bool m_cacheEnabled;
+    zwValueMap_t m_valueCache;
+    pthread_rwlock_t m_cacheLock;
+
+    // subscriptions, the change handler and the change queue
+    std::set<uint64_t> m_subscriptions;
+    void (*m_changeHandler)(int nodeId, int index, void *arg);
+    void *m_changeArg;
+    std::deque<std::pair<int, int> > m_changeQueue;
+    unsigned int m_changeQueueSize;
+    unsigned int m_changeOverruns;
+    pthread_mutex_t m_changeLock;
   };
 }
 
@@ -9,6 +9,7 @@
 %feature("autodoc", "3");
 
 %pointer_functions(float, floatp);
+%pointer_functions(int, intp);
 
 %include "ozw.h"
 %{
@@ -54,25 +54,30 @@ uint32_t zwNode::homeId()
   return m_homeId;
 }
 
-void zwNode::addValueID(ValueID vid) 
+int zwNode::addValueID(ValueID vid) 
 {
+  int index = m_vindex++;
+
   // We need to use insert since ValueID's default ctor is private
-  m_values.insert(std::pair<int, ValueID>(m_vindex++, vid));
+  m_values.insert(std::pair<int, ValueID>(index, vid));
+  m_indices[vid.GetId()] = index;
+
+  return index;
 }
 
-void zwNode::removeValueID(ValueID vid) 
+int zwNode::removeValueID(ValueID vid) 
 {
-  //we have to get a little complicated here since we need to delete
-  //the value id, but the map is indexed by m_vindex
-  for (valueMap_t::iterator it = m_values.begin();
-       it != m_values.end(); ++it)
-    {
-      if ((*it).second == vid)
-        {
-          m_values.erase((*it).first);
-          break;
-        }
-    }
+  indexMap_t::iterator it = m_indices.find(vid.GetId());
+
+  if (it == m_indices.end())
+    return -1;
+
+  int index = (*it).second;
+
+  m_values.erase(index);
+  m_indices.erase(it);
+
+  return index;
 }
 
 bool zwNode::indexToValueID(int index, ValueID *vid)
@@ -92,6 +97,16 @@ bool zwNode::indexToValueID(int index, ValueID *vid)
   return true;
 }
 
+int zwNode::valueIDToIndex(ValueID vid)
+{
+  indexMap_t::iterator it = m_indices.find(vid.GetId());
+
+  if (it == m_indices.end())
+    return -1;
+
+  return (*it).second;
+}
+
 void zwNode::dumpNode(bool all)
 {
   for (valueMap_t::iterator it = m_values.begin();
@@ -32,6 +32,7 @@ namespace upm {
   class zwNode {
   public:
     typedef std::map<int, OpenZWave::ValueID> valueMap_t;
+    typedef std::map<uint64_t, int> indexMap_t;
 
     /**
      * zwNode contructor.
@@ -62,15 +63,17 @@ namespace upm {
      * incrementing m_vindex.
      *
      * @param vid The OpenZWave ValueID
+     * @return The index assigned to the value
      */
-    void addValueID(OpenZWave::ValueID vid);
+    int addValueID(OpenZWave::ValueID vid);
 
     /**
      * Remove an OpenZWave ValueID from the value map.
      *
      * @param vid The OpenZWave ValueID
+     * @return The index the value was stored at, or -1 if not found
      */
-    void removeValueID(OpenZWave::ValueID vid);
+    int removeValueID(OpenZWave::ValueID vid);
 
     /**
      * Lookup and return a ValueID corresponding to an index.
@@ -81,6 +84,14 @@ namespace upm {
      */
     bool indexToValueID(int index, OpenZWave::ValueID *vid);
 
+    /**
+     * Lookup and return the index corresponding to a ValueID.
+     *
+     * @param vid The OpenZWave ValueID to look up
+     * @return The index of the value, or -1 if it was not found
+     */
+    int valueIDToIndex(OpenZWave::ValueID vid);
+
     /**
      * Dump various information about the ValueIDs stored in this
      * node.
@@ -98,6 +109,10 @@ namespace upm {
 
     valueMap_t m_values;
 
+    // reverse lookup of ValueID's (by their 64b id) to indexes, used
+    // when handling value notifications
+    indexMap_t m_indices;
+
     // we increment this index for every ValueID we add
     unsigned int m_vindex;
   };
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <math.h>
+#include <sched.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "pollsched.h"
+
+using namespace upm;
+using namespace std;
+
+PollScheduler::PollScheduler()
+{
+  m_running = false;
+
+  pthread_condattr_t condAttrib;
+  pthread_condattr_init(&condAttrib);
+  // deadlines are computed on the monotonic clock
+  pthread_condattr_setclock(&condAttrib, CLOCK_MONOTONIC);
+
+  if (pthread_cond_init(&m_runCond, &condAttrib))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_cond_init() failed");
+    }
+
+  pthread_condattr_destroy(&condAttrib);
+
+  if (pthread_mutex_init(&m_runLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(runLock) failed");
+    }
+
+  if (pthread_mutex_init(&m_statsLock, NULL))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(statsLock) failed");
+    }
+}
+
+PollScheduler::~PollScheduler()
+{
+  stop();
+
+  pthread_cond_destroy(&m_runCond);
+  pthread_mutex_destroy(&m_runLock);
+  pthread_mutex_destroy(&m_statsLock);
+}
+
+uint64_t PollScheduler::now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t(ts.tv_sec) * 1000000000ULL) + ts.tv_nsec;
+}
+
+void PollScheduler::checkId(int id)
+{
+  if (id < 0 || id >= int(m_devices.size()))
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": invalid device id");
+    }
+}
+
+int PollScheduler::addDevice(POLL_FUNC_T func, void *ctx, float rate,
+                             BUS_TYPE_T busType, int busNum)
+{
+  if (m_running)
+    {
+      throw std::logic_error(std::string(__FUNCTION__) +
+                             ": devices cannot be added while running");
+      return -1;
+    }
+
+  if (!func)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": func must not be NULL");
+      return -1;
+    }
+
+  // the period is kept in whole nanoseconds and must not be 0
+  if (!(rate > 0.0) || rate > 1000000000.0)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": rate must be greater than 0 and no more "
+                              "than 1e9 Hz");
+      return -1;
+    }
+
+  device_t dev;
+
+  dev.func = func;
+  dev.ctx = ctx;
+  dev.period = uint64_t(1000000000.0 / rate);
+  dev.deadline = 0;
+  dev.seq = 0;
+  dev.samples = 0;
+  dev.misses = 0;
+  dev.errors = 0;
+  dev.jitterSq = 0;
+  dev.maxJitter = 0;
+  dev.pollTime = 0;
+
+  int id = m_devices.size();
+  m_devices.push_back(dev);
+
+  // find (or add) the bus
+  for (size_t i=0; i<m_buses.size(); i++)
+    {
+      if (m_buses[i].type == busType && m_buses[i].num == busNum)
+        {
+          m_buses[i].devices.push_back(id);
+          return id;
+        }
+    }
+
+  bus_t bus;
+
+  bus.type = busType;
+  bus.num = busNum;
+  bus.devices.push_back(id);
+  bus.sched = this;
+
+  m_buses.push_back(bus);
+
+  return id;
+}
+
+void PollScheduler::start()
+{
+  if (m_running)
+    return;
+
+  m_running = true;
+
+  // every device is first polled right away
+  uint64_t t = now();
+  for (size_t i=0; i<m_devices.size(); i++)
+    m_devices[i].deadline = t;
+
+  for (size_t i=0; i<m_buses.size(); i++)
+    {
+      if (pthread_create(&m_buses[i].thread, NULL, busThread, &m_buses[i]))
+        {
+          // stop the threads already started
+          pthread_mutex_lock(&m_runLock);
+          m_running = false;
+          pthread_cond_broadcast(&m_runCond);
+          pthread_mutex_unlock(&m_runLock);
+
+          for (size_t j=0; j<i; j++)
+            pthread_join(m_buses[j].thread, NULL);
+
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": pthread_create() failed");
+          return;
+        }
+    }
+}
+
+void PollScheduler::stop()
+{
+  if (!m_running)
+    return;
+
+  pthread_mutex_lock(&m_runLock);
+  m_running = false;
+  pthread_cond_broadcast(&m_runCond);
+  pthread_mutex_unlock(&m_runLock);
+
+  for (size_t i=0; i<m_buses.size(); i++)
+    pthread_join(m_buses[i].thread, NULL);
+}
+
+void *PollScheduler::busThread(void *ctx)
+{
+  bus_t *bus = (bus_t *)ctx;
+
+  bus->sched->runBus(bus);
+
+  return NULL;
+}
+
+void PollScheduler::runBus(bus_t *bus)
+{
+  while (m_running)
+    {
+      // find the device with the earliest deadline on this bus
+      int id = bus->devices[0];
+      for (size_t i=1; i<bus->devices.size(); i++)
+        {
+          if (m_devices[bus->devices[i]].deadline < m_devices[id].deadline)
+            id = bus->devices[i];
+        }
+
+      device_t *dev = &m_devices[id];
+
+      // sleep until it is due, or we are stopped
+      struct timespec ts;
+      ts.tv_sec = dev->deadline / 1000000000ULL;
+      ts.tv_nsec = dev->deadline % 1000000000ULL;
+
+      pthread_mutex_lock(&m_runLock);
+      while (m_running && now() < dev->deadline)
+        pthread_cond_timedwait(&m_runCond, &m_runLock, &ts);
+      pthread_mutex_unlock(&m_runLock);
+
+      if (!m_running)
+        break;
+
+      uint64_t start = now();
+      uint64_t late = (start > dev->deadline) ? start - dev->deadline : 0;
+      bool failed = false;
+
+      // an odd sequence number tells readers a poll is in progress.
+      // __sync_fetch_and_add() is a full memory barrier.
+      __sync_fetch_and_add(&dev->seq, 1);
+
+      try
+        {
+          dev->func(dev->ctx);
+        }
+      catch (std::exception& e)
+        {
+          cerr << __FUNCTION__ << ": device " << id << ": " << e.what()
+               << endl;
+          failed = true;
+        }
+      catch (...)
+        {
+          failed = true;
+        }
+
+      __sync_fetch_and_add(&dev->seq, 1);
+
+      uint64_t elapsed = now() - start;
+
+      // schedule the next poll, skipping any periods we have already
+      // missed entirely
+      uint32_t missed = late / dev->period;
+      dev->deadline += uint64_t(missed + 1) * dev->period;
+
+      uint64_t lateUs = late / 1000;
+
+      pthread_mutex_lock(&m_statsLock);
+      dev->samples++;
+      dev->misses += missed;
+      if (failed)
+        dev->errors++;
+      dev->jitterSq += lateUs * lateUs;
+      if (late > dev->maxJitter)
+        dev->maxJitter = late;
+      dev->pollTime += elapsed;
+      pthread_mutex_unlock(&m_statsLock);
+    }
+}
+
+uint32_t PollScheduler::readBegin(int id)
+{
+  checkId(id);
+
+  uint32_t seq;
+
+  // wait for any poll in progress to complete
+  while ((seq = m_devices[id].seq) & 1)
+    sched_yield();
+
+  __sync_synchronize();
+
+  return seq;
+}
+
+bool PollScheduler::readRetry(int id, uint32_t seq)
+{
+  checkId(id);
+
+  __sync_synchronize();
+
+  return (m_devices[id].seq != seq);
+}
+
+uint32_t PollScheduler::getSampleCount(int id)
+{
+  checkId(id);
+
+  // every completed poll advances the sequence number by 2
+  return m_devices[id].seq / 2;
+}
+
+uint32_t PollScheduler::getDeadlineMisses(int id)
+{
+  checkId(id);
+
+  pthread_mutex_lock(&m_statsLock);
+  uint32_t rv = m_devices[id].misses;
+  pthread_mutex_unlock(&m_statsLock);
+
+  return rv;
+}
+
+uint32_t PollScheduler::getErrors(int id)
+{
+  checkId(id);
+
+  pthread_mutex_lock(&m_statsLock);
+  uint32_t rv = m_devices[id].errors;
+  pthread_mutex_unlock(&m_statsLock);
+
+  return rv;
+}
+
+float PollScheduler::getJitter(int id)
+{
+  checkId(id);
+
+  float rv = 0.0;
+
+  pthread_mutex_lock(&m_statsLock);
+  if (m_devices[id].samples)
+    rv = sqrt(double(m_devices[id].jitterSq) / m_devices[id].samples);
+  pthread_mutex_unlock(&m_statsLock);
+
+  return rv;
+}
+
+float PollScheduler::getMaxJitter(int id)
+{
+  checkId(id);
+
+  pthread_mutex_lock(&m_statsLock);
+  float rv = float(m_devices[id].maxJitter) / 1000.0;
+  pthread_mutex_unlock(&m_statsLock);
+
+  return rv;
+}
+
+float PollScheduler::getPollTime(int id)
+{
+  checkId(id);
+
+  float rv = 0.0;
+
+  pthread_mutex_lock(&m_statsLock);
+  if (m_devices[id].samples)
+    rv = (float(m_devices[id].pollTime) / m_devices[id].samples) / 1000.0;
+  pthread_mutex_unlock(&m_statsLock);
+
+  return rv;
+}
+
+void PollScheduler::resetStats(int id)
+{
+  checkId(id);
+
+  pthread_mutex_lock(&m_statsLock);
+  m_devices[id].samples = 0;
+  m_devices[id].misses = 0;
+  m_devices[id].errors = 0;
+  m_devices[id].jitterSq = 0;
+  m_devices[id].maxJitter = 0;
+  m_devices[id].pollTime = 0;
+  pthread_mutex_unlock(&m_statsLock);
+}
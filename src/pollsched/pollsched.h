@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <vector>
+
+namespace upm {
+
+  /**
+   * @library pollsched
+   * @brief Multi-device polling scheduler
+   *
+   * PollScheduler periodically calls the update() (or any other
+   * polling function) of a set of drivers, each at its own rate.
+   * Devices are grouped by the bus they are attached to (I2C, SPI
+   * or UART bus number).  Every bus gets its own worker thread, so
+   * devices on different buses are polled in parallel, while devices
+   * sharing a bus are polled one at a time, earliest deadline first.
+   *
+   * Each completed poll is published through a per-device sequence
+   * counter.  Readers use readBegin()/readRetry() around the driver
+   * getters to obtain a consistent sample without blocking the
+   * worker thread:
+   *
+   * @code
+   * uint32_t seq;
+   * do {
+   *   seq = sched.readBegin(id);
+   *   imu.getAccelerometer(&x, &y, &z);
+   * } while (sched.readRetry(id, seq));
+   * @endcode
+   *
+   * The scheduler also keeps per-device timing statistics: the number
+   * of deadline misses (polls that started a full period or more
+   * late), the maximum and RMS start jitter, and the average time
+   * spent in the polling function.  These can be used to choose
+   * sensible polling rates.
+   *
+   * Devices must be added before start() is called.
+   *
+   * @snippet pollsched.cxx Interesting
+   */
+  class PollScheduler {
+  public:
+
+    /**
+     * Bus types, used along with a bus number to decide which
+     * devices must be serialized
+     */
+    typedef enum {
+      BUS_I2C                   = 0,
+      BUS_SPI                   = 1,
+      BUS_UART                  = 2,
+      BUS_OTHER                 = 3
+    } BUS_TYPE_T;
+
+    /**
+     * Polling function type.  Exceptions thrown from the polling
+     * function are caught and counted (see getErrors()).
+     */
+    typedef void (*POLL_FUNC_T)(void *ctx);
+
+    /**
+     * Polling function calling T::update() on a driver instance.
+     * For example:
+     *
+     * @code
+     * sched.addDevice(&PollScheduler::updateDevice<upm::MPU9150>, &imu,
+     *                 100.0, PollScheduler::BUS_I2C, 0);
+     * @endcode
+     *
+     * @param ctx A pointer to the driver instance
+     */
+    template <class T>
+    static void updateDevice(void *ctx)
+    {
+      static_cast<T *>(ctx)->update();
+    };
+
+    /**
+     * PollScheduler constructor
+     */
+    PollScheduler();
+
+    /**
+     * PollScheduler destructor.  Stops the worker threads if running.
+     */
+    ~PollScheduler();
+
+    /**
+     * Add a device to be polled.
+     *
+     * @param func The polling function
+     * @param ctx A pointer passed to the polling function, usually
+     * the driver instance
+     * @param rate The polling rate in Hz, at most 1e9
+     * @param busType The type of bus the device is attached to
+     * @param busNum The bus number.  Devices with the same bus type
+     * and number are never polled concurrently.
+     * @return The device id, used with the other methods
+     */
+    int addDevice(POLL_FUNC_T func, void *ctx, float rate,
+                  BUS_TYPE_T busType, int busNum);
+
+    /**
+     * Start polling.  One worker thread is created for every bus
+     * that has at least one device.
+     */
+    void start();
+
+    /**
+     * Stop polling, and wait for all of the worker threads to exit.
+     */
+    void stop();
+
+    /**
+     * Return whether the scheduler is running.
+     *
+     * @return true if the worker threads are running, false otherwise
+     */
+    bool isRunning() { return m_running; };
+
+    /**
+     * Return the number of buses, and therefore worker threads, in
+     * use.
+     *
+     * @return The number of buses
+     */
+    int getBusCount() { return m_buses.size(); };
+
+    /**
+     * Begin reading the latest sample of a device.  The returned
+     * sequence number must be passed to readRetry() once the driver's
+     * getters have been called.  This does not block the worker
+     * thread.
+     *
+     * @param id The device id
+     * @return The sequence number to pass to readRetry()
+     */
+    uint32_t readBegin(int id);
+
+    /**
+     * Test whether the values read since readBegin() may have been
+     * modified by a concurrent poll, in which case they must be read
+     * again.
+     *
+     * @param id The device id
+     * @param seq The sequence number returned by readBegin()
+     * @return true if the read must be retried, false otherwise
+     */
+    bool readRetry(int id, uint32_t seq);
+
+    /**
+     * Return the number of completed polls of a device.  This can be
+     * used to detect that a new sample is available.  It is not
+     * affected by resetStats().
+     *
+     * @param id The device id
+     * @return The number of completed polls
+     */
+    uint32_t getSampleCount(int id);
+
+    /**
+     * Return the number of deadline misses for a device.  A deadline
+     * is missed when a poll starts one or more full periods late; the
+     * skipped periods are each counted as a miss.
+     *
+     * @param id The device id
+     * @return The number of missed deadlines
+     */
+    uint32_t getDeadlineMisses(int id);
+
+    /**
+     * Return the number of polls that threw an exception.
+     *
+     * @param id The device id
+     * @return The number of failed polls
+     */
+    uint32_t getErrors(int id);
+
+    /**
+     * Return the RMS start jitter of a device, which is the RMS of
+     * the difference between the time each poll was scheduled to
+     * start, and the time it actually started.
+     *
+     * @param id The device id
+     * @return The RMS jitter in microseconds
+     */
+    float getJitter(int id);
+
+    /**
+     * Return the largest start jitter seen for a device.
+     *
+     * @param id The device id
+     * @return The maximum jitter in microseconds
+     */
+    float getMaxJitter(int id);
+
+    /**
+     * Return the average time spent in the polling function of a
+     * device.
+     *
+     * @param id The device id
+     * @return The average poll time in microseconds
+     */
+    float getPollTime(int id);
+
+    /**
+     * Reset the statistics of a device.
+     *
+     * @param id The device id
+     */
+    void resetStats(int id);
+
+  protected:
+    // a polled device
+    typedef struct {
+      POLL_FUNC_T func;
+      void *ctx;
+      uint64_t period;          // ns
+      uint64_t deadline;        // ns, CLOCK_MONOTONIC
+
+      // odd while a poll is in progress
+      volatile uint32_t seq;
+
+      // statistics, protected by m_statsLock
+      uint32_t samples;
+      uint32_t misses;
+      uint32_t errors;
+      uint64_t jitterSq;        // sum of squared jitter, us^2
+      uint64_t maxJitter;       // ns
+      uint64_t pollTime;        // sum, ns
+    } device_t;
+
+    // a bus, and the devices attached to it
+    typedef struct {
+      BUS_TYPE_T type;
+      int num;
+      std::vector<int> devices;
+      pthread_t thread;
+      PollScheduler *sched;
+    } bus_t;
+
+    /**
+     * Return the current CLOCK_MONOTONIC time in nanoseconds.
+     *
+     * @return The time in nanoseconds
+     */
+    static uint64_t now();
+
+    /**
+     * Poll the devices of a bus until stop() is called.
+     *
+     * @param bus The bus to service
+     */
+    void runBus(bus_t *bus);
+
+    /**
+     * Worker thread entry point.
+     *
+     * @param ctx A pointer to the bus_t to service
+     */
+    static void *busThread(void *ctx);
+
+    /**
+     * Validate a device id.
+     *
+     * @param id The device id
+     */
+    void checkId(int id);
+
+  private:
+    std::vector<device_t> m_devices;
+    std::vector<bus_t> m_buses;
+
+    volatile bool m_running;
+    pthread_mutex_t m_runLock;
+    pthread_cond_t m_runCond;
+
+    pthread_mutex_t m_statsLock;
+  };
+}
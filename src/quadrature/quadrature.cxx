@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <sched.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "quadrature.h"
+#include "edgerate.h"
+
+using namespace upm;
+using namespace std;
+
+// marks a transition where both channels changed
+#define QD_INVALID 2
+
+// Indexed by (previous AB << 2) | current AB, with A as the low bit.
+// Gives the count change of each transition, 0 for no change, or
+// QD_INVALID when a state was skipped.
+static const int8_t transitionTable[16] = {
+  0,          -1,           1,          QD_INVALID,
+  1,           0,           QD_INVALID, -1,
+  -1,          QD_INVALID,  0,           1,
+  QD_INVALID,  1,          -1,           0
+};
+
+QuadratureDecoder::QuadratureDecoder(int pinA, int pinB, bool pullup)
+{
+  if ( !(m_gpioA = mraa_gpio_init(pinA)) )
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": mraa_gpio_init(pinA) failed, invalid pin?");
+      return;
+    }
+
+  if ( !(m_gpioB = mraa_gpio_init(pinB)) )
+    {
+      mraa_gpio_close(m_gpioA);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": mraa_gpio_init(pinB) failed, invalid pin?");
+      return;
+    }
+
+  mraa_gpio_dir(m_gpioA, MRAA_GPIO_IN);
+  mraa_gpio_dir(m_gpioB, MRAA_GPIO_IN);
+
+  if (pullup)
+    {
+      mraa_gpio_mode(m_gpioA, MRAA_GPIO_PULLUP);
+      mraa_gpio_mode(m_gpioB, MRAA_GPIO_PULLUP);
+    }
+
+  pthread_mutex_init(&m_lock, NULL);
+
+  m_mode = DECODE_ISR;
+  m_running = false;
+  m_pollRun = false;
+  m_pollIntervalUs = QUADRATURE_DEFAULT_POLL_US;
+
+  m_state = (mraa_gpio_read(m_gpioB) << 1) | mraa_gpio_read(m_gpioA);
+  m_position = 0;
+  m_errors = 0;
+
+  m_histHead = 0;
+  m_histCount = 0;
+}
+
+QuadratureDecoder::~QuadratureDecoder()
+{
+  stop();
+
+  mraa_gpio_close(m_gpioA);
+  mraa_gpio_close(m_gpioB);
+
+  pthread_mutex_destroy(&m_lock);
+}
+
+void QuadratureDecoder::start(DECODE_MODE_T mode, int pollIntervalUs,
+                              int priority)
+{
+  stop();
+
+  // resynchronize with the current state of the channels
+  pthread_mutex_lock(&m_lock);
+  m_state = (mraa_gpio_read(m_gpioB) << 1) | mraa_gpio_read(m_gpioA);
+  pthread_mutex_unlock(&m_lock);
+
+  m_mode = mode;
+
+  if (mode == DECODE_ISR)
+    {
+      if (mraa_gpio_isr(m_gpioA, MRAA_GPIO_EDGE_BOTH, &isrHandler, this)
+          != MRAA_SUCCESS)
+        {
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": mraa_gpio_isr(A) failed");
+          return;
+        }
+
+      if (mraa_gpio_isr(m_gpioB, MRAA_GPIO_EDGE_BOTH, &isrHandler, this)
+          != MRAA_SUCCESS)
+        {
+          mraa_gpio_isr_exit(m_gpioA);
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": mraa_gpio_isr(B) failed");
+          return;
+        }
+
+      m_running = true;
+      return;
+    }
+
+  // we warn if these fail, since it may not be possible on all
+  // platforms.  Decoding still works, at lower edge rates.
+  if (mraa_gpio_use_mmaped(m_gpioA, 1) != MRAA_SUCCESS)
+    cerr << __FUNCTION__
+         << ": Warning: mmap of A pin failed, maximum edge rate "
+         << "will be reduced."
+         << endl;
+
+  if (mraa_gpio_use_mmaped(m_gpioB, 1) != MRAA_SUCCESS)
+    cerr << __FUNCTION__
+         << ": Warning: mmap of B pin failed, maximum edge rate "
+         << "will be reduced."
+         << endl;
+
+  m_pollIntervalUs = (pollIntervalUs < 0) ? 0 : pollIntervalUs;
+  m_pollRun = true;
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+
+  if (priority > 0)
+    {
+      struct sched_param param;
+
+      param.sched_priority = priority;
+      pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+      pthread_attr_setschedparam(&attr, &param);
+    }
+
+  int rv = pthread_create(&m_pollThread, &attr, pollThread, this);
+
+  // most likely not permitted to use a realtime priority, so fall
+  // back to the default scheduling rather than not decoding at all
+  if (rv && priority > 0)
+    {
+      cerr << __FUNCTION__
+           << ": Warning: unable to set realtime priority, using default."
+           << endl;
+      rv = pthread_create(&m_pollThread, NULL, pollThread, this);
+    }
+
+  pthread_attr_destroy(&attr);
+
+  if (rv)
+    {
+      m_pollRun = false;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_create() failed");
+      return;
+    }
+
+  m_running = true;
+}
+
+void QuadratureDecoder::stop()
+{
+  if (!m_running)
+    return;
+
+  if (m_mode == DECODE_ISR)
+    {
+      mraa_gpio_isr_exit(m_gpioA);
+      mraa_gpio_isr_exit(m_gpioB);
+    }
+  else
+    {
+      m_pollRun = false;
+      pthread_join(m_pollThread, NULL);
+
+      mraa_gpio_use_mmaped(m_gpioA, 0);
+      mraa_gpio_use_mmaped(m_gpioB, 0);
+    }
+
+  m_running = false;
+}
+
+void QuadratureDecoder::sample()
+{
+  // with one ISR thread per pin, the read and the state update must
+  // happen together or two edges can be applied out of order
+  pthread_mutex_lock(&m_lock);
+
+  uint8_t state = (mraa_gpio_read(m_gpioB) << 1) | mraa_gpio_read(m_gpioA);
+  int8_t delta = transitionTable[(m_state << 2) | state];
+  m_state = state;
+
+  if (delta == QD_INVALID)
+    m_errors++;
+  else if (delta)
+    {
+      m_position += delta;
+
+      m_histTime[m_histHead] = EdgeRate::now();
+      m_histPos[m_histHead] = m_position;
+      m_histHead = (m_histHead + 1) % QUADRATURE_HISTORY;
+      if (m_histCount < QUADRATURE_HISTORY)
+        m_histCount++;
+    }
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+void QuadratureDecoder::isrHandler(void *ctx)
+{
+  upm::QuadratureDecoder *This = (upm::QuadratureDecoder *)ctx;
+
+  This->sample();
+}
+
+void *QuadratureDecoder::pollThread(void *ctx)
+{
+  upm::QuadratureDecoder *This = (upm::QuadratureDecoder *)ctx;
+
+  while (This->m_pollRun)
+    {
+      This->sample();
+
+      if (This->m_pollIntervalUs)
+        usleep(This->m_pollIntervalUs);
+    }
+
+  return 0;
+}
+
+int QuadratureDecoder::position()
+{
+  return m_position;
+}
+
+void QuadratureDecoder::setPosition(int count)
+{
+  pthread_mutex_lock(&m_lock);
+
+  m_position = count;
+  // velocity history is relative to the old position
+  m_histCount = 0;
+
+  pthread_mutex_unlock(&m_lock);
+}
+
+uint32_t QuadratureDecoder::errorCount()
+{
+  return m_errors;
+}
+
+void QuadratureDecoder::clearErrors()
+{
+  pthread_mutex_lock(&m_lock);
+  m_errors = 0;
+  pthread_mutex_unlock(&m_lock);
+}
+
+float QuadratureDecoder::velocity(uint32_t windowMs)
+{
+  uint64_t start = EdgeRate::now() - (uint64_t(windowMs) * 1000);
+
+  pthread_mutex_lock(&m_lock);
+
+  if (!m_histCount)
+    {
+      pthread_mutex_unlock(&m_lock);
+      return 0.0;
+    }
+
+  int newest = (m_histHead + QUADRATURE_HISTORY - 1) % QUADRATURE_HISTORY;
+
+  // the oldest transition still inside the window
+  int n = 0;
+  int oldest = newest;
+  while (n < m_histCount)
+    {
+      int idx = (newest + QUADRATURE_HISTORY - n) % QUADRATURE_HISTORY;
+
+      if (m_histTime[idx] < start)
+        break;
+
+      oldest = idx;
+      n++;
+    }
+
+  uint64_t span = m_histTime[newest] - m_histTime[oldest];
+  int counts = m_histPos[newest] - m_histPos[oldest];
+
+  pthread_mutex_unlock(&m_lock);
+
+  // stopped, or a single transition in the window
+  if (n < 2 || span == 0)
+    return 0.0;
+
+  return (float(counts) * 1000000.0) / float(span);
+}
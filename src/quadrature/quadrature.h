@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+#include <mraa/gpio.h>
+
+// Default sampling interval of the polled decoder, in microseconds
+#define QUADRATURE_DEFAULT_POLL_US 50
+
+// Default window of velocity(), in milliseconds
+#define QUADRATURE_DEFAULT_WINDOW 100
+
+// Number of transitions kept for velocity estimation
+#define QUADRATURE_HISTORY 64
+
+namespace upm {
+
+  /**
+   * @library quadrature
+   * @brief 4x quadrature decoder for incremental encoders
+   *
+   * QuadratureDecoder tracks the A and B channels of an incremental
+   * encoder.  Every change of either channel is looked up in a state
+   * transition table, giving four counts per encoder cycle (4x
+   * decoding).  A transition where both channels changed at once
+   * means at least one state was missed, and its direction is
+   * unknown; such transitions are not counted, but are reported by
+   * errorCount().
+   *
+   * The decoder runs in one of two modes:
+   *
+   * DECODE_ISR installs interrupt handlers on both edges of both
+   * channels.  This costs no CPU while the encoder is still, but every
+   * edge goes through an ISR thread wakeup, which limits it to low
+   * edge rates (hand operated knobs).
+   *
+   * DECODE_POLL samples both channels from a dedicated thread, using
+   * memory mapped GPIO when the platform supports it, optionally at a
+   * realtime (SCHED_FIFO) priority.  This keeps up with motor encoders
+   * at edge rates in the kHz range, at the cost of a busy thread.
+   *
+   * velocity() estimates the count rate from the timestamps of the
+   * most recent transitions.
+   */
+  class QuadratureDecoder {
+  public:
+
+    /**
+     * Decoder modes
+     */
+    typedef enum {
+      DECODE_ISR                = 0,
+      DECODE_POLL               = 1
+    } DECODE_MODE_T;
+
+    /**
+     * QuadratureDecoder constructor.  Decoding does not begin until
+     * start() is called.
+     *
+     * @param pinA GPIO pin for channel A
+     * @param pinB GPIO pin for channel B
+     * @param pullup true to enable the pins' pull-up resistors
+     */
+    QuadratureDecoder(int pinA, int pinB, bool pullup=false);
+
+    /**
+     * QuadratureDecoder destructor
+     */
+    ~QuadratureDecoder();
+
+    /**
+     * start decoding.  If the decoder is already running, it is
+     * stopped and restarted in the new mode.
+     *
+     * @param mode one of the DECODE_MODE_T values
+     * @param pollIntervalUs for DECODE_POLL, the time between samples
+     * in microseconds.  The edge rate must stay below the sampling
+     * rate.  0 samples continuously.
+     * @param priority for DECODE_POLL, a SCHED_FIFO priority (1-99)
+     * for the polling thread, or 0 to use the default scheduling.
+     * Realtime priorities usually require root privileges.
+     */
+    void start(DECODE_MODE_T mode=DECODE_ISR,
+               int pollIntervalUs=QUADRATURE_DEFAULT_POLL_US,
+               int priority=0);
+
+    /**
+     * stop decoding.  The position is kept.
+     */
+    void stop();
+
+    /**
+     * return the current position in counts (four per cycle)
+     *
+     * @return position
+     */
+    int position();
+
+    /**
+     * set the current position
+     *
+     * @param count the new position in counts
+     */
+    void setPosition(int count);
+
+    /**
+     * return the number of invalid transitions (both channels changed
+     * between two samples) since construction or clearErrors()
+     *
+     * @return number of errors
+     */
+    uint32_t errorCount();
+
+    /**
+     * reset the error count to 0
+     */
+    void clearErrors();
+
+    /**
+     * return the signed count rate, averaged over the transitions of
+     * the last windowMs milliseconds.  Once no transition has been
+     * seen for longer than the window, 0 is returned.
+     *
+     * @param windowMs length of the averaging window in milliseconds
+     * @return counts per second
+     */
+    float velocity(uint32_t windowMs=QUADRATURE_DEFAULT_WINDOW);
+
+  protected:
+    // read both channels and process the resulting transition
+    void sample();
+
+  private:
+    static void isrHandler(void *ctx);
+    static void *pollThread(void *ctx);
+
+    mraa_gpio_context m_gpioA;
+    mraa_gpio_context m_gpioB;
+
+    DECODE_MODE_T m_mode;
+    bool m_running;
+    volatile bool m_pollRun;
+    int m_pollIntervalUs;
+    pthread_t m_pollThread;
+
+    // previous AB state
+    uint8_t m_state;
+    volatile int m_position;
+    volatile uint32_t m_errors;
+
+    // time (us) and position of the most recent transitions
+    uint64_t m_histTime[QUADRATURE_HISTORY];
+    int m_histPos[QUADRATURE_HISTORY];
+    int m_histHead;
+    int m_histCount;
+
+    pthread_mutex_t m_lock;
+  };
+}
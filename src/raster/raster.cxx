@@ -0,0 +1,1062 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "raster.h"
+
+using namespace upm;
+using namespace std;
+
+#define RASTER_SWAP(a, b) { int16_t t = a; a = b; b = t; }
+
+// For a quarter circle of radius r drawn by the midpoint algorithm of
+// the classic GFX primitives, fill in the half width of each row: for
+// row offset c from the center, halfWidth[c] is the largest column
+// offset reached at that row, or -1 if the arc does not reach the
+// row.  minColumn is the smallest column offset drawn, which is 1
+// except for tiny circles.
+static void circleExtents(int16_t r, vector<int16_t> &halfWidth,
+                          int16_t &minColumn)
+{
+  int16_t f     = 1 - r;
+  int16_t ddF_x = 1;
+  int16_t ddF_y = -2 * r;
+  int16_t x     = 0;
+  int16_t y     = r;
+
+  halfWidth.assign(r + 1, -1);
+  minColumn = 1;
+
+  // first, the widest column reaching exactly each row offset
+  while (x < y)
+    {
+      if (f >= 0)
+        {
+          y--;
+          ddF_y += 2;
+          f     += ddF_y;
+        }
+      x++;
+      ddF_x += 2;
+      f     += ddF_x;
+
+      // the classic helpers draw column x down to row offset y, and
+      // column y down to row offset x
+      if (halfWidth[y] < x)
+        halfWidth[y] = x;
+      if (halfWidth[x] < y)
+        halfWidth[x] = y;
+      if (y < minColumn)
+        minColumn = y;
+    }
+
+  // a column reaching row offset c also covers every row above it
+  for (int c = r - 1; c >= 0; c--)
+    if (halfWidth[c] < halfWidth[c + 1])
+      halfWidth[c] = halfWidth[c + 1];
+}
+
+// the columns and width of a character's glyph, false if the font
+// has none
+static bool glyphOf(const Raster::FONT_T *font, unsigned char c,
+                    const unsigned char *&columns, int &width)
+{
+  if (c < font->first || c >= font->first + font->count)
+    return false;
+
+  int idx = c - font->first;
+  int bytes = (font->height + 7) / 8;
+
+  if (font->offsets)
+    {
+      columns = font->columns + (font->offsets[idx] * bytes);
+      width = font->widths[idx];
+    }
+  else
+    {
+      columns = font->columns + (idx * font->width * bytes);
+      width = font->width;
+    }
+
+  return true;
+}
+
+Raster::Raster()
+{
+  for (int i = 0; i < RASTER_GLYPH_CACHE; i++)
+    m_glyphs[i].valid = false;
+}
+
+Raster::~Raster()
+{
+}
+
+void Raster::fill565(uint8_t *dst, uint16_t color, int count)
+{
+  if (count <= 0)
+    return;
+
+  uint8_t hi = color >> 8;
+  uint8_t lo = color & 0xff;
+
+  // seed a few pixels, then keep doubling the filled part
+  int done = (count < 8) ? count : 8;
+  for (int i = 0; i < done; i++)
+    {
+      dst[i * 2] = hi;
+      dst[(i * 2) + 1] = lo;
+    }
+
+  while (done < count)
+    {
+      int chunk = (done < count - done) ? done : count - done;
+
+      memcpy(dst + (done * 2), dst, chunk * 2);
+      done += chunk;
+    }
+}
+
+void Raster::fill565Rect(uint8_t *map, int stride, int16_t x, int16_t y,
+                         int16_t w, int16_t h, uint16_t color)
+{
+  uint8_t *first = map + (y * stride) + (x * 2);
+
+  fill565(first, color, w);
+
+  uint8_t *row = first;
+  for (int16_t i = 1; i < h; i++)
+    {
+      row += stride;
+      memcpy(row, first, w * 2);
+    }
+}
+
+void Raster::blit565Rect(uint8_t *map, int stride, int16_t x, int16_t y,
+                         int16_t w, int16_t h, const uint8_t *pixels,
+                         int srcStride)
+{
+  uint8_t *row = map + (y * stride) + (x * 2);
+
+  for (int16_t i = 0; i < h; i++)
+    {
+      memcpy(row, pixels, w * 2);
+      row += stride;
+      pixels += srcStride;
+    }
+}
+
+int16_t Raster::glyphAdvance(const FONT_T *font, unsigned char c)
+{
+  const unsigned char *columns;
+  int width;
+
+  if (!glyphOf(font, c, columns, width))
+    return 0;
+
+  return width + font->spacing;
+}
+
+void Raster::blitBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                       const uint8_t *pixels, int stride)
+{
+  for (int16_t j = 0; j < h; j++)
+    {
+      const uint8_t *row = pixels + (j * stride);
+      int16_t start = 0;
+
+      for (int16_t i = 1; i <= w; i++)
+        {
+          if (i < w && row[i * 2] == row[start * 2] &&
+              row[(i * 2) + 1] == row[(start * 2) + 1])
+            continue;
+
+          fillBlock(x + start, y + j, i - start, 1,
+                    (row[start * 2] << 8) | row[(start * 2) + 1]);
+          start = i;
+        }
+    }
+}
+
+void Raster::rasterBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                         uint16_t color)
+{
+  // work in int, so that clipping cannot overflow
+  int x0 = x;
+  int y0 = y;
+  int x1 = x0 + w;
+  int y1 = y0 + h;
+  int width = rasterWidth();
+  int height = rasterHeight();
+
+  if (x0 < 0)
+    x0 = 0;
+  if (y0 < 0)
+    y0 = 0;
+  if (x1 > width)
+    x1 = width;
+  if (y1 > height)
+    y1 = height;
+
+  if (x1 <= x0 || y1 <= y0)
+    return;
+
+  fillBlock(x0, y0, x1 - x0, y1 - y0, color);
+}
+
+void Raster::rasterLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                        uint16_t color)
+{
+  int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+
+  if (steep)
+    {
+      RASTER_SWAP(x0, y0);
+      RASTER_SWAP(x1, y1);
+    }
+
+  if (x0 > x1)
+    {
+      RASTER_SWAP(x0, x1);
+      RASTER_SWAP(y0, y1);
+    }
+
+  int16_t dx = x1 - x0;
+  int16_t dy = abs(y1 - y0);
+  int16_t err = dx / 2;
+  int16_t ystep = (y0 < y1) ? 1 : -1;
+
+  // Bresenham, but each run of pixels on the same row (or column, for
+  // steep lines) is drawn as one block
+  int16_t runStart = x0;
+
+  for (; x0 <= x1; x0++)
+    {
+      err -= dy;
+      if (err < 0 || x0 == x1)
+        {
+          if (steep)
+            rasterVLine(y0, runStart, x0 - runStart + 1, color);
+          else
+            rasterHLine(runStart, y0, x0 - runStart + 1, color);
+
+          runStart = x0 + 1;
+        }
+      if (err < 0)
+        {
+          y0 += ystep;
+          err += dx;
+        }
+    }
+}
+
+void Raster::rasterRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint16_t color)
+{
+  rasterHLine(x, y, w, color);
+  rasterHLine(x, y + h - 1, w, color);
+  rasterVLine(x, y, h, color);
+  rasterVLine(x + w - 1, y, h, color);
+}
+
+void Raster::rasterCircleCorners(int16_t x0, int16_t y0, int16_t r,
+                                 uint8_t corners, uint16_t color)
+{
+  int16_t f     = 1 - r;
+  int16_t ddF_x = 1;
+  int16_t ddF_y = -2 * r;
+  int16_t x     = 0;
+  int16_t y     = r;
+
+  // Midpoint circle.  The pixels (x, y) of consecutive steps that
+  // share a y form a horizontal run in the octants near the top and
+  // bottom, and a vertical run in the octants near the sides.
+  int16_t xs = 1;
+
+  while (x < y)
+    {
+      if (f >= 0)
+        {
+          y--;
+          ddF_y += 2;
+          f     += ddF_y;
+        }
+      x++;
+      ddF_x += 2;
+      f     += ddF_x;
+
+      // keep going while the next step stays on this y
+      if (f < 0 && x < y)
+        continue;
+
+      int16_t len = x - xs + 1;
+
+      if (corners & 0x4)
+        {
+          rasterHLine(x0 + xs, y0 + y, len, color);
+          rasterVLine(x0 + y, y0 + xs, len, color);
+        }
+      if (corners & 0x2)
+        {
+          rasterHLine(x0 + xs, y0 - y, len, color);
+          rasterVLine(x0 + y, y0 - x, len, color);
+        }
+      if (corners & 0x8)
+        {
+          rasterVLine(x0 - y, y0 + xs, len, color);
+          rasterHLine(x0 - x, y0 + y, len, color);
+        }
+      if (corners & 0x1)
+        {
+          rasterVLine(x0 - y, y0 - x, len, color);
+          rasterHLine(x0 - x, y0 - y, len, color);
+        }
+
+      xs = x + 1;
+    }
+}
+
+void Raster::rasterCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  rasterPixel(x0    , y0 + r, color);
+  rasterPixel(x0    , y0 - r, color);
+  rasterPixel(x0 + r, y0    , color);
+  rasterPixel(x0 - r, y0    , color);
+
+  rasterCircleCorners(x0, y0, r, 0xf, color);
+}
+
+void Raster::rasterFillCircleHalves(int16_t x0, int16_t y0, int16_t r,
+                                    uint8_t halves, int16_t delta,
+                                    uint16_t color)
+{
+  if (r <= 0)
+    return;
+
+  vector<int16_t> halfWidth;
+  int16_t minColumn;
+
+  circleExtents(r, halfWidth, minColumn);
+
+  for (int16_t c = 0; c <= r; c++)
+    {
+      int16_t hw = halfWidth[c];
+      if (hw < minColumn)
+        continue;
+
+      int16_t len = hw - minColumn + 1;
+      // the rows between y0 and y0 + delta are all as wide as row 0
+      int16_t top = y0 - c;
+      int16_t rows = 1;
+
+      if (c == 0)
+        rows = delta + 1;
+
+      if (halves & 0x1)
+        rasterBlock(x0 + minColumn, top, len, rows, color);
+      if (halves & 0x2)
+        rasterBlock(x0 - hw, top, len, rows, color);
+
+      if (c == 0)
+        continue;
+
+      if (halves & 0x1)
+        rasterHLine(x0 + minColumn, y0 + delta + c, len, color);
+      if (halves & 0x2)
+        rasterHLine(x0 - hw, y0 + delta + c, len, color);
+    }
+}
+
+void Raster::fillRounded(int16_t cx1, int16_t cx2, int16_t cy1, int16_t cy2,
+                         int16_t r, uint16_t color)
+{
+  vector<int16_t> halfWidth;
+  int16_t minColumn = 1;
+
+  if (r > 0)
+    circleExtents(r, halfWidth, minColumn);
+  else
+    halfWidth.assign(1, -1);
+
+  for (int16_t c = 0; c <= r; c++)
+    {
+      // the straight part between the arc centers
+      int16_t left = cx1;
+      int16_t right = cx2;
+      int16_t hw = halfWidth[c];
+
+      // plus the left and right arcs, if they reach this row
+      if (hw >= minColumn)
+        {
+          if (cx1 - hw < left)
+            left = cx1 - hw;
+          if (cx2 + minColumn < left)
+            left = cx2 + minColumn;
+          if (cx2 + hw > right)
+            right = cx2 + hw;
+          if (cx1 - minColumn > right)
+            right = cx1 - minColumn;
+        }
+
+      if (c == 0)
+        rasterBlock(left, cy1, right - left + 1, cy2 - cy1 + 1, color);
+      else
+        {
+          rasterHLine(left, cy1 - c, right - left + 1, color);
+          rasterHLine(left, cy2 + c, right - left + 1, color);
+        }
+    }
+}
+
+void Raster::rasterFillCircle(int16_t x0, int16_t y0, int16_t r,
+                              uint16_t color)
+{
+  fillRounded(x0, x0, y0, y0, r, color);
+}
+
+void Raster::rasterTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                            int16_t x2, int16_t y2, uint16_t color)
+{
+  rasterLine(x0, y0, x1, y1, color);
+  rasterLine(x1, y1, x2, y2, color);
+  rasterLine(x2, y2, x0, y0, color);
+}
+
+void Raster::rasterFillTriangle(int16_t x0, int16_t y0, int16_t x1,
+                                int16_t y1, int16_t x2, int16_t y2,
+                                uint16_t color)
+{
+  int16_t a, b, y, last;
+
+  // Sort coordinates by Y order (y2 >= y1 >= y0)
+  if (y0 > y1)
+    {
+      RASTER_SWAP(y0, y1); RASTER_SWAP(x0, x1);
+    }
+  if (y1 > y2)
+    {
+      RASTER_SWAP(y2, y1); RASTER_SWAP(x2, x1);
+    }
+  if (y0 > y1)
+    {
+      RASTER_SWAP(y0, y1); RASTER_SWAP(x0, x1);
+    }
+
+  // all on the same line
+  if (y0 == y2)
+    {
+      a = b = x0;
+      if (x1 < a)      a = x1;
+      else if (x1 > b) b = x1;
+      if (x2 < a)      a = x2;
+      else if (x2 > b) b = x2;
+      rasterHLine(a, y0, b - a + 1, color);
+      return;
+    }
+
+  int16_t
+    dx01 = x1 - x0,
+    dy01 = y1 - y0,
+    dx02 = x2 - x0,
+    dy02 = y2 - y0,
+    dx12 = x2 - x1,
+    dy12 = y2 - y1;
+  int32_t
+    sa   = 0,
+    sb   = 0;
+
+  // The upper part uses the edges 0-1 and 0-2, and includes the y1
+  // row only for a flat bottomed triangle, where the lower part is
+  // empty.  This also keeps both loops from dividing by 0.
+  if (y1 == y2) last = y1;
+  else          last = y1 - 1;
+
+  for (y = y0; y <= last; y++)
+    {
+      a   = x0 + sa / dy01;
+      b   = x0 + sb / dy02;
+      sa += dx01;
+      sb += dx02;
+      if (a > b) RASTER_SWAP(a, b);
+      rasterHLine(a, y, b - a + 1, color);
+    }
+
+  // the lower part uses the edges 1-2 and 0-2
+  sa = dx12 * (y - y1);
+  sb = dx02 * (y - y0);
+  for (; y <= y2; y++)
+    {
+      a   = x1 + sa / dy12;
+      b   = x0 + sb / dy02;
+      sa += dx12;
+      sb += dx02;
+      if (a > b) RASTER_SWAP(a, b);
+      rasterHLine(a, y, b - a + 1, color);
+    }
+}
+
+void Raster::rasterRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                             int16_t r, uint16_t color)
+{
+  rasterHLine(x + r    , y        , w - 2 * r, color); // Top
+  rasterHLine(x + r    , y + h - 1, w - 2 * r, color); // Bottom
+  rasterVLine(x        , y + r    , h - 2 * r, color); // Left
+  rasterVLine(x + w - 1, y + r    , h - 2 * r, color); // Right
+
+  rasterCircleCorners(x + r        , y + r        , r, 1, color);
+  rasterCircleCorners(x + w - r - 1, y + r        , r, 2, color);
+  rasterCircleCorners(x + w - r - 1, y + h - r - 1, r, 4, color);
+  rasterCircleCorners(x + r        , y + h - r - 1, r, 8, color);
+}
+
+void Raster::rasterFillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                                 int16_t r, uint16_t color)
+{
+  fillRounded(x + r, x + w - r - 1, y + r, y + h - r - 1, r, color);
+}
+
+void Raster::rasterGlyph(int16_t x, int16_t y, const unsigned char *columns,
+                         uint16_t color, uint16_t bg, uint8_t size,
+                         uint8_t width)
+{
+  glyphRuns(x, y, columns, 1, 8, (width < 5) ? width : 5, width,
+            color, bg, size);
+}
+
+void Raster::glyphRuns(int16_t x, int16_t y, const unsigned char *columns,
+                       int bytesPerColumn, int rows, int glyphWidth,
+                       int width, uint16_t color, uint16_t bg, uint8_t size)
+{
+  for (int j = 0; j < rows; j++)
+    {
+      const unsigned char *bits = columns + (j / 8);
+      uint8_t mask = 1 << (j % 8);
+      int start = 0;
+      bool on = (glyphWidth > 0) ? (bits[0] & mask) : false;
+
+      // split the row into runs of foreground and background pixels
+      for (int i = 1; i <= width; i++)
+        {
+          bool next = (i < width && i < glyphWidth) ?
+            (bits[i * bytesPerColumn] & mask) : false;
+
+          if (i < width && next == on)
+            continue;
+
+          if (on || bg != color)
+            rasterBlock(x + (start * size), y + (j * size),
+                        (i - start) * size, size, on ? color : bg);
+
+          start = i;
+          on = next;
+        }
+    }
+}
+
+void Raster::renderGlyph(uint8_t *dst, int stride, const FONT_T *font,
+                         unsigned char c, uint16_t color, uint16_t bg,
+                         uint8_t size)
+{
+  const unsigned char *columns;
+  int width;
+
+  if (!glyphOf(font, c, columns, width))
+    return;
+
+  int bytes = (font->height + 7) / 8;
+  int total = width + font->spacing;
+
+  for (int j = 0; j < font->height; j++)
+    {
+      const unsigned char *bits = columns + (j / 8);
+      uint8_t mask = 1 << (j % 8);
+      uint8_t *row = dst + (j * size * stride);
+
+      for (int i = 0; i < total; i++)
+        {
+          bool on = (i < width) ? (bits[i * bytes] & mask) : false;
+
+          fill565(row + (i * size * 2), on ? color : bg, size);
+        }
+
+      // the remaining rows of the scaled row are the same
+      for (int k = 1; k < size; k++)
+        memcpy(row + (k * stride), row, total * size * 2);
+    }
+}
+
+const uint8_t *Raster::cachedGlyph(const FONT_T *font, unsigned char c,
+                                   uint16_t color, uint16_t bg,
+                                   uint8_t size)
+{
+  int stride = glyphAdvance(font, c) * size * 2;
+  int bytes = stride * font->height * size;
+
+  if (!bytes || bytes > RASTER_GLYPH_MAX_BYTES)
+    return 0;
+
+  // direct mapped, a new glyph simply replaces the one in its slot
+  unsigned int slot = (c + (size * 131) + (color * 17) + (bg * 7) +
+                       ((uintptr_t)font >> 4)) % RASTER_GLYPH_CACHE;
+  GLYPH_T &glyph = m_glyphs[slot];
+
+  if (!glyph.valid || glyph.font != font || glyph.c != c ||
+      glyph.size != size || glyph.color != color || glyph.bg != bg)
+    {
+      glyph.pixels.resize(bytes);
+      renderGlyph(&glyph.pixels[0], stride, font, c, color, bg, size);
+
+      glyph.valid = true;
+      glyph.font = font;
+      glyph.c = c;
+      glyph.size = size;
+      glyph.color = color;
+      glyph.bg = bg;
+    }
+
+  return &glyph.pixels[0];
+}
+
+void Raster::clearGlyphCache()
+{
+  for (int i = 0; i < RASTER_GLYPH_CACHE; i++)
+    {
+      m_glyphs[i].valid = false;
+      std::vector<uint8_t>().swap(m_glyphs[i].pixels);
+    }
+}
+
+void Raster::rasterBlit(int16_t x, int16_t y, int16_t w, int16_t h,
+                        const uint8_t *pixels, int stride)
+{
+  int x0 = x;
+  int y0 = y;
+  int x1 = x0 + w;
+  int y1 = y0 + h;
+  int width = rasterWidth();
+  int height = rasterHeight();
+
+  if (x0 < 0)
+    x0 = 0;
+  if (y0 < 0)
+    y0 = 0;
+  if (x1 > width)
+    x1 = width;
+  if (y1 > height)
+    y1 = height;
+
+  if (x1 <= x0 || y1 <= y0)
+    return;
+
+  pixels += ((y0 - y) * stride) + ((x0 - x) * 2);
+  blitBlock(x0, y0, x1 - x0, y1 - y0, pixels, stride);
+}
+
+int16_t Raster::rasterText(int16_t x, int16_t y, const FONT_T *font,
+                           const unsigned char *text, int len,
+                           uint16_t color, uint16_t bg, uint8_t size)
+{
+  if (size < 1)
+    size = 1;
+
+  int total = 0;
+  for (int i = 0; i < len; i++)
+    total += glyphAdvance(font, text[i]) * size;
+
+  int rows = font->height * size;
+  int width = rasterWidth();
+
+  if (y >= rasterHeight() || y + rows <= 0 || x >= width || x + total <= 0)
+    return total;
+
+  if (bg == color)
+    {
+      int gx = x;
+      int bytes = (font->height + 7) / 8;
+
+      for (int i = 0; i < len && gx < width; i++)
+        {
+          const unsigned char *columns;
+          int w;
+
+          if (!glyphOf(font, text[i], columns, w))
+            continue;
+
+          glyphRuns(gx, y, columns, bytes, font->height, w, w, color, bg,
+                    size);
+          gx += (w + font->spacing) * size;
+        }
+
+      return total;
+    }
+
+  // only compose the glyphs that are at least partly visible
+  int first = 0;
+  int runX = x;
+  while (first < len && runX + (glyphAdvance(font, text[first]) * size) <= 0)
+    runX += glyphAdvance(font, text[first++]) * size;
+
+  int last = first;
+  int runW = 0;
+  while (last < len && runX + runW < width)
+    runW += glyphAdvance(font, text[last++]) * size;
+
+  if (!runW)
+    return total;
+
+  int stride = runW * 2;
+  m_textRun.resize(stride * rows);
+
+  uint8_t *dst = &m_textRun[0];
+  for (int i = first; i < last; i++)
+    {
+      int w = glyphAdvance(font, text[i]) * size;
+      if (!w)
+        continue;
+
+      const uint8_t *glyph = cachedGlyph(font, text[i], color, bg, size);
+
+      if (glyph)
+        blit565Rect(dst, stride, 0, 0, w, rows, glyph, w * 2);
+      else
+        renderGlyph(dst, stride, font, text[i], color, bg, size);
+
+      dst += w * 2;
+    }
+
+  rasterBlit(runX, y, runW, rows, &m_textRun[0], stride);
+
+  return total;
+}
+
+int Raster::imageBytesPerPixel(IMAGE_FORMAT_T format)
+{
+  switch (format)
+    {
+    case IMAGE_RGB888:
+    case IMAGE_BGR888:
+      return 3;
+
+    case IMAGE_BGRX8888:
+      return 4;
+
+    default:
+      return 2;
+    }
+}
+
+// red and green move up a bit, and green's top bit is repeated in
+// the new low bit
+static inline uint16_t rgb555to565(uint16_t v)
+{
+  return ((v & 0x7fe0) << 1) | ((v & 0x0200) >> 4) | (v & 0x001f);
+}
+
+// the RGB565 value of each source pixel, written scale times
+#define RASTER_CONVERT(expr)                            \
+  for (int i = 0; i < count; i++, src += bpp)           \
+    {                                                   \
+      uint16_t c = (expr);                              \
+      for (int k = 0; k < scale; k++)                   \
+        {                                               \
+          *dst++ = c >> 8;                              \
+          *dst++ = c & 0xff;                            \
+        }                                               \
+    }
+
+void Raster::convertRow(uint8_t *dst, const uint8_t *src, int count,
+                        IMAGE_FORMAT_T format, uint8_t scale)
+{
+  int bpp = imageBytesPerPixel(format);
+
+  if (scale < 1)
+    scale = 1;
+
+  switch (format)
+    {
+    case IMAGE_RGB565:
+      if (scale == 1)
+        memcpy(dst, src, count * 2);
+      else
+        RASTER_CONVERT((src[0] << 8) | src[1]);
+      break;
+
+    case IMAGE_RGB565_LE:
+      RASTER_CONVERT((src[1] << 8) | src[0]);
+      break;
+
+    case IMAGE_RGB555_LE:
+      RASTER_CONVERT(rgb555to565((src[1] << 8) | src[0]));
+      break;
+
+    case IMAGE_RGB888:
+      RASTER_CONVERT(((src[0] & 0xf8) << 8) | ((src[1] & 0xfc) << 3) |
+                     (src[2] >> 3));
+      break;
+
+    case IMAGE_BGR888:
+    case IMAGE_BGRX8888:
+      RASTER_CONVERT(((src[2] & 0xf8) << 8) | ((src[1] & 0xfc) << 3) |
+                     (src[0] >> 3));
+      break;
+    }
+}
+
+void Raster::rasterImage(int16_t x, int16_t y, const uint8_t *pixels,
+                         int w, int h, int stride, IMAGE_FORMAT_T format,
+                         uint8_t scale)
+{
+  if (scale < 1)
+    scale = 1;
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  // the visible part of the scaled image
+  int dx0 = (x < 0) ? 0 : x;
+  int dy0 = (y < 0) ? 0 : y;
+  int dx1 = x + (w * scale);
+  int dy1 = y + (h * scale);
+
+  if (dx1 > rasterWidth())
+    dx1 = rasterWidth();
+  if (dy1 > rasterHeight())
+    dy1 = rasterHeight();
+
+  if (dx1 <= dx0 || dy1 <= dy0)
+    return;
+
+  // already in the display's format, send it as it is
+  if (format == IMAGE_RGB565 && scale == 1)
+    {
+      rasterBlit(x, y, w, h, pixels, stride);
+      return;
+    }
+
+  // the source pixels covering the visible part
+  int sx0 = (dx0 - x) / scale;
+  int sx1 = (dx1 - x + scale - 1) / scale;
+  int sy0 = (dy0 - y) / scale;
+  int sy1 = (dy1 - y + scale - 1) / scale;
+
+  int bpp = imageBytesPerPixel(format);
+  int cols = sx1 - sx0;
+  int rowBytes = cols * scale * 2;
+
+  // source rows converted per batch
+  int batch = RASTER_IMAGE_BATCH / (rowBytes * scale);
+  if (batch < 1)
+    batch = 1;
+
+  m_imageRows.resize(batch * scale * rowBytes);
+
+  for (int sy = sy0; sy < sy1; sy += batch)
+    {
+      int n = (sy1 - sy < batch) ? sy1 - sy : batch;
+      uint8_t *dst = &m_imageRows[0];
+
+      for (int i = 0; i < n; i++)
+        {
+          convertRow(dst, pixels + ((sy + i) * stride) + (sx0 * bpp), cols,
+                     format, scale);
+
+          for (int k = 1; k < scale; k++)
+            memcpy(dst + (k * rowBytes), dst, rowBytes);
+
+          dst += scale * rowBytes;
+        }
+
+      rasterBlit(x + (sx0 * scale), y + (sy * scale), cols * scale,
+                 n * scale, &m_imageRows[0], rowBytes);
+    }
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+RasterImage::RasterImage(std::string filename)
+{
+  size_t size = map(filename);
+  const uint8_t *file = (const uint8_t *)m_map;
+
+  if (size < 54 || file[0] != 'B' || file[1] != 'M' || le32(file + 14) < 40)
+    {
+      munmap(m_map, m_size);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": not a supported BMP file: " + filename);
+      return;
+    }
+
+  uint32_t offset = le32(file + 10);
+  int32_t width = le32(file + 18);
+  int32_t height = le32(file + 22);
+  uint16_t bits = le16(file + 28);
+  uint32_t compression = le32(file + 30);
+  bool known = true;
+
+  if (compression == 0 && bits == 16)
+    m_format = Raster::IMAGE_RGB555_LE;
+  else if (compression == 0 && bits == 24)
+    m_format = Raster::IMAGE_BGR888;
+  else if (compression == 0 && bits == 32)
+    m_format = Raster::IMAGE_BGRX8888;
+  else if (compression == 3 && size >= 66)
+    {
+      // BI_BITFIELDS, the masks follow the 40 byte header
+      uint32_t red = le32(file + 54);
+      uint32_t green = le32(file + 58);
+      uint32_t blue = le32(file + 62);
+
+      if (bits == 16 && red == 0xf800 && green == 0x07e0 && blue == 0x001f)
+        m_format = Raster::IMAGE_RGB565_LE;
+      else if (bits == 16 && red == 0x7c00 && green == 0x03e0 &&
+               blue == 0x001f)
+        m_format = Raster::IMAGE_RGB555_LE;
+      else if (bits == 32 && red == 0xff0000 && green == 0xff00 &&
+               blue == 0xff)
+        m_format = Raster::IMAGE_BGRX8888;
+      else
+        known = false;
+    }
+  else
+    known = false;
+
+  // the header is untrusted, so bound both dimensions before any
+  // arithmetic on them (negating INT_MIN would overflow)
+  if (!known || width <= 0 || width > RASTER_IMAGE_MAX_DIM ||
+      height == 0 || height < -RASTER_IMAGE_MAX_DIM ||
+      height > RASTER_IMAGE_MAX_DIM)
+    {
+      munmap(m_map, m_size);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": unsupported BMP file: " + filename);
+      return;
+    }
+
+  // rows are padded to 4 bytes
+  uint64_t rowBytes = ((uint64_t(width) * bits + 31) / 32) * 4;
+  int rows = (height < 0) ? -height : height;
+
+  if (uint64_t(offset) + (rowBytes * rows) > size)
+    {
+      munmap(m_map, m_size);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": truncated BMP file: " + filename);
+      return;
+    }
+
+  m_width = width;
+  m_height = rows;
+
+  // a positive height means the rows are stored bottom up
+  if (height > 0)
+    {
+      m_pixels = file + offset + ((rows - 1) * rowBytes);
+      m_stride = -int(rowBytes);
+    }
+  else
+    {
+      m_pixels = file + offset;
+      m_stride = int(rowBytes);
+    }
+}
+
+RasterImage::RasterImage(std::string filename, int width, int height,
+                         Raster::IMAGE_FORMAT_T format)
+{
+  size_t size = map(filename);
+
+  m_width = width;
+  m_height = height;
+  m_format = format;
+  m_pixels = (const uint8_t *)m_map;
+
+  if (width <= 0 || width > RASTER_IMAGE_MAX_DIM ||
+      height <= 0 || height > RASTER_IMAGE_MAX_DIM ||
+      uint64_t(width) * Raster::imageBytesPerPixel(format) * height > size)
+    {
+      munmap(m_map, m_size);
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": file too small for the image size: " +
+                                  filename);
+      return;
+    }
+
+  m_stride = width * Raster::imageBytesPerPixel(format);
+}
+
+RasterImage::~RasterImage()
+{
+  munmap(m_map, m_size);
+}
+
+size_t RasterImage::map(std::string filename)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": open() failed: " + filename);
+      return 0;
+    }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+      close(fd);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": empty or unreadable file: " + filename);
+      return 0;
+    }
+
+  m_size = st.st_size;
+  m_map = mmap(0, m_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+
+  if (m_map == MAP_FAILED)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mmap() failed: " + filename);
+      return 0;
+    }
+
+  return m_size;
+}
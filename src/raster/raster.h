@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Number of rendered glyphs kept by the glyph cache
+#define RASTER_GLYPH_CACHE 128
+
+// Largest rendered glyph, in bytes, that is cached.  Bigger glyphs
+// are rendered straight into the text run.
+#define RASTER_GLYPH_MAX_BYTES 4096
+
+// Size of the buffer images are converted into before being sent,
+// in bytes.  Rows are converted and sent in batches of this size.
+#define RASTER_IMAGE_BATCH 8192
+
+// Largest width or height accepted for an image file, in pixels.
+// Drawing coordinates are 16 bit, so nothing bigger can be shown.
+#define RASTER_IMAGE_MAX_DIM 32767
+
+namespace upm {
+
+  /**
+   * @library raster
+   * @brief Span based 2D rasterizer for RGB565 display drivers
+   *
+   * Raster turns the usual drawing primitives (lines, rectangles,
+   * circles, triangles, rounded rectangles and 5x8 font glyphs) into
+   * clipped solid blocks of pixels, mostly horizontal spans, and
+   * hands each block to the display back end through fillBlock().
+   * Nothing is drawn one pixel at a time unless the shape really is a
+   * single pixel: a line becomes one block per horizontal or vertical
+   * run, a filled shape one span per row, and a glyph one block per
+   * run of equal pixels in a row.
+   *
+   * A back end with a framebuffer fills the block in memory, usually
+   * with fill565Rect().  A back end without one sets the controller's
+   * address window to the block once, and streams the color.
+   *
+   * The rasterizer reproduces the pixel sets of the classic GFX
+   * primitives, so drivers moved onto it draw the same images.
+   *
+   * Text with a background color is not drawn as runs.  Each glyph
+   * is rendered once into an RGB565 bitmap, cached per font,
+   * character, size and colors, and a whole run of text is composed
+   * from the cached bitmaps and handed to blitBlock() as one block,
+   * which the back end can send in a single address window.  Fonts
+   * are described by FONT_T, and may be proportional and taller than
+   * 8 rows.
+   *
+   * Images are drawn with rasterImage().  Images already in the
+   * display's format (RGB565, high byte first) are clipped and handed
+   * to blitBlock() straight from the caller's memory, such as a
+   * memory mapped file (see RasterImage).  Other formats, and scaled
+   * images, are converted in batches of rows.
+   */
+  class Raster {
+  public:
+
+    /**
+     * A column font.  Each glyph is stored as a run of columns, left
+     * to right, each column taking (height + 7) / 8 bytes with the
+     * top row in the least significant bit of the first byte.
+     */
+    typedef struct {
+      // the column data of all glyphs
+      const unsigned char *columns;
+      // for proportional fonts, the index in columns of the first
+      // column of each glyph, and the width of each glyph.  NULL for
+      // fixed width fonts.
+      const uint16_t *offsets;
+      const uint8_t *widths;
+      // glyph width of a fixed width font
+      uint8_t width;
+      // glyph height in rows
+      uint8_t height;
+      // character code of the first glyph, and the number of glyphs
+      uint8_t first;
+      uint16_t count;
+      // blank columns added after each glyph
+      uint8_t spacing;
+    } FONT_T;
+
+    /**
+     * Pixel formats accepted by rasterImage()
+     */
+    typedef enum {
+      // 16 bit 5-6-5, high byte first (the display's own format)
+      IMAGE_RGB565              = 0,
+      // 16 bit 5-6-5, low byte first
+      IMAGE_RGB565_LE           = 1,
+      // 16 bit x-5-5-5, low byte first (16 bit BMP)
+      IMAGE_RGB555_LE           = 2,
+      // 8 bits each of red, green and blue
+      IMAGE_RGB888              = 3,
+      // 8 bits each of blue, green and red (24 bit BMP)
+      IMAGE_BGR888              = 4,
+      // blue, green, red and an ignored byte (32 bit BMP)
+      IMAGE_BGRX8888            = 5
+    } IMAGE_FORMAT_T;
+    /**
+     * Raster constructor
+     */
+    Raster();
+
+    /**
+     * Raster destructor
+     */
+    virtual ~Raster();
+
+    /**
+     * fill count pixels of an RGB565 framebuffer, stored high byte
+     * first, with a color.  The pattern is built once, then doubled
+     * with memcpy(), so long spans are filled with wide stores and no
+     * alignment is required.
+     *
+     * @param dst first byte of the first pixel
+     * @param color RGB565 color
+     * @param count number of pixels
+     */
+    static void fill565(uint8_t *dst, uint16_t color, int count);
+
+    /**
+     * fill a rectangle of an RGB565 framebuffer, stored high byte
+     * first.  The rectangle must already be clipped.
+     *
+     * @param map the framebuffer
+     * @param stride bytes per framebuffer row
+     * @param x left column
+     * @param y top row
+     * @param w width in pixels
+     * @param h height in pixels
+     * @param color RGB565 color
+     */
+    static void fill565Rect(uint8_t *map, int stride, int16_t x, int16_t y,
+                            int16_t w, int16_t h, uint16_t color);
+
+    /**
+     * copy a block of RGB565 pixels into a framebuffer of the same
+     * format.  The block must already be clipped.
+     *
+     * @param map the framebuffer
+     * @param stride bytes per framebuffer row
+     * @param x left column
+     * @param y top row
+     * @param w width in pixels
+     * @param h height in pixels
+     * @param pixels the first pixel of the block
+     * @param srcStride bytes per row of the block
+     */
+    static void blit565Rect(uint8_t *map, int stride, int16_t x, int16_t y,
+                            int16_t w, int16_t h, const uint8_t *pixels,
+                            int srcStride);
+
+    /**
+     * return the horizontal advance of a character in a font, at size
+     * 1, including the spacing.  Characters the font has no glyph for
+     * advance by 0.
+     *
+     * @param font the font
+     * @param c the character
+     * @return advance in pixels
+     */
+    static int16_t glyphAdvance(const FONT_T *font, unsigned char c);
+
+    /**
+     * return the number of bytes per pixel of an image format
+     *
+     * @param format the format
+     * @return bytes per pixel
+     */
+    static int imageBytesPerPixel(IMAGE_FORMAT_T format);
+
+    /**
+     * convert a row of pixels to RGB565, high byte first, repeating
+     * each pixel scale times
+     *
+     * @param dst the converted row, count * scale pixels
+     * @param src the source row
+     * @param count number of source pixels
+     * @param format format of the source pixels
+     * @param scale horizontal scale factor
+     */
+    static void convertRow(uint8_t *dst, const uint8_t *src, int count,
+                           IMAGE_FORMAT_T format, uint8_t scale=1);
+
+  protected:
+    /**
+     * fill a solid block.  The block is already clipped to the size
+     * returned by rasterWidth() and rasterHeight(), and is never
+     * empty.
+     */
+    virtual void fillBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                           uint16_t color) = 0;
+
+    /**
+     * copy a block of RGB565 pixels, stored high byte first, to the
+     * display.  The block is already clipped, and never empty.  The
+     * default implementation breaks each row into runs of one color
+     * for fillBlock(); back ends that can stream pixel data should
+     * override it.
+     *
+     * @param pixels the first pixel of the block
+     * @param stride bytes per row of the block
+     */
+    virtual void blitBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                           const uint8_t *pixels, int stride);
+
+    /**
+     * current drawing area width, used for clipping
+     */
+    virtual int16_t rasterWidth() = 0;
+
+    /**
+     * current drawing area height, used for clipping
+     */
+    virtual int16_t rasterHeight() = 0;
+
+    // clip a block and pass what is left to fillBlock()
+    void rasterBlock(int16_t x, int16_t y, int16_t w, int16_t h,
+                     uint16_t color);
+
+    void rasterPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      rasterBlock(x, y, 1, 1, color);
+    };
+
+    void rasterHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      rasterBlock(x, y, w, 1, color);
+    };
+
+    void rasterVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      rasterBlock(x, y, 1, h, color);
+    };
+
+    void rasterLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                    uint16_t color);
+
+    void rasterRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                    uint16_t color);
+
+    // the circle outline
+    void rasterCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+
+    // quarter circle outlines, for the corners of rounded rectangles.
+    // corners is a mask of 1 (top left), 2 (top right), 4 (bottom
+    // right) and 8 (bottom left).
+    void rasterCircleCorners(int16_t x0, int16_t y0, int16_t r,
+                             uint8_t corners, uint16_t color);
+
+    // the filled half circles of the classic fillCircleHelper(), with
+    // halves 1 (right) and 2 (left), stretched down by delta rows
+    void rasterFillCircleHalves(int16_t x0, int16_t y0, int16_t r,
+                                uint8_t halves, int16_t delta,
+                                uint16_t color);
+
+    void rasterFillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+
+    void rasterTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                        int16_t x2, int16_t y2, uint16_t color);
+
+    void rasterFillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                            int16_t x2, int16_t y2, uint16_t color);
+
+    void rasterRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                         int16_t r, uint16_t color);
+
+    void rasterFillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                             int16_t r, uint16_t color);
+
+    // a glyph of a 5x8 column font, width columns wide (columns past
+    // the fifth are blank).  Rows are drawn as runs of foreground and
+    // background pixels, each scaled to a size x size block.  When
+    // bg == color, the background is left alone.
+    void rasterGlyph(int16_t x, int16_t y, const unsigned char *columns,
+                     uint16_t color, uint16_t bg, uint8_t size,
+                     uint8_t width=6);
+
+    // clip a block of RGB565 pixels and pass what is left to
+    // blitBlock()
+    void rasterBlit(int16_t x, int16_t y, int16_t w, int16_t h,
+                    const uint8_t *pixels, int stride);
+
+    // draw len characters of text with its top left corner at x, y.
+    // With a background color, the visible part of the run is
+    // composed from cached glyphs and sent as one block; when bg ==
+    // color, each glyph is drawn as foreground runs only.  Returns
+    // the width of the whole run in pixels.
+    int16_t rasterText(int16_t x, int16_t y, const FONT_T *font,
+                       const unsigned char *text, int len,
+                       uint16_t color, uint16_t bg, uint8_t size);
+
+    // drop all cached glyphs, needed if a font's data is changed in
+    // place
+    void clearGlyphCache();
+
+    // draw an image of w x h pixels with its top left corner at x, y,
+    // each pixel scaled to a scale x scale block.  stride is the
+    // distance between rows in bytes, and may be negative for bottom
+    // up images.  Only the visible part is converted.
+    void rasterImage(int16_t x, int16_t y, const uint8_t *pixels,
+                     int w, int h, int stride, IMAGE_FORMAT_T format,
+                     uint8_t scale=1);
+
+  private:
+    typedef struct {
+      bool valid;
+      const FONT_T *font;
+      unsigned char c;
+      uint8_t size;
+      uint16_t color;
+      uint16_t bg;
+      std::vector<uint8_t> pixels;
+    } GLYPH_T;
+
+    // draw a glyph as runs of equal pixels in each row.  glyphWidth
+    // columns come from the font data, the rest up to width are blank.
+    void glyphRuns(int16_t x, int16_t y, const unsigned char *columns,
+                   int bytesPerColumn, int rows, int glyphWidth,
+                   int width, uint16_t color, uint16_t bg, uint8_t size);
+
+    // render a glyph, including its spacing, as RGB565 pixels
+    static void renderGlyph(uint8_t *dst, int stride, const FONT_T *font,
+                            unsigned char c, uint16_t color, uint16_t bg,
+                            uint8_t size);
+
+    // the cached bitmap of a glyph, rendered if needed, or NULL if it
+    // is too big to be cached
+    const uint8_t *cachedGlyph(const FONT_T *font, unsigned char c,
+                               uint16_t color, uint16_t bg, uint8_t size);
+
+    // rows of a filled rounded shape: the rows above cy1 and below cy2
+    // are cut by arcs of radius r centered on cx1 and cx2
+    void fillRounded(int16_t cx1, int16_t cx2, int16_t cy1, int16_t cy2,
+                     int16_t r, uint16_t color);
+
+    GLYPH_T m_glyphs[RASTER_GLYPH_CACHE];
+    // the text run being composed by rasterText()
+    std::vector<uint8_t> m_textRun;
+    // image rows converted by rasterImage()
+    std::vector<uint8_t> m_imageRows;
+  };
+
+  /**
+   * @brief Memory mapped image file for Raster based displays
+   *
+   * RasterImage maps an image file into memory, so that its pixels can
+   * be drawn without being read or copied first.  Windows BMP files
+   * (uncompressed 16, 24 or 32 bit, or 16 bit 5-6-5 bitfields) are
+   * recognized from their header; raw files are described by their
+   * size and pixel format.  The mapping is released when the object
+   * is destroyed.
+   */
+  class RasterImage {
+  public:
+    /**
+     * RasterImage constructor for BMP files
+     *
+     * @param filename the file to map
+     */
+    RasterImage(std::string filename);
+
+    /**
+     * RasterImage constructor for raw files, rows stored top to
+     * bottom without padding
+     *
+     * @param filename the file to map
+     * @param width image width in pixels
+     * @param height image height in pixels
+     * @param format pixel format of the file
+     */
+    RasterImage(std::string filename, int width, int height,
+                Raster::IMAGE_FORMAT_T format=Raster::IMAGE_RGB565);
+
+    /**
+     * RasterImage destructor
+     */
+    ~RasterImage();
+
+    /**
+     * return the first pixel of the top row
+     */
+    const uint8_t *pixels() { return m_pixels; };
+
+    /**
+     * return the distance between rows in bytes, negative if the rows
+     * are stored bottom up
+     */
+    int stride() { return m_stride; };
+
+    /**
+     * return the image width in pixels
+     */
+    int width() { return m_width; };
+
+    /**
+     * return the image height in pixels
+     */
+    int height() { return m_height; };
+
+    /**
+     * return the pixel format
+     */
+    Raster::IMAGE_FORMAT_T format() { return m_format; };
+
+  private:
+    // not copyable, the mapping belongs to one object
+    RasterImage(const RasterImage &);
+    RasterImage &operator=(const RasterImage &);
+
+    // map the file, return its size
+    size_t map(std::string filename);
+
+    void *m_map;
+    size_t m_size;
+
+    const uint8_t *m_pixels;
+    int m_stride;
+    int m_width;
+    int m_height;
+    Raster::IMAGE_FORMAT_T m_format;
+  };
+}
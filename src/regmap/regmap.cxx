@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <string.h>
+
+#include "regmap.h"
+
+using namespace upm;
+using namespace std;
+
+RegMap::RegMap(int size)
+{
+  if (size <= 0 || size > 256)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": size must be between 1 and 256");
+      return;
+    }
+
+  m_size = size;
+  m_cache = new uint8_t[size];
+  m_flags = new uint8_t[size];
+  m_selfClearing = new uint8_t[size];
+  memset(m_cache, 0, size);
+  memset(m_flags, 0, size);
+  memset(m_selfClearing, 0, size);
+
+  m_deferred = false;
+  m_busReads = 0;
+  m_busWrites = 0;
+}
+
+RegMap::~RegMap()
+{
+  delete [] m_cache;
+  delete [] m_flags;
+  delete [] m_selfClearing;
+}
+
+void RegMap::checkReg(uint8_t reg, int len)
+{
+  if (len < 1 || (reg + len) > m_size)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": register out of range");
+    }
+}
+
+void RegMap::setPolicy(uint8_t first, uint8_t last, REG_POLICY_T policy)
+{
+  checkReg(first, (last - first) + 1);
+
+  for (int i=first; i<=last; i++)
+    {
+      if (policy == REG_CACHED)
+        m_flags[i] |= FLAG_CACHED;
+      else
+        m_flags[i] = 0;
+    }
+}
+
+void RegMap::setSelfClearing(uint8_t reg, uint8_t mask)
+{
+  checkReg(reg, 1);
+
+  m_selfClearing[reg] = mask;
+  m_cache[reg] &= ~mask;
+}
+
+uint8_t RegMap::readReg(uint8_t reg)
+{
+  checkReg(reg, 1);
+
+  if ((m_flags[reg] & (FLAG_CACHED | FLAG_VALID)) ==
+      (FLAG_CACHED | FLAG_VALID))
+    return m_cache[reg];
+
+  uint8_t val = 0;
+  m_busReads++;
+  if (busRead(reg, &val, 1) != 1)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": bus read failed");
+      return 0;
+    }
+
+  if (m_flags[reg] & FLAG_CACHED)
+    {
+      m_cache[reg] = val & ~m_selfClearing[reg];
+      m_flags[reg] |= FLAG_VALID;
+    }
+
+  return val;
+}
+
+int RegMap::readRegs(uint8_t reg, uint8_t *buffer, int len)
+{
+  checkReg(reg, len);
+
+  m_busReads++;
+  return busRead(reg, buffer, len);
+}
+
+mraa::Result RegMap::writeReg(uint8_t reg, uint8_t val)
+{
+  checkReg(reg, 1);
+
+  if (!(m_flags[reg] & FLAG_CACHED))
+    {
+      m_busWrites++;
+      return busWrite(reg, &val, 1);
+    }
+
+  m_cache[reg] = val & ~m_selfClearing[reg];
+  m_flags[reg] |= FLAG_VALID;
+
+  if (m_deferred && !(val & m_selfClearing[reg]))
+    {
+      m_flags[reg] |= FLAG_DIRTY;
+      return mraa::SUCCESS;
+    }
+
+  m_flags[reg] &= ~FLAG_DIRTY;
+  m_busWrites++;
+  mraa::Result rv = busWrite(reg, &val, 1);
+
+  // we no longer know what the device holds
+  if (rv != mraa::SUCCESS)
+    m_flags[reg] &= ~FLAG_VALID;
+
+  return rv;
+}
+
+mraa::Result RegMap::updateReg(uint8_t reg, uint8_t mask, uint8_t bits)
+{
+  uint8_t old = readReg(reg);
+  uint8_t val = (old & ~mask) | (bits & mask);
+
+  if ((m_flags[reg] & FLAG_CACHED) && val == old)
+    return mraa::SUCCESS;
+
+  return writeReg(reg, val);
+}
+
+mraa::Result RegMap::setDeferred(bool enable)
+{
+  m_deferred = enable;
+
+  if (!enable)
+    return sync();
+
+  return mraa::SUCCESS;
+}
+
+mraa::Result RegMap::sync()
+{
+  int reg = 0;
+
+  while (reg < m_size)
+    {
+      if (!(m_flags[reg] & FLAG_DIRTY))
+        {
+          reg++;
+          continue;
+        }
+
+      // find the run of consecutive dirty registers starting here
+      int len = 1;
+      while ((reg + len) < m_size && len < REGMAP_MAX_BURST &&
+             (m_flags[reg + len] & FLAG_DIRTY))
+        len++;
+
+      m_busWrites++;
+      mraa::Result rv = busWrite(reg, &m_cache[reg], len);
+      if (rv != mraa::SUCCESS)
+        return rv;
+
+      for (int i=reg; i<reg + len; i++)
+        m_flags[i] &= ~FLAG_DIRTY;
+
+      reg += len;
+    }
+
+  return mraa::SUCCESS;
+}
+
+mraa::Result RegMap::restore()
+{
+  for (int i=0; i<m_size; i++)
+    {
+      if ((m_flags[i] & (FLAG_CACHED | FLAG_VALID)) ==
+          (FLAG_CACHED | FLAG_VALID))
+        m_flags[i] |= FLAG_DIRTY;
+    }
+
+  return sync();
+}
+
+void RegMap::invalidate()
+{
+  for (int i=0; i<m_size; i++)
+    m_flags[i] &= FLAG_CACHED;
+}
+
+void RegMap::invalidate(uint8_t reg)
+{
+  checkReg(reg, 1);
+
+  m_flags[reg] &= FLAG_CACHED;
+}
+
+I2cRegMap::I2cRegMap(mraa::I2c *i2c, uint8_t address, int size,
+                     uint8_t autoIncrement) :
+  RegMap(size), m_i2c(i2c)
+{
+  m_addr = address;
+  m_autoIncrement = autoIncrement;
+}
+
+int I2cRegMap::busRead(uint8_t reg, uint8_t *buffer, int len)
+{
+  if (m_i2c->address(m_addr) != mraa::SUCCESS)
+    return -1;
+
+  // readReg() cannot report a failed transfer, so single registers
+  // are read with readBytesReg() as well
+  if (len == 1)
+    return m_i2c->readBytesReg(reg, buffer, 1);
+
+  return m_i2c->readBytesReg(reg | m_autoIncrement, buffer, len);
+}
+
+mraa::Result I2cRegMap::busWrite(uint8_t reg, const uint8_t *buffer, int len)
+{
+  mraa::Result rv;
+
+  if ((rv = m_i2c->address(m_addr)) != mraa::SUCCESS)
+    return rv;
+
+  if (len == 1)
+    return m_i2c->writeReg(reg, buffer[0]);
+
+  // register address followed by the data, in one transfer
+  uint8_t buf[REGMAP_MAX_BURST + 1];
+
+  buf[0] = reg | m_autoIncrement;
+  memcpy(&buf[1], buffer, len);
+
+  return m_i2c->write(buf, len + 1);
+}
+
+SpiRegMap::SpiRegMap(mraa::Spi *spi, int size, uint8_t readBit,
+                     uint8_t autoIncrement, mraa::Gpio *cs) :
+  RegMap(size), m_spi(spi), m_cs(cs)
+{
+  m_readBit = readBit;
+  m_autoIncrement = autoIncrement;
+
+  if (m_cs)
+    m_cs->write(1);
+}
+
+mraa::Result SpiRegMap::transfer(uint8_t *tx, uint8_t *rx, int len)
+{
+  if (m_cs)
+    m_cs->write(0);
+
+  mraa::Result rv = m_spi->transfer(tx, rx, len);
+
+  if (m_cs)
+    m_cs->write(1);
+
+  return rv;
+}
+
+int SpiRegMap::busRead(uint8_t reg, uint8_t *buffer, int len)
+{
+  // the register address, then one dummy byte per register read
+  uint8_t tx[257];
+  uint8_t rx[257];
+
+  memset(tx, 0, len + 1);
+  tx[0] = reg | m_readBit;
+  if (len > 1)
+    tx[0] |= m_autoIncrement;
+
+  if (transfer(tx, rx, len + 1) != mraa::SUCCESS)
+    return -1;
+
+  memcpy(buffer, &rx[1], len);
+
+  return len;
+}
+
+mraa::Result SpiRegMap::busWrite(uint8_t reg, const uint8_t *buffer, int len)
+{
+  // register address followed by the data, in one transfer
+  uint8_t buf[REGMAP_MAX_BURST + 1];
+
+  buf[0] = reg;
+  if (len > 1)
+    buf[0] |= m_autoIncrement;
+  memcpy(&buf[1], buffer, len);
+
+  return transfer(buf, NULL, len + 1);
+}
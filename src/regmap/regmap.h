@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <string>
+#include <mraa/common.hpp>
+#include <mraa/i2c.hpp>
+#include <mraa/spi.hpp>
+#include <mraa/gpio.hpp>
+
+// Longest run of registers written by a single sync() transfer
+#define REGMAP_MAX_BURST 32
+
+namespace upm {
+
+  /**
+   * @library regmap
+   * @brief Cached register map shared by register based drivers
+   *
+   * RegMap sits between a driver and its bus, and keeps a cache of
+   * the device registers the driver marks as REG_CACHED (registers
+   * that only change when the host writes them, such as control and
+   * configuration registers).  Reads of cached registers, and the read
+   * half of read-modify-write cycles, are then served from memory
+   * after the first bus access.  Status, data and FIFO registers keep
+   * the default REG_VOLATILE policy and always go to the bus.
+   *
+   * Writes to cached registers can be deferred with setDeferred(),
+   * and later sent with sync(), which coalesces consecutive dirty
+   * registers into single auto-increment writes.  After a device
+   * reset or power cycle, restore() rewrites every cached register.
+   *
+   * The bus transfers are implemented by subclasses; I2cRegMap and
+   * SpiRegMap provide the usual mraa::I2c and mraa::Spi
+   * implementations, so a driver supporting both buses only differs
+   * in the RegMap it creates.
+   */
+  class RegMap {
+  public:
+
+    /**
+     * Register cache policies
+     */
+    typedef enum {
+      REG_VOLATILE              = 0, // never cached
+      REG_CACHED                = 1  // only changed by host writes
+    } REG_POLICY_T;
+
+    /**
+     * RegMap constructor
+     *
+     * @param size number of registers (highest register address + 1)
+     */
+    RegMap(int size);
+
+    /**
+     * RegMap destructor
+     */
+    virtual ~RegMap();
+
+    /**
+     * set the cache policy of a range of registers.  All registers
+     * start out as REG_VOLATILE.
+     *
+     * @param first the first register of the range
+     * @param last the last register of the range (inclusive)
+     * @param policy one of the REG_POLICY_T values
+     */
+    void setPolicy(uint8_t first, uint8_t last, REG_POLICY_T policy);
+
+    /**
+     * mark bits of a cached register as self clearing (such as reset
+     * bits).  They are sent to the device, but never kept in the
+     * cache, so restore() and later read-modify-write cycles do not
+     * set them again.  A write setting any of them is never deferred.
+     *
+     * @param reg the register
+     * @param mask the self clearing bits
+     */
+    void setSelfClearing(uint8_t reg, uint8_t mask);
+
+    /**
+     * read a register, from the cache if it is cached and valid
+     *
+     * @param reg the register to read
+     * @return the value of the register
+     */
+    uint8_t readReg(uint8_t reg);
+
+    /**
+     * read contiguous registers from the device into a buffer with
+     * a single auto-increment transfer.  The cache is not consulted
+     * or updated; this is intended for data and FIFO registers.
+     *
+     * @param reg the register to start reading at
+     * @param buffer the buffer to store the results
+     * @param len the number of registers to read
+     * @return the number of bytes read, or -1 on error
+     */
+    int readRegs(uint8_t reg, uint8_t *buffer, int len);
+
+    /**
+     * write a register.  Writes to cached registers only update the
+     * cache while writes are deferred.
+     *
+     * @param reg the register to write to
+     * @param val the value to write
+     * @return mraa::SUCCESS if successful
+     */
+    mraa::Result writeReg(uint8_t reg, uint8_t val);
+
+    /**
+     * change the masked bits of a register.  For cached registers,
+     * this does not read the device once the cache is valid, and no
+     * write is done if the value does not change.
+     *
+     * @param reg the register to modify
+     * @param mask the bits to change
+     * @param bits the new value of the masked bits
+     * @return mraa::SUCCESS if successful
+     */
+    mraa::Result updateReg(uint8_t reg, uint8_t mask, uint8_t bits);
+
+    /**
+     * defer writes to cached registers until sync() is called, so
+     * that several configuration changes can be sent together.
+     * Disabling deferral syncs any pending writes.
+     *
+     * @param enable true to defer writes
+     * @return mraa::SUCCESS if successful
+     */
+    mraa::Result setDeferred(bool enable);
+
+    /**
+     * write all dirty cached registers to the device.  Runs of
+     * consecutive dirty registers are written with one transfer.
+     *
+     * @return mraa::SUCCESS if successful
+     */
+    mraa::Result sync();
+
+    /**
+     * rewrite every valid cached register to the device, such as
+     * after a device reset or power down.
+     *
+     * @return mraa::SUCCESS if successful
+     */
+    mraa::Result restore();
+
+    /**
+     * discard the cached value of all registers, so they are read
+     * from the device on next access.  Pending deferred writes are
+     * lost.
+     */
+    void invalidate();
+
+    /**
+     * discard the cached value of one register
+     *
+     * @param reg the register to invalidate
+     */
+    void invalidate(uint8_t reg);
+
+    /**
+     * return the number of bus read transfers done since
+     * construction or the last resetStats()
+     *
+     * @return number of bus reads
+     */
+    unsigned int getBusReads() { return m_busReads; };
+
+    /**
+     * return the number of bus write transfers done since
+     * construction or the last resetStats()
+     *
+     * @return number of bus writes
+     */
+    unsigned int getBusWrites() { return m_busWrites; };
+
+    /**
+     * reset the bus transfer counters
+     */
+    void resetStats() { m_busReads = m_busWrites = 0; };
+
+  protected:
+    /**
+     * read len registers from the device starting at reg
+     *
+     * @param reg the register to start reading at
+     * @param buffer the buffer to store the results
+     * @param len the number of registers to read
+     * @return the number of bytes read, or -1 on error
+     */
+    virtual int busRead(uint8_t reg, uint8_t *buffer, int len) = 0;
+
+    /**
+     * write len registers to the device starting at reg
+     *
+     * @param reg the register to start writing at
+     * @param buffer the values to write
+     * @param len the number of registers to write
+     * @return mraa::SUCCESS if successful
+     */
+    virtual mraa::Result busWrite(uint8_t reg, const uint8_t *buffer,
+                                  int len) = 0;
+
+  private:
+    // per register flags
+    typedef enum {
+      FLAG_CACHED               = 0x01,
+      FLAG_VALID                = 0x02,
+      FLAG_DIRTY                = 0x04
+    } REG_FLAGS_T;
+
+    void checkReg(uint8_t reg, int len);
+
+    int m_size;
+    uint8_t *m_cache;
+    uint8_t *m_flags;
+    uint8_t *m_selfClearing;
+    bool m_deferred;
+
+    unsigned int m_busReads;
+    unsigned int m_busWrites;
+  };
+
+  /**
+   * @library regmap
+   * @brief RegMap on an mraa::I2c context
+   *
+   * The I2C address is set before every transfer, so the context may
+   * be shared between several devices.  Devices that need a flag in
+   * the register address to auto-increment (such as 0x80 on most ST
+   * parts) pass it as autoIncrement.
+   */
+  class I2cRegMap : public RegMap {
+  public:
+    /**
+     * I2cRegMap constructor
+     *
+     * @param i2c the I2C context of the device, owned by the caller
+     * @param address the address of the device
+     * @param size number of registers (highest register address + 1)
+     * @param autoIncrement bits to OR into the register address of
+     * multi-byte transfers
+     */
+    I2cRegMap(mraa::I2c *i2c, uint8_t address, int size,
+              uint8_t autoIncrement=0);
+
+  protected:
+    virtual int busRead(uint8_t reg, uint8_t *buffer, int len);
+    virtual mraa::Result busWrite(uint8_t reg, const uint8_t *buffer,
+                                  int len);
+
+  private:
+    mraa::I2c *m_i2c;
+    uint8_t m_addr;
+    uint8_t m_autoIncrement;
+  };
+
+  /**
+   * @library regmap
+   * @brief RegMap on an mraa::Spi context
+   *
+   * The register address is the first byte of every transfer.  Reads
+   * set readBit in it (0x80 on most parts), and multi-byte transfers
+   * also set autoIncrement, for devices that need a flag to step
+   * through registers (such as 0x40 on ST parts).  When the chip
+   * select is not driven by the SPI controller, a GPIO can be passed
+   * that is held low during each transfer.
+   */
+  class SpiRegMap : public RegMap {
+  public:
+    /**
+     * SpiRegMap constructor
+     *
+     * @param spi the SPI context of the device, owned by the caller
+     * @param size number of registers (highest register address + 1)
+     * @param readBit bits to OR into the register address of reads
+     * @param autoIncrement bits to OR into the register address of
+     * multi-byte transfers
+     * @param cs chip select GPIO, configured as an output and owned by
+     * the caller, or NULL
+     */
+    SpiRegMap(mraa::Spi *spi, int size, uint8_t readBit=0x80,
+              uint8_t autoIncrement=0, mraa::Gpio *cs=0);
+
+  protected:
+    virtual int busRead(uint8_t reg, uint8_t *buffer, int len);
+    virtual mraa::Result busWrite(uint8_t reg, const uint8_t *buffer,
+                                  int len);
+
+  private:
+    mraa::Result transfer(uint8_t *tx, uint8_t *rx, int len);
+
+    mraa::Spi *m_spi;
+    mraa::Gpio *m_cs;
+    uint8_t m_readBit;
+    uint8_t m_autoIncrement;
+  };
+}
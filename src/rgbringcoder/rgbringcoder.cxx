@@ -36,11 +36,10 @@ RGBRingCoder::RGBRingCoder(int en, int latch, int clear, int clk, int dat,
                            int sw, int encA, int encB, int red, 
                            int green, int blue) :
   m_gpioEn(en), m_gpioLatch(latch), m_gpioClear(clear), m_gpioClock(clk), 
-  m_gpioData(dat), m_gpioSwitch(sw), m_gpioEncA(encA), m_gpioEncB(encB),
-  m_pwmRed(red), m_pwmGreen(green), m_pwmBlue(blue)
+  m_gpioData(dat), m_gpioSwitch(sw),
+  m_pwmRed(red), m_pwmGreen(green), m_pwmBlue(blue),
+  m_encoder(encA, encB, true)
 {
-  m_counter = 0;
-
   // enable, set LOW
   m_gpioEn.dir(mraa::DIR_OUT);
   m_gpioEn.write(0);
@@ -66,17 +65,8 @@ RGBRingCoder::RGBRingCoder(int en, int latch, int clear, int clk, int dat,
   m_gpioSwitch.mode(mraa::MODE_HIZ);  // no pullup
   m_gpioSwitch.write(0);
   
-  // ecoder A interrupt
-  m_gpioEncA.dir(mraa::DIR_IN);
-  m_gpioEncA.mode(mraa::MODE_PULLUP);
-  // EDGE_BOTH would be nice...
-  m_gpioEncA.isr(mraa::EDGE_RISING, &interruptHandler, this);
-
-  // ecoder B interrupt
-  m_gpioEncB.dir(mraa::DIR_IN);
-  m_gpioEncB.mode(mraa::MODE_PULLUP);
-  // EDGE_BOTH would be nice...
-  m_gpioEncB.isr(mraa::EDGE_RISING, &interruptHandler, this);
+  // encoder, with pullups, decoded on both edges of both pins
+  m_encoder.start(QuadratureDecoder::DECODE_ISR);
 
   // RGB LED pwms, set to off
 
@@ -100,8 +90,7 @@ RGBRingCoder::RGBRingCoder(int en, int latch, int clear, int clk, int dat,
 
 RGBRingCoder::~RGBRingCoder()
 {
-  m_gpioEncA.isrExit();
-  m_gpioEncB.isrExit();
+  m_encoder.stop();
 
   // turn off the ring
   setRingLEDS(0x0000);
@@ -116,44 +105,25 @@ RGBRingCoder::~RGBRingCoder()
   m_pwmBlue.enable(false);
 }
 
-void RGBRingCoder::interruptHandler(void *ctx)
+int RGBRingCoder::getEncoderPosition()
 {
-   upm::RGBRingCoder *This = (upm::RGBRingCoder *)ctx;
-
-   // From the Sparkfun guys:
-
-   // enc_states[] is a fancy way to keep track of which direction
-   // the encoder is turning. 2-bits of oldEncoderState are paired
-   // with 2-bits of newEncoderState to create 16 possible values.
-   // Each of the 16 values will produce either a CW turn (1),
-   // CCW turn (-1) or no movement (0).
-
-   static int8_t enc_states[] = {0, -1, 1, 0, 1, 0, 0, -1,
-                                 -1, 0, 0, 1, 0, 1, -1, 0};
-   static uint8_t oldEncoderState = 0;
-   static uint8_t newEncoderState = 0;
-
-   // First, find the newEncoderState. This'll be a 2-bit value
-   // the msb is the state of the B pin. The lsb is the state
-   // of the A pin on the encoder.
-   newEncoderState = (This->m_gpioEncB.read()<<1) | 
-     (This->m_gpioEncA.read());
+  int counts = m_encoder.position();
 
-   // Now we pair oldEncoderState with new encoder state
-   // First we need to shift oldEncoder state left two bits.
-   // This'll put the last state in bits 2 and 3.
+  // two counts per cycle, rounded toward negative infinity like
+  // RotaryEncoder::position()
+  if (counts < 0)
+    return -((-counts + 1) / 2);
 
-   oldEncoderState <<= 2;
-
-   // Mask out everything in oldEncoderState except for the previous state
-   oldEncoderState &= 0x0c;
-
-   // Now add the newEncoderState. oldEncoderState will now be of
-   // the form: 0b0000(old B)(old A)(new B)(new A)
-   oldEncoderState |= newEncoderState;
+  return counts / 2;
+}
 
-   // update our counter
-   This->m_counter += enc_states[oldEncoderState & 0x0f];
+void RGBRingCoder::enableEncoderPolling(bool enable, int intervalUs,
+                                        int priority)
+{
+  if (enable)
+    m_encoder.start(QuadratureDecoder::DECODE_POLL, intervalUs, priority);
+  else
+    m_encoder.start(QuadratureDecoder::DECODE_ISR);
 }
 
 void RGBRingCoder::setRingLEDS(uint16_t bits)
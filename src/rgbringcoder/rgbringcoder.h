@@ -32,6 +32,8 @@
 
 #include <mraa/pwm.hpp>
 
+#include "quadrature.h"
+
 
 namespace upm {
   /**
@@ -57,6 +59,14 @@ namespace upm {
    *
    * The device requires 11 pins, 3 of which must be PWM-capable
    * (for the RGB LEDs).
+   *
+   * The encoder is decoded on both edges of both signals, giving
+   * four counts per cycle.  getEncoderPosition() reports two per
+   * cycle, as earlier versions of this driver did, while
+   * getEncoderRawPosition() reports the full resolution.  Decoding
+   * normally runs from interrupts;
+   * enableEncoderPolling() moves it to a polling thread for higher
+   * turning rates.
    * 
    * @image html rgbringcoder.jpg
    * @snippet rgbringcoder.cxx Interesting
@@ -110,12 +120,53 @@ namespace upm {
      *
      * @return Current counter value
      */
-    int getEncoderPosition() { return m_counter; };
+    int getEncoderPosition();
+
+    /*
+     * Gets the encoder position in quadrature counts, four per cycle
+     * (twice the resolution of getEncoderPosition())
+     *
+     * @return Position in counts
+     */
+    int getEncoderRawPosition() { return m_encoder.position(); };
 
     /* 
      * Sets the encoder counter to 0
      */
-    void clearEncoderPosition() { m_counter = 0; };
+    void clearEncoderPosition() { m_encoder.setPosition(0); };
+
+    /*
+     * Returns the encoder speed, averaged over a window
+     *
+     * @param windowMs Length of the averaging window in milliseconds
+     * @return getEncoderPosition() counts per second; negative when
+     * the counter is decreasing
+     */
+    float getEncoderVelocity(uint32_t windowMs=QUADRATURE_DEFAULT_WINDOW)
+    {
+      return m_encoder.velocity(windowMs) / 2.0;
+    };
+
+    /*
+     * Returns the number of invalid encoder transitions detected,
+     * where both signals changed at once
+     *
+     * @return Number of errors
+     */
+    uint32_t getEncoderErrors() { return m_encoder.errorCount(); };
+
+    /*
+     * Decodes the encoder from a polling thread instead of
+     * interrupts, using memory mapped GPIO where available
+     *
+     * @param enable True to poll, false to return to interrupts
+     * @param intervalUs Time between samples in microseconds
+     * @param priority SCHED_FIFO priority of the polling thread, 0
+     * for the default scheduling
+     */
+    void enableEncoderPolling(bool enable,
+                              int intervalUs=QUADRATURE_DEFAULT_POLL_US,
+                              int priority=0);
 
     /* 
      * Sets the intensity of the red, green, and blue LEDs. Values can
@@ -142,11 +193,7 @@ namespace upm {
     mraa::Pwm m_pwmGreen;
     mraa::Pwm m_pwmBlue;
 
-    mraa::Gpio m_gpioEncA;
-    mraa::Gpio m_gpioEncB;
-
-    static void interruptHandler(void *ctx);
-    volatile int m_counter;
+    QuadratureDecoder m_encoder;
 
   };
 }
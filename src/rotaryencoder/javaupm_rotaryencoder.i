@@ -1,8 +1,6 @@
 %module javaupm_rotaryencoder
 %include "../upm.i"
 
-%ignore signalAISR;
-
 %{
     #include "rotaryencoder.h"
 %}
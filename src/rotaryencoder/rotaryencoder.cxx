@@ -31,65 +31,53 @@
 using namespace upm;
 using namespace std;
 
-RotaryEncoder::RotaryEncoder(int pinA, int pinB)
+RotaryEncoder::RotaryEncoder(int pinA, int pinB) :
+  m_decoder(pinA, pinB)
 {
-  if ( !(m_gpioA = mraa_gpio_init(pinA)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_gpio_init(pinA) failed, invalid pin?");
-      return;
-    }
-
-  mraa_gpio_dir(m_gpioA, MRAA_GPIO_IN);
-
-  if ( !(m_gpioB = mraa_gpio_init(pinB)) )
-    {
-      throw std::invalid_argument(std::string(__FUNCTION__) +
-                                  ": mraa_gpio_init(pinB) failed, invalid pin?");
-      return;
-    }
-
-  mraa_gpio_dir(m_gpioB, MRAA_GPIO_IN);
-
-  m_position = 0;
-
-  // setup the ISR
-
-  // We would prefer to use MRAA_GPIO_EDGE_BOTH for better resolution,
-  // but that does not appear to be supported
-  mraa_gpio_isr(m_gpioA, MRAA_GPIO_EDGE_RISING, 
-                &signalAISR, this);
+  m_decoder.start(QuadratureDecoder::DECODE_ISR);
 }
 
 RotaryEncoder::~RotaryEncoder()
 {
-  mraa_gpio_isr_exit(m_gpioA);
-
-  mraa_gpio_close(m_gpioA);
-  mraa_gpio_close(m_gpioB);
+  m_decoder.stop();
 }
 
 void RotaryEncoder::initPosition(int count)
 {
-  m_position = count;
+  m_decoder.setPosition(count * 4);
 }
 
 int RotaryEncoder::position()
 {
-  return m_position;
+  int counts = m_decoder.position();
+
+  // round toward negative infinity, so the position does not stick
+  // at 0 for a whole extra cycle when turning backwards
+  if (counts < 0)
+    return -((-counts + 3) / 4);
+
+  return counts / 4;
 }
 
-void RotaryEncoder::signalAISR(void *ctx)
+int RotaryEncoder::rawPosition()
 {
-  upm::RotaryEncoder *This = (upm::RotaryEncoder *)ctx;
+  return m_decoder.position();
+}
 
-  if (mraa_gpio_read(This->m_gpioA))
-    {
-      if (mraa_gpio_read(This->m_gpioB))
-        This->m_position++;      // CW
-      else
-        This->m_position--;      // CCW
-    }
+float RotaryEncoder::velocity(uint32_t windowMs)
+{
+  return m_decoder.velocity(windowMs) / 4.0;
 }
 
+uint32_t RotaryEncoder::errorCount()
+{
+  return m_decoder.errorCount();
+}
 
+void RotaryEncoder::enablePolling(bool enable, int intervalUs, int priority)
+{
+  if (enable)
+    m_decoder.start(QuadratureDecoder::DECODE_POLL, intervalUs, priority);
+  else
+    m_decoder.start(QuadratureDecoder::DECODE_ISR);
+}
@@ -25,8 +25,7 @@
 
 #include <string>
 #include <stdint.h>
-#include <sys/time.h>
-#include <mraa/gpio.h>
+#include "quadrature.h"
 
 namespace upm {
 
@@ -58,6 +57,12 @@ namespace upm {
  * This module maintains a position that is incremented or
  * decremented according to the rotation on the encoder.
  *
+ * Both edges of both signals are decoded, giving four counts per
+ * encoder cycle.  position() reports whole cycles, as earlier
+ * versions of this driver did, while rawPosition() reports the
+ * individual counts.  For fast spinning shafts, decoding can be
+ * moved from interrupts to a polling thread with enablePolling().
+ *
  * @image html rotaryencoder.jpg
  * @snippet rotaryencoder.cxx Interesting
  */
@@ -88,17 +93,46 @@ namespace upm {
      */
     int position();
 
-  private:
     /**
-     * Interrupt service routine (ISR) for signal A
+     * Gets the position in quadrature counts, four per cycle
+     *
+     * @return Position in counts
+     */
+    int rawPosition();
+
+    /**
+     * Returns the rotation speed, averaged over a window
+     *
+     * @param windowMs Length of the averaging window in milliseconds
+     * @return Speed in cycles per second; negative when the position
+     * is decreasing
+     */
+    float velocity(uint32_t windowMs=QUADRATURE_DEFAULT_WINDOW);
+
+    /**
+     * Returns the number of invalid transitions detected, where both
+     * signals changed at once.  These indicate that the encoder turned
+     * faster than it could be decoded.
+     *
+     * @return Number of errors
+     */
+    uint32_t errorCount();
+
+    /**
+     * Decodes from a polling thread instead of interrupts.  Polling
+     * uses memory mapped GPIO where available, and handles much
+     * higher edge rates, but keeps a thread busy.
      *
-     * @param ctx User context for the ISR (*this pointer)
+     * @param enable True to poll, false to return to interrupts
+     * @param intervalUs Time between samples in microseconds
+     * @param priority SCHED_FIFO priority of the polling thread, 0
+     * for the default scheduling
      */
-    static void signalAISR(void *ctx);
-  
-    volatile int m_position;
-    mraa_gpio_context m_gpioA;
-    mraa_gpio_context m_gpioB;
+    void enablePolling(bool enable, int intervalUs=QUADRATURE_DEFAULT_POLL_US,
+                       int priority=0);
+
+  private:
+    QuadratureDecoder m_decoder;
   };
 }
 
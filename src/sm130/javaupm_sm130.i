@@ -1,6 +1,9 @@
 %module javaupm_sm130
 %include "../upm.i"
 
+// Java users should poll getNextTag() instead
+%ignore setTagCallback;
+
 %{
     #include "sm130.h"
 %}
@@ -47,6 +47,24 @@ SM130::SM130(int uart, int reset) :
 
   m_gpioReset.dir(mraa::DIR_OUT);
   m_gpioReset.write(0);
+
+  m_rxState = 0;
+  m_rxPos = 0;
+  m_rxSum = 0;
+
+  m_waitCmd = 0;
+  m_respLen = 0;
+
+  m_seeking = false;
+  m_rearm = false;
+  m_rearmed = false;
+  m_lastTag.type = TAG_NONE;
+  m_lastTag.uidLen = 0;
+  m_lastTagTime = 0;
+  m_tagCount = 0;
+
+  m_tagCallback = 0;
+  m_tagCallbackArg = 0;
 }
 
 SM130::~SM130() 
@@ -61,45 +79,71 @@ mraa::Result SM130::setBaudRate(int baud)
 
 string SM130::sendCommand(CMD_T cmd, string data)
 {
+  int len = sendCommand(cmd, (const uint8_t *)data.data(), data.size());
+
+  if (!len)
+    return "";
+
+  // length, command and data
+  return string((char *)m_resp, len);
+}
+
+bool SM130::writeCommand(CMD_T cmd, const uint8_t *data, int len)
+{
+  // 2 sync bytes, length, command, up to 254 data bytes and checksum
+  uint8_t frame[2 + 1 + 1 + 254 + 1];
+
+  if (len < 0 || len > 254)
+    {
+      throw std::invalid_argument(string(__FUNCTION__) +
+                                  ": command data too long");
+      return false;
+    }
+
+  int pos = 0;
   uint8_t cksum = 0;
-  string command;
 
   // for uart, we need to add the sync bytes, 0xff, 0x00
-  command.push_back(0xff);
-  command.push_back(0x00);
-  
-  // compute the length - command + data
-  uint8_t len = 1; // command
-  if (!data.empty())
-    len += data.size();
+  frame[pos++] = 0xff;
+  frame[pos++] = 0x00;
 
-  command.push_back(len);
+  // length is command + data
+  frame[pos++] = len + 1;
+  cksum += len + 1;
 
-  cksum += len;
-
-  // now the command
-  command.push_back(cmd);
+  frame[pos++] = cmd;
   cksum += cmd;
 
-  // now the data if any
-  if (!data.empty())
+  for (int i=0; i<len; i++)
     {
-      for (int i=0; i<data.size(); i++)
-        {
-          command.push_back(data[i]);
-          cksum += (uint8_t)data[i];
-        }
+      frame[pos++] = data[i];
+      cksum += data[i];
     }
 
-  // now add the checksum
-  command.push_back(cksum);
+  frame[pos++] = cksum;
 
 #ifdef SM130_DEBUG
-  cerr << "CMD: " << string2HexString(command) << endl;
+  cerr << "CMD: " << string2HexString(string((char *)frame, pos)) << endl;
 #endif // SM130_DEBUG
 
-  // send it
-  m_uart.writeStr(command);
+  return (m_uart.write((char *)frame, pos) == pos);
+}
+
+int SM130::sendCommand(CMD_T cmd, const uint8_t *data, int len)
+{
+  // any other command ends a seek on the reader
+  if (cmd != CMD_SEEK_TAG)
+    m_seeking = false;
+
+  m_waitCmd = cmd;
+  m_respLen = 0;
+
+  if (!writeCommand(cmd, data, len))
+    {
+      cerr << __FUNCTION__ << ": write failed" << endl;
+      m_waitCmd = 0;
+      return 0;
+    }
 
   // if the command is SET_BAUD, then switch to the new baudrate here
   // before attempting to read the response (and hope it worked).
@@ -109,56 +153,225 @@ string SM130::sendCommand(CMD_T cmd, string data)
       setBaudRate(m_baud);
     }
 
-  // now wait for a response
-  if (!m_uart.dataAvailable(defaultDelay))
+  // now wait for a response.  The parser stores it in m_resp, and
+  // handles any seek results that arrive first.
+  uint32_t start = getMillis();
+
+  while (!m_respLen)
     {
-      cerr << __FUNCTION__ << ": timeout waiting for response" << endl;
-      return "";
+      uint32_t elapsed = getMillis() - start;
+
+      if (elapsed >= uint32_t(defaultDelay))
+        {
+          cerr << __FUNCTION__ << ": timeout waiting for response" << endl;
+          m_waitCmd = 0;
+          return 0;
+        }
+
+      processInput(defaultDelay - elapsed);
     }
 
-  string resp = m_uart.readStr(maxLen);
+  return m_respLen;
+}
+
+int SM130::processInput(unsigned int millis)
+{
+  unsigned int tags = m_tagCount;
+
+  if (!m_uart.dataAvailable(millis))
+    return 0;
+
+  uint8_t buf[maxLen];
+
+  do
+    {
+      int rv = m_uart.read((char *)buf, sizeof(buf));
+      if (rv <= 0)
+        break;
+
+      // frames are validated as the bytes arrive: sync (0xff 0x00),
+      // length, command and data (length bytes), checksum
+      for (int i=0; i<rv; i++)
+        {
+          uint8_t c = buf[i];
+
+          switch (m_rxState)
+            {
+            case 0:             // looking for the first sync byte
+              if (c == 0xff)
+                m_rxState = 1;
+              break;
+
+            case 1:             // second sync byte
+              if (c == 0x00)
+                m_rxState = 2;
+              else if (c != 0xff)
+                m_rxState = 0;
+              break;
+
+            case 2:             // length
+              if (c == 0)
+                {
+                  cerr << __FUNCTION__ << ": invalid packet length" << endl;
+                  m_rxState = 0;
+                  break;
+                }
+              m_rxFrame[0] = c;
+              m_rxSum = c;
+              m_rxPos = 1;
+              m_rxState = 3;
+              break;
+
+            case 3:             // command and data
+              m_rxFrame[m_rxPos++] = c;
+              m_rxSum += c;
+              if (m_rxPos > m_rxFrame[0])
+                m_rxState = 4;
+              break;
+
+            case 4:             // checksum
+              m_rxState = 0;
 
 #ifdef SM130_DEBUG
-  cerr << "RSP: " << string2HexString(resp) << endl;
+              cerr << "RSP: "
+                   << string2HexString(string((char *)m_rxFrame, m_rxPos))
+                   << endl;
 #endif // SM130_DEBUG
 
-  if (!((uint8_t)resp[0] == 0xff && (uint8_t)resp[1] == 0x00))
+              if (c != m_rxSum)
+                {
+                  cerr << __FUNCTION__ << ": invalid checksum, expected "
+                       << int(m_rxSum) << ", got " << int(c) << endl;
+                  break;
+                }
+
+              handleFrame(m_rxFrame);
+              break;
+            }
+        }
+    } while (m_uart.dataAvailable(0));
+
+  return m_tagCount - tags;
+}
+
+void SM130::handleFrame(const uint8_t *frame)
+{
+  // frame[0] is the length, frame[1] the command
+  if (frame[1] == CMD_SEEK_TAG && m_seeking)
     {
-      cerr << __FUNCTION__ << ": invalid packet header" << endl;
-      return "";
+      // a 2 byte response is a status: 'L' means the seek is in
+      // progress, anything else that it failed
+      if (frame[0] < 6)
+        {
+          if (frame[2] == 'L')
+            return;
+
+          m_lastErrorCode = frame[2];
+          if (m_lastErrorCode == 'U')
+            m_lastErrorString = "Access failed, RF field is off";
+          else
+            m_lastErrorString = "Unknown error code";
+
+          m_seeking = false;
+          return;
+        }
+
+      TAG_EVENT_T tag;
+
+      tag.type = (TAG_TYPE_T)frame[2];
+      tag.uidLen = (frame[0] == 6) ? 4 : 7;
+      memcpy(tag.uid, frame + 3, tag.uidLen);
+
+      // a tag that stays in the field is found again by every
+      // rearmed seek, so only report it once
+      uint32_t now = getMillis();
+      bool repeat = (m_rearmed && tag.uidLen == m_lastTag.uidLen &&
+                     !memcmp(tag.uid, m_lastTag.uid, tag.uidLen) &&
+                     (now - m_lastTagTime) < SM130_SEEK_HOLDOFF);
+
+      m_lastTag = tag;
+      m_lastTagTime = now;
+
+      if (m_rearm)
+        {
+          m_rearmed = true;
+          writeCommand(CMD_SEEK_TAG, 0, 0);
+        }
+      else
+        m_seeking = false;
+
+      if (repeat)
+        return;
+
+      if (m_tagEvents.size() >= SM130_MAX_TAG_EVENTS)
+        m_tagEvents.pop_front();
+      m_tagEvents.push_back(tag);
+      m_tagCount++;
+
+      if (m_tagCallback)
+        m_tagCallback(tag.type, tag.uid, tag.uidLen, m_tagCallbackArg);
+
+      return;
     }
-    
-  // check size - 2 header bytes + len + cksum.
-  if (resp.size() != ((uint8_t)resp[2] + 2 + 1 + 1))
+
+  if (m_waitCmd && frame[1] == m_waitCmd)
     {
-      cerr << __FUNCTION__ << ": invalid packet length, expected " 
-           << int((uint8_t)resp[2] + 2 + 1 + 1) 
-           << ", got " << resp.size() << endl;
-      return "";
+      // length, command and data
+      m_respLen = frame[0] + 1;
+      memcpy(m_resp, frame, m_respLen);
+      m_waitCmd = 0;
     }
 
-  // verify the cksum
-  cksum = 0;
-  for (int i=2; i<(resp.size() - 1); i++)
-    cksum += (uint8_t)resp[i];
+  // anything else is a stale response, dropped
+}
+
+bool SM130::startSeek(bool rearm)
+{
+  clearError();
+
+  m_rearm = rearm;
+  m_rearmed = false;
 
-  if (cksum != (uint8_t)resp[resp.size() - 1])
+  if (!writeCommand(CMD_SEEK_TAG, 0, 0))
     {
-      cerr << __FUNCTION__ << ": invalid checksum, expected " 
-           << int(cksum) << ", got " << (uint8_t)resp[resp.size()-1] << endl;
-      return "";
+      cerr << __FUNCTION__ << ": failed" << endl;
+      return false;
     }
 
-  // we could also verify that the command code returned was for the
-  // command submitted...
+  m_seeking = true;
+  return true;
+}
 
-  // now, remove the 2 header bytes and the checksum, leave the length
-  // and command.
-  resp.erase(resp.size() - 1, 1); // cksum
-  resp.erase(0, 2);               // header bytes
+void SM130::stopSeek()
+{
+  m_rearm = false;
 
-  // return the rest
-  return resp;
+  if (!m_seeking)
+    return;
+
+  // any command cancels the seek, so send a harmless one
+  sendCommand(CMD_READ_PORT, 0, 0);
+}
+
+bool SM130::getNextTag()
+{
+  if (m_tagEvents.empty())
+    return false;
+
+  TAG_EVENT_T tag = m_tagEvents.front();
+  m_tagEvents.pop_front();
+
+  m_tagType = tag.type;
+  m_uidLen = tag.uidLen;
+  m_uid.assign((char *)tag.uid, tag.uidLen);
+
+  return true;
+}
+
+void SM130::setTagCallback(TAG_CALLBACK_T func, void *arg)
+{
+  m_tagCallback = func;
+  m_tagCallbackArg = arg;
 }
 
 string SM130::getFirmwareVersion()
@@ -310,23 +523,23 @@ string SM130::readBlock16(uint8_t block)
 {
   clearError();
 
-  string data;
+  uint8_t data[1];
 
-  data.push_back(block);
+  data[0] = block;
 
-  string resp = sendCommand(CMD_READ16, data);
+  int len = sendCommand(CMD_READ16, data, sizeof(data));
 
-  if (resp.empty())
+  if (!len)
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return "";
     }
 
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -341,32 +554,29 @@ string SM130::readBlock16(uint8_t block)
       return "";
     }
 
-  // trim off the len, cmd, and block # bytes and return the rest
-  resp.erase(0, 3);
-  return resp;
+  // skip the len, cmd, and block # bytes and return the rest
+  return string((char *)m_resp + 3, len - 3);
 }
 
 int32_t SM130::readValueBlock(uint8_t block)
 {
   clearError();
 
-  string data;
+  uint8_t data[1];
 
-  data.push_back(block);
-
-  string resp = sendCommand(CMD_READ_VALUE, data);
+  data[0] = block;
 
-  if (resp.empty())
+  if (!sendCommand(CMD_READ_VALUE, data, sizeof(data)))
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return 0;
     }
 
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -384,10 +594,10 @@ int32_t SM130::readValueBlock(uint8_t block)
     }
 
   int32_t rv;
-  rv = ((uint8_t)resp[3] |
-        ((uint8_t)resp[4] << 8) |
-        ((uint8_t)resp[5] << 16) |
-        ((uint8_t)resp[6] << 24));
+  rv = (m_resp[3] |
+        (m_resp[4] << 8) |
+        (m_resp[5] << 16) |
+        (m_resp[6] << 24));
 
   return rv;
 }
@@ -405,23 +615,21 @@ bool SM130::writeBlock16(uint8_t block, string contents)
       return false;
     }
 
-  string data;
-  data.push_back(block);
-  data += contents;
+  uint8_t data[1 + 16];
+  data[0] = block;
+  memcpy(data + 1, contents.data(), 16);
 
-  string resp = sendCommand(CMD_WRITE16, data);
-  
-  if (resp.empty())
+  if (!sendCommand(CMD_WRITE16, data, sizeof(data)))
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return false;
     }
   
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -446,27 +654,25 @@ bool SM130::writeValueBlock(uint8_t block, int32_t value)
 {
   clearError();
   
-  string data;
-  data.push_back(block);
+  uint8_t data[5];
+  data[0] = block;
   // put the value in, LSB first
-  data += (value & 0xff);
-  data += ((value >> 8) & 0xff);
-  data += ((value >> 16) & 0xff);
-  data += ((value >> 24) & 0xff);
+  data[1] = value & 0xff;
+  data[2] = (value >> 8) & 0xff;
+  data[3] = (value >> 16) & 0xff;
+  data[4] = (value >> 24) & 0xff;
 
-  string resp = sendCommand(CMD_WRITE_VALUE, data);
-  
-  if (resp.empty())
+  if (!sendCommand(CMD_WRITE_VALUE, data, sizeof(data)))
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return false;
     }
   
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -498,23 +704,21 @@ bool SM130::writeBlock4(uint8_t block, string contents)
       return false;
     }
 
-  string data;
-  data.push_back(block);
-  data += contents;
+  uint8_t data[1 + 4];
+  data[0] = block;
+  memcpy(data + 1, contents.data(), 4);
 
-  string resp = sendCommand(CMD_WRITE4, data);
-  
-  if (resp.empty())
+  if (!sendCommand(CMD_WRITE4, data, sizeof(data)))
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return false;
     }
   
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -595,27 +799,26 @@ int32_t SM130::adjustValueBlock(uint8_t block, int32_t value, bool incr)
 {
   clearError();
   
-  string data;
-  data.push_back(block);
+  uint8_t data[5];
+  data[0] = block;
   // put the value in, LSB first
-  data += (value & 0xff);
-  data += ((value >> 8) & 0xff);
-  data += ((value >> 16) & 0xff);
-  data += ((value >> 24) & 0xff);
+  data[1] = value & 0xff;
+  data[2] = (value >> 8) & 0xff;
+  data[3] = (value >> 16) & 0xff;
+  data[4] = (value >> 24) & 0xff;
 
-  string resp = sendCommand(((incr) ? CMD_INC_VALUE : CMD_DEC_VALUE), data);
-  
-  if (resp.empty())
+  if (!sendCommand(((incr) ? CMD_INC_VALUE : CMD_DEC_VALUE), data,
+                   sizeof(data)))
     {
       cerr << __FUNCTION__ << ": failed" << endl;
       return 0;
     }
   
-  if ((uint8_t)resp[0] == 2)
+  if (m_resp[0] == 2)
     {
       // then we got an error of some sort, store the error code, str
       // and bail.
-      m_lastErrorCode = resp[2];
+      m_lastErrorCode = m_resp[2];
       
       switch (m_lastErrorCode) 
         {
@@ -633,10 +836,10 @@ int32_t SM130::adjustValueBlock(uint8_t block, int32_t value, bool incr)
 
   // now unpack the new value, LSB first
   int32_t rv;
-  rv = ((uint8_t)resp[3] |
-        ((uint8_t)resp[4] << 8) |
-        ((uint8_t)resp[5] << 16) |
-        ((uint8_t)resp[6] << 24));
+  rv = (m_resp[3] |
+        (m_resp[4] << 8) |
+        (m_resp[5] << 16) |
+        (m_resp[6] << 24));
   
   return rv;
 }
@@ -838,26 +1041,37 @@ uint32_t SM130::getMillis()
 
 bool SM130::waitForTag(uint32_t timeout)
 {
-  initClock();
+  // a tag found by an earlier seek
+  if (getNextTag())
+    return true;
+
+  if (!startSeek(false))
+    return false;
 
-  do 
+  uint32_t start = getMillis();
+
+  // the reader reports the tag as soon as it is selected
+  while (m_seeking)
     {
-      if (select())
-        {
-          // success
-          return true;
-        }
-      else
-        {
-          // If there was an error, fail if it's anything other than a
-          // tag not present
-          if (getLastErrorCode() != 'N')
-            return false;
+      uint32_t elapsed = getMillis() - start;
 
-          // otherwise, sleep for 100ms and try again
-          usleep(100000);
-        }
-    } while (getMillis() <= timeout);
+      if (elapsed > timeout)
+        break;
+
+      processInput(timeout - elapsed);
+    }
+
+  if (getNextTag())
+    return true;
+
+  // an error ended the seek
+  if (m_lastErrorCode)
+    return false;
+
+  stopSeek();
+
+  m_lastErrorCode = 'N';
+  m_lastErrorString = "No tag present";
 
   return false;
 }
@@ -25,6 +25,7 @@
 
 #include <string>
 #include <iostream>
+#include <deque>
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -42,6 +43,13 @@
 #define SM130_DEFAULT_UART 0
 #define SM130_DEFAULT_RESET_PIN 13
 
+// Maximum number of seek tag events queued for getNextTag()
+#define SM130_MAX_TAG_EVENTS 16
+
+// A tag seen again within this many milliseconds of its last
+// detection is not reported again
+#define SM130_SEEK_HOLDOFF 1000
+
 namespace upm {
   
   /**
@@ -68,6 +76,14 @@ namespace upm {
    * fairly trivial to add support for I2C communication in the
    * future, if you have the correct firmware on the SM130.
    *
+   * Tags can be detected in the background with startSeek(), which
+   * uses the reader's own seek command.  The reader selects a tag as
+   * soon as it enters the RF field, and reports it without being
+   * polled.  Responses are validated by a streaming parser as bytes
+   * arrive, and detected tags are passed to a callback or queued for
+   * getNextTag().  Frames are only processed from processInput(), and
+   * while waiting for the response to another command.
+   *
    * @image html sm130.jpg
    * <br><em>SM130 RFID Reader image provided by SparkFun* under
    * <a href=https://creativecommons.org/licenses/by-nc-sa/3.0/>
@@ -155,6 +171,13 @@ namespace upm {
       KEY_TYPE_A_AND_TRANSPORT_F = 0xff
     } KEY_TYPES_T;
 
+    /**
+     * Tag detection callback.  uid is only valid until the callback
+     * returns.
+     */
+    typedef void (*TAG_CALLBACK_T)(TAG_TYPE_T type, const uint8_t *uid,
+                                   int uidLen, void *arg);
+
     /**
      * Instantiates an SM130 object
      *
@@ -208,8 +231,9 @@ namespace upm {
 
     /**
      * Waits for a tag to enter the RF field for up to 'timeout'
-     * milliseconds. It will call select() every 100ms until 'timeout'
-     * has been exceeded.
+     * milliseconds.  This runs a seek on the reader (see startSeek()),
+     * so the tag is reported as soon as it is selected.  A tag already
+     * queued by an earlier seek is returned right away.
      *
      * @param timeout The number of milliseconds to wait for a tag to appear
      * @return true if a tag was detected, false if no tag was
@@ -217,6 +241,59 @@ namespace upm {
      */
     bool waitForTag(uint32_t timeout);
 
+    /**
+     * Starts seeking for tags in the background.  When a tag enters
+     * the RF field, the reader selects it, and the tag is reported
+     * to the tag callback and queued for getNextTag().  Sending any
+     * other command to the reader ends the seek, so call this again
+     * after working with a tag.
+     *
+     * @param rearm true to restart the seek after each detected tag.
+     * A tag that stays in the field is then only reported again once
+     * it has been absent for SM130_SEEK_HOLDOFF milliseconds.
+     * @return true if the seek command was sent
+     */
+    bool startSeek(bool rearm=true);
+
+    /**
+     * Stops seeking for tags.  Tags already detected stay queued.
+     */
+    void stopSeek();
+
+    /**
+     * Returns true while a seek is in progress
+     *
+     * @return true if seeking
+     */
+    bool isSeeking() { return m_seeking; };
+
+    /**
+     * Reads and parses any frames sent by the reader, reporting the
+     * tags found by a seek
+     *
+     * @param millis Number of milliseconds to wait for data; 0 means
+     * no waiting
+     * @return Number of tags detected
+     */
+    int processInput(unsigned int millis=0);
+
+    /**
+     * Makes the oldest tag detected by a seek the current tag, as if
+     * it had been found by select(), and removes it from the queue.
+     *
+     * @return true if a tag was available, false otherwise
+     */
+    bool getNextTag();
+
+    /**
+     * Installs a function to be called for each tag detected by a
+     * seek, from within processInput()
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setTagCallback(TAG_CALLBACK_T func, void *arg);
+
     /**
      * Set the authentication key for a block.  Depending on the
      * permissions on the tag, the correct key must be authenticated
@@ -441,6 +518,14 @@ namespace upm {
     mraa::Gpio m_gpioReset;
 
     std::string sendCommand(CMD_T cmd, std::string data);
+    // send a command built from data, and wait for its response,
+    // which is left in m_resp (length, command, data).  Returns the
+    // response length, or 0 on failure.
+    int sendCommand(CMD_T cmd, const uint8_t *data, int len);
+    // write a command frame without waiting for the response
+    bool writeCommand(CMD_T cmd, const uint8_t *data, int len);
+    // handle a complete frame (length, command, data)
+    void handleFrame(const uint8_t *frame);
     void initClock();
     uint32_t getMillis();
 
@@ -457,6 +542,37 @@ namespace upm {
 
     struct timeval m_startTime;
 
+    typedef struct {
+      TAG_TYPE_T type;
+      int uidLen;
+      uint8_t uid[7];
+    } TAG_EVENT_T;
+
+    // frame parser state: sync bytes seen, then length, command, data
+    // and checksum
+    int m_rxState;
+    uint8_t m_rxFrame[256 + 1];
+    int m_rxPos;
+    uint8_t m_rxSum;
+
+    // response to the command being waited for
+    uint8_t m_waitCmd;
+    uint8_t m_resp[256 + 1];
+    int m_respLen;
+
+    bool m_seeking;
+    bool m_rearm;
+    std::deque<TAG_EVENT_T> m_tagEvents;
+    TAG_EVENT_T m_lastTag;
+    uint32_t m_lastTagTime;
+    // the seek was restarted after a detection
+    bool m_rearmed;
+    // total number of tags reported
+    unsigned int m_tagCount;
+
+    TAG_CALLBACK_T m_tagCallback;
+    void *m_tagCallbackArg;
+
     void clearError()
     { 
       m_lastErrorCode = 0;
@@ -34,7 +34,10 @@ using namespace upm;
 
 GFX::GFX (int width, int height) : m_width(width), m_height(height),
         m_textSize(1), m_textColor(0xFFFF), m_textBGColor(0x0000),
-        m_cursorX(0), m_cursorY(0), m_font(font) {
+        m_cursorX(0), m_cursorY(0), m_wrap(0), m_font(font) {
+    Raster::FONT_T classic = { font, 0, 0, 5, 8, 0, 256, 1 };
+    m_classicFont = classic;
+    m_textFont    = &m_classicFont;
 }
 
 GFX::~GFX () {
@@ -47,97 +50,57 @@ GFX::fillScreen (uint16_t color) {
 
 void
 GFX::fillRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
-    for (int16_t i=x; i<x+w; i++) {
-        drawFastVLine(i, y, h, color);
-    }
+    rasterBlock(x, y, w, h, color);
 }
 
 void
 GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
-    drawLine(x, y, x, y+h-1, color);
+    rasterVLine(x, y, h, color);
 }
 
 void
-GFX::drawLine (int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
-    int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    rasterHLine(x, y, w, color);
+}
 
-    if (steep) {
-        swap(x0, y0);
-        swap(x1, y1);
-    }
+void
+GFX::drawRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    rasterRect(x, y, w, h, color);
+}
 
-    if (x0 > x1) {
-        swap(x0, x1);
-        swap(y0, y1);
-    }
+void
+GFX::drawLine (int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    rasterLine(x0, y0, x1, y1, color);
+}
 
-    int16_t dx, dy;
-    dx = x1 - x0;
-    dy = abs (y1 - y0);
+void
+GFX::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+    rasterTriangle(x0, y0, x1, y1, x2, y2, color);
+}
 
-    int16_t err = dx / 2;
-    int16_t ystep;
+void
+GFX::fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+    rasterFillTriangle(x0, y0, x1, y1, x2, y2, color);
+}
 
-    if (y0 < y1) {
-        ystep = 1;
-    } else {
-        ystep = -1;
-    }
+void
+GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    rasterCircle(x0, y0, r, color);
+}
 
-    for (; x0 <= x1; x0++) {
-        if (steep) {
-            drawPixel(y0, x0, color);
-        } else {
-            drawPixel(x0, y0, color);
-        }
-        err -= dy;
-        if (err < 0) {
-            y0 += ystep;
-            err += dx;
-        }
-    }
+void
+GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    rasterFillCircle(x0, y0, r, color);
 }
 
 void
-GFX::drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
-    drawLine(x0, y0, x1, y1, color);
-    drawLine(x1, y1, x2, y2, color);
-    drawLine(x2, y2, x0, y0, color);
+GFX::drawRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    rasterRoundRect(x, y, w, h, r, color);
 }
 
 void
-GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
-    int16_t y = r;
-
-    drawPixel(x0  , y0+r, color);
-    drawPixel(x0  , y0-r, color);
-    drawPixel(x0+r, y0  , color);
-    drawPixel(x0-r, y0  , color);
-
-    while (x<y) {
-        if (f >= 0) {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-
-        ddF_x += 2;
-        f += ddF_x;
-
-        drawPixel(x0 + x, y0 + y, color);
-        drawPixel(x0 - x, y0 + y, color);
-        drawPixel(x0 + x, y0 - y, color);
-        drawPixel(x0 - x, y0 - y, color);
-        drawPixel(x0 + y, y0 + x, color);
-        drawPixel(x0 - y, y0 + x, color);
-        drawPixel(x0 + y, y0 - x, color);
-        drawPixel(x0 - y, y0 - x, color);
-    }
+GFX::fillRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    rasterFillRoundRect(x, y, w, h, r, color);
 }
 
 void
@@ -170,49 +133,71 @@ GFX::drawChar (int16_t x, int16_t y, uint8_t data, uint16_t color, uint16_t bg,
         ((y + 8 * size - 1) < 0))    // Clip top
     return;
 
-    for (int8_t i=0; i<6; i++ ) {
-        uint8_t line;
-        if (i == 5) {
-            line = 0x0;
-        } else {
-            line = *(m_font+(data * 5)+i);
-            for (int8_t j = 0; j<8; j++) {
-                if (line & 0x1) {
-                    if (size == 1) // default size
-                        drawPixel (x+i, y+j, color);
-                    else {  // big size
-                        fillRect (x+(i*size), y+(j*size), size, size, color);
-                    }
-                } else if (bg != color) {
-                    if (size == 1) // default size
-                        drawPixel (x+i, y+j, bg);
-                    else {  // big size
-                        fillRect (x+i*size, y+j*size, size, size, bg);
-                    }
-                }
-                line >>= 1;
-            }
-        }
-    }
+    // the font's blank sixth column is not drawn
+    rasterGlyph(x, y, m_font + (data * 5), color, bg, size, 5);
+}
+
+void
+GFX::drawImage (int16_t x, int16_t y, const uint8_t * pixels, int16_t w, int16_t h,
+                Raster::IMAGE_FORMAT_T format, uint8_t scale) {
+    rasterImage(x, y, pixels, w, h, w * imageBytesPerPixel(format), format, scale);
+}
+
+void
+GFX::drawImage (int16_t x, int16_t y, RasterImage & image, uint8_t scale) {
+    rasterImage(x, y, image.pixels(), image.width(), image.height(),
+                image.stride(), image.format(), scale);
+}
+
+void
+GFX::drawImage (int16_t x, int16_t y, std::string filename, uint8_t scale) {
+    RasterImage image(filename);
+    drawImage(x, y, image, scale);
 }
 
 void
 GFX::print (std::string msg) {
+    // the characters of the current line, drawn as one run
+    std::string run;
+    int16_t runX = m_cursorX;
+    int16_t runY = m_cursorY;
     int len = msg.length();
 
     for (int idx = 0; idx < len; idx++) {
         if (msg[idx] == '\n') {
-            m_cursorY += m_textSize * 8;
+            rasterText(runX, runY, m_textFont, (const unsigned char *)run.data(),
+                       run.size(), m_textColor, m_textBGColor, m_textSize);
+            run.clear();
+
+            m_cursorY += m_textSize * m_textFont->height;
             m_cursorX  = 0;
         } else if (msg[idx] == '\r') {
             // skip em
         } else {
-            drawChar(m_cursorX, m_cursorY, msg[idx], m_textColor, m_textBGColor, m_textSize);
-            m_cursorX += m_textSize * 6;
-            if (m_wrap && ((m_cursorX + m_textSize * 6) >= m_width)) {
-                m_cursorY += m_textSize * 8;
+            if (run.empty()) {
+                runX = m_cursorX;
+                runY = m_cursorY;
+            }
+            run += msg[idx];
+
+            int16_t advance = m_textSize * glyphAdvance(m_textFont, msg[idx]);
+            m_cursorX += advance;
+            if (m_wrap && ((m_cursorX + advance) >= m_width)) {
+                rasterText(runX, runY, m_textFont, (const unsigned char *)run.data(),
+                           run.size(), m_textColor, m_textBGColor, m_textSize);
+                run.clear();
+
+                m_cursorY += m_textSize * m_textFont->height;
                 m_cursorX = 0;
             }
         }
     }
+
+    rasterText(runX, runY, m_textFont, (const unsigned char *)run.data(),
+               run.size(), m_textColor, m_textBGColor, m_textSize);
+}
+
+void
+GFX::setFont (const Raster::FONT_T * font) {
+    m_textFont = font ? font : &m_classicFont;
 }
@@ -30,6 +30,8 @@
 #include <unistd.h>
 #include <stdint.h>
 
+#include "raster.h"
+
 #define swap(a, b) { int16_t t = a; a = b; b = t; }
 
 namespace upm {
@@ -295,9 +297,11 @@ const unsigned char font[] = {
 /**
  * @brief GFX helper class
  *
- * This file is used by the screen.
+ * This file is used by the screen. The primitives are rasterized by
+ * upm::Raster into clipped blocks, which the screen fills with
+ * fillBlock().
  */
-class GFX {
+class GFX : protected Raster {
     public:
         /**
          * Instantiates a GFX object
@@ -340,12 +344,58 @@ class GFX {
         void drawChar (int16_t x, int16_t y, uint8_t data, uint16_t color, uint16_t bg, uint8_t size);
 
         /**
-         * Prints a message on the screen
+         * Draws an image from memory, such as a decoded camera frame.
+         * Images in RGB565 (high byte first) are copied straight from the
+         * buffer; other formats are converted a few rows at a time.
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param pixels First pixel of the top row
+         * @param w Width of the image
+         * @param h Height of the image
+         * @param format Pixel format of the image
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, const uint8_t * pixels, int16_t w, int16_t h,
+                        Raster::IMAGE_FORMAT_T format = Raster::IMAGE_RGB565, uint8_t scale = 1);
+
+        /**
+         * Draws a memory mapped image, see RasterImage
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param image The image
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, RasterImage & image, uint8_t scale = 1);
+
+        /**
+         * Draws a BMP file (uncompressed 16, 24 or 32 bit). The file is
+         * memory mapped, not read.
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param filename The BMP file
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, std::string filename, uint8_t scale = 1);
+
+        /**
+         * Prints a message on the screen. The characters of each line
+         * are composed from cached glyphs and sent as one block.
          *
          * @param msg Message to print
          */
         void print (std::string msg);
 
+        /**
+         * Sets the font used by print(). Fonts may be proportional, and
+         * taller than the built-in one; the line height follows the font.
+         *
+         * @param font Font, or NULL for the built-in 5x8 font
+         */
+        void setFont (const Raster::FONT_T * font);
+
         /**
          * Fills the screen with a selected color
          *
@@ -374,6 +424,27 @@ class GFX {
          */
         void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 
+        /**
+         * Draws a line on the horizontal scale
+         *
+         * @param x Axis on the horizontal scale
+         * @param y Axis on the vertical scale
+         * @param w Distanse from x
+         * @param color Selected color
+         */
+        void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+
+        /**
+         * Draws a rectangle outline
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param color Selected color
+         */
+        void drawRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
         /**
          * Draws a line from coordinate C0 to coordinate C1
          *
@@ -398,6 +469,19 @@ class GFX {
          */
         void drawTriangle (int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 
+        /**
+         * Draws a filled triangle
+         *
+         * @param x0 First coordinate
+         * @param y0 First coordinate
+         * @param x1 Second coordinate
+         * @param y1 Second coordinate
+         * @param x2 Third coordinate
+         * @param y2 Third coordinate
+         * @param color Selected color
+         */
+        void fillTriangle (int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+
         /**
          * Draws a circle
          *
@@ -408,6 +492,40 @@ class GFX {
          */
         void drawCircle (int16_t x, int16_t y, int16_t r, uint16_t color);
 
+        /**
+         * Draws a filled circle
+         *
+         * @param x Center of the circle on the horizontal scale
+         * @param y Center of the circle on the vertical scale
+         * @param r Radius of the circle
+         * @param color Color of the circle
+         */
+        void fillCircle (int16_t x, int16_t y, int16_t r, uint16_t color);
+
+        /**
+         * Draws a rectangle outline with rounded corners
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param r Radius of the corners
+         * @param color Selected color
+         */
+        void drawRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
+        /**
+         * Fills a rectangle with rounded corners
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param r Radius of the corners
+         * @param color Selected color
+         */
+        void fillRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
         /**
          * Sets the cursor for a text message
          *
@@ -439,6 +557,9 @@ class GFX {
         void setTextWrap (uint8_t wrap);
 
     protected:
+        int16_t rasterWidth () { return m_width; }
+        int16_t rasterHeight () { return m_height; }
+
         int m_width; /**< Screen width */
         int m_height; /**< Screen height */
         int m_textSize; /**< Printed text size */
@@ -449,5 +570,7 @@ class GFX {
         int m_wrap; /**< Wrapper flag (true or false) */
 
         const unsigned char * m_font;
+        Raster::FONT_T m_classicFont;
+        const Raster::FONT_T * m_textFont;
     };
 }
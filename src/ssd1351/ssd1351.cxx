@@ -37,10 +37,12 @@ using namespace std;
 
 SSD1351::SSD1351 (uint8_t oc, uint8_t dc, uint8_t rst) :
         GFX(SSD1351WIDTH, SSD1351HEIGHT),
-        m_spi(0), m_oc(oc), m_dc(dc), m_rst(rst) {
+        m_spi(0), m_oc(oc), m_dc(dc), m_rst(rst),
+        m_flush(sizeof(m_map), &SSD1351::flushFrame, this) {
 
     m_name = "SSD1351";
     m_usemap = true;
+    m_frame = m_map;
 
     // Setup SPI bus
     m_spi.frequency(8 * 1000000);
@@ -166,8 +168,8 @@ SSD1351::drawPixel(int16_t x, int16_t y, uint16_t color) {
 
       if(m_usemap) {
           int index = (y * SSD1351WIDTH + x) * 2;
-          m_map[index] = color >> 8;
-          m_map[index + 1] = color;
+          m_frame[index] = color >> 8;
+          m_frame[index + 1] = color;
       } else {
           writeCommand(SSD1351_CMD_SETCOLUMN);
           writeData(x);
@@ -182,15 +184,135 @@ SSD1351::drawPixel(int16_t x, int16_t y, uint16_t color) {
           writeData(color);
       }
 }
+
 void
-SSD1351::refresh () {
+SSD1351::setWindow (int16_t x, int16_t y, int16_t w, int16_t h) {
+    writeCommand(SSD1351_CMD_SETCOLUMN);
+    writeData(x);
+    writeData(x + w - 1);
+
+    writeCommand(SSD1351_CMD_SETROW);
+    writeData(y);
+    writeData(y + h - 1);
+
     writeCommand(SSD1351_CMD_WRITERAM);
-    int blockSize = SSD1351HEIGHT * SSD1351WIDTH * 2 / BLOCKS;
     dcHigh();
+}
+
+void
+SSD1351::fillBlock (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (m_usemap) {
+        fill565Rect(m_frame, SSD1351WIDTH * 2, x, y, w, h, color);
+        return;
+    }
+
+    setWindow(x, y, w, h);
+
+    int remaining = w * h;
+    int span = (remaining < SSD1351_SPAN_PIXELS) ? remaining : SSD1351_SPAN_PIXELS;
+    fill565(m_spanBuffer, color, span);
+
+    while (remaining > 0) {
+        int n = (remaining < span) ? remaining : span;
+        m_spi.transfer(m_spanBuffer, NULL, n * 2);
+        remaining -= n;
+    }
+}
+
+void
+SSD1351::blitBlock (int16_t x, int16_t y, int16_t w, int16_t h,
+                    const uint8_t *pixels, int stride) {
+    if (m_usemap) {
+        blit565Rect(m_frame, SSD1351WIDTH * 2, x, y, w, h, pixels, stride);
+        return;
+    }
+
+    setWindow(x, y, w, h);
+
+    if (stride == w * 2) {
+        // contiguous rows, send them as one stream
+        int remaining = w * h * 2;
+        while (remaining > 0) {
+            int n = (remaining < SSD1351_MAX_TRANSFER) ? remaining : SSD1351_MAX_TRANSFER;
+            m_spi.transfer(const_cast<uint8_t *>(pixels), NULL, n);
+            pixels += n;
+            remaining -= n;
+        }
+    } else {
+        for (int16_t row = 0; row < h; row++) {
+            m_spi.transfer(const_cast<uint8_t *>(pixels), NULL, w * 2);
+            pixels += stride;
+        }
+    }
+}
+
+void
+SSD1351::refresh () {
+    if (m_flush.isRunning()) {
+        swapBuffers();
+        return;
+    }
+
+    sendFrame(m_map);
+}
+
+void
+SSD1351::sendFrame (const uint8_t *frame) {
+    // the window may have been narrowed by unbuffered drawing
+    setWindow(0, 0, SSD1351WIDTH, SSD1351HEIGHT);
+
+    int blockSize = SSD1351HEIGHT * SSD1351WIDTH * 2 / BLOCKS;
     for (int block = 0; block < BLOCKS; block++) {
-        m_spi.write(&m_map[block * blockSize], blockSize);
+        m_spi.transfer(const_cast<uint8_t *>(&frame[block * blockSize]),
+                       NULL, blockSize);
     }
 }
+
+void
+SSD1351::flushFrame (const uint8_t *frame, void *ctx) {
+    static_cast<SSD1351 *>(ctx)->sendFrame(frame);
+}
+
+void
+SSD1351::setDoubleBuffer (bool enable) {
+    if (enable) {
+        m_usemap = true;
+        m_frame = m_flush.start(m_frame);
+    } else if (m_flush.isRunning()) {
+        m_flush.stop(m_map);
+        m_frame = m_map;
+    }
+}
+
+void
+SSD1351::swapBuffers (bool preserve) {
+    if (!m_flush.isRunning()) {
+        sendFrame(m_map);
+        return;
+    }
+
+    m_frame = m_flush.swapBuffers(preserve);
+}
+
+void
+SSD1351::setFrameRate (float fps) {
+    m_flush.setFrameRate(fps);
+}
+
+float
+SSD1351::getFrameTime () {
+    return m_flush.getFrameTime();
+}
+
+float
+SSD1351::getFlushTime () {
+    return m_flush.getFlushTime();
+}
+
+uint32_t
+SSD1351::getFrameCount () {
+    return m_flush.getFrameCount();
+}
 void
 SSD1351::ocLow() {
     if (m_oc.write(LOW) != mraa::SUCCESS) {
@@ -221,5 +343,7 @@ SSD1351::dcHigh() {
 }
 void
 upm::SSD1351::useMemoryMap(bool var) {
+    if (!var)
+        setDoubleBuffer(false);
     m_usemap = var;
 }
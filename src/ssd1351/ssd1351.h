@@ -31,6 +31,7 @@
 #include <mraa/gpio.hpp>
 #include <mraa/spi.hpp>
 #include "gfx.h"
+#include "frameflush.h"
 
 // Display Size
 #define SSD1351WIDTH 128
@@ -75,6 +76,13 @@
 // Number of blocks for SPI transfer of buffer
 #define BLOCKS              8
 
+// Pixels staged per SPI transfer by fillBlock() (one full row)
+#define SSD1351_SPAN_PIXELS SSD1351WIDTH
+
+// Largest SPI transfer used when streaming pixel data (the default
+// spidev buffer size)
+#define SSD1351_MAX_TRANSFER 4096
+
 namespace upm {
 /**
  * @brief SSD1351 OLED library
@@ -144,10 +152,59 @@ class SSD1351 : public GFX{
         void drawPixel (int16_t x, int16_t y, uint16_t color);
 
         /**
-         * Copies the buffer to the chip via the SPI bus
+         * Copies the buffer to the chip via the SPI bus. In double
+         * buffered mode, this is the same as swapBuffers().
          */
         void refresh ();
 
+        /**
+         * Enables or disables double buffering. When enabled, drawing
+         * goes to a back buffer, and swapBuffers() hands it to a
+         * background thread that sends it to the chip, so the next frame
+         * can be drawn while the current one is on the wire. Double
+         * buffering implies memory mapped writes. Apart from drawing and
+         * swapBuffers(), the chip must not be accessed while double
+         * buffering is enabled.
+         *
+         * @param enable True to enable, false to wait for the last frame
+         * and return to the single buffer
+         */
+        void setDoubleBuffer (bool enable);
+
+        /**
+         * Sends the frame drawn so far and continues with the other
+         * buffer. Blocks only while the previous frame is still being
+         * sent. Without double buffering, this is the same as refresh().
+         *
+         * @param preserve True to start the next frame as a copy of this
+         * one, false if the whole frame is redrawn every time
+         */
+        void swapBuffers (bool preserve = true);
+
+        /**
+         * Limits the rate at which double buffered frames are sent
+         *
+         * @param fps Maximum frames per second, 0 for no limit
+         */
+        void setFrameRate (float fps);
+
+        /**
+         * Returns the time between the last two swapBuffers() calls, in
+         * milliseconds
+         */
+        float getFrameTime ();
+
+        /**
+         * Returns the time spent sending the last double buffered frame,
+         * in milliseconds
+         */
+        float getFlushTime ();
+
+        /**
+         * Returns the number of double buffered frames sent
+         */
+        uint32_t getFrameCount ();
+
         /**
          * Set OLED chip select LOW
          */
@@ -169,14 +226,54 @@ class SSD1351 : public GFX{
         void dcHigh ();
 
         /**
-         * Use memory mapped (buffered) writes to the display
+         * Use memory mapped (buffered) writes to the display. Disabling
+         * them also disables double buffering.
          *
          * @param var true for yes (default), false for no
          */
         void useMemoryMap (bool var);
+
+    protected:
+        /**
+         * Fills a clipped block with a color, in the screen buffer, or
+         * without it, by opening the block as the chip's write window
+         * and streaming the pixels in full-row SPI transfers
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Width of the block
+         * @param h Height of the block
+         * @param color RGB (16-bit) color
+         */
+        void fillBlock (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+        /**
+         * Copies a clipped block of pixels, to the screen buffer, or
+         * without it, by opening the block as the chip's write window
+         * and streaming the rows in as few SPI transfers as possible
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Width of the block
+         * @param h Height of the block
+         * @param pixels First pixel of the block (RGB565, high byte first)
+         * @param stride Bytes per row of the block
+         */
+        void blitBlock (int16_t x, int16_t y, int16_t w, int16_t h,
+                        const uint8_t *pixels, int stride);
+
     private:
+        // open a block as the chip's write window, ready for pixel data
+        void setWindow (int16_t x, int16_t y, int16_t w, int16_t h);
+
+        // send a complete frame to the chip
+        void sendFrame (const uint8_t *frame);
+        static void flushFrame (const uint8_t *frame, void *ctx);
+
         mraa::Spi       m_spi;
         uint8_t         m_map[SSD1351HEIGHT * SSD1351WIDTH * 2]; /**< Screen buffer */
+        uint8_t *       m_frame; // where drawing goes, m_map or the back buffer
+        uint8_t         m_spanBuffer[SSD1351_SPAN_PIXELS * 2];
         bool            m_usemap;
 
         mraa::Gpio      m_oc;
@@ -184,5 +281,7 @@ class SSD1351 : public GFX{
         mraa::Gpio      m_rst;
 
         std::string     m_name;
+
+        FrameFlush      m_flush;
 };
 }
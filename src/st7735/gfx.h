@@ -29,6 +29,7 @@
 #include <stdint.h>
 
 #include <mraa.hpp>
+#include "raster.h"
 
 #define swap(a, b) { int16_t t = a; a = b; b = t; }
 
@@ -37,9 +38,10 @@ namespace upm {
 /**
  * @brief GFX helper class
  *
- * This file is used by the screen.
+ * This file is used by the screen. The primitives are rasterized by
+ * upm::Raster into clipped blocks, filled directly in the screen buffer.
  */
-class GFX {
+class GFX : protected Raster {
     public:
         /**
          * Instantiates a GFX object
@@ -94,12 +96,58 @@ class GFX {
         void drawChar (int16_t x, int16_t y, uint8_t data, uint16_t color, uint16_t bg, uint8_t size);
 
         /**
-         * Prints a message on the screen
+         * Draws an image from memory, such as a decoded camera frame.
+         * Images in RGB565 (high byte first) are copied straight from the
+         * buffer; other formats are converted a few rows at a time.
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param pixels First pixel of the top row
+         * @param w Width of the image
+         * @param h Height of the image
+         * @param format Pixel format of the image
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, const uint8_t * pixels, int16_t w, int16_t h,
+                        Raster::IMAGE_FORMAT_T format = Raster::IMAGE_RGB565, uint8_t scale = 1);
+
+        /**
+         * Draws a memory mapped image, see RasterImage
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param image The image
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, RasterImage & image, uint8_t scale = 1);
+
+        /**
+         * Draws a BMP file (uncompressed 16, 24 or 32 bit). The file is
+         * memory mapped, not read.
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param filename The BMP file
+         * @param scale Integer scale factor
+         */
+        void drawImage (int16_t x, int16_t y, std::string filename, uint8_t scale = 1);
+
+        /**
+         * Prints a message on the screen. The characters of each line
+         * are composed from cached glyphs and copied as one block.
          *
          * @param msg Message to print
          */
         void print (std::string msg);
 
+        /**
+         * Sets the font used by print(). Fonts may be proportional, and
+         * taller than the built-in one; the line height follows the font.
+         *
+         * @param font Font, or NULL for the built-in 5x8 font
+         */
+        void setFont (const Raster::FONT_T * font);
+
         /**
          * Prints a message on the screen
          *
@@ -137,6 +185,27 @@ class GFX {
          */
         void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 
+        /**
+         * Draws a line on the horizontal scale
+         *
+         * @param x Axis on the horizontal scale
+         * @param y Axis on the vertical scale
+         * @param w Distanse from x
+         * @param color Selected color
+         */
+        void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+
+        /**
+         * Draws a rectangle outline
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param color Selected color
+         */
+        void drawRect (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
         /**
          * Draws a line from coordinate C0 to coordinate C1
          *
@@ -161,6 +230,19 @@ class GFX {
          */
         void drawTriangle (int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 
+        /**
+         * Draws a filled triangle
+         *
+         * @param x0 First coordinate
+         * @param y0 First coordinate
+         * @param x1 Second coordinate
+         * @param y1 Second coordinate
+         * @param x2 Third coordinate
+         * @param y2 Third coordinate
+         * @param color Selected color
+         */
+        void fillTriangle (int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+
         /**
          * Draws a circle
          *
@@ -171,6 +253,40 @@ class GFX {
          */
         void drawCircle (int16_t x, int16_t y, int16_t r, uint16_t color);
 
+        /**
+         * Draws a filled circle
+         *
+         * @param x Center of the circle on the horizontal scale
+         * @param y Center of the circle on the vertical scale
+         * @param r Radius of the circle
+         * @param color Color of the circle
+         */
+        void fillCircle (int16_t x, int16_t y, int16_t r, uint16_t color);
+
+        /**
+         * Draws a rectangle outline with rounded corners
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param r Radius of the corners
+         * @param color Selected color
+         */
+        void drawRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
+        /**
+         * Fills a rectangle with rounded corners
+         *
+         * @param x Axis on the horizontal scale (top-left corner)
+         * @param y Axis on the vertical scale (top-left corner)
+         * @param w Distanse from x
+         * @param h Distanse from y
+         * @param r Radius of the corners
+         * @param color Selected color
+         */
+        void fillRoundRect (int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+
         /**
          * Sets the cursor for a text message
          *
@@ -213,7 +329,15 @@ class GFX {
         uint8_t * m_map; /**< Screens buffer */
 
     protected:
+        // Raster interface, drawing into m_map
+        void fillBlock (int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+        int16_t rasterWidth () { return m_width; }
+        int16_t rasterHeight () { return m_height; }
+        void blitBlock (int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t * pixels, int stride);
+
         const int16_t   WIDTH, HEIGHT;
         const unsigned char * m_font;
+        Raster::FONT_T m_classicFont;
+        const Raster::FONT_T * m_textFont;
     };
 }
@@ -36,7 +36,8 @@ using namespace upm;
 
 ST7735::ST7735 (uint8_t csLCD, uint8_t cSD, uint8_t rs, uint8_t rst)
     : GFX (160, 128, m_map, font), m_csLCDPinCtx(csLCD), m_cSDPinCtx(cSD),
-      m_rSTPinCtx(rst), m_rSPinCtx(rs), m_spi(0) {
+      m_rSTPinCtx(rst), m_rSPinCtx(rs), m_spi(0),
+      m_flush(sizeof(m_map), &ST7735::flushFrame, this) {
 
       initModule ();
     configModule ();
@@ -153,12 +154,69 @@ ST7735::drawPixel(int16_t x, int16_t y, uint16_t color) {
 
 void
 ST7735::refresh () {
+    if (m_flush.isRunning()) {
+        swapBuffers ();
+        return;
+    }
+
+    sendFrame (m_map);
+}
+
+void
+ST7735::sendFrame (const uint8_t *frame) {
     rsHIGH ();
 
     int fragmentSize = m_height * m_width * 2 / 20;
     for (int fragment = 0; fragment < 20; fragment++) {
-        m_spi.write(&m_map[fragment * fragmentSize], fragmentSize);
+        m_spi.transfer(const_cast<uint8_t *>(&frame[fragment * fragmentSize]),
+                       NULL, fragmentSize);
+    }
+}
+
+void
+ST7735::flushFrame (const uint8_t *frame, void *ctx) {
+    static_cast<ST7735 *>(ctx)->sendFrame (frame);
+}
+
+void
+ST7735::setDoubleBuffer (bool enable) {
+    // GFX::m_map is where drawing goes, m_map the single buffer
+    if (enable) {
+        GFX::m_map = m_flush.start (GFX::m_map);
+    } else if (m_flush.isRunning()) {
+        m_flush.stop (m_map);
+        GFX::m_map = m_map;
+    }
+}
+
+void
+ST7735::swapBuffers (bool preserve) {
+    if (!m_flush.isRunning()) {
+        sendFrame (m_map);
+        return;
     }
+
+    GFX::m_map = m_flush.swapBuffers (preserve);
+}
+
+void
+ST7735::setFrameRate (float fps) {
+    m_flush.setFrameRate (fps);
+}
+
+float
+ST7735::getFrameTime () {
+    return m_flush.getFrameTime ();
+}
+
+float
+ST7735::getFlushTime () {
+    return m_flush.getFlushTime ();
+}
+
+uint32_t
+ST7735::getFrameCount () {
+    return m_flush.getFrameCount ();
 }
 
 void
@@ -34,6 +34,7 @@
 
 #include <mraa/spi.hpp>
 #include "gfx.h"
+#include "frameflush.h"
 
 #define INITR_GREENTAB      0x0
 #define INITR_REDTAB        0x1
@@ -589,10 +590,58 @@ class ST7735 : public GFX {
         void drawPixel (int16_t x, int16_t y, uint16_t color);
 
         /**
-         * Copies the buffer to the chip via the SPI.
+         * Copies the buffer to the chip via the SPI. In double buffered
+         * mode, this is the same as swapBuffers().
          */
         void refresh ();
 
+        /**
+         * Enables or disables double buffering. When enabled, drawing
+         * goes to a back buffer, and swapBuffers() hands it to a
+         * background thread that sends it to the chip, so the next frame
+         * can be drawn while the current one is on the wire. Apart from
+         * drawing and swapBuffers(), the chip must not be accessed while
+         * double buffering is enabled.
+         *
+         * @param enable True to enable, false to wait for the last frame
+         * and return to the single buffer
+         */
+        void setDoubleBuffer (bool enable);
+
+        /**
+         * Sends the frame drawn so far and continues with the other
+         * buffer. Blocks only while the previous frame is still being
+         * sent. Without double buffering, this is the same as refresh().
+         *
+         * @param preserve True to start the next frame as a copy of this
+         * one, false if the whole frame is redrawn every time
+         */
+        void swapBuffers (bool preserve = true);
+
+        /**
+         * Limits the rate at which double buffered frames are sent
+         *
+         * @param fps Maximum frames per second, 0 for no limit
+         */
+        void setFrameRate (float fps);
+
+        /**
+         * Returns the time between the last two swapBuffers() calls, in
+         * milliseconds
+         */
+        float getFrameTime ();
+
+        /**
+         * Returns the time spent sending the last double buffered frame,
+         * in milliseconds
+         */
+        float getFlushTime ();
+
+        /**
+         * Returns the number of double buffered frames sent
+         */
+        uint32_t getFrameCount ();
+
         /**
          * LCD chip select is LOW
          */
@@ -634,6 +683,12 @@ class ST7735 : public GFX {
         mraa::Gpio     m_rSPinCtx;
 
         std::string    m_name;
+
+        FrameFlush     m_flush;
+
+        // send a complete frame to the chip
+        void sendFrame (const uint8_t *frame);
+        static void flushFrame (const uint8_t *frame, void *ctx);
 };
 
 }
@@ -72,6 +72,12 @@ upm::TM1637::TM1637(int clk_pin, int dio_pin, int bright, M_FAST_GPIO mmio) {
 
     mraa_gpio_write(m_clk, 0);
     mraa_gpio_write(m_dio, 0);
+    m_clkLevel = 0;
+    m_dioLevel = 0;
+    m_seqLen = 0;
+
+    m_autoUpdate = true;
+    m_synced = false;
 
     for (int i = 0; i < M_DISPLAY_DIGITS; i++) {
         m_digits[i] = 0x00;
@@ -82,7 +88,7 @@ upm::TM1637::~TM1637() {
     for (int i = 0; i < M_DISPLAY_DIGITS; i++) {
         m_digits[i] = 0x00;
     }
-    update();
+    update(true);
 
     mraa_gpio_close(m_clk);
     mraa_gpio_close(m_dio);
@@ -91,7 +97,7 @@ mraa_result_t upm::TM1637::write(uint8_t *digits) {
     for (int i = 0; i < M_DISPLAY_DIGITS; i++) {
         m_digits[i] = digits[i];
     }
-    update();
+    changed();
     return MRAA_SUCCESS;
 }
 mraa_result_t upm::TM1637::write(int d, ...) {
@@ -104,7 +110,7 @@ mraa_result_t upm::TM1637::write(int d, ...) {
         d++;
     }
     va_end(args);
-    update();
+    changed();
     return MRAA_SUCCESS;
 }
 mraa_result_t upm::TM1637::writeAt(int index, char symbol) {
@@ -113,7 +119,7 @@ mraa_result_t upm::TM1637::writeAt(int index, char symbol) {
         return MRAA_ERROR_INVALID_PARAMETER;
     }
     m_digits[index] = encode(symbol);
-    update();
+    changed();
     return MRAA_SUCCESS;
 }
 mraa_result_t upm::TM1637::write(std::string digits) {
@@ -124,7 +130,7 @@ mraa_result_t upm::TM1637::write(std::string digits) {
     for (int i = 0; i < len; i++) {
         m_digits[i] = encode(digits[i]);
     }
-    update();
+    changed();
     return MRAA_SUCCESS;
 }
 void upm::TM1637::setColon(bool value) {
@@ -134,55 +140,102 @@ void upm::TM1637::setColon(bool value) {
     else{
        m_digits[1] &= 0x7f;
     }
-    update();
+    changed();
 }
 void upm::TM1637::setBrightness(int value) {
     m_brightness = value & 0x07;
-    update();
+    changed();
+}
+void upm::TM1637::pinWrite(int pin, int level) {
+    m_seq[m_seqLen++] = (pin << 1) | level;
 }
 void upm::TM1637::i2c_start() {
-    mraa_gpio_write(m_clk, 1);
-    mraa_gpio_write(m_dio, 1);
-    mraa_gpio_write(m_dio, 0);
+    pinWrite(0, 1);
+    pinWrite(1, 1);
+    pinWrite(1, 0);
 }
 void upm::TM1637::i2c_stop() {
-    mraa_gpio_write(m_clk, 0);
-    mraa_gpio_write(m_dio, 0);
-    mraa_gpio_write(m_clk, 1);
-    mraa_gpio_write(m_dio, 1);
+    pinWrite(0, 0);
+    pinWrite(1, 0);
+    pinWrite(0, 1);
+    pinWrite(1, 1);
 }
 void upm::TM1637::i2c_writeByte(uint8_t value) {
     for(uint8_t i = 0; i < 8; i++)
     {
-        mraa_gpio_write(m_clk, 0);
-        if(value & 0x01)
-            mraa_gpio_write(m_dio, 1);
-        else
-            mraa_gpio_write(m_dio, 0);
+        pinWrite(0, 0);
+        pinWrite(1, value & 0x01);
         value >>= 1;
-        mraa_gpio_write(m_clk, 1);
+        pinWrite(0, 1);
     }
 
     // Ack clock without skew, TM1637 is fast enough
-    mraa_gpio_write(m_clk, 0);
-    mraa_gpio_write(m_clk, 1);
-    mraa_gpio_write(m_clk, 0);
+    pinWrite(0, 0);
+    pinWrite(0, 1);
+    pinWrite(0, 0);
 }
-void upm::TM1637::update() {
-    i2c_start();
-    i2c_writeByte(TM1637_ADDR);
-    i2c_stop();
+void upm::TM1637::flushSeq() {
+    // clock out the prepared writes, skipping those that would leave
+    // a pin at the level it already has
+    for (int i = 0; i < m_seqLen; i++) {
+        int level = m_seq[i] & 0x01;
 
-    i2c_start();
-    i2c_writeByte(TM1637_REG);
-    for (int i = 0; i < M_DISPLAY_DIGITS; i++) {
-        i2c_writeByte(m_digits[i]);
+        if (m_seq[i] & 0x02) {
+            if (level != m_dioLevel) {
+                mraa_gpio_write(m_dio, level);
+                m_dioLevel = level;
+            }
+        } else {
+            if (level != m_clkLevel) {
+                mraa_gpio_write(m_clk, level);
+                m_clkLevel = level;
+            }
+        }
+    }
+    m_seqLen = 0;
+}
+void upm::TM1637::changed() {
+    if (m_autoUpdate)
+        update();
+}
+void upm::TM1637::update(bool force) {
+    if (!m_synced)
+        force = true;
+
+    // find the span of digits that changed
+    int first = 0;
+    int last = M_DISPLAY_DIGITS - 1;
+    if (!force) {
+        while (first <= last && m_digits[first] == m_sent[first])
+            first++;
+        while (last >= first && m_digits[last] == m_sent[last])
+            last--;
+    }
+
+    if (first <= last) {
+        // auto-incrementing addresses, starting at the first change
+        i2c_start();
+        i2c_writeByte(TM1637_ADDR);
+        i2c_stop();
+
+        i2c_start();
+        i2c_writeByte(TM1637_REG + first);
+        for (int i = first; i <= last; i++) {
+            i2c_writeByte(m_digits[i]);
+            m_sent[i] = m_digits[i];
+        }
+        i2c_stop();
+    }
+
+    if (force || m_brightness != m_sentBrightness) {
+        i2c_start();
+        i2c_writeByte(TM1637_CMD | m_brightness);
+        i2c_stop();
+        m_sentBrightness = m_brightness;
     }
-    i2c_stop();
 
-    i2c_start();
-    i2c_writeByte(TM1637_CMD | m_brightness);
-    i2c_stop();
+    flushSeq();
+    m_synced = true;
 }
 uint8_t upm::TM1637::encode(char c) {
     if(c >= '0' && c <= '9')
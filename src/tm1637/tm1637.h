@@ -37,6 +37,9 @@
 #define TM1637_REG     0xC0
 #define TM1637_CMD     0x88
 
+// Maximum number of pin writes in one prepared transaction
+#define TM1637_MAX_SEQ 256
+
 // Display-specific values
 #define M_DISPLAY_DIGITS  4
 
@@ -66,6 +69,18 @@ namespace upm
  * digits, thus making it ideal for clock displays, timers, counters, or even
  * score displays in a two-player arcade game.
  *
+ * The driver keeps a copy of what the display currently shows, and an
+ * update only sends the span of digits that changed, and the
+ * brightness only when it changed.  The pin writes of a whole update
+ * are prepared in a buffer first, then clocked out in one tight loop
+ * that skips writes leaving a pin at its current level.  With
+ * memory-mapped GPIO this runs at the rate of the GPIO writes.
+ *
+ * By default, every write updates the display right away.  With
+ * setAutoUpdate(false), writes only change the buffer, and the
+ * display is updated by update(), so that several changes go out in
+ * a single transaction.
+ *
  * @image html tm1637.jpeg
  * @snippet tm1637.cxx Interesting
  */
@@ -134,17 +149,46 @@ namespace upm
        * @param value Brightness, from 0 (darkest) to 7 (brightest)
        */
       void setBrightness(int value);
+      /**
+       * Selects whether the write functions update the display
+       * immediately (the default), or only change the buffered
+       * digits until update() is called
+       *
+       * @param enable True to update on every write
+       */
+      void setAutoUpdate(bool enable) { m_autoUpdate = enable; };
+      /**
+       * Sends the buffered digits and brightness to the display.
+       * Only what changed since the last update is sent.
+       *
+       * @param force True to resend everything
+       */
+      void update(bool force = false);
 
   private:
       void i2c_start();
       void i2c_stop();
       void i2c_writeByte(uint8_t value);
-      void update();
+      void changed();
+      void pinWrite(int pin, int level);
+      void flushSeq();
       uint8_t encode(char c);
 
       mraa_gpio_context m_clk, m_dio;
       std::string m_name;
       uint8_t m_digits[4];
       uint8_t m_brightness;
+
+      bool m_autoUpdate;
+      // what the display currently shows
+      bool m_synced;
+      uint8_t m_sent[M_DISPLAY_DIGITS];
+      uint8_t m_sentBrightness;
+
+      // prepared pin writes, each (pin << 1) | level, pin 0 is CLK
+      uint8_t m_seq[TM1637_MAX_SEQ];
+      int m_seqLen;
+      // current levels of the pins
+      int m_clkLevel, m_dioLevel;
   };
 }
@@ -1,6 +1,9 @@
 %module javaupm_wheelencoder
 %include "../upm.i"
 
+// Java users should poll the rate methods instead
+%ignore setCountCallback;
+
 %{
     #include "wheelencoder.h"
 %}
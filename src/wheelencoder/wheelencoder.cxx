@@ -39,6 +39,7 @@ WheelEncoder::WheelEncoder(int pin) :
 
   initClock();
   m_counter = 0;
+  m_edges.reset();
   m_isrInstalled = false;
 }
 
@@ -49,35 +50,12 @@ WheelEncoder::~WheelEncoder()
 
 void WheelEncoder::initClock()
 {
-  gettimeofday(&m_startTime, NULL);
+  m_startTime = EdgeRate::now();
 }
 
 uint32_t WheelEncoder::getMillis()
 {
-  struct timeval elapsed, now;
-  uint32_t elapse;
-
-  // get current time
-  gettimeofday(&now, NULL);
-
-  // compute the delta since m_startTime
-  if( (elapsed.tv_usec = now.tv_usec - m_startTime.tv_usec) < 0 ) 
-    {
-      elapsed.tv_usec += 1000000;
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec - 1;
-    } 
-  else 
-    {
-      elapsed.tv_sec = now.tv_sec - m_startTime.tv_sec;
-    }
-
-  elapse = (uint32_t)((elapsed.tv_sec * 1000) + (elapsed.tv_usec / 1000));
-
-  // never return 0
-  if (elapse == 0)
-    elapse = 1;
-
-  return elapse;
+  return EdgeRate::elapsedMillis(m_startTime);
 }
 
 void WheelEncoder::startCounter()
@@ -105,5 +83,6 @@ void WheelEncoder::wheelISR(void *ctx)
 {
   upm::WheelEncoder *This = (upm::WheelEncoder *)ctx;
   This->m_counter++;
+  This->m_edges.edge();
 }
 
@@ -25,9 +25,13 @@
 
 #include <string>
 #include <stdint.h>
-#include <sys/time.h>
 #include <mraa/gpio.hpp>
 
+#include "edgerate.h"
+
+// Default window for windowRate(), in milliseconds
+#define WHEELENCODER_DEFAULT_WINDOW 1000
+
 namespace upm {
 
   /**
@@ -96,7 +100,7 @@ namespace upm {
      * stopped via stopCounter() prior to calling this function.
      *
      */
-    void clearCounter() { m_counter = 0; };
+    void clearCounter() { m_counter = 0; m_edges.reset(); };
 
     /**
      * Starts the counter.  This function will also clear the current
@@ -118,13 +122,48 @@ namespace upm {
      */
     uint32_t counter() { return m_counter; };
 
+    /**
+     * Computes the count rate from the interval between the last two
+     * counts, so it follows speed changes within one count.
+     *
+     * @return Counts per second, 0 until two counts were seen
+     */
+    float instantRate() { return m_edges.instantRate(); };
+
+    /**
+     * Computes the average count rate over the counts of the last
+     * windowMs milliseconds
+     *
+     * @param windowMs Window length in milliseconds
+     * @return Counts per second, 0 until two counts were seen in the
+     * window
+     */
+    float windowRate(uint32_t windowMs=WHEELENCODER_DEFAULT_WINDOW)
+    {
+      return m_edges.windowRate(windowMs);
+    };
+
+    /**
+     * Installs a function to be called on every count, from the
+     * interrupt thread.  The timestamp passed to it is in
+     * microseconds on the monotonic clock.
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setCountCallback(EdgeRate::EDGE_CALLBACK_T func, void *arg)
+    {
+      m_edges.setCallback(func, arg);
+    };
+
   protected:
     mraa::Gpio m_gpio;
     static void wheelISR(void *ctx);
 
   private:
     volatile uint32_t m_counter;
-    struct timeval m_startTime;
+    uint64_t m_startTime;
+    EdgeRate m_edges;
     bool m_isrInstalled;
   };
 }
@@ -3,6 +3,10 @@
 %include "carrays.i"
 %include "std_string.i"
 
+// Java users should poll getFrameStatus() instead
+%ignore setFrameCallback;
+%ignore setStatusCallback;
+
 %{
     #include "xbee.h"
 %}
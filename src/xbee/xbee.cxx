@@ -23,6 +23,8 @@
  */
 
 #include <iostream>
+#include <stdexcept>
+#include <stdio.h>
 #include <time.h>
 
 #include "xbee.h"
@@ -32,9 +34,49 @@ using namespace std;
 
 static const int maxBuffer = 1024;
 
+// API frame start delimiter, and the other bytes escaped in
+// API_MODE_ESCAPED
+#define XBEE_START      0x7e
+#define XBEE_ESCAPE     0x7d
+#define XBEE_XON        0x11
+#define XBEE_XOFF       0x13
+
+static uint64_t getMillis()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t(ts.tv_sec) * 1000) + (ts.tv_nsec / 1000000);
+}
+
+// store a big endian 64-bit address
+static void putAddr64(uint8_t *buf, uint64_t addr)
+{
+  for (int i=7; i>=0; i--)
+    {
+      buf[i] = addr & 0xff;
+      addr >>= 8;
+    }
+}
+
 XBee::XBee(int uart) :
   m_uart(uart)
 {
+  m_apiMode = API_MODE_TRANSPARENT;
+
+  m_rxLen = 0;
+  m_rxEscape = false;
+  m_rxErrors = 0;
+
+  m_nextFrameId = 1;
+  for (int i=0; i<256; i++)
+    m_frameStatus[i] = XBEE_FRAME_UNUSED;
+
+  m_frameCallback = 0;
+  m_frameCallbackArg = 0;
+  m_statusCallback = 0;
+  m_statusCallbackArg = 0;
 }
 
 XBee::~XBee()
@@ -100,3 +142,446 @@ string XBee::stringCR2LF(string str)
   
   return str;
 }
+
+bool XBee::enterAPIMode(API_MODE_T mode, std::string cmdChars,
+                        int guardTimeMS)
+{
+  if (!commandMode(cmdChars, guardTimeMS))
+    return false;
+
+  // set the mode and leave command mode in one line
+  char cmd[16];
+  snprintf(cmd, sizeof(cmd), "ATAP%d,CN\r", int(mode));
+
+  writeDataStr(cmd);
+
+  string resp;
+  while (dataAvailable(guardTimeMS))
+    resp += readDataStr(maxBuffer);
+
+  // one OK for each command
+  size_t first = resp.find("OK");
+  if (first == string::npos || resp.find("OK", first + 2) == string::npos)
+    return false;
+
+  setAPIMode(mode);
+
+  return true;
+}
+
+void XBee::setAPIMode(API_MODE_T mode)
+{
+  m_apiMode = mode;
+
+  m_rxLen = 0;
+  m_rxEscape = false;
+}
+
+uint8_t XBee::allocFrameId()
+{
+  // frame ID 0 means no status, so IDs cycle through 1-255.  If all
+  // of them are pending, the oldest one is reused.
+  uint8_t id = m_nextFrameId;
+
+  for (int i=0; i<255; i++)
+    {
+      uint8_t candidate = ((m_nextFrameId - 1 + i) % 255) + 1;
+
+      if (m_frameStatus[candidate] != XBEE_FRAME_PENDING)
+        {
+          id = candidate;
+          break;
+        }
+    }
+
+  m_nextFrameId = (id % 255) + 1;
+  m_frameStatus[id] = XBEE_FRAME_PENDING;
+
+  return id;
+}
+
+int XBee::sendFrame(uint8_t type, const uint8_t *data, int len,
+                    bool wantStatus)
+{
+  return writeFrame(type, wantStatus, 0, 0, data, len);
+}
+
+int XBee::writeFrame(uint8_t type, bool wantStatus,
+                     const uint8_t *hdr, int hdrLen,
+                     const uint8_t *data, int len)
+{
+  if (m_apiMode == API_MODE_TRANSPARENT)
+    {
+      throw std::logic_error(std::string(__FUNCTION__) +
+                             ": the device is not in API mode");
+      return -1;
+    }
+
+  // type and frame ID come before the header and data
+  int frameLen = hdrLen + len + 2;
+
+  if (len < 0 || frameLen > XBEE_MAX_FRAME_SIZE)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": frame data too long");
+      return -1;
+    }
+
+  uint8_t frameId = (wantStatus) ? allocFrameId() : 0;
+  bool escape = (m_apiMode == API_MODE_ESCAPED);
+
+  // The frame is escaped directly from the caller's buffers into
+  // m_txBuf, and written with one call, so that frames can be queued
+  // back to back without waiting for the UART to drain.
+  int pos = 0;
+  uint8_t sum = 0;
+
+  m_txBuf[pos++] = XBEE_START;
+
+  for (int i=-4; i<=hdrLen + len; i++)
+    {
+      uint8_t c;
+
+      if (i == -4)
+        c = (frameLen >> 8) & 0xff;
+      else if (i == -3)
+        c = frameLen & 0xff;
+      else if (i == -2)
+        c = type;
+      else if (i == -1)
+        c = frameId;
+      else if (i < hdrLen)
+        c = hdr[i];
+      else if (i < hdrLen + len)
+        c = data[i - hdrLen];
+      else
+        c = 0xff - sum;
+
+      // the checksum covers the frame data only
+      if (i >= -2 && i < hdrLen + len)
+        sum += c;
+
+      if (escape && (c == XBEE_START || c == XBEE_ESCAPE ||
+                     c == XBEE_XON || c == XBEE_XOFF))
+        {
+          m_txBuf[pos++] = XBEE_ESCAPE;
+          c ^= 0x20;
+        }
+
+      m_txBuf[pos++] = c;
+    }
+
+  if (m_uart.write((char *)m_txBuf, pos) != pos)
+    {
+      if (frameId)
+        m_frameStatus[frameId] = XBEE_FRAME_UNUSED;
+
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": uart write failed");
+      return -1;
+    }
+
+  return frameId;
+}
+
+int XBee::transmit64(uint64_t addr64, const uint8_t *data, int len,
+                     uint8_t options)
+{
+  uint8_t hdr[9];
+
+  putAddr64(hdr, addr64);
+  hdr[8] = options;
+
+  return writeFrame(FRAME_TX64, true, hdr, sizeof(hdr), data, len);
+}
+
+int XBee::transmitRequest(uint64_t addr64, uint16_t addr16,
+                          const uint8_t *data, int len,
+                          uint8_t radius, uint8_t options)
+{
+  uint8_t hdr[12];
+
+  putAddr64(hdr, addr64);
+  hdr[8] = (addr16 >> 8) & 0xff;
+  hdr[9] = addr16 & 0xff;
+  hdr[10] = radius;
+  hdr[11] = options;
+
+  return writeFrame(FRAME_TX_REQUEST, true, hdr, sizeof(hdr), data, len);
+}
+
+int XBee::transmitRequestStr(uint64_t addr64, std::string data,
+                             uint16_t addr16)
+{
+  return transmitRequest(addr64, addr16, (const uint8_t *)data.data(),
+                         data.size());
+}
+
+int XBee::sendATCommand(std::string cmd, std::string param, bool queue)
+{
+  if (cmd.size() != 2)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": command must be 2 characters");
+      return -1;
+    }
+
+  uint8_t hdr[2];
+
+  hdr[0] = cmd[0];
+  hdr[1] = cmd[1];
+
+  return writeFrame((queue) ? FRAME_AT_QUEUE : FRAME_AT_COMMAND, true,
+                    hdr, sizeof(hdr), (const uint8_t *)param.data(),
+                    param.size());
+}
+
+int XBee::sendRemoteATCommand(uint64_t addr64, uint16_t addr16,
+                              std::string cmd, std::string param,
+                              bool apply)
+{
+  if (cmd.size() != 2)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": command must be 2 characters");
+      return -1;
+    }
+
+  uint8_t hdr[13];
+
+  putAddr64(hdr, addr64);
+  hdr[8] = (addr16 >> 8) & 0xff;
+  hdr[9] = addr16 & 0xff;
+  hdr[10] = (apply) ? 0x02 : 0x00;
+  hdr[11] = cmd[0];
+  hdr[12] = cmd[1];
+
+  return writeFrame(FRAME_REMOTE_AT_COMMAND, true, hdr, sizeof(hdr),
+                    (const uint8_t *)param.data(), param.size());
+}
+
+bool XBee::waitFrame(int frameId, unsigned int timeoutMs)
+{
+  uint64_t start = getMillis();
+
+  while (m_frameStatus[frameId] == XBEE_FRAME_PENDING)
+    {
+      uint64_t elapsed = getMillis() - start;
+
+      if (elapsed >= timeoutMs)
+        return false;
+
+      processInput(timeoutMs - elapsed);
+    }
+
+  return (m_frameStatus[frameId] == 0);
+}
+
+bool XBee::atCommand(std::string cmd, std::string param,
+                     unsigned int timeoutMs)
+{
+  m_atResponse.clear();
+
+  return waitFrame(sendATCommand(cmd, param), timeoutMs);
+}
+
+bool XBee::remoteATCommand(uint64_t addr64, uint16_t addr16,
+                           std::string cmd, std::string param,
+                           unsigned int timeoutMs)
+{
+  m_atResponse.clear();
+
+  return waitFrame(sendRemoteATCommand(addr64, addr16, cmd, param),
+                   timeoutMs);
+}
+
+int XBee::processInput(unsigned int millis)
+{
+  int frames = 0;
+
+  // in transparent mode, the data belongs to the application
+  if (m_apiMode == API_MODE_TRANSPARENT)
+    return 0;
+
+  if (!m_uart.dataAvailable(millis))
+    return 0;
+
+  bool escape = (m_apiMode == API_MODE_ESCAPED);
+
+  do
+    {
+      // new bytes are read right after the partial frame, and
+      // unescaped and framed in place.  Decoding never produces more
+      // bytes than it consumes, so the write position w never passes
+      // the read position i.
+      int rv = m_uart.read((char *)m_rxBuf + m_rxLen,
+                           sizeof(m_rxBuf) - m_rxLen);
+      if (rv <= 0)
+        break;
+
+      int end = m_rxLen + rv;
+      int w = m_rxLen;
+
+      for (int i=m_rxLen; i<end; i++)
+        {
+          uint8_t c = m_rxBuf[i];
+
+          // look for a start delimiter
+          if (w == 0)
+            {
+              if (c == XBEE_START)
+                m_rxBuf[w++] = c;
+              continue;
+            }
+
+          if (escape)
+            {
+              // in escaped mode, a delimiter always starts a new
+              // frame, so drop the one in progress
+              if (c == XBEE_START)
+                {
+                  m_rxErrors++;
+                  m_rxEscape = false;
+                  w = 0;
+                  m_rxBuf[w++] = c;
+                  continue;
+                }
+
+              if (c == XBEE_ESCAPE)
+                {
+                  m_rxEscape = true;
+                  continue;
+                }
+
+              if (m_rxEscape)
+                {
+                  c ^= 0x20;
+                  m_rxEscape = false;
+                }
+            }
+
+          m_rxBuf[w++] = c;
+
+          if (w < 3)
+            continue;
+
+          int frameLen = (m_rxBuf[1] << 8) | m_rxBuf[2];
+
+          if (frameLen == 0 || frameLen > XBEE_MAX_FRAME_SIZE)
+            {
+              m_rxErrors++;
+              m_rxEscape = false;
+              w = 0;
+              continue;
+            }
+
+          // delimiter, length, data and checksum
+          if (w < frameLen + 4)
+            continue;
+
+          uint8_t sum = 0;
+          for (int j=3; j<w; j++)
+            sum += m_rxBuf[j];
+
+          if (sum == 0xff)
+            {
+              dispatchFrame(m_rxBuf + 3, frameLen);
+              frames++;
+            }
+          else
+            m_rxErrors++;
+
+          w = 0;
+        }
+
+      m_rxLen = w;
+    } while (m_uart.dataAvailable(0));
+
+  return frames;
+}
+
+void XBee::dispatchFrame(const uint8_t *frame, int len)
+{
+  int statusId = -1;
+  uint8_t status = 0;
+
+  switch (frame[0])
+    {
+    case FRAME_AT_RESPONSE:
+      // type, ID, command (2), status, data
+      if (len < 5)
+        break;
+      statusId = frame[1];
+      status = frame[4];
+      m_atResponse.assign((const char *)frame + 5, len - 5);
+      break;
+
+    case FRAME_REMOTE_AT_RESPONSE:
+      // type, ID, addr64 (8), addr16 (2), command (2), status, data
+      if (len < 15)
+        break;
+      statusId = frame[1];
+      status = frame[14];
+      m_atResponse.assign((const char *)frame + 15, len - 15);
+      break;
+
+    case FRAME_TX_STATUS:
+      // type, ID, status
+      if (len < 3)
+        break;
+      statusId = frame[1];
+      status = frame[2];
+      break;
+
+    case FRAME_TRANSMIT_STATUS:
+      // type, ID, addr16 (2), retries, delivery status, discovery
+      if (len < 6)
+        break;
+      statusId = frame[1];
+      status = frame[5];
+      break;
+
+    default:
+      break;
+    }
+
+  // ignore status for frame ID 0, or IDs we did not send
+  if (statusId > 0 && m_frameStatus[statusId] == XBEE_FRAME_PENDING)
+    {
+      m_frameStatus[statusId] = status;
+
+      if (m_statusCallback)
+        m_statusCallback(statusId, status, m_statusCallbackArg);
+    }
+
+  if (m_frameCallback)
+    m_frameCallback(frame, len, m_frameCallbackArg);
+}
+
+int XBee::getFrameStatus(uint8_t frameId)
+{
+  return m_frameStatus[frameId];
+}
+
+int XBee::pendingFrames()
+{
+  int count = 0;
+
+  for (int i=1; i<256; i++)
+    if (m_frameStatus[i] == XBEE_FRAME_PENDING)
+      count++;
+
+  return count;
+}
+
+void XBee::setFrameCallback(FRAME_CALLBACK_T func, void *arg)
+{
+  m_frameCallback = func;
+  m_frameCallbackArg = arg;
+}
+
+void XBee::setStatusCallback(STATUS_CALLBACK_T func, void *arg)
+{
+  m_statusCallback = func;
+  m_statusCallbackArg = arg;
+}
@@ -29,6 +29,7 @@
 #include <string>
 #include <iostream>
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -38,6 +39,17 @@
 
 #define XBEE_DEFAULT_UART 0
 
+// Largest API frame handled, counted from the frame type byte
+#define XBEE_MAX_FRAME_SIZE 2048
+
+// Default time to wait for an AT command response, in milliseconds
+#define XBEE_DEFAULT_TIMEOUT 2000
+
+// Frame status values, in addition to the status byte reported by
+// the device (0 is success)
+#define XBEE_FRAME_PENDING -1
+#define XBEE_FRAME_UNUSED  -2
+
 namespace upm {
     /**
      * @brief XBee modules
@@ -70,6 +82,19 @@ namespace upm {
      * windows software, however it is possible of course to configure
      * them manually using AT commands.  See the examples.
      *
+     * In addition to transparent mode, the API frame modes (AP=1 and
+     * AP=2, escaped) are supported.  In API mode, every transmission
+     * and local or remote AT command is a frame carrying a frame ID,
+     * so commands run without the command mode guard times, and many
+     * transmissions can be outstanding at once.  Their completion is
+     * reported by status frames, tracked per frame ID, and optionally
+     * passed to a callback.  Received frames are parsed in place in
+     * the driver's receive buffer, and handed to a callback.
+     *
+     * Incoming frames are only processed from processInput(), which
+     * must be called regularly, and from the blocking AT command
+     * methods.  Callbacks are run from within these calls.
+     *
      * @image html xbee.jpg
      * <br><em>XBee Sensor image provided by SparkFun* under
      * <a href=https://creativecommons.org/licenses/by-nc-sa/3.0/>
@@ -81,6 +106,52 @@ namespace upm {
   class XBee {
   public:
 
+    /**
+     * Operating modes, as set by the AP command
+     */
+    typedef enum {
+      API_MODE_TRANSPARENT      = 0,
+      API_MODE_API              = 1,
+      API_MODE_ESCAPED          = 2
+    } API_MODE_T;
+
+    /**
+     * API frame types
+     */
+    typedef enum {
+      FRAME_TX64                = 0x00, // 802.15.4
+      FRAME_TX16                = 0x01, // 802.15.4
+      FRAME_AT_COMMAND          = 0x08,
+      FRAME_AT_QUEUE            = 0x09,
+      FRAME_TX_REQUEST          = 0x10, // ZigBee, DigiMesh
+      FRAME_REMOTE_AT_COMMAND   = 0x17,
+      FRAME_RX64                = 0x80, // 802.15.4
+      FRAME_RX16                = 0x81, // 802.15.4
+      FRAME_AT_RESPONSE         = 0x88,
+      FRAME_TX_STATUS           = 0x89, // 802.15.4, WiFi
+      FRAME_MODEM_STATUS        = 0x8a,
+      FRAME_TRANSMIT_STATUS     = 0x8b, // ZigBee, DigiMesh
+      FRAME_RX_PACKET           = 0x90, // ZigBee, DigiMesh
+      FRAME_REMOTE_AT_RESPONSE  = 0x97
+    } FRAME_TYPE_T;
+
+    /**
+     * Callback for received API frames.  frame points to the frame
+     * type byte, followed by the rest of the frame data, without the
+     * checksum.  It points into the driver's receive buffer, and is
+     * only valid until the callback returns.
+     */
+    typedef void (*FRAME_CALLBACK_T)(const uint8_t *frame, int len,
+                                     void *arg);
+
+    /**
+     * Callback for frame completions (transmit status and AT command
+     * responses).  status is the status byte reported by the device,
+     * 0 on success.
+     */
+    typedef void (*STATUS_CALLBACK_T)(uint8_t frameId, uint8_t status,
+                                      void *arg);
+
     /**
      * XBee object constructor
      *
@@ -183,10 +254,247 @@ namespace upm {
      */
     std::string stringCR2LF(std::string str);
 
+    /**
+     * Switches the device from transparent mode into an API mode,
+     * using commandMode() once.  Once in API mode, AT commands are
+     * sent as frames with atCommand().
+     *
+     * @param mode API_MODE_API or API_MODE_ESCAPED
+     * @param cmdChars The command mode characters, default "+++"
+     * @param guardTimeMS The command mode guard time in milliseconds
+     * @return true if the device accepted the new mode
+     */
+    bool enterAPIMode(API_MODE_T mode=API_MODE_ESCAPED,
+                      std::string cmdChars="+++", int guardTimeMS=1000);
+
+    /**
+     * Tells the driver which mode the device operates in, without
+     * talking to it.  Use this when the device was already configured
+     * for API mode (for example, with X-CTU).
+     *
+     * @param mode One of the API_MODE_T values
+     */
+    void setAPIMode(API_MODE_T mode);
+
+    /**
+     * Returns the mode the driver operates in
+     *
+     * @return One of the API_MODE_T values
+     */
+    API_MODE_T getAPIMode() { return m_apiMode; };
+
+    /**
+     * Sends an API frame.  A frame ID is allocated and inserted after
+     * the frame type, so data starts with the first byte following
+     * the frame ID.  The call returns once the frame is written,
+     * without waiting for its status.
+     *
+     * @param type Frame type, one of the FRAME_TYPE_T values
+     * @param data Frame data following the frame ID
+     * @param len Length of data
+     * @param wantStatus If false, frame ID 0 is used, and the device
+     * does not report a status for the frame
+     * @return The frame ID, 0 if no status was requested
+     */
+    int sendFrame(uint8_t type, const uint8_t *data, int len,
+                  bool wantStatus=true);
+
+    /**
+     * Transmits data to a 64-bit address (802.15.4 TX64 frame)
+     *
+     * @param addr64 Destination address, 0xffff for broadcast
+     * @param data Data to transmit
+     * @param len Length of data
+     * @param options Transmit options
+     * @return The frame ID
+     */
+    int transmit64(uint64_t addr64, const uint8_t *data, int len,
+                   uint8_t options=0);
+
+    /**
+     * Transmits data to a node (ZigBee and DigiMesh transmit request
+     * frame)
+     *
+     * @param addr64 Destination 64-bit address, 0xffff for broadcast
+     * @param addr16 Destination 16-bit network address, 0xfffe if
+     * unknown
+     * @param data Data to transmit
+     * @param len Length of data
+     * @param radius Maximum number of hops, 0 for the maximum
+     * @param options Transmit options
+     * @return The frame ID
+     */
+    int transmitRequest(uint64_t addr64, uint16_t addr16,
+                        const uint8_t *data, int len,
+                        uint8_t radius=0, uint8_t options=0);
+
+    /**
+     * Transmits a string to a node with transmitRequest()
+     *
+     * @param addr64 Destination 64-bit address, 0xffff for broadcast
+     * @param data Data to transmit
+     * @param addr16 Destination 16-bit network address, 0xfffe if
+     * unknown
+     * @return The frame ID
+     */
+    int transmitRequestStr(uint64_t addr64, std::string data,
+                           uint16_t addr16=0xfffe);
+
+    /**
+     * Sends a local AT command frame, without waiting for the
+     * response.  Its status is reported like a transmission's.
+     *
+     * @param cmd The two character command, without the "AT" prefix
+     * @param param Parameter value, empty to query
+     * @param queue If true, the value is queued until the next AC
+     * command, or an AT command sent without queue
+     * @return The frame ID
+     */
+    int sendATCommand(std::string cmd, std::string param="",
+                      bool queue=false);
+
+    /**
+     * Sends a remote AT command frame, without waiting for the
+     * response
+     *
+     * @param addr64 64-bit address of the remote node
+     * @param addr16 16-bit network address of the remote node, 0xfffe
+     * if unknown
+     * @param cmd The two character command, without the "AT" prefix
+     * @param param Parameter value, empty to query
+     * @param apply If true, the change is applied immediately
+     * @return The frame ID
+     */
+    int sendRemoteATCommand(uint64_t addr64, uint16_t addr16,
+                            std::string cmd, std::string param="",
+                            bool apply=true);
+
+    /**
+     * Runs a local AT command and waits for its response.  Other
+     * frames received meanwhile are processed as usual.  The
+     * response value is available from getATResponse().
+     *
+     * @param cmd The two character command, without the "AT" prefix
+     * @param param Parameter value, empty to query
+     * @param timeoutMs Time to wait for the response in milliseconds
+     * @return true if the device reported success
+     */
+    bool atCommand(std::string cmd, std::string param="",
+                   unsigned int timeoutMs=XBEE_DEFAULT_TIMEOUT);
+
+    /**
+     * Runs a remote AT command and waits for its response.  The
+     * response value is available from getATResponse().
+     *
+     * @param addr64 64-bit address of the remote node
+     * @param addr16 16-bit network address of the remote node, 0xfffe
+     * if unknown
+     * @param cmd The two character command, without the "AT" prefix
+     * @param param Parameter value, empty to query
+     * @param timeoutMs Time to wait for the response in milliseconds
+     * @return true if the remote device reported success
+     */
+    bool remoteATCommand(uint64_t addr64, uint16_t addr16,
+                         std::string cmd, std::string param="",
+                         unsigned int timeoutMs=XBEE_DEFAULT_TIMEOUT);
+
+    /**
+     * Returns the value from the last AT command response received
+     *
+     * @return The response value, binary
+     */
+    std::string getATResponse() { return m_atResponse; };
+
+    /**
+     * Reads and parses any data received from the device, and runs
+     * the callbacks for the complete frames found
+     *
+     * @param millis Number of milliseconds to wait for data; 0 means
+     * no waiting
+     * @return Number of frames processed
+     */
+    int processInput(unsigned int millis=0);
+
+    /**
+     * Returns the status of a frame ID
+     *
+     * @param frameId The frame ID returned when the frame was sent
+     * @return XBEE_FRAME_PENDING while no status has been received,
+     * XBEE_FRAME_UNUSED for an ID that was never allocated, or the
+     * status byte reported by the device, 0 on success
+     */
+    int getFrameStatus(uint8_t frameId);
+
+    /**
+     * Returns the number of frames sent for which no status has been
+     * received
+     *
+     * @return Number of pending frames
+     */
+    int pendingFrames();
+
+    /**
+     * Returns the number of received frames dropped because of a bad
+     * checksum, length or an interrupted escape sequence
+     *
+     * @return Number of bad frames
+     */
+    unsigned int getRxErrors() { return m_rxErrors; };
+
+    /**
+     * Installs a function to be called for every received frame
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setFrameCallback(FRAME_CALLBACK_T func, void *arg);
+
+    /**
+     * Installs a function to be called when the status of a frame is
+     * received
+     *
+     * @param func Function to call, or NULL to remove it
+     * @param arg Argument passed to func
+     */
+    void setStatusCallback(STATUS_CALLBACK_T func, void *arg);
+
   protected:
     mraa::Uart m_uart;
 
+    // send a frame made of a header and data, see sendFrame()
+    int writeFrame(uint8_t type, bool wantStatus,
+                   const uint8_t *hdr, int hdrLen,
+                   const uint8_t *data, int len);
+    // allocate the next frame ID, skipping pending ones
+    uint8_t allocFrameId();
+    // handle a complete received frame
+    void dispatchFrame(const uint8_t *frame, int len);
+    // process input until a frame completes, or the timeout expires
+    bool waitFrame(int frameId, unsigned int timeoutMs);
+
   private:
+    API_MODE_T m_apiMode;
+
+    // escaped frame being sent: delimiter, length, up to
+    // XBEE_MAX_FRAME_SIZE escaped data bytes and checksum
+    uint8_t m_txBuf[(XBEE_MAX_FRAME_SIZE + 3) * 2 + 1];
+
+    // frame being received, unescaped in place: delimiter, length,
+    // data and checksum
+    uint8_t m_rxBuf[XBEE_MAX_FRAME_SIZE + 4];
+    int m_rxLen;
+    bool m_rxEscape;
+    unsigned int m_rxErrors;
+
+    uint8_t m_nextFrameId;
+    int16_t m_frameStatus[256];
+
+    std::string m_atResponse;
+
+    FRAME_CALLBACK_T m_frameCallback;
+    void *m_frameCallbackArg;
+    STATUS_CALLBACK_T m_statusCallback;
+    void *m_statusCallbackArg;
   };
 }
 
@@ -68,6 +68,10 @@ ZFM20::ZFM20(int uart)
   setPassword(ZFM20_DEFAULT_PASSWORD);
   setAddress(ZFM20_DEFAULT_ADDRESS);
 
+  m_packetSize = 0;
+  m_rxHead = 0;
+  m_rxLen = 0;
+
   initClock();
 }
 
@@ -131,6 +135,8 @@ int ZFM20::writeData(char *buffer, int len)
 
   // first, flush any pending but unread input
   tcflush(m_ttyFd, TCIFLUSH);
+  m_rxHead = 0;
+  m_rxLen = 0;
 
   int rv = write(m_ttyFd, buffer, len);
 
@@ -503,6 +509,8 @@ uint8_t ZFM20::storeModel(int slot, uint16_t id)
 
   getResponse(rPkt, rPktLen);
 
+  m_modelCache.erase(id);
+
   return rPkt[9];
 }
 
@@ -523,6 +531,8 @@ uint8_t ZFM20::deleteModel(uint16_t id)
 
   getResponse(rPkt, rPktLen);
 
+  m_modelCache.erase(id);
+
   return rPkt[9];
 }
 
@@ -539,6 +549,8 @@ uint8_t ZFM20::deleteDB()
 
   getResponse(rPkt, rPktLen);
 
+  m_modelCache.clear();
+
   return rPkt[9];
 }
 
@@ -601,4 +613,402 @@ uint8_t ZFM20::match(uint16_t *score)
   return rPkt[9];
 }
 
+int ZFM20::readPacket(uint8_t *pkt, int len)
+{
+  initClock();
+
+  while (true)
+    {
+      // skip anything before a start code
+      while (m_rxLen > 0 &&
+             (m_rxBuffer[m_rxHead] != ZFM20_START1 ||
+              (m_rxLen > 1 && m_rxBuffer[m_rxHead + 1] != ZFM20_START2)))
+        {
+          m_rxHead++;
+          m_rxLen--;
+        }
+
+      if (m_rxLen >= 9)
+        {
+          uint8_t *rPkt = &m_rxBuffer[m_rxHead];
+          int plen = 9 + ((rPkt[7] << 8) | rPkt[8]);
+
+          if (plen < 11 || plen > len || plen > ZFM20_RX_BUFFER)
+            {
+              throw std::runtime_error(std::string(__FUNCTION__) +
+                                       ": Invalid packet length");
+              return 0;
+            }
+
+          if (m_rxLen >= plen)
+            {
+              memcpy(pkt, rPkt, plen);
+              m_rxHead += plen;
+              m_rxLen -= plen;
+
+              // the checksum covers the packet id, length and payload
+              uint16_t cksum = 0;
+              for (int i=6; i<plen-2; i++)
+                cksum += pkt[i];
+
+              if (cksum != ((pkt[plen-2] << 8) | pkt[plen-1]))
+                {
+                  throw std::runtime_error(std::string(__FUNCTION__) +
+                                           ": Packet checksum mismatch");
+                  return 0;
+                }
+
+              return plen;
+            }
+        }
+
+      // keep the partial packet at the start of the buffer, and
+      // read whatever has arrived behind it
+      if (m_rxHead)
+        {
+          memmove(m_rxBuffer, &m_rxBuffer[m_rxHead], m_rxLen);
+          m_rxHead = 0;
+        }
+
+      if (!dataAvailable(100))
+        {
+          if (getMillis() > ZFM20_TIMEOUT)
+            {
+              throw std::runtime_error(std::string(__FUNCTION__) +
+                                       ": Timed out waiting for packet");
+              return 0;
+            }
+
+          continue;
+        }
+
+      m_rxLen += readData((char *)&m_rxBuffer[m_rxLen],
+                          ZFM20_RX_BUFFER - m_rxLen);
+    }
+}
+
+uint8_t ZFM20::uploadData(uint8_t *pkt, int pktLen,
+                          uint8_t *buffer, int bufLen, int *len)
+{
+  *len = 0;
+
+  writeCmdPacket(pkt, pktLen);
+
+  // the acknowledgement, directly followed by the data packets
+  uint8_t rPkt[ZFM20_MAX_DATA_LEN + 11];
+
+  readPacket(rPkt, sizeof(rPkt));
+  verifyPacket(rPkt, sizeof(rPkt));
+
+  if (rPkt[9] != ERR_OK)
+    return rPkt[9];
+
+  int total = 0;
+  uint8_t pid;
+
+  do
+    {
+      int plen = readPacket(rPkt, sizeof(rPkt));
+
+      pid = rPkt[6];
+      if (pid != PKT_DATA && pid != PKT_END_DATA)
+        {
+          throw std::runtime_error(std::string(__FUNCTION__) +
+                                   ": Invalid data packet");
+          return ERR_INTERNAL_ERR;
+        }
+
+      if (total + plen - 11 > bufLen)
+        {
+          throw std::out_of_range(std::string(__FUNCTION__) +
+                                  ": buffer is too small");
+          return ERR_INTERNAL_ERR;
+        }
+
+      memcpy(&buffer[total], &rPkt[9], plen - 11);
+      total += plen - 11;
+    } while (pid != PKT_END_DATA);
+
+  *len = total;
+
+  return ERR_OK;
+}
+
+uint8_t ZFM20::downloadData(uint8_t *pkt, int pktLen,
+                            const uint8_t *buffer, int len)
+{
+  int size = getPacketSize();
+
+  writeCmdPacket(pkt, pktLen);
+
+  // now read a response
+  const int rPktLen = 12;
+  uint8_t rPkt[rPktLen];
+
+  getResponse(rPkt, rPktLen);
+
+  if (rPkt[9] != ERR_OK)
+    return rPkt[9];
+
+  // the module does not acknowledge data packets, so all of them are
+  // composed up front and written in one go
+  int count = (len + size - 1) / size;
+  std::vector<uint8_t> data(count * (size + 11));
+
+  int j = 0;
+  for (int i=0; i<len; i+=size)
+    {
+      int plen = (len - i < size) ? len - i : size;
+      uint8_t pid = (i + plen >= len) ? PKT_END_DATA : PKT_DATA;
+
+      data[j++] = ZFM20_START1;
+      data[j++] = ZFM20_START2;
+
+      data[j++] = (m_address >> 24) & 0xff;
+      data[j++] = (m_address >> 16) & 0xff;
+      data[j++] = (m_address >> 8) & 0xff;
+      data[j++] = m_address & 0xff;
+
+      data[j++] = pid;
+      data[j++] = ((plen + 2) >> 8) & 0xff;
+      data[j++] = (plen + 2) & 0xff;
+
+      uint16_t cksum = pid + ((plen + 2) >> 8) + ((plen + 2) & 0xff);
+
+      for (int k=0; k<plen; k++)
+        {
+          data[j++] = buffer[i + k];
+          cksum += buffer[i + k];
+        }
+
+      data[j++] = (cksum >> 8) & 0xff;
+      data[j++] = cksum & 0xff;
+    }
+
+  for (int i=0; i<j; )
+    i += writeData((char *)&data[i], j - i);
+
+  return ERR_OK;
+}
+
+uint8_t ZFM20::loadModel(int slot, uint16_t id)
+{
+  if (slot != 1 && slot != 2)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": slot must be 1 or 2");
+      return ERR_INTERNAL_ERR;
+    }
+
+  const int pktLen = 4;
+  uint8_t pkt[pktLen] = {CMD_LOAD_TMPL,
+                         (slot & 0xff),
+                         (id >> 8) & 0xff,
+                         id & 0xff};
+
+  writeCmdPacket(pkt, pktLen);
 
+  // now read a response
+  const int rPktLen = 12;
+  uint8_t rPkt[rPktLen];
+
+  getResponse(rPkt, rPktLen);
+
+  return rPkt[9];
+}
+
+uint8_t ZFM20::uploadCharFile(int slot, uint8_t *buffer, int bufLen, int *len)
+{
+  if (slot != 1 && slot != 2)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": slot must be 1 or 2");
+      return ERR_INTERNAL_ERR;
+    }
+
+  const int pktLen = 2;
+  uint8_t pkt[pktLen] = {CMD_UPLOAD_TMPL,
+                         (slot & 0xff)};
+
+  return uploadData(pkt, pktLen, buffer, bufLen, len);
+}
+
+uint8_t ZFM20::downloadCharFile(int slot, const uint8_t *buffer, int len)
+{
+  if (slot != 1 && slot != 2)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": slot must be 1 or 2");
+      return ERR_INTERNAL_ERR;
+    }
+
+  const int pktLen = 2;
+  uint8_t pkt[pktLen] = {CMD_DOWNLOAD_TMPL,
+                         (slot & 0xff)};
+
+  return downloadData(pkt, pktLen, buffer, len);
+}
+
+uint8_t ZFM20::uploadModel(uint16_t id, uint8_t *buffer, int bufLen, int *len)
+{
+  std::map<uint16_t, std::vector<uint8_t> >::iterator it;
+
+  if ((it = m_modelCache.find(id)) != m_modelCache.end())
+    {
+      if ((int)it->second.size() > bufLen)
+        {
+          throw std::out_of_range(std::string(__FUNCTION__) +
+                                  ": buffer is too small");
+          return ERR_INTERNAL_ERR;
+        }
+
+      memcpy(buffer, &it->second[0], it->second.size());
+      *len = it->second.size();
+      return ERR_OK;
+    }
+
+  *len = 0;
+
+  uint8_t rv;
+
+  if ((rv = loadModel(1, id)) != ERR_OK)
+    return rv;
+
+  if ((rv = uploadCharFile(1, buffer, bufLen, len)) != ERR_OK)
+    return rv;
+
+  m_modelCache[id].assign(buffer, buffer + *len);
+
+  return ERR_OK;
+}
+
+uint8_t ZFM20::downloadModel(uint16_t id, const uint8_t *buffer, int len)
+{
+  uint8_t rv;
+
+  if ((rv = downloadCharFile(1, buffer, len)) != ERR_OK)
+    return rv;
+
+  if ((rv = storeModel(1, id)) != ERR_OK)
+    return rv;
+
+  m_modelCache[id].assign(buffer, buffer + len);
+
+  return ERR_OK;
+}
+
+uint8_t ZFM20::uploadImage(uint8_t *buffer, int bufLen, int *len)
+{
+  const int pktLen = 1;
+  uint8_t pkt[pktLen] = {CMD_UPLOAD_IMAGE};
+
+  return uploadData(pkt, pktLen, buffer, bufLen, len);
+}
+
+uint8_t ZFM20::downloadImage(const uint8_t *buffer, int len)
+{
+  const int pktLen = 1;
+  uint8_t pkt[pktLen] = {CMD_DOWNLOAD_IMAGE};
+
+  return downloadData(pkt, pktLen, buffer, len);
+}
+
+uint8_t ZFM20::setSysParam(uint8_t param, uint8_t value)
+{
+  const int pktLen = 3;
+  uint8_t pkt[pktLen] = {CMD_SET_SYSPARAMS,
+                         param,
+                         value};
+
+  writeCmdPacket(pkt, pktLen);
+
+  // now read a response
+  const int rPktLen = 12;
+  uint8_t rPkt[rPktLen];
+
+  getResponse(rPkt, rPktLen);
+
+  return rPkt[9];
+}
+
+uint8_t ZFM20::setBaudRate(int baud)
+{
+  speed_t speed;
+
+  // the module supports multiples of 9600, but only these have a
+  // termios speed
+  switch (baud)
+    {
+    case 9600:   speed = B9600;   break;
+    case 19200:  speed = B19200;  break;
+    case 38400:  speed = B38400;  break;
+    case 57600:  speed = B57600;  break;
+    case 115200: speed = B115200; break;
+    default:
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": unsupported baud rate");
+      return ERR_INTERNAL_ERR;
+    }
+
+  // the response still arrives at the old rate
+  uint8_t rv = setSysParam(4, baud / 9600);
+
+  if (rv == ERR_OK)
+    setupTty(speed);
+
+  return rv;
+}
+
+uint8_t ZFM20::setPacketSize(int size)
+{
+  uint8_t code;
+
+  switch (size)
+    {
+    case 32:  code = 0; break;
+    case 64:  code = 1; break;
+    case 128: code = 2; break;
+    case 256: code = 3; break;
+    default:
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": size must be 32, 64, 128 or 256");
+      return ERR_INTERNAL_ERR;
+    }
+
+  uint8_t rv = setSysParam(6, code);
+
+  if (rv == ERR_OK)
+    m_packetSize = size;
+
+  return rv;
+}
+
+int ZFM20::getPacketSize()
+{
+  if (m_packetSize)
+    return m_packetSize;
+
+  const int pktLen = 1;
+  uint8_t pkt[pktLen] = {CMD_GET_SYSPARAMS};
+
+  writeCmdPacket(pkt, pktLen);
+
+  // now read a response
+  const int rPktLen = 28;
+  uint8_t rPkt[rPktLen];
+
+  getResponse(rPkt, rPktLen);
+
+  // check confirmation code
+  if (rPkt[9] != 0x00)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": Invalid confirmation code");
+      return 0;
+    }
+
+  // the packet size is stored as 0-3, for 32-256 bytes
+  m_packetSize = 32 << (rPkt[23] & 0x03);
+
+  return m_packetSize;
+}
@@ -28,6 +28,8 @@
 
 #include <string>
 #include <iostream>
+#include <map>
+#include <vector>
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -51,6 +53,18 @@
 
 #define ZFM20_MAX_PKT_LEN 256
 
+// largest data packet payload the module can be configured for
+#define ZFM20_MAX_DATA_LEN 256
+
+// size of a character file or template
+#define ZFM20_TEMPLATE_SIZE 512
+
+// size of a fingerprint image, 256x288 pixels at 4 bits per pixel
+#define ZFM20_IMAGE_SIZE 36864
+
+// receive buffer of the data transfers, holding a few packets
+#define ZFM20_RX_BUFFER 1024
+
 #define ZFM20_TIMEOUT 5000 // in ms
 
 #define ZFM20_DEFAULT_PASSWORD 0x00000000
@@ -85,6 +99,13 @@ namespace upm {
      * @snippet zfm20-register.cxx Interesting
      * This example demonstrates reading a fingerprint and locating it in the DB
      * @snippet zfm20.cxx Interesting
+     *
+     * Templates and images can be moved between the module and the
+     * host, for instance to copy a fingerprint DB to other units.
+     * The transfers stream the module's data packets, verifying the
+     * checksum of each one.  Templates uploaded by ID are cached on
+     * the host, so repeated synchronizations only read each template
+     * once.
      */
   class ZFM20 {
   public:
@@ -363,6 +384,116 @@ namespace upm {
      */
     uint8_t match(uint16_t *score);
 
+    /**
+     * Loads a stored model into one of the characteristics buffers
+     *
+     * @param slot Characteristics buffer to load the model into, 1 or 2
+     * @param id Location of the model
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t loadModel(int slot, uint16_t id);
+
+    /**
+     * Uploads the contents of a characteristics buffer to the host
+     *
+     * @param slot Characteristics buffer to upload, 1 or 2
+     * @param buffer Buffer to hold the data, ZFM20_TEMPLATE_SIZE bytes
+     * is enough
+     * @param bufLen Size of the buffer
+     * @param len Number of bytes received
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t uploadCharFile(int slot, uint8_t *buffer, int bufLen, int *len);
+
+    /**
+     * Downloads data from the host into a characteristics buffer
+     *
+     * @param slot Characteristics buffer to fill, 1 or 2
+     * @param buffer Data, as returned by uploadCharFile()
+     * @param len Number of bytes
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t downloadCharFile(int slot, const uint8_t *buffer, int len);
+
+    /**
+     * Uploads a stored model to the host.  Models are cached by ID,
+     * so a model is only read from the module the first time.  The
+     * cache entry is dropped when the model is changed or deleted
+     * through this class.
+     *
+     * @param id Location of the model
+     * @param buffer Buffer to hold the model, ZFM20_TEMPLATE_SIZE bytes
+     * is enough
+     * @param bufLen Size of the buffer
+     * @param len Number of bytes received
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t uploadModel(uint16_t id, uint8_t *buffer, int bufLen, int *len);
+
+    /**
+     * Downloads a model from the host and stores it at a location.
+     * Characteristics buffer 1 is used for the transfer.
+     *
+     * @param id Location to store the model
+     * @param buffer Model data, as returned by uploadModel()
+     * @param len Number of bytes
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t downloadModel(uint16_t id, const uint8_t *buffer, int len);
+
+    /**
+     * Discards all models cached by uploadModel()
+     */
+    void clearModelCache() { m_modelCache.clear(); };
+
+    /**
+     * Uploads the image buffer (generated by generateImage()) to the
+     * host
+     *
+     * @param buffer Buffer to hold the image, ZFM20_IMAGE_SIZE bytes is
+     * enough
+     * @param bufLen Size of the buffer
+     * @param len Number of bytes received
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t uploadImage(uint8_t *buffer, int bufLen, int *len);
+
+    /**
+     * Downloads an image from the host into the image buffer
+     *
+     * @param buffer Image data, as returned by uploadImage()
+     * @param len Number of bytes
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t downloadImage(const uint8_t *buffer, int len);
+
+    /**
+     * Sets the baud rate of the module, and switches the tty to it.
+     * The setting is stored in the module, so setupTty() must use
+     * the new rate from then on.
+     *
+     * @param baud 9600, 19200, 38400, 57600 or 115200
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t setBaudRate(int baud);
+
+    /**
+     * Sets the size of the module's data packets.  Larger packets
+     * lower the protocol overhead of image and template transfers.
+     * The setting is stored in the module.
+     *
+     * @param size 32, 64, 128 or 256
+     * @return One of the ZFM20_ERRORS_T values
+     */
+    uint8_t setPacketSize(int size);
+
+    /**
+     * Queries the module for the size of its data packets
+     *
+     * @return Packet size in bytes
+     */
+    int getPacketSize();
+
 
   protected:
     int ttyFd() { return m_ttyFd; };
@@ -373,6 +504,26 @@ namespace upm {
     uint32_t m_password;
     uint32_t m_address;
     struct timeval m_startTime;
+
+    // data packet size, 0 until queried
+    int m_packetSize;
+
+    // bytes received but not yet consumed by readPacket()
+    uint8_t m_rxBuffer[ZFM20_RX_BUFFER];
+    int m_rxHead;
+    int m_rxLen;
+
+    std::map<uint16_t, std::vector<uint8_t> > m_modelCache;
+
+    // read the next packet from the stream and verify its checksum
+    int readPacket(uint8_t *pkt, int len);
+    // send a command, then receive its data packets
+    uint8_t uploadData(uint8_t *pkt, int pktLen,
+                       uint8_t *buffer, int bufLen, int *len);
+    // send a command, then send data packets
+    uint8_t downloadData(uint8_t *pkt, int pktLen,
+                         const uint8_t *buffer, int len);
+    uint8_t setSysParam(uint8_t param, uint8_t value);
   };
 }
 
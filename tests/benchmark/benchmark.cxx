@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Driver throughput benchmark.  Representative drivers are built
+ * against the simulated bus (simmraa.cxx, simmodbus.cxx), and each
+ * benchmarked operation is run repeatedly while the bus transactions
+ * and wall time are measured.  Results are reported per operation.
+ *
+ * usage: upm-benchmark [-n iterations] [-l]
+ *
+ *   -n  number of iterations of each operation (default 1000)
+ *   -l  inject bus latencies approximating real hardware (400kHz I2C,
+ *       8MHz SPI, sysfs GPIO, 9600 baud modbus RTU) so the wall time
+ *       reflects the cost of the bus traffic, not just the CPU time
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+#include "simbus.h"
+
+#include "lsm9ds0.h"
+#include "mpu9150.h"
+#include "ili9341.h"
+#include "ssd1306.h"
+#include "sx1276.h"
+#if defined(UPM_BENCHMARK_T3311)
+# include "t3311.h"
+#endif
+
+using namespace upm;
+using namespace std;
+
+namespace {
+  int iterations = 1000;
+
+  uint64_t nowNs()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+  }
+
+  // run an operation and print its per iteration cost
+  void bench(const char *driver, const char *op, void (*fn)(void *),
+             void *ctx)
+  {
+    // warm up (and let drivers prime any caches)
+    fn(ctx);
+
+    SimBus::resetStats();
+    uint64_t start = nowNs();
+
+    for (int i=0; i<iterations; i++)
+      fn(ctx);
+
+    uint64_t elapsed = nowNs() - start;
+
+    uint64_t xfers = 0;
+    uint64_t bytes = 0;
+    for (int t=0; t<SimBus::BUS_MAX; t++)
+      {
+        if (t == SimBus::BUS_GPIO)
+          continue;
+
+        SimBus::STATS_T s = SimBus::getStats(SimBus::BUS_TYPE_T(t));
+        xfers += s.transactions;
+        bytes += s.bytesWritten + s.bytesRead;
+      }
+    SimBus::STATS_T gpio = SimBus::getStats(SimBus::BUS_GPIO);
+
+    double n = iterations;
+    cout << left << setw(10) << driver << setw(22) << op << right
+         << fixed << setprecision(1)
+         << setw(10) << xfers / n
+         << setw(11) << bytes / n
+         << setw(9) << gpio.transactions / n
+         << setw(12) << (elapsed / n) / 1000.0 << endl;
+  }
+
+  // LSM9DS0
+
+  void lsm9ds0Update(void *ctx)
+  {
+    ((LSM9DS0 *)ctx)->update();
+  }
+
+  void benchLSM9DS0()
+  {
+    SimDevice g, xm;
+
+    // the ST parts only auto-increment when the register MSB is set
+    g.setAutoIncrement(0x80);
+    g.setReg(LSM9DS0::REG_WHO_AM_I_G, 0xd4);
+    xm.setAutoIncrement(0x80);
+    xm.setReg(LSM9DS0::REG_WHO_AM_I_XM, 0x49);
+
+    SimBus::attachI2c(LSM9DS0_I2C_BUS, LSM9DS0_DEFAULT_GYRO_ADDR, &g);
+    SimBus::attachI2c(LSM9DS0_I2C_BUS, LSM9DS0_DEFAULT_XM_ADDR, &xm);
+
+    LSM9DS0 sensor;
+    sensor.init();
+
+    bench("LSM9DS0", "update()", lsm9ds0Update, &sensor);
+  }
+
+  // MPU9150
+
+  // the AK8975 always reports a completed measurement
+  class SimAK8975 : public SimDevice {
+  public:
+    SimAK8975()
+    {
+      setReg(AK8975::REG_WIA, 0x48);
+      setReg(AK8975::REG_ST1, AK8975::ST1_DRDY);
+      setReg(AK8975::REG_ASAX, 128);
+      setReg(AK8975::REG_ASAY, 128);
+      setReg(AK8975::REG_ASAZ, 128);
+    };
+  };
+
+  // DEVICE_RESET is self clearing
+  class SimMPU60X0 : public SimDevice {
+  public:
+    SimMPU60X0()
+    {
+      setReg(MPU60X0::REG_WHO_AM_I, 0x68);
+    };
+
+    void regWritten(uint8_t reg, uint8_t val)
+    {
+      if (reg == MPU60X0::REG_PWR_MGMT_1)
+        val &= ~MPU60X0::DEVICE_RESET;
+
+      SimDevice::regWritten(reg, val);
+    };
+  };
+
+  void mpu9150Update(void *ctx)
+  {
+    ((MPU9150 *)ctx)->update();
+  }
+
+  void benchMPU9150()
+  {
+    SimMPU60X0 mpu;
+    SimAK8975 mag;
+
+    SimBus::attachI2c(MPU9150_I2C_BUS, MPU9150_DEFAULT_I2C_ADDR, &mpu);
+    SimBus::attachI2c(MPU9150_I2C_BUS, AK8975_DEFAULT_I2C_ADDR, &mag);
+
+    MPU9150 sensor;
+    sensor.init();
+
+    bench("MPU9150", "update() bypass", mpu9150Update, &sensor);
+
+    // the slave data normally shows up in EXT_SENS_DATA, copy the
+    // AK8975 registers there
+    uint8_t st1 = AK8975::ST1_DRDY;
+    mpu.setRegs(MPU60X0::REG_EXT_SENS_DATA_00, &st1, 1);
+
+    sensor.enableAuxMagnetometer(true);
+
+    bench("MPU9150", "update() aux master", mpu9150Update, &sensor);
+  }
+
+  // ILI9341
+
+  void ili9341FillScreen(void *ctx)
+  {
+    ((ILI9341 *)ctx)->fillScreen(ILI9341_BLUE);
+  }
+
+  void ili9341FillRect(void *ctx)
+  {
+    ((ILI9341 *)ctx)->fillRect(10, 10, 32, 32, ILI9341_RED);
+  }
+
+  void ili9341Pixel(void *ctx)
+  {
+    ((ILI9341 *)ctx)->drawPixel(20, 20, ILI9341_WHITE);
+  }
+
+  void ili9341Text(void *ctx)
+  {
+    ILI9341 *lcd = (ILI9341 *)ctx;
+
+    // transparent text, drawn as runs of foreground pixels
+    lcd->setTextColor(ILI9341_WHITE);
+    lcd->setCursor(0, 0);
+    lcd->print("Hello World");
+  }
+
+  void ili9341TextOpaque(void *ctx)
+  {
+    ILI9341 *lcd = (ILI9341 *)ctx;
+
+    // opaque text, sent from the glyph cache in one window per run
+    lcd->setTextColor(ILI9341_WHITE, ILI9341_BLACK);
+    lcd->setCursor(0, 0);
+    lcd->print("Hello World");
+  }
+
+  void benchILI9341()
+  {
+    // the panel is write only, nothing needs to be attached
+    ILI9341 lcd(10, 4, 9, 8);
+
+    int n = iterations;
+
+    bench("ILI9341", "drawPixel()", ili9341Pixel, &lcd);
+    bench("ILI9341", "fillRect(32x32)", ili9341FillRect, &lcd);
+    bench("ILI9341", "print(11 chars)", ili9341Text, &lcd);
+    bench("ILI9341", "print(11 chars, bg)", ili9341TextOpaque, &lcd);
+
+    // full screen fills are slow, run fewer of them
+    iterations = (n / 100) ? (n / 100) : 1;
+    bench("ILI9341", "fillScreen()", ili9341FillScreen, &lcd);
+    iterations = n;
+  }
+
+  // SSD1306
+
+  uint8_t ssd1306Image[1024];
+
+  void ssd1306Draw(void *ctx)
+  {
+    ((SSD1306 *)ctx)->draw(ssd1306Image, sizeof(ssd1306Image));
+  }
+
+  void ssd1306Write(void *ctx)
+  {
+    SSD1306 *lcd = (SSD1306 *)ctx;
+
+    lcd->setCursor(0, 0);
+    lcd->write("Hello World");
+  }
+
+  void ssd1306Clear(void *ctx)
+  {
+    ((SSD1306 *)ctx)->clear();
+  }
+
+  void benchSSD1306()
+  {
+    SimDevice oled;
+
+    SimBus::attachI2c(0, 0x3c, &oled);
+
+    SSD1306 lcd(0, 0x3c);
+
+    memset(ssd1306Image, 0x55, sizeof(ssd1306Image));
+
+    bench("SSD1306", "draw(full frame)", ssd1306Draw, &lcd);
+    bench("SSD1306", "write(11 chars)", ssd1306Write, &lcd);
+    bench("SSD1306", "clear()", ssd1306Clear, &lcd);
+  }
+
+  // SX1276
+
+  uint8_t sx1276Buf[64];
+
+  void sx1276RSSI(void *ctx)
+  {
+    ((SX1276 *)ctx)->getRSSI(SX1276::MODEM_LORA);
+  }
+
+  void sx1276Channel(void *ctx)
+  {
+    ((SX1276 *)ctx)->setChannel(915000000);
+  }
+
+  void sx1276Fifo(void *ctx)
+  {
+    SX1276 *radio = (SX1276 *)ctx;
+
+    radio->writeFifo(sx1276Buf, sizeof(sx1276Buf));
+    radio->readFifo(sx1276Buf, sizeof(sx1276Buf));
+  }
+
+  void benchSX1276()
+  {
+    SimDevice radio;
+
+    // the MSB selects a write, and the chip select pin frames
+    // transactions
+    radio.setSPIProtocol(0x80, false);
+    radio.setChipSelect(10);
+    radio.setReg(SX1276::COM_RegVersion, SX1276::chipRevision);
+
+    SimBus::attachSpi(1, &radio);
+
+    SX1276 sensor;
+
+    bench("SX1276", "getRSSI()", sx1276RSSI, &sensor);
+    bench("SX1276", "setChannel()", sx1276Channel, &sensor);
+    bench("SX1276", "FIFO write+read 64B", sx1276Fifo, &sensor);
+  }
+
+#if defined(UPM_BENCHMARK_T3311)
+  // T3311
+
+  void t3311Update(void *ctx)
+  {
+    ((T3311 *)ctx)->update();
+  }
+
+  void benchT3311()
+  {
+    const int slave = 1;
+
+    for (int reg=T3311::REG_TEMPERATURE;
+         reg<=T3311::REG_SPECIFIC_ENTHALPY; reg++)
+      SimBus::setModbusInputReg(slave, reg, 250);
+
+    SimBus::setModbusInputReg(slave, T3311::REG_UNIT_SETTINGS, 0);
+    SimBus::setModbusInputReg(slave, T3311::REG_FW_HI, 0x0002);
+    SimBus::setModbusInputReg(slave, T3311::REG_FW_LO, 0x0244);
+    SimBus::setModbusInputReg(slave, T3311::REG_SERIAL_HI, 0x1234);
+    SimBus::setModbusInputReg(slave, T3311::REG_SERIAL_LO, 0x5678);
+
+    // note, the constructor waits 5 seconds for the device to boot
+    T3311 sensor("/dev/ttyUSB0", slave);
+
+    bench("T3311", "update()", t3311Update, &sensor);
+  }
+#endif
+
+  void run(const char *name, void (*fn)())
+  {
+    try
+      {
+        fn();
+      }
+    catch (std::exception& e)
+      {
+        cerr << name << ": failed: " << e.what() << endl;
+      }
+
+    SimBus::reset();
+  }
+
+  void setLatencies()
+  {
+    // 400kHz I2C: 9 bits per byte, plus start/address/stop and the
+    // ioctl overhead per transaction
+    SimBus::setLatency(SimBus::BUS_I2C, 50000, 22500);
+    // 8MHz SPI, plus the ioctl overhead per transaction
+    SimBus::setLatency(SimBus::BUS_SPI, 20000, 1000);
+    // sysfs GPIO writes
+    SimBus::setLatency(SimBus::BUS_GPIO, 5000, 0);
+    // 115200 baud UART, 10 bits per byte
+    SimBus::setLatency(SimBus::BUS_UART, 0, 86800);
+    // 9600 baud modbus RTU, 11 bits per byte plus the 3.5 character
+    // inter-frame gap
+    SimBus::setLatency(SimBus::BUS_MODBUS, 4010000, 1146000);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  bool latencies = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:l")) != -1)
+    {
+      switch (opt)
+        {
+        case 'n':
+          iterations = atoi(optarg);
+          if (iterations <= 0)
+            iterations = 1;
+          break;
+
+        case 'l':
+          latencies = true;
+          break;
+
+        default:
+          cerr << "usage: " << argv[0] << " [-n iterations] [-l]" << endl;
+          return 1;
+        }
+    }
+
+  cout << left << setw(10) << "driver" << setw(22) << "operation" << right
+       << setw(10) << "xfers/op" << setw(11) << "bytes/op"
+       << setw(9) << "gpio/op" << setw(12) << "us/op" << endl;
+
+  void (*benches[])() = {
+    benchLSM9DS0,
+    benchMPU9150,
+    benchILI9341,
+    benchSSD1306,
+    benchSX1276,
+#if defined(UPM_BENCHMARK_T3311)
+    benchT3311,
+#endif
+  };
+  const char *names[] = {
+    "LSM9DS0",
+    "MPU9150",
+    "ILI9341",
+    "SSD1306",
+    "SX1276",
+#if defined(UPM_BENCHMARK_T3311)
+    "T3311",
+#endif
+  };
+
+  for (unsigned int i=0; i<sizeof(benches) / sizeof(benches[0]); i++)
+    {
+      // latencies are reset along with the bus after each driver
+      if (latencies)
+        setLatencies();
+      run(names[i], benches[i]);
+    }
+
+  return 0;
+}
@@ -0,0 +1,478 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "simbus.h"
+
+using namespace upm;
+using namespace std;
+
+// SimDevice
+
+SimDevice::SimDevice()
+{
+  memset(m_regs, 0, sizeof(m_regs));
+
+  m_autoIncrement = 0;
+  m_spiFlag = 0x80;
+  m_spiReadWhenSet = true;
+  m_spiAutoIncFlag = 0;
+  m_csPin = -1;
+
+  m_ptr = 0;
+  m_increment = true;
+  m_spiHaveAddr = false;
+  m_spiRead = false;
+}
+
+void SimDevice::setRegs(uint8_t reg, const uint8_t *vals, int len)
+{
+  for (int i=0; i<len; i++)
+    m_regs[uint8_t(reg + i)] = vals[i];
+}
+
+void SimDevice::pushFIFO(uint8_t reg, const uint8_t *data, int len)
+{
+  std::deque<uint8_t>& fifo = m_fifos[reg];
+
+  for (int i=0; i<len; i++)
+    fifo.push_back(data[i]);
+}
+
+int SimDevice::fifoLevel(uint8_t reg)
+{
+  if (!m_fifos.count(reg))
+    return 0;
+
+  return m_fifos[reg].size();
+}
+
+void SimDevice::setSPIProtocol(uint8_t flag, bool readWhenSet,
+                               uint8_t autoIncFlag)
+{
+  m_spiFlag = flag;
+  m_spiReadWhenSet = readWhenSet;
+  m_spiAutoIncFlag = autoIncFlag;
+}
+
+uint8_t SimDevice::regRead(uint8_t reg)
+{
+  std::map<uint8_t, std::deque<uint8_t> >::iterator it = m_fifos.find(reg);
+
+  if (it != m_fifos.end() && !(*it).second.empty())
+    {
+      uint8_t val = (*it).second.front();
+      (*it).second.pop_front();
+      return val;
+    }
+
+  return m_regs[reg];
+}
+
+void SimDevice::setPointer(uint8_t addr, uint8_t incFlag)
+{
+  if (incFlag)
+    {
+      m_increment = ((addr & incFlag) != 0);
+      m_ptr = addr & ~incFlag;
+    }
+  else
+    {
+      m_increment = true;
+      m_ptr = addr;
+    }
+}
+
+void SimDevice::advance()
+{
+  // FIFO registers are read repeatedly without moving the pointer
+  if (m_increment && !m_fifos.count(m_ptr))
+    m_ptr++;
+}
+
+void SimDevice::i2cWrite(const uint8_t *data, int len)
+{
+  if (len <= 0)
+    return;
+
+  setPointer(data[0], m_autoIncrement);
+
+  for (int i=1; i<len; i++)
+    {
+      regWritten(m_ptr, data[i]);
+      advance();
+    }
+}
+
+void SimDevice::i2cRead(uint8_t *data, int len)
+{
+  for (int i=0; i<len; i++)
+    {
+      data[i] = regRead(m_ptr);
+      advance();
+    }
+}
+
+void SimDevice::spiBegin()
+{
+  m_spiHaveAddr = false;
+}
+
+void SimDevice::spiTransfer(const uint8_t *tx, uint8_t *rx, int len)
+{
+  for (int i=0; i<len; i++)
+    {
+      uint8_t out = (tx) ? tx[i] : 0;
+      uint8_t in = 0;
+
+      if (!m_spiHaveAddr)
+        {
+          m_spiRead = (out & m_spiFlag) ? m_spiReadWhenSet : !m_spiReadWhenSet;
+          setPointer(out & ~m_spiFlag, m_spiAutoIncFlag);
+          if (!m_spiAutoIncFlag)
+            m_increment = true;
+          m_spiHaveAddr = true;
+        }
+      else if (m_spiRead)
+        {
+          in = regRead(m_ptr);
+          advance();
+        }
+      else
+        {
+          regWritten(m_ptr, out);
+          advance();
+        }
+
+      if (rx)
+        rx[i] = in;
+    }
+}
+
+// SimBus
+
+namespace {
+  pthread_mutex_t simLock = PTHREAD_MUTEX_INITIALIZER;
+
+  std::map<std::pair<int, uint8_t>, SimDevice *> i2cDevices;
+  std::multimap<int, SimDevice *> spiDevices;
+  std::map<std::pair<int, int>, uint16_t> modbusRegs;
+  std::map<int, int> gpioLevels;
+
+  typedef struct {
+    int edge;                   // mraa_gpio_edge_t
+    void (*isr)(void *);
+    void *arg;
+  } gpio_isr_t;
+  std::map<int, gpio_isr_t> gpioIsrs;
+  std::map<int, std::string> uartInput;
+  std::map<int, std::string> uartOutput;
+
+  SimBus::STATS_T stats[SimBus::BUS_MAX];
+  uint32_t latencyTransaction[SimBus::BUS_MAX];
+  uint32_t latencyByte[SimBus::BUS_MAX];
+
+  // busy wait, nanosleep() is far too coarse for per-byte latencies
+  void delayNs(uint64_t ns)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t end = uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec + ns;
+
+    do
+      {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+      } while (uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec < end);
+  }
+}
+
+void SimBus::attachI2c(int bus, uint8_t addr, SimDevice *dev)
+{
+  pthread_mutex_lock(&simLock);
+  i2cDevices[std::make_pair(bus, addr)] = dev;
+  pthread_mutex_unlock(&simLock);
+}
+
+void SimBus::attachSpi(int bus, SimDevice *dev)
+{
+  pthread_mutex_lock(&simLock);
+  spiDevices.insert(std::make_pair(bus, dev));
+  pthread_mutex_unlock(&simLock);
+}
+
+void SimBus::setModbusInputReg(int slave, int reg, uint16_t val)
+{
+  pthread_mutex_lock(&simLock);
+  modbusRegs[std::make_pair(slave, reg)] = val;
+  pthread_mutex_unlock(&simLock);
+}
+
+void SimBus::setGpio(int pin, int val)
+{
+  val = (val) ? 1 : 0;
+
+  pthread_mutex_lock(&simLock);
+
+  int old = gpioLevels[pin];
+  gpioLevels[pin] = val;
+
+  gpio_isr_t isr = {0, 0, 0};
+  if (gpioIsrs.count(pin))
+    isr = gpioIsrs[pin];
+
+  pthread_mutex_unlock(&simLock);
+
+  // edges are 1 (both), 2 (rising) and 3 (falling), as in mraa
+  if (isr.isr && old != val &&
+      (isr.edge == 1 || (isr.edge == 2 && val) || (isr.edge == 3 && !val)))
+    isr.isr(isr.arg);
+}
+
+void SimBus::gpioIsr(int pin, int edge, void (*isr)(void *), void *arg)
+{
+  pthread_mutex_lock(&simLock);
+
+  if (isr)
+    {
+      gpio_isr_t entry = {edge, isr, arg};
+      gpioIsrs[pin] = entry;
+    }
+  else
+    gpioIsrs.erase(pin);
+
+  pthread_mutex_unlock(&simLock);
+}
+
+int SimBus::getGpio(int pin)
+{
+  pthread_mutex_lock(&simLock);
+  int rv = gpioLevels[pin];
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+void SimBus::pushUart(int uart, const std::string& data)
+{
+  pthread_mutex_lock(&simLock);
+  uartInput[uart] += data;
+  pthread_mutex_unlock(&simLock);
+}
+
+std::string SimBus::drainUart(int uart)
+{
+  pthread_mutex_lock(&simLock);
+  std::string rv = uartOutput[uart];
+  uartOutput[uart].clear();
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+void SimBus::setLatency(BUS_TYPE_T type, uint32_t perTransaction,
+                        uint32_t perByte)
+{
+  pthread_mutex_lock(&simLock);
+  latencyTransaction[type] = perTransaction;
+  latencyByte[type] = perByte;
+  pthread_mutex_unlock(&simLock);
+}
+
+SimBus::STATS_T SimBus::getStats(BUS_TYPE_T type)
+{
+  pthread_mutex_lock(&simLock);
+  STATS_T rv = stats[type];
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+void SimBus::resetStats()
+{
+  pthread_mutex_lock(&simLock);
+  memset(stats, 0, sizeof(stats));
+  pthread_mutex_unlock(&simLock);
+}
+
+void SimBus::reset()
+{
+  pthread_mutex_lock(&simLock);
+  i2cDevices.clear();
+  spiDevices.clear();
+  modbusRegs.clear();
+  gpioLevels.clear();
+  gpioIsrs.clear();
+  uartInput.clear();
+  uartOutput.clear();
+  memset(stats, 0, sizeof(stats));
+  memset(latencyTransaction, 0, sizeof(latencyTransaction));
+  memset(latencyByte, 0, sizeof(latencyByte));
+  pthread_mutex_unlock(&simLock);
+}
+
+SimDevice *SimBus::i2cDevice(int bus, uint8_t addr)
+{
+  pthread_mutex_lock(&simLock);
+
+  SimDevice *dev = 0;
+  std::map<std::pair<int, uint8_t>, SimDevice *>::iterator it =
+    i2cDevices.find(std::make_pair(bus, addr));
+  if (it != i2cDevices.end())
+    dev = (*it).second;
+
+  pthread_mutex_unlock(&simLock);
+
+  return dev;
+}
+
+SimDevice *SimBus::spiDevice(int bus)
+{
+  pthread_mutex_lock(&simLock);
+
+  SimDevice *dev = 0;
+  std::pair<std::multimap<int, SimDevice *>::iterator,
+            std::multimap<int, SimDevice *>::iterator> range =
+    spiDevices.equal_range(bus);
+
+  for (std::multimap<int, SimDevice *>::iterator it = range.first;
+       it != range.second; ++it)
+    {
+      int cs = (*it).second->getChipSelect();
+
+      // a device without a chip select pin sees every transfer,
+      // otherwise the device must be selected
+      if (cs < 0 || gpioLevels[cs] == 0)
+        {
+          dev = (*it).second;
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&simLock);
+
+  return dev;
+}
+
+SimDevice *SimBus::spiDeviceForCS(int pin)
+{
+  pthread_mutex_lock(&simLock);
+
+  SimDevice *dev = 0;
+  for (std::multimap<int, SimDevice *>::iterator it = spiDevices.begin();
+       it != spiDevices.end(); ++it)
+    {
+      if ((*it).second->getChipSelect() == pin)
+        {
+          dev = (*it).second;
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&simLock);
+
+  return dev;
+}
+
+bool SimBus::modbusInputReg(int slave, int reg, uint16_t *val)
+{
+  pthread_mutex_lock(&simLock);
+
+  bool rv = false;
+  std::map<std::pair<int, int>, uint16_t>::iterator it =
+    modbusRegs.find(std::make_pair(slave, reg));
+  if (it != modbusRegs.end())
+    {
+      *val = (*it).second;
+      rv = true;
+    }
+
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+void SimBus::gpioWritten(int pin, int val)
+{
+  pthread_mutex_lock(&simLock);
+  int old = gpioLevels[pin];
+  gpioLevels[pin] = val;
+  pthread_mutex_unlock(&simLock);
+
+  // a falling chip select starts a new SPI transaction
+  if (old && !val)
+    {
+      SimDevice *dev = spiDeviceForCS(pin);
+      if (dev)
+        dev->spiBegin();
+    }
+}
+
+int SimBus::uartRead(int uart, char *buf, int len)
+{
+  pthread_mutex_lock(&simLock);
+
+  std::string& in = uartInput[uart];
+  int rv = (int(in.size()) < len) ? in.size() : len;
+  memcpy(buf, in.data(), rv);
+  in.erase(0, rv);
+
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+int SimBus::uartAvailable(int uart)
+{
+  pthread_mutex_lock(&simLock);
+  int rv = uartInput[uart].size();
+  pthread_mutex_unlock(&simLock);
+
+  return rv;
+}
+
+void SimBus::uartWritten(int uart, const char *buf, int len)
+{
+  pthread_mutex_lock(&simLock);
+  uartOutput[uart].append(buf, len);
+  pthread_mutex_unlock(&simLock);
+}
+
+void SimBus::account(BUS_TYPE_T type, int written, int read)
+{
+  pthread_mutex_lock(&simLock);
+
+  stats[type].transactions++;
+  stats[type].bytesWritten += written;
+  stats[type].bytesRead += read;
+
+  uint64_t ns = latencyTransaction[type] +
+    uint64_t(latencyByte[type]) * (written + read);
+
+  pthread_mutex_unlock(&simLock);
+
+  if (ns)
+    delayNs(ns);
+}
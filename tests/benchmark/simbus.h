@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace upm {
+
+  /**
+   * @brief Simulated register based device
+   *
+   * SimDevice models a register based peripheral for the simulated
+   * bus (see SimBus).  It holds up to 256 8-bit registers, which can
+   * be scripted with setReg()/setRegs(), and any register can be
+   * turned into a FIFO with pushFIFO(): reads of a FIFO register
+   * return the queued bytes in order, and do not advance the
+   * register pointer.
+   *
+   * Over I2C, the first byte written selects the register, and any
+   * further bytes are written starting at that register.  Over SPI,
+   * the first byte of each transaction is the register address,
+   * combined with a read or write flag (see setSPIProtocol()).
+   *
+   * Register pointers advance after every byte, unless the device
+   * has an auto-increment flag (see setAutoIncrement()), in which
+   * case they only advance if the flag was set in the register
+   * address.
+   */
+  class SimDevice {
+  public:
+    /**
+     * SimDevice constructor.  All registers are initialized to 0.
+     */
+    SimDevice();
+
+    virtual ~SimDevice() {};
+
+    /**
+     * Set the value of a register.
+     *
+     * @param reg The register
+     * @param val The value
+     */
+    void setReg(uint8_t reg, uint8_t val) { m_regs[reg] = val; };
+
+    /**
+     * Set consecutive registers.
+     *
+     * @param reg The first register
+     * @param vals The values
+     * @param len The number of registers to set
+     */
+    void setRegs(uint8_t reg, const uint8_t *vals, int len);
+
+    /**
+     * Return the value of a register, as last written by a driver
+     * or by setReg().
+     *
+     * @param reg The register
+     * @return The register value
+     */
+    uint8_t getReg(uint8_t reg) { return m_regs[reg]; };
+
+    /**
+     * Queue bytes to be returned by reads of a FIFO register.  When
+     * the FIFO is empty, reads return the register value.
+     *
+     * @param reg The FIFO register
+     * @param data The bytes to queue
+     * @param len The number of bytes
+     */
+    void pushFIFO(uint8_t reg, const uint8_t *data, int len);
+
+    /**
+     * Return the number of bytes still queued in a FIFO register.
+     *
+     * @param reg The FIFO register
+     * @return The number of bytes queued
+     */
+    int fifoLevel(uint8_t reg);
+
+    /**
+     * Set the register address flag that enables auto-increment for
+     * multi-byte transfers (for example 0x80 for the ST parts).  The
+     * default, 0, always auto-increments.
+     *
+     * @param flag The auto-increment flag
+     */
+    void setAutoIncrement(uint8_t flag) { m_autoIncrement = flag; };
+
+    /**
+     * Set how the first byte of an SPI transaction is interpreted.
+     * The default is readFlag = 0x80, readWhenSet = true (a set MSB
+     * means read), which matches most sensors.  Devices such as the
+     * SX1276, which set the MSB to write, use readWhenSet = false.
+     *
+     * @param flag The read/write flag bit(s)
+     * @param readWhenSet true if the flag being set means read
+     * @param autoIncFlag Address bit(s) that must be stripped and
+     * enable auto-increment (0 if none)
+     */
+    void setSPIProtocol(uint8_t flag, bool readWhenSet, uint8_t autoIncFlag=0);
+
+    /**
+     * Frame SPI transactions with a GPIO chip select.  By default,
+     * every SPI transfer is a separate transaction.  With a chip
+     * select pin, a transaction starts when the pin is driven low,
+     * and may span several transfers.
+     *
+     * @param pin The GPIO pin used as chip select, or -1 for none
+     */
+    void setChipSelect(int pin) { m_csPin = pin; };
+
+    /**
+     * Return the chip select pin, or -1.
+     *
+     * @return The chip select pin
+     */
+    int getChipSelect() { return m_csPin; };
+
+    /**
+     * Called for every register written by the driver.  The default
+     * stores the value.  Override to model side effects (self
+     * clearing bits, triggered conversions, ...).
+     *
+     * @param reg The register
+     * @param val The value written
+     */
+    virtual void regWritten(uint8_t reg, uint8_t val) { m_regs[reg] = val; };
+
+    /**
+     * Called for every register read by the driver.  The default
+     * returns the next FIFO byte, or the register value.
+     *
+     * @param reg The register
+     * @return The value to return to the driver
+     */
+    virtual uint8_t regRead(uint8_t reg);
+
+    // bus side interface, used by the simulated mraa implementation
+    void i2cWrite(const uint8_t *data, int len);
+    void i2cRead(uint8_t *data, int len);
+    void spiBegin();
+    void spiTransfer(const uint8_t *tx, uint8_t *rx, int len);
+
+  protected:
+    uint8_t m_regs[256];
+    std::map<uint8_t, std::deque<uint8_t> > m_fifos;
+
+    uint8_t m_autoIncrement;
+    uint8_t m_spiFlag;
+    bool m_spiReadWhenSet;
+    uint8_t m_spiAutoIncFlag;
+    int m_csPin;
+
+    // current register pointer, and whether it advances
+    uint8_t m_ptr;
+    bool m_increment;
+
+    // SPI transaction state
+    bool m_spiHaveAddr;
+    bool m_spiRead;
+
+    void setPointer(uint8_t addr, uint8_t incFlag);
+    void advance();
+  };
+
+  /**
+   * @brief Simulated bus backend
+   *
+   * SimBus replaces libmraa (and the parts of libmodbus used by
+   * UPM) for drivers built against it.  Devices are attached to I2C
+   * addresses, SPI buses, and modbus slave addresses; GPIO and UART
+   * input can be scripted.  Every transaction is counted per bus
+   * type, and an optional latency (per transaction and per byte) can
+   * be injected to model real bus speeds.
+   */
+  class SimBus {
+  public:
+    /**
+     * Bus types
+     */
+    typedef enum {
+      BUS_I2C                   = 0,
+      BUS_SPI                   = 1,
+      BUS_UART                  = 2,
+      BUS_GPIO                  = 3,
+      BUS_MODBUS                = 4,
+
+      BUS_MAX                   = 5
+    } BUS_TYPE_T;
+
+    /**
+     * Transaction counters for a bus type
+     */
+    typedef struct {
+      uint64_t transactions;
+      uint64_t bytesWritten;
+      uint64_t bytesRead;
+    } STATS_T;
+
+    /**
+     * Attach a device to an I2C bus and address.
+     *
+     * @param bus The I2C bus
+     * @param addr The 7-bit address
+     * @param dev The device
+     */
+    static void attachI2c(int bus, uint8_t addr, SimDevice *dev);
+
+    /**
+     * Attach a device to an SPI bus.  Several devices can be attached
+     * to one bus if each uses a different chip select pin.
+     *
+     * @param bus The SPI bus
+     * @param dev The device
+     */
+    static void attachSpi(int bus, SimDevice *dev);
+
+    /**
+     * Set an input register of a simulated modbus slave.
+     *
+     * @param slave The slave address
+     * @param reg The input register
+     * @param val The value
+     */
+    static void setModbusInputReg(int slave, int reg, uint16_t val);
+
+    /**
+     * Set the level read from a GPIO pin configured as an input.  If
+     * the driver installed an ISR on the pin and the change matches
+     * its edge, the ISR is called from this thread before setGpio()
+     * returns.
+     *
+     * @param pin The pin
+     * @param val The level
+     */
+    static void setGpio(int pin, int val);
+
+    /**
+     * Return the level last written to a GPIO pin.
+     *
+     * @param pin The pin
+     * @return The level
+     */
+    static int getGpio(int pin);
+
+    /**
+     * Queue bytes to be read from a UART.
+     *
+     * @param uart The UART
+     * @param data The data
+     */
+    static void pushUart(int uart, const std::string& data);
+
+    /**
+     * Return, and clear, everything written to a UART.
+     *
+     * @param uart The UART
+     * @return The data written
+     */
+    static std::string drainUart(int uart);
+
+    /**
+     * Inject latency into every transaction on a bus type.
+     *
+     * @param type The bus type
+     * @param perTransaction Latency per transaction in nanoseconds
+     * @param perByte Latency per byte transferred in nanoseconds
+     */
+    static void setLatency(BUS_TYPE_T type, uint32_t perTransaction,
+                           uint32_t perByte);
+
+    /**
+     * Return the transaction counters for a bus type.
+     *
+     * @param type The bus type
+     * @return The counters
+     */
+    static STATS_T getStats(BUS_TYPE_T type);
+
+    /**
+     * Reset the transaction counters of all bus types.
+     */
+    static void resetStats();
+
+    /**
+     * Remove all devices and scripted input, and reset counters and
+     * latencies.
+     */
+    static void reset();
+
+    // used by the simulated mraa and modbus implementations
+    static SimDevice *i2cDevice(int bus, uint8_t addr);
+    static SimDevice *spiDevice(int bus);
+    static SimDevice *spiDeviceForCS(int pin);
+    static bool modbusInputReg(int slave, int reg, uint16_t *val);
+    static void gpioWritten(int pin, int val);
+    static void gpioIsr(int pin, int edge, void (*isr)(void *), void *arg);
+    static int uartRead(int uart, char *buf, int len);
+    static int uartAvailable(int uart);
+    static void uartWritten(int uart, const char *buf, int len);
+    static void account(BUS_TYPE_T type, int written, int read);
+  };
+}
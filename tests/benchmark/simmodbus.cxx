@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The subset of libmodbus used by the UPM modbus drivers, routed to
+ * the SimBus modbus model.  Each request is accounted as one
+ * transaction with RTU framing sizes.
+ */
+
+#include <errno.h>
+
+#include <modbus/modbus.h>
+
+#include "simbus.h"
+
+using namespace upm;
+
+struct _modbus {
+  int slave;
+};
+
+extern "C" {
+
+modbus_t* modbus_new_rtu(const char *device, int baud, char parity,
+                         int data_bit, int stop_bit)
+{
+  modbus_t *ctx = new _modbus;
+
+  ctx->slave = 0;
+
+  return ctx;
+}
+
+int modbus_set_slave(modbus_t *ctx, int slave)
+{
+  ctx->slave = slave;
+
+  return 0;
+}
+
+int modbus_rtu_set_serial_mode(modbus_t *ctx, int mode)
+{
+  return 0;
+}
+
+int modbus_set_debug(modbus_t *ctx, int flag)
+{
+  return 0;
+}
+
+int modbus_connect(modbus_t *ctx)
+{
+  return 0;
+}
+
+void modbus_close(modbus_t *ctx)
+{
+}
+
+void modbus_free(modbus_t *ctx)
+{
+  delete ctx;
+}
+
+int modbus_read_input_registers(modbus_t *ctx, int addr, int nb,
+                                uint16_t *dest)
+{
+  // request: slave, function, address, count, crc
+  // response: slave, function, byte count, data, crc
+  SimBus::account(SimBus::BUS_MODBUS, 8, 5 + (nb * 2));
+
+  for (int i=0; i<nb; i++)
+    {
+      if (!SimBus::modbusInputReg(ctx->slave, addr + i, &dest[i]))
+        {
+          errno = EMBXILADD;
+          return -1;
+        }
+    }
+
+  return nb;
+}
+
+}
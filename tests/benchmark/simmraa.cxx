@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2016 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * A libmraa replacement that routes I2C, SPI, GPIO and UART access
+ * to the SimBus models.  It implements the mraa C API, which the
+ * mraa C++ classes are built on, so drivers are built unmodified
+ * against the installed mraa headers and linked with this file
+ * instead of libmraa.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+
+#include <mraa/common.h>
+#include <mraa/i2c.h>
+#include <mraa/spi.h>
+#include <mraa/gpio.h>
+#include <mraa/uart.h>
+
+#include "simbus.h"
+
+using namespace upm;
+
+struct _i2c {
+  int bus;
+  uint8_t addr;
+};
+
+struct _spi {
+  int bus;
+};
+
+struct _gpio {
+  int pin;
+  int dir;
+};
+
+struct _uart {
+  int uart;
+  std::string path;
+};
+
+extern "C" {
+
+// common
+
+mraa_result_t mraa_init()
+{
+  return MRAA_SUCCESS;
+}
+
+void mraa_deinit()
+{
+}
+
+void mraa_result_print(mraa_result_t result)
+{
+  fprintf(stderr, "simbus: mraa result %d\n", int(result));
+}
+
+int mraa_set_priority(const int priority)
+{
+  return priority;
+}
+
+// I2C
+
+mraa_i2c_context mraa_i2c_init(int bus)
+{
+  mraa_i2c_context dev = new _i2c;
+
+  dev->bus = bus;
+  dev->addr = 0;
+
+  return dev;
+}
+
+mraa_i2c_context mraa_i2c_init_raw(unsigned int bus)
+{
+  return mraa_i2c_init(bus);
+}
+
+mraa_result_t mraa_i2c_frequency(mraa_i2c_context dev, mraa_i2c_mode_t mode)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_i2c_address(mraa_i2c_context dev, uint8_t address)
+{
+  dev->addr = address;
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_i2c_stop(mraa_i2c_context dev)
+{
+  delete dev;
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_i2c_write(mraa_i2c_context dev, const uint8_t* data,
+                             int length)
+{
+  SimDevice *sim = SimBus::i2cDevice(dev->bus, dev->addr);
+
+  SimBus::account(SimBus::BUS_I2C, length, 0);
+
+  if (!sim)
+    return MRAA_ERROR_UNSPECIFIED;
+
+  sim->i2cWrite(data, length);
+
+  return MRAA_SUCCESS;
+}
+
+int mraa_i2c_read(mraa_i2c_context dev, uint8_t* data, int length)
+{
+  SimDevice *sim = SimBus::i2cDevice(dev->bus, dev->addr);
+
+  SimBus::account(SimBus::BUS_I2C, 0, length);
+
+  if (!sim)
+    return -1;
+
+  sim->i2cRead(data, length);
+
+  return length;
+}
+
+int mraa_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command,
+                             uint8_t* data, int length)
+{
+  SimDevice *sim = SimBus::i2cDevice(dev->bus, dev->addr);
+
+  // register write and read, joined by a repeated start
+  SimBus::account(SimBus::BUS_I2C, 1, length);
+
+  if (!sim)
+    return -1;
+
+  sim->i2cWrite(&command, 1);
+  sim->i2cRead(data, length);
+
+  return length;
+}
+
+uint8_t mraa_i2c_read_byte(mraa_i2c_context dev)
+{
+  uint8_t data = 0xff;
+
+  mraa_i2c_read(dev, &data, 1);
+
+  return data;
+}
+
+uint8_t mraa_i2c_read_byte_data(mraa_i2c_context dev, const uint8_t command)
+{
+  uint8_t data = 0xff;
+
+  mraa_i2c_read_bytes_data(dev, command, &data, 1);
+
+  return data;
+}
+
+uint16_t mraa_i2c_read_word_data(mraa_i2c_context dev, const uint8_t command)
+{
+  uint8_t data[2] = {0xff, 0xff};
+
+  mraa_i2c_read_bytes_data(dev, command, data, 2);
+
+  // SMBus words are little endian
+  return (data[1] << 8) | data[0];
+}
+
+mraa_result_t mraa_i2c_write_byte(mraa_i2c_context dev, const uint8_t data)
+{
+  return mraa_i2c_write(dev, &data, 1);
+}
+
+mraa_result_t mraa_i2c_write_byte_data(mraa_i2c_context dev,
+                                       const uint8_t data,
+                                       const uint8_t command)
+{
+  uint8_t buf[2] = {command, data};
+
+  return mraa_i2c_write(dev, buf, 2);
+}
+
+mraa_result_t mraa_i2c_write_word_data(mraa_i2c_context dev,
+                                       const uint16_t data,
+                                       const uint8_t command)
+{
+  uint8_t buf[3] = {command, uint8_t(data & 0xff), uint8_t(data >> 8)};
+
+  return mraa_i2c_write(dev, buf, 3);
+}
+
+// SPI
+
+mraa_spi_context mraa_spi_init(int bus)
+{
+  mraa_spi_context dev = new _spi;
+
+  dev->bus = bus;
+
+  return dev;
+}
+
+mraa_spi_context mraa_spi_init_raw(unsigned int bus, unsigned int cs)
+{
+  return mraa_spi_init(bus);
+}
+
+mraa_result_t mraa_spi_mode(mraa_spi_context dev, mraa_spi_mode_t mode)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_frequency(mraa_spi_context dev, int hz)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_lsbmode(mraa_spi_context dev, mraa_boolean_t lsb)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_bit_per_word(mraa_spi_context dev, unsigned int bits)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_stop(mraa_spi_context dev)
+{
+  delete dev;
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t* data,
+                                    uint8_t* rxbuf, int length)
+{
+  SimDevice *sim = SimBus::spiDevice(dev->bus);
+
+  SimBus::account(SimBus::BUS_SPI, length, (rxbuf) ? length : 0);
+
+  if (!sim)
+    {
+      // nothing attached, the bus reads back as 0
+      if (rxbuf)
+        memset(rxbuf, 0, length);
+      return MRAA_SUCCESS;
+    }
+
+  // without a chip select pin, every transfer is a transaction
+  if (sim->getChipSelect() < 0)
+    sim->spiBegin();
+
+  sim->spiTransfer(data, rxbuf, length);
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_transfer_buf_word(mraa_spi_context dev,
+                                         uint16_t* data, uint16_t* rxbuf,
+                                         int length)
+{
+  // words are sent MSB first
+  uint8_t *tx = new uint8_t[length * 2];
+  uint8_t *rx = new uint8_t[length * 2];
+
+  for (int i=0; i<length; i++)
+    {
+      tx[i * 2] = (data) ? data[i] >> 8 : 0;
+      tx[(i * 2) + 1] = (data) ? data[i] & 0xff : 0;
+    }
+
+  mraa_result_t rv = mraa_spi_transfer_buf(dev, tx, rx, length * 2);
+
+  if (rxbuf)
+    for (int i=0; i<length; i++)
+      rxbuf[i] = (rx[i * 2] << 8) | rx[(i * 2) + 1];
+
+  delete [] tx;
+  delete [] rx;
+
+  return rv;
+}
+
+int mraa_spi_write(mraa_spi_context dev, uint8_t data)
+{
+  uint8_t rx = 0;
+
+  mraa_spi_transfer_buf(dev, &data, &rx, 1);
+
+  return rx;
+}
+
+uint16_t mraa_spi_write_word(mraa_spi_context dev, uint16_t data)
+{
+  uint16_t rx = 0;
+
+  mraa_spi_transfer_buf_word(dev, &data, &rx, 1);
+
+  return rx;
+}
+
+uint8_t* mraa_spi_write_buf(mraa_spi_context dev, uint8_t* data, int length)
+{
+  // the caller frees the returned buffer
+  uint8_t *rx = (uint8_t *)malloc(length);
+
+  if (!rx)
+    return NULL;
+
+  mraa_spi_transfer_buf(dev, data, rx, length);
+
+  return rx;
+}
+
+uint16_t* mraa_spi_write_buf_word(mraa_spi_context dev, uint16_t* data,
+                                  int length)
+{
+  uint16_t *rx = (uint16_t *)malloc(length * sizeof(uint16_t));
+
+  if (!rx)
+    return NULL;
+
+  mraa_spi_transfer_buf_word(dev, data, rx, length);
+
+  return rx;
+}
+
+// GPIO
+
+mraa_gpio_context mraa_gpio_init(int pin)
+{
+  mraa_gpio_context dev = new _gpio;
+
+  dev->pin = pin;
+  dev->dir = MRAA_GPIO_IN;
+
+  return dev;
+}
+
+mraa_gpio_context mraa_gpio_init_raw(int pin)
+{
+  return mraa_gpio_init(pin);
+}
+
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev)
+{
+  SimBus::gpioIsr(dev->pin, 0, 0, 0);
+  delete dev;
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_edge_mode(mraa_gpio_context dev,
+                                  mraa_gpio_edge_t mode)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_isr(mraa_gpio_context dev, mraa_gpio_edge_t edge,
+                            void (*fptr)(void*), void* args)
+{
+  SimBus::gpioIsr(dev->pin, int(edge), fptr, args);
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_isr_exit(mraa_gpio_context dev)
+{
+  SimBus::gpioIsr(dev->pin, 0, 0, 0);
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir)
+{
+  dev->dir = dir;
+
+  if (dir == MRAA_GPIO_OUT_HIGH)
+    SimBus::gpioWritten(dev->pin, 1);
+  else if (dir == MRAA_GPIO_OUT_LOW)
+    SimBus::gpioWritten(dev->pin, 0);
+
+  return MRAA_SUCCESS;
+}
+
+int mraa_gpio_read(mraa_gpio_context dev)
+{
+  SimBus::account(SimBus::BUS_GPIO, 0, 1);
+
+  return SimBus::getGpio(dev->pin);
+}
+
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value)
+{
+  SimBus::account(SimBus::BUS_GPIO, 1, 0);
+  SimBus::gpioWritten(dev->pin, (value) ? 1 : 0);
+
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_owner(mraa_gpio_context dev, mraa_boolean_t owner)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_use_mmaped(mraa_gpio_context dev,
+                                   mraa_boolean_t mmap)
+{
+  return MRAA_SUCCESS;
+}
+
+int mraa_gpio_get_pin(mraa_gpio_context dev)
+{
+  return dev->pin;
+}
+
+int mraa_gpio_get_pin_raw(mraa_gpio_context dev)
+{
+  return dev->pin;
+}
+
+// UART
+
+mraa_uart_context mraa_uart_init(int uart)
+{
+  mraa_uart_context dev = new _uart;
+  char path[32];
+
+  snprintf(path, sizeof(path), "/dev/simuart%d", uart);
+  dev->uart = uart;
+  dev->path = path;
+
+  return dev;
+}
+
+mraa_uart_context mraa_uart_init_raw(const char* path)
+{
+  // raw devices all map to UART 0
+  mraa_uart_context dev = mraa_uart_init(0);
+
+  dev->path = path;
+
+  return dev;
+}
+
+mraa_result_t mraa_uart_flush(mraa_uart_context dev)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_baudrate(mraa_uart_context dev, unsigned int baud)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_mode(mraa_uart_context dev, int bytesize,
+                                 mraa_uart_parity_t parity, int stopbits)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_flowcontrol(mraa_uart_context dev,
+                                        mraa_boolean_t xonxoff,
+                                        mraa_boolean_t rtscts)
+{
+  return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_timeout(mraa_uart_context dev, int read,
+                                    int write, int interchar)
+{
+  return MRAA_SUCCESS;
+}
+
+const char* mraa_uart_get_dev_path(mraa_uart_context dev)
+{
+  return dev->path.c_str();
+}
+
+mraa_result_t mraa_uart_stop(mraa_uart_context dev)
+{
+  delete dev;
+
+  return MRAA_SUCCESS;
+}
+
+int mraa_uart_read(mraa_uart_context dev, char* buf, size_t length)
+{
+  int rv = SimBus::uartRead(dev->uart, buf, length);
+
+  SimBus::account(SimBus::BUS_UART, 0, rv);
+
+  return rv;
+}
+
+int mraa_uart_write(mraa_uart_context dev, const char* buf, size_t length)
+{
+  SimBus::account(SimBus::BUS_UART, length, 0);
+  SimBus::uartWritten(dev->uart, buf, length);
+
+  return length;
+}
+
+mraa_boolean_t mraa_uart_data_available(mraa_uart_context dev,
+                                        unsigned int millis)
+{
+  // scripted input is available immediately, there is nothing to
+  // wait for
+  return (SimBus::uartAvailable(dev->uart) > 0);
+}
+
+}